@@ -0,0 +1,159 @@
+#include "actuator_task.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include <atomic>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+static QueueHandle_t event_queue = nullptr;
+static actuator_handler_t state_machine = nullptr;
+static esp_timer_handle_t timeout_timer = nullptr;
+static esp_timer_handle_t tick_timer = nullptr;
+
+// Bumped on every (re)arm or cancel; queued events from older timers are dropped
+static std::atomic<uint16_t> timeout_generation{0};
+static std::atomic<uint16_t> tick_generation{0};
+static bool isr_service_installed = false;
+
+static void post_timer_event(uint8_t type, uint16_t generation) {
+    actuator_event_t event = {};
+    event.type = type;
+    event.generation = generation;
+    xQueueSend(event_queue, &event, 0);
+}
+
+static void timeout_callback(void* arg) {
+    post_timer_event(ACTUATOR_EVENT_TIMEOUT, timeout_generation.load(std::memory_order_relaxed));
+}
+
+static void tick_callback(void* arg) {
+    post_timer_event(ACTUATOR_EVENT_TICK, tick_generation.load(std::memory_order_relaxed));
+}
+
+static void IRAM_ATTR gpio_isr(void* arg) {
+    actuator_event_t event = {};
+    event.type = ACTUATOR_EVENT_GPIO;
+    event.args[0] = (int32_t)(intptr_t)arg;
+
+    BaseType_t must_yield = pdFALSE;
+    xQueueSendFromISR(event_queue, &event, &must_yield);
+    portYIELD_FROM_ISR(must_yield);
+}
+
+static void handle_event(const actuator_event_t* event) {
+    // A timeout raced by a re-arm leaves the one-shot timer active again
+    if (event->type == ACTUATOR_EVENT_TIMEOUT &&
+        (event->generation != timeout_generation.load(std::memory_order_relaxed) ||
+         esp_timer_is_active(timeout_timer))) {
+        return;
+    }
+    if (event->type == ACTUATOR_EVENT_TICK &&
+        event->generation != tick_generation.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (event->type >= ACTUATOR_EVENT_USER) {
+        metrics_record_since(METRIC_ACTUATION, event->posted_us);
+    }
+    state_machine(event);
+}
+
+static void actuator_task(void* pvParameter) {
+    actuator_event_t event;
+
+    while (1) {
+        // The event stays queued until handled, so actuator_busy() has no gap
+        // between taking an event and the state machine arming its timer
+        if (xQueuePeek(event_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        handle_event(&event);
+        xQueueReceive(event_queue, &event, 0);
+    }
+}
+
+bool actuator_start(actuator_handler_t handler) {
+    if (event_queue != nullptr) {
+        return false;
+    }
+
+    state_machine = handler;
+    event_queue = xQueueCreate(ACTUATOR_QUEUE_LENGTH, sizeof(actuator_event_t));
+    if (event_queue == nullptr) {
+        DebugHelper::error("Actuator: failed to create event queue");
+        return false;
+    }
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = timeout_callback;
+    timer_args.name = "actuator_timeout";
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timeout_timer));
+    timer_args.callback = tick_callback;
+    timer_args.name = "actuator_tick";
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &tick_timer));
+
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(actuator_task, "actuator", ACTUATOR_TASK_STACK, nullptr,
+                                ACTUATOR_TASK_PRIORITY, &task, ACTUATOR_TASK_CORE) != pdPASS) {
+        DebugHelper::error("Actuator: failed to create task");
+        return false;
+    }
+    metrics_watch_task("actuator", task);
+    return true;
+}
+
+bool actuator_post(uint8_t type, int32_t arg0, int32_t arg1) {
+    actuator_event_t event = {};
+    event.type = type;
+    event.posted_us = metrics_now();
+    event.args[0] = arg0;
+    event.args[1] = arg1;
+
+    if (event_queue == nullptr || xQueueSend(event_queue, &event, 0) != pdTRUE) {
+        DebugHelper::warning("Actuator: event %u dropped", (unsigned)type);
+        return false;
+    }
+    return true;
+}
+
+bool actuator_watch_gpio(int pin) {
+    if (!isr_service_installed) {
+        if (gpio_install_isr_service(0) != ESP_OK) {
+            DebugHelper::error("Actuator: failed to install GPIO ISR service");
+            return false;
+        }
+        isr_service_installed = true;
+    }
+    return gpio_isr_handler_add(pin, gpio_isr, (void*)(intptr_t)pin) == ESP_OK;
+}
+
+void actuator_set_timeout(uint32_t timeout_ms) {
+    esp_timer_stop(timeout_timer);
+    timeout_generation.fetch_add(1, std::memory_order_relaxed);
+    esp_timer_start_once(timeout_timer, (uint64_t)timeout_ms * 1000);
+}
+
+void actuator_set_tick(uint32_t period_ms) {
+    esp_timer_stop(tick_timer);
+    tick_generation.fetch_add(1, std::memory_order_relaxed);
+    if (period_ms > 0) {
+        esp_timer_start_periodic(tick_timer, (uint64_t)period_ms * 1000);
+    }
+}
+
+void actuator_cancel_timers() {
+    esp_timer_stop(timeout_timer);
+    esp_timer_stop(tick_timer);
+    timeout_generation.fetch_add(1, std::memory_order_relaxed);
+    tick_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool actuator_busy() {
+    if (event_queue == nullptr) {
+        return false;
+    }
+    return esp_timer_is_active(timeout_timer) || esp_timer_is_active(tick_timer) ||
+           uxQueueMessagesWaiting(event_queue) > 0;
+}
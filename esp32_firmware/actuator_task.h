@@ -0,0 +1,107 @@
+#ifndef ACTUATOR_TASK_H
+#define ACTUATOR_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "task_config.h"
+
+/**
+ * @file actuator_task.h
+ * @brief Event-driven actuator state machine runner
+ *
+ * Runs a module's actuator state machine on its own task, fed by an event
+ * queue. Command handlers post an event and return immediately, so the MQTT
+ * task is never blocked by an actuation. Completion and progress come from
+ * GPIO edge interrupts on feedback pins and esp_timer timeouts/ticks, all of
+ * which arrive at the state machine as events; it reports progress
+ * asynchronously (e.g. through sendStatus()).
+ *
+ * The runner owns one one-shot timeout and one periodic tick. Restarting or
+ * cancelling them invalidates events already queued by the previous timer,
+ * so a state machine never sees a stale timeout after leaving a state.
+ */
+
+#define ACTUATOR_QUEUE_LENGTH   8
+#ifndef ACTUATOR_TASK_STACK
+#define ACTUATOR_TASK_STACK     4096
+#endif
+#define ACTUATOR_TASK_PRIORITY  6       // Lowest on APP_CPU (task_config.h)
+#define ACTUATOR_TASK_CORE      TASK_CORE_CONTROL
+
+/**
+ * @brief Built-in event types; module events start at ACTUATOR_EVENT_USER
+ */
+typedef enum {
+    ACTUATOR_EVENT_TIMEOUT = 0,         // actuator_set_timeout() expired
+    ACTUATOR_EVENT_TICK = 1,            // actuator_set_tick() period elapsed
+    ACTUATOR_EVENT_GPIO = 2,            // Edge on a watched pin, args[0] = pin
+    ACTUATOR_EVENT_ANOMALY = 3,         // Sensor anomaly onset, args[0] = channel,
+                                        // args[1] = anomaly_kind_t bits (anomaly_detector.h)
+    ACTUATOR_EVENT_USER = 16
+} actuator_event_type_t;
+
+/**
+ * @brief Event delivered to the state machine
+ */
+typedef struct {
+    uint8_t type;                       // actuator_event_type_t or module event
+    uint16_t generation;                // Timer generation (internal)
+    uint32_t posted_us;                 // Post time, for actuation latency (internal)
+    int32_t args[2];                    // Event arguments
+} actuator_event_t;
+
+/**
+ * @brief State machine step, runs on the actuator task
+ */
+typedef void (*actuator_handler_t)(const actuator_event_t* event);
+
+/**
+ * @brief Create the actuator task and its timers
+ * @param handler Module state machine
+ * @return true if the task was started
+ */
+bool actuator_start(actuator_handler_t handler);
+
+/**
+ * @brief Post an event to the state machine (any task, never blocks)
+ * @param type Event type (>= ACTUATOR_EVENT_USER for module events)
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ * @return false if the queue was full and the event dropped
+ */
+bool actuator_post(uint8_t type, int32_t arg0, int32_t arg1);
+
+/**
+ * @brief Deliver edges on a GPIO as ACTUATOR_EVENT_GPIO events
+ *
+ * The pin's interrupt type must already be configured (gpio_config()).
+ *
+ * @param pin GPIO number
+ * @return true if the ISR handler was installed
+ */
+bool actuator_watch_gpio(int pin);
+
+/**
+ * @brief (Re)arm the one-shot timeout
+ * @param timeout_ms Delay until ACTUATOR_EVENT_TIMEOUT
+ */
+void actuator_set_timeout(uint32_t timeout_ms);
+
+/**
+ * @brief (Re)arm the periodic tick
+ * @param period_ms Tick period, 0 to stop
+ */
+void actuator_set_tick(uint32_t period_ms);
+
+/**
+ * @brief Stop the timeout and tick and discard their pending events
+ */
+void actuator_cancel_timers();
+
+/**
+ * @brief Whether an actuation is in progress (a timer is armed or events are queued)
+ */
+bool actuator_busy();
+
+#endif // ACTUATOR_TASK_H
@@ -0,0 +1,210 @@
+#include "adc_scheduler.h"
+#include "adc_stream.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include "seqlock.h"
+
+#if !ADC_STREAM_ENABLED
+
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+
+typedef struct {
+    uint8_t channel;
+    std::atomic<uint32_t> period_us;    // Requested period, any task
+    uint32_t interval;                  // Ticks between conversions (scan task)
+    uint32_t next_tick;                 // Tick of the next conversion (scan task)
+} scan_slot_t;
+
+static scan_slot_t slots[ADC_SCHEDULER_MAX_CHANNELS];
+static size_t slot_count = 0;
+static Seqlock<adc_snapshot_t> latest;
+
+static TaskHandle_t scan_task = nullptr;
+static esp_timer_handle_t scan_timer = nullptr;
+static std::atomic<bool> periods_changed{false};
+
+// Scan task only
+static adc_snapshot_t working;          // Snapshot being built
+static uint32_t tick_us = 0;
+static uint32_t tick = 0;
+static size_t cursor = 0;               // First slot looked at in the next pass
+
+static void IRAM_ATTR scan_timer_cb(void* arg) {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(scan_task, &woken);
+    if (woken == pdTRUE) {
+        esp_timer_isr_dispatch_need_yield();
+    }
+#else
+    xTaskNotifyGive(scan_task);
+#endif
+}
+
+static inline void convert(scan_slot_t* slot) {
+    working.raw[slot->channel] = (uint16_t)adc1_get_raw((adc1_channel_t)slot->channel);
+    working.conversions[slot->channel]++;
+}
+
+// Tick at the shortest period; every channel converts on the nearest tick to its own
+static void apply_periods() {
+    uint32_t shortest = UINT32_MAX;
+    for (size_t i = 0; i < slot_count; i++) {
+        uint32_t period_us = slots[i].period_us.load(std::memory_order_relaxed);
+        if (period_us < shortest) {
+            shortest = period_us;
+        }
+    }
+    for (size_t i = 0; i < slot_count; i++) {
+        uint32_t period_us = slots[i].period_us.load(std::memory_order_relaxed);
+        slots[i].interval = (period_us + shortest / 2) / shortest;
+        slots[i].next_tick = tick + 1;
+    }
+
+    if (shortest != tick_us) {
+        tick_us = shortest;
+        esp_timer_stop(scan_timer);
+        if (esp_timer_start_periodic(scan_timer, tick_us) != ESP_OK) {
+            DebugHelper::error("ADC scheduler: failed to restart timer");
+        }
+    }
+    DebugHelper::verbose("ADC scheduler: tick %lu us", (unsigned long)tick_us);
+}
+
+static void scan_task_fn(void* pvParameter) {
+    while (1) {
+        tick += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (periods_changed.exchange(false)) {
+            apply_periods();
+        }
+
+        uint32_t start = metrics_now();
+        bool converted = false;
+        for (size_t n = 0; n < slot_count; n++) {
+            scan_slot_t* slot = &slots[(cursor + n) % slot_count];
+            if ((int32_t)(tick - slot->next_tick) < 0) {
+                continue;
+            }
+            convert(slot);
+            slot->next_tick = tick + slot->interval;
+            converted = true;
+        }
+        cursor = (cursor + 1) % slot_count;
+
+        if (converted) {
+            working.timestamp_us = (uint32_t)esp_timer_get_time();
+            latest.write(working);
+            metrics_record_since(METRIC_ADC_SCAN, start);
+        }
+    }
+}
+
+bool adc_scheduler_start(const adc_scan_entry_t* entries, size_t count) {
+    if (count == 0 || count > ADC_SCHEDULER_MAX_CHANNELS || scan_task != nullptr) {
+        return false;
+    }
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].channel >= ADC1_CHANNEL_MAX) {
+            DebugHelper::error("ADC scheduler: no ADC1 channel %u", (unsigned)entries[i].channel);
+            return false;
+        }
+        adc1_config_channel_atten((adc1_channel_t)entries[i].channel, entries[i].atten);
+        slots[i].channel = entries[i].channel;
+        slots[i].period_us.store(entries[i].period_us > ADC_SCHEDULER_MIN_PERIOD_US
+                                     ? entries[i].period_us : ADC_SCHEDULER_MIN_PERIOD_US);
+        convert(&slots[i]);
+    }
+    slot_count = count;
+    working.timestamp_us = (uint32_t)esp_timer_get_time();
+    latest.write(working);
+
+    // The task waits for its first tick, so the timer can only start after it
+    if (xTaskCreatePinnedToCore(scan_task_fn, "adc_scan", ADC_SCHEDULER_TASK_STACK, nullptr,
+                                ADC_SCHEDULER_TASK_PRIORITY, &scan_task,
+                                ADC_SCHEDULER_TASK_CORE) != pdPASS) {
+        DebugHelper::error("ADC scheduler: failed to create task");
+        return false;
+    }
+    metrics_watch_task("adc_scan", scan_task);
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = scan_timer_cb;
+    timer_args.name = "adc_scan";
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    timer_args.dispatch_method = ESP_TIMER_ISR;
+#endif
+    if (esp_timer_create(&timer_args, &scan_timer) != ESP_OK) {
+        DebugHelper::error("ADC scheduler: failed to create timer");
+        return false;
+    }
+    apply_periods();
+
+    DebugHelper::info("ADC scheduler started: %u channels, tick %lu us",
+                      (unsigned)count, (unsigned long)tick_us);
+    return true;
+}
+
+bool adc_scheduler_set_period(uint8_t channel, uint32_t period_us) {
+    if (scan_task == nullptr) {
+        return false;
+    }
+    for (size_t i = 0; i < slot_count; i++) {
+        if (slots[i].channel == channel) {
+            slots[i].period_us.store(period_us > ADC_SCHEDULER_MIN_PERIOD_US
+                                         ? period_us : ADC_SCHEDULER_MIN_PERIOD_US);
+            // Wake the task now rather than on the old, possibly slow, tick
+            periods_changed.store(true);
+            xTaskNotifyGive(scan_task);
+            return true;
+        }
+    }
+    return false;
+}
+
+void adc_scheduler_snapshot(adc_snapshot_t* snapshot) {
+    latest.read(*snapshot);
+}
+
+uint16_t adc_scheduler_read(uint8_t channel) {
+    adc_snapshot_t snapshot;
+    latest.read(snapshot);
+    return channel < ADC1_CHANNEL_MAX ? snapshot.raw[channel] : 0;
+}
+
+uint32_t adc_scheduler_sequence(uint8_t channel) {
+    adc_snapshot_t snapshot;
+    latest.read(snapshot);
+    return channel < ADC1_CHANNEL_MAX ? snapshot.conversions[channel] : 0;
+}
+
+#else // ADC_STREAM_ENABLED
+
+// The continuous driver owns ADC1; keep the API linkable
+bool adc_scheduler_start(const adc_scan_entry_t* entries, size_t count) {
+    DebugHelper::warning("ADC scheduler not used with ADC_STREAM");
+    return false;
+}
+
+bool adc_scheduler_set_period(uint8_t channel, uint32_t period_us) {
+    return false;
+}
+
+void adc_scheduler_snapshot(adc_snapshot_t* snapshot) {
+    *snapshot = {};
+}
+
+uint16_t adc_scheduler_read(uint8_t channel) {
+    return 0;
+}
+
+uint32_t adc_scheduler_sequence(uint8_t channel) {
+    return 0;
+}
+
+#endif // ADC_STREAM_ENABLED
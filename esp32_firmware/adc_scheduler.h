@@ -0,0 +1,95 @@
+#ifndef ADC_SCHEDULER_H
+#define ADC_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <driver/adc.h>
+#include "task_config.h"
+
+/**
+ * @file adc_scheduler.h
+ * @brief Single owner of ADC1 for one-shot builds: scan table and snapshots
+ *
+ * One task does every ADC1 conversion. It walks a scan table where each
+ * channel has its own attenuation and period, round-robin so that no channel
+ * is always converted last, and publishes the latest reading of every
+ * channel as one snapshot behind a seqlock (seqlock.h). Readers (the
+ * acquisition task, control loops) copy the snapshot and never wait for a
+ * conversion or for each other, so a 1 kHz control step is not held up by
+ * a sampling pass and the ADC driver is never entered from two tasks.
+ *
+ * The scan timer ticks at the shortest channel period and channels are
+ * converted on the tick closest to their own period. A control loop raises
+ * its channels' rate with adc_scheduler_set_period() while it runs.
+ *
+ * With ADC_STREAM the continuous driver owns ADC1 instead (adc_stream.h)
+ * and this component is compiled out.
+ */
+
+#define ADC_SCHEDULER_MAX_CHANNELS  ADC1_CHANNEL_MAX
+#define ADC_SCHEDULER_MIN_PERIOD_US 250         // Fastest channel period (~20 us per conversion)
+#ifndef ADC_SCHEDULER_TASK_STACK
+#define ADC_SCHEDULER_TASK_STACK    2048
+#endif
+#define ADC_SCHEDULER_TASK_PRIORITY 12          // Between acquisition and control (task_config.h)
+#define ADC_SCHEDULER_TASK_CORE     TASK_CORE_CONTROL
+
+/**
+ * @brief One channel of the scan table
+ */
+typedef struct {
+    uint8_t channel;                    // ADC1 channel number (ADC1_CHANNEL_x)
+    adc_atten_t atten;                  // Input attenuation
+    uint32_t period_us;                 // Conversion period
+} adc_scan_entry_t;
+
+/**
+ * @brief Latest readings of all ADC1 channels, from one scan pass
+ */
+typedef struct {
+    uint16_t raw[ADC1_CHANNEL_MAX];                 // Last conversion (0-4095)
+    uint32_t conversions[ADC1_CHANNEL_MAX];         // Conversions since start
+    uint32_t timestamp_us;                          // End of the pass (esp_timer)
+} adc_snapshot_t;
+
+/**
+ * @brief Configure ADC1 and start scanning
+ *
+ * Converts every channel once before returning, so the first snapshot is
+ * already valid (a deep-sleep wake samples right away).
+ *
+ * @param entries Scan table, in round-robin order
+ * @param count Number of entries (<= ADC_SCHEDULER_MAX_CHANNELS, one per channel)
+ * @return true if the scan task and timer were started
+ */
+bool adc_scheduler_start(const adc_scan_entry_t* entries, size_t count);
+
+/**
+ * @brief Change a channel's conversion period (applied at once)
+ * @param channel ADC1 channel in the scan table
+ * @param period_us New period (>= ADC_SCHEDULER_MIN_PERIOD_US)
+ * @return false if the channel is not scanned
+ */
+bool adc_scheduler_set_period(uint8_t channel, uint32_t period_us);
+
+/**
+ * @brief Copy the latest snapshot (any task, never blocks)
+ * @param snapshot Receives the readings
+ */
+void adc_scheduler_snapshot(adc_snapshot_t* snapshot);
+
+/**
+ * @brief Latest reading of one channel (any task, never blocks)
+ * @param channel ADC1 channel number
+ * @return Last raw conversion, 0 before the scheduler started
+ */
+uint16_t adc_scheduler_read(uint8_t channel);
+
+/**
+ * @brief Conversions of a channel so far, to detect a fresh reading
+ * @param channel ADC1 channel number
+ */
+uint32_t adc_scheduler_sequence(uint8_t channel);
+
+#endif // ADC_SCHEDULER_H
@@ -0,0 +1,206 @@
+#include "adc_stream.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include "task_config.h"
+#include <atomic>
+
+#if ADC_STREAM_ENABLED
+
+#include <esp_adc/adc_continuous.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#define ADC_STREAM_FRAME_SIZE   256     // Bytes per DMA conversion frame
+#define ADC_STREAM_POOL_SIZE    1024    // Driver ring buffer (bytes)
+#ifndef ADC_STREAM_TASK_STACK
+#define ADC_STREAM_TASK_STACK   3072
+#endif
+#define ADC_STREAM_TASK_PRIORITY 12     // Between acquisition and control (task_config.h)
+#define ADC_STREAM_TASK_CORE    TASK_CORE_CONTROL
+
+// Per-channel decimation state, indexed by ADC1 channel number
+typedef struct {
+    uint32_t sum;                   // Accumulated raw conversions
+    uint16_t count;                 // Conversions in current block
+    // Written by the drain task, read by the acquisition and control tasks
+    std::atomic<float> latest;      // Last block mean
+    std::atomic<int32_t> latest_milli;  // Same mean x 1000, for the fixed-point path
+    std::atomic<uint32_t> sequence; // Completed blocks, published after the means
+} stream_channel_state_t;
+
+static stream_channel_state_t channel_state[ADC1_CHANNEL_MAX];
+static adc_continuous_handle_t adc_handle = nullptr;
+static TaskHandle_t drain_task = nullptr;
+static SemaphoreHandle_t handle_lock = nullptr;    // Held by the drain task while it reads
+static uint16_t block_size = ADC_STREAM_OVERSAMPLE;
+
+// Conversion-frame-done ISR: wake the drain task
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle,
+                                   const adc_continuous_evt_data_t* edata, void* user_data) {
+    BaseType_t must_yield = pdFALSE;
+    vTaskNotifyGiveFromISR(drain_task, &must_yield);
+    return must_yield == pdTRUE;
+}
+
+static void adc_stream_task(void* pvParameter) {
+    static uint8_t frame[ADC_STREAM_FRAME_SIZE];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // adc_stream_stop() takes the lock before it deinits the handle
+        xSemaphoreTake(handle_lock, portMAX_DELAY);
+        uint32_t length = 0;
+        while (adc_handle != nullptr &&
+               adc_continuous_read(adc_handle, frame, sizeof(frame), &length, 0) == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t* out = (const adc_digi_output_data_t*)&frame[i];
+                uint32_t channel = out->type1.channel;
+                if (channel >= ADC1_CHANNEL_MAX) {
+                    continue;
+                }
+
+                stream_channel_state_t* state = &channel_state[channel];
+                state->sum += out->type1.data;
+                if (++state->count >= block_size) {
+                    state->latest.store((float)state->sum / state->count, std::memory_order_relaxed);
+                    state->latest_milli.store((int32_t)((state->sum * 1000ULL) / state->count),
+                                              std::memory_order_relaxed);
+                    state->sequence.fetch_add(1, std::memory_order_release);
+                    state->sum = 0;
+                    state->count = 0;
+                }
+            }
+        }
+        xSemaphoreGive(handle_lock);
+    }
+}
+
+// Stop and release the driver; the drain task is parked outside its reads
+static void release_handle() {
+    adc_continuous_stop(adc_handle);
+    xSemaphoreTake(handle_lock, portMAX_DELAY);
+    adc_continuous_deinit(adc_handle);
+    adc_handle = nullptr;
+    xSemaphoreGive(handle_lock);
+}
+
+bool adc_stream_start(const adc_stream_channel_t* channels, size_t count,
+                      uint32_t sample_rate_hz, uint16_t oversample) {
+    if (count == 0 || count > ADC_STREAM_MAX_CHANNELS || adc_handle != nullptr) {
+        return false;
+    }
+
+    for (stream_channel_state_t& state : channel_state) {
+        state.sum = 0;
+        state.count = 0;
+        state.latest.store(0.0f, std::memory_order_relaxed);
+        state.latest_milli.store(0, std::memory_order_relaxed);
+        state.sequence.store(0, std::memory_order_relaxed);
+    }
+    block_size = oversample > 0 ? oversample : 1;
+
+    if (drain_task == nullptr) {
+        handle_lock = xSemaphoreCreateMutex();
+        if (handle_lock == nullptr ||
+            xTaskCreatePinnedToCore(adc_stream_task, "adc_stream", ADC_STREAM_TASK_STACK, nullptr,
+                                    ADC_STREAM_TASK_PRIORITY, &drain_task,
+                                    ADC_STREAM_TASK_CORE) != pdPASS) {
+            DebugHelper::error("ADC stream: failed to create drain task");
+            return false;
+        }
+        metrics_watch_task("adc_stream", drain_task);
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {};
+    handle_cfg.max_store_buf_size = ADC_STREAM_POOL_SIZE;
+    handle_cfg.conv_frame_size = ADC_STREAM_FRAME_SIZE;
+    if (adc_continuous_new_handle(&handle_cfg, &adc_handle) != ESP_OK) {
+        DebugHelper::error("ADC stream: failed to create handle");
+        adc_handle = nullptr;
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern[ADC_STREAM_MAX_CHANNELS] = {};
+    for (size_t i = 0; i < count; i++) {
+        pattern[i].atten = channels[i].atten;
+        pattern[i].channel = channels[i].channel;
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_config_t config = {};
+    config.pattern_num = count;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = sample_rate_hz;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    adc_continuous_evt_cbs_t callbacks = {};
+    callbacks.on_conv_done = on_conv_done;
+
+    esp_err_t ret = adc_continuous_config(adc_handle, &config);
+    if (ret == ESP_OK) {
+        ret = adc_continuous_register_event_callbacks(adc_handle, &callbacks, nullptr);
+    }
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(adc_handle);
+    }
+    if (ret != ESP_OK) {
+        DebugHelper::error("ADC stream: failed to start: %s", esp_err_to_name(ret));
+        release_handle();
+        return false;
+    }
+
+    DebugHelper::info("ADC stream started: %u channels, %lu Hz, %ux oversampling",
+                      (unsigned)count, (unsigned long)sample_rate_hz, (unsigned)block_size);
+    return true;
+}
+
+void adc_stream_stop() {
+    if (adc_handle != nullptr) {
+        release_handle();
+    }
+}
+
+float adc_stream_read(uint8_t channel) {
+    return channel < ADC1_CHANNEL_MAX ? channel_state[channel].latest.load(std::memory_order_relaxed)
+                                      : 0.0f;
+}
+
+int32_t adc_stream_read_milli(uint8_t channel) {
+    return channel < ADC1_CHANNEL_MAX
+        ? channel_state[channel].latest_milli.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t adc_stream_sequence(uint8_t channel) {
+    return channel < ADC1_CHANNEL_MAX
+        ? channel_state[channel].sequence.load(std::memory_order_acquire) : 0;
+}
+
+#else // !ADC_STREAM_ENABLED
+
+// Streaming compiled out: keep the API linkable without pulling in the
+// continuous driver, which would conflict with the one-shot driver.
+bool adc_stream_start(const adc_stream_channel_t* channels, size_t count,
+                      uint32_t sample_rate_hz, uint16_t oversample) {
+    DebugHelper::warning("ADC stream not enabled in this build");
+    return false;
+}
+
+void adc_stream_stop() {
+}
+
+float adc_stream_read(uint8_t channel) {
+    return 0.0f;
+}
+
+int32_t adc_stream_read_milli(uint8_t channel) {
+    return 0;
+}
+
+uint32_t adc_stream_sequence(uint8_t channel) {
+    return 0;
+}
+
+#endif // ADC_STREAM_ENABLED
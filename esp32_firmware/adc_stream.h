@@ -0,0 +1,129 @@
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <driver/adc.h>
+#include "adc_scheduler.h"
+#include "sensor_value.h"
+
+/**
+ * @file adc_stream.h
+ * @brief Continuous (DMA) ADC1 sampling with block oversampling
+ *
+ * Streams a set of ADC1 channels through the continuous-mode driver at kHz
+ * rates. A drain task averages every ADC_STREAM_OVERSAMPLE conversions of a
+ * channel into one decimated reading (with sub-LSB resolution) and publishes
+ * it as the channel's latest value. Readers never block and never touch the
+ * ADC, so they cost a memory read instead of a one-shot conversion.
+ *
+ * ESP-IDF does not allow the continuous driver and the legacy one-shot
+ * driver in the same image, so streaming is selected for the whole build
+ * with the ADC_STREAM CMake option (defines ADC_STREAM_ENABLED). Without it
+ * the ADC scheduler owns ADC1 (adc_scheduler.h). Modules read through
+ * adc_read_raw(), which picks the active path at compile time; neither path
+ * converts on the reader's task.
+ */
+
+#ifndef ADC_STREAM_ENABLED
+#define ADC_STREAM_ENABLED 0
+#endif
+
+#define ADC_STREAM_MAX_CHANNELS 4
+
+#ifndef ADC_STREAM_SAMPLE_RATE_HZ
+#define ADC_STREAM_SAMPLE_RATE_HZ 20000     // Total conversions/s, all channels
+#endif
+
+#ifndef ADC_STREAM_OVERSAMPLE
+#define ADC_STREAM_OVERSAMPLE 64            // Conversions averaged per reading
+#endif
+
+/**
+ * @brief One channel of the scan pattern
+ */
+typedef struct {
+    uint8_t channel;        // ADC1 channel number (ADC1_CHANNEL_x)
+    adc_atten_t atten;      // Input attenuation
+} adc_stream_channel_t;
+
+/**
+ * @brief Configure and start continuous sampling
+ * @param channels Channels to scan, in pattern order
+ * @param count Number of channels (<= ADC_STREAM_MAX_CHANNELS)
+ * @param sample_rate_hz Total conversion rate across all channels
+ * @param oversample Conversions averaged into each published reading
+ * @return true if the stream was started
+ */
+bool adc_stream_start(const adc_stream_channel_t* channels, size_t count,
+                      uint32_t sample_rate_hz, uint16_t oversample);
+
+/**
+ * @brief Stop continuous sampling
+ */
+void adc_stream_stop();
+
+/**
+ * @brief Latest decimated reading of a channel
+ * @param channel ADC1 channel number
+ * @return Mean raw value (0-4095) of the last completed block, 0 before the first
+ */
+float adc_stream_read(uint8_t channel);
+
+/**
+ * @brief Latest decimated reading of a channel in milli-counts
+ *
+ * Integer form of adc_stream_read() for the SENSOR_FIXED_POINT path; keeps
+ * the sub-LSB resolution of the oversampling without a float.
+ *
+ * @param channel ADC1 channel number
+ * @return Mean raw value x 1000 of the last completed block
+ */
+int32_t adc_stream_read_milli(uint8_t channel);
+
+/**
+ * @brief Number of decimated readings produced for a channel so far
+ *
+ * Lets control loops detect whether a fresh reading arrived since the last
+ * iteration.
+ *
+ * @param channel ADC1 channel number
+ * @return Monotonic block counter
+ */
+uint32_t adc_stream_sequence(uint8_t channel);
+
+/**
+ * @brief Raw ADC1 reading through the build's active ADC path
+ * @param channel ADC1 channel number
+ * @return Oversampled stream value, or the scheduler's latest conversion
+ */
+static inline float adc_read_raw(uint8_t channel) {
+#if ADC_STREAM_ENABLED
+    return adc_stream_read(channel);
+#else
+    return (float)adc_scheduler_read(channel);
+#endif
+}
+
+/**
+ * @brief Raw ADC1 reading as a sensor_value_t
+ *
+ * Integer counts with SENSOR_FIXED_POINT (the oversampled stream is rounded
+ * to whole counts, which the integer calibrations expect), adc_read_raw()
+ * otherwise.
+ *
+ * @param channel ADC1 channel number
+ * @return Raw reading in the build's sensor value type
+ */
+static inline sensor_value_t adc_read_value(uint8_t channel) {
+#if SENSOR_FIXED_POINT && ADC_STREAM_ENABLED
+    return (adc_stream_read_milli(channel) + 500) / 1000;
+#elif SENSOR_FIXED_POINT
+    return adc_scheduler_read(channel);
+#else
+    return adc_read_raw(channel);
+#endif
+}
+
+#endif // ADC_STREAM_H
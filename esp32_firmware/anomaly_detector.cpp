@@ -0,0 +1,247 @@
+#include "anomaly_detector.h"
+#include "actuator_task.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ANOMALY_MESSAGE_SIZE 160
+
+// Statistics in sample units: milli-units (and their squares) on the
+// fixed-point path, so the acquisition task stays off the FPU
+#if SENSOR_FIXED_POINT
+typedef int64_t anomaly_stat_t;
+#else
+typedef float anomaly_stat_t;
+#endif
+
+// Rolling statistics of one channel (acquisition task only)
+typedef struct {
+    bool seeded;                        // Has seen a sample since the last reset
+    bool flagged;                       // The previous sample was anomalous
+#if SENSOR_FIXED_POINT
+    int64_t mean_sum;                   // Mean << ANOMALY_WINDOW_SHIFT
+#else
+    float mean;
+#endif
+    anomaly_stat_t variance;
+    sensor_value_t previous;
+    int64_t previous_us;
+} channel_stats_t;
+
+// Onset handed to the network task
+typedef struct {
+    int64_t timestamp_us;
+    uint8_t channel;
+    uint8_t kind;                       // anomaly_kind_t bits
+    bool during_actuation;              // Went to the state machine instead of an alert
+    sensor_value_t value;
+    sensor_value_t mean;                // Before this sample
+    anomaly_stat_t variance;
+    sensor_value_t previous;
+    uint32_t dt_us;                     // Since the previous sample
+} anomaly_event_t;
+
+static const anomaly_detector_config_t* config = nullptr;
+static channel_stats_t stats[TELEMETRY_BATCH_MAX_FLOATS];
+static uint32_t warmup = 0;             // Samples checked since the last reset
+static std::atomic<bool> reset_pending{false};
+#if SENSOR_FIXED_POINT
+static int64_t z_limit_sq_q8[TELEMETRY_BATCH_MAX_FLOATS];   // z_limit^2 * 256
+#endif
+
+static SpscQueue<anomaly_event_t, ANOMALY_EVENT_QUEUE> events;
+
+// Network task state
+static uint32_t last_alert_ms[TELEMETRY_BATCH_MAX_FLOATS];
+static bool alerted[TELEMETRY_BATCH_MAX_FLOATS];
+static uint32_t window_end_ms = 0;
+
+// ==================== Statistics ====================
+
+static inline sensor_value_t stats_mean(const channel_stats_t* s) {
+#if SENSOR_FIXED_POINT
+    return (sensor_value_t)(s->mean_sum >> ANOMALY_WINDOW_SHIFT);
+#else
+    return s->mean;
+#endif
+}
+
+static void stats_seed(channel_stats_t* s, sensor_value_t value) {
+#if SENSOR_FIXED_POINT
+    s->mean_sum = (int64_t)value << ANOMALY_WINDOW_SHIFT;
+#else
+    s->mean = value;
+#endif
+    s->variance = 0;
+    s->seeded = true;
+}
+
+// Exponentially weighted mean and variance, alpha = 1 / ANOMALY_WINDOW_SAMPLES
+static void stats_update(channel_stats_t* s, anomaly_stat_t deviation) {
+#if SENSOR_FIXED_POINT
+    s->mean_sum += deviation;
+    s->variance = ((s->variance + ((deviation * deviation) >> ANOMALY_WINDOW_SHIFT)) *
+                   (ANOMALY_WINDOW_SAMPLES - 1)) >> ANOMALY_WINDOW_SHIFT;
+#else
+    constexpr float alpha = 1.0f / ANOMALY_WINDOW_SAMPLES;
+    s->mean += alpha * deviation;
+    s->variance = (1.0f - alpha) * (s->variance + alpha * deviation * deviation);
+#endif
+}
+
+static bool is_outlier(uint8_t channel, const channel_stats_t* s, anomaly_stat_t deviation) {
+    anomaly_stat_t magnitude = deviation < 0 ? -deviation : deviation;
+    if (config->rules[channel].z_limit <= 0.0f || magnitude <= config->deadband[channel]) {
+        return false;
+    }
+#if SENSOR_FIXED_POINT
+    return ((deviation * deviation) << 8) > z_limit_sq_q8[channel] * s->variance;
+#else
+    float z_limit = config->rules[channel].z_limit;
+    return deviation * deviation > z_limit * z_limit * s->variance;
+#endif
+}
+
+static bool is_too_fast(uint8_t channel, anomaly_stat_t change, int64_t dt_us) {
+    sensor_value_t rate_limit = config->rules[channel].rate_limit;
+    if (rate_limit <= 0 || dt_us <= 0) {
+        return false;
+    }
+    anomaly_stat_t magnitude = change < 0 ? -change : change;
+#if SENSOR_FIXED_POINT
+    return magnitude * 1000000 > (int64_t)rate_limit * dt_us;
+#else
+    return magnitude * 1e6f > rate_limit * (float)dt_us;
+#endif
+}
+
+// ==================== Acquisition Side ====================
+
+void anomaly_detector_init(const anomaly_detector_config_t* new_config) {
+    config = new_config;
+#if SENSOR_FIXED_POINT
+    for (uint8_t i = 0; i < config->channel_count; i++) {
+        float z_limit = config->rules[i].z_limit;
+        z_limit_sq_q8[i] = (int64_t)(z_limit * z_limit * 256.0f);
+    }
+#endif
+    anomaly_detector_reset();
+}
+
+uint8_t anomaly_detector_check(int64_t timestamp_us, const sensor_value_t* values) {
+    if (config == nullptr) {
+        return 0;
+    }
+    if (reset_pending.exchange(false, std::memory_order_acquire)) {
+        memset(stats, 0, sizeof(stats));
+        warmup = 0;
+    }
+    bool warm = warmup >= ANOMALY_WARMUP_SAMPLES;
+    if (!warm) {
+        warmup++;
+    }
+
+    uint8_t onsets = 0;
+    for (uint8_t i = 0; i < config->channel_count; i++) {
+        channel_stats_t* s = &stats[i];
+        sensor_value_t value = values[i];
+        if (!s->seeded) {
+            stats_seed(s, value);
+            s->previous = value;
+            s->previous_us = timestamp_us;
+            continue;
+        }
+
+        sensor_value_t mean = stats_mean(s);
+        anomaly_stat_t deviation = (anomaly_stat_t)value - mean;
+        anomaly_stat_t change = (anomaly_stat_t)value - s->previous;
+        int64_t dt_us = timestamp_us - s->previous_us;
+        uint8_t kind = 0;
+        if (warm) {
+            if (is_outlier(i, s, deviation)) {
+                kind |= ANOMALY_OUTLIER | (deviation < 0 ? ANOMALY_FALLING : 0);
+            }
+            if (is_too_fast(i, change, dt_us)) {
+                kind |= ANOMALY_RATE | (change < 0 ? ANOMALY_FALLING : 0);
+            }
+        }
+
+        anomaly_event_t event = {timestamp_us, i, kind, false, value, mean, s->variance,
+                                 s->previous, (uint32_t)(dt_us > 0 ? dt_us : 0)};
+        stats_update(s, deviation);
+        s->previous = value;
+        s->previous_us = timestamp_us;
+
+        bool onset = kind != 0 && !s->flagged;
+        s->flagged = kind != 0;
+        if (!onset) {
+            continue;
+        }
+        onsets |= (uint8_t)(1u << i);
+
+        // The state machine reacts in this tick; the network task reports later
+        if (config->busy != nullptr && config->busy()) {
+            event.during_actuation = true;
+            actuator_post(ACTUATOR_EVENT_ANOMALY, i, kind);
+        }
+        events.push(event);             // A full queue only loses the report
+    }
+    return onsets;
+}
+
+void anomaly_detector_reset() {
+    reset_pending.store(true, std::memory_order_release);
+}
+
+// ==================== Network Side ====================
+
+static void describe(const anomaly_event_t* event, char* message, size_t size) {
+    float value = SENSOR_VALUE_TO_FLOAT(event->value);
+    float deviation = value - SENSOR_VALUE_TO_FLOAT(event->mean);
+    float stddev = SENSOR_VALUE_TO_FLOAT(sqrtf((float)event->variance));
+    float change = value - SENSOR_VALUE_TO_FLOAT(event->previous);
+    float rate = event->dt_us > 0 ? change * 1e6f / (float)event->dt_us : 0.0f;
+
+    snprintf(message, size, "%s %s%s%s: value %.3f, mean %.3f, z %.1f, rate %.3f/s",
+             config->fields[event->channel],
+             (event->kind & ANOMALY_OUTLIER) ? "outlier" : "rate",
+             (event->kind & ANOMALY_OUTLIER) && (event->kind & ANOMALY_RATE) ? "+rate" : "",
+             (event->kind & ANOMALY_FALLING) ? " falling" : " rising",
+             value, SENSOR_VALUE_TO_FLOAT(event->mean),
+             stddev > 0.0f ? fabsf(deviation) / stddev : INFINITY, rate);
+}
+
+bool anomaly_detector_poll(uint32_t now_ms) {
+    if (config == nullptr) {
+        return false;
+    }
+
+    anomaly_event_t event;
+    while (events.pop(event)) {
+        // Publish the lead-up and what follows at full resolution
+        telemetry_batch_flag(config->batch, event.timestamp_us, ANOMALY_FLAG_WINDOW_MS);
+        window_end_ms = now_ms + ANOMALY_FLAG_WINDOW_MS;
+        metrics_count(METRIC_ANOMALIES, 1);
+
+        char message[ANOMALY_MESSAGE_SIZE];
+        describe(&event, message, sizeof(message));
+        if (event.during_actuation) {
+            DebugHelper::warning("Anomaly during actuation: %s", message);
+            continue;
+        }
+        uint8_t channel = event.channel;
+        if (alerted[channel] && now_ms - last_alert_ms[channel] < ANOMALY_ALERT_HOLDOFF_MS) {
+            DebugHelper::info("Anomaly (alert held off): %s", message);
+            continue;
+        }
+        alerted[channel] = true;
+        last_alert_ms[channel] = now_ms;
+        DebugHelper::warning("Anomaly: %s", message);
+        config->send_status("ALERT", message);
+    }
+    return (int32_t)(window_end_ms - now_ms) > 0;
+}
@@ -0,0 +1,113 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensor_value.h"
+#include "telemetry_batch.h"
+
+/**
+ * @file anomaly_detector.h
+ * @brief On-device anomaly detection between calibration and publishing
+ *
+ * Each filtered, calibrated sample is checked on the acquisition task
+ * against per-channel rules, so a fault is acted on in the same tick
+ * instead of after a broker round trip to the backend:
+ *
+ *  - outlier: the value is more than z_limit standard deviations from the
+ *    channel's rolling mean and further than its deadband. Mean and
+ *    variance are exponentially weighted over about ANOMALY_WINDOW_SAMPLES
+ *    samples, so a lasting step becomes the new normal after a window.
+ *  - rate: the value changed faster than rate_limit per second since the
+ *    previous sample.
+ *
+ * Checks start after ANOMALY_WARMUP_SAMPLES samples, once the filters have
+ * settled. Only the onset of an anomaly on a channel is reported:
+ *  - during an actuation or right after one (config busy()), straight to
+ *    the module's state machine as ACTUATOR_EVENT_ANOMALY (args[0] =
+ *    channel, args[1] = anomaly_kind_t bits), which decides whether it is a
+ *    safety stop or an expected transient
+ *  - otherwise as an ALERT status message from the network task, at most
+ *    one per channel every ANOMALY_ALERT_HOLDOFF_MS
+ * Either way the batch keeps every sample from its suppressed history
+ * (TELEMETRY_BATCH_HISTORY) up to ANOMALY_FLAG_WINDOW_MS after the onset,
+ * so flagged windows reach the backend at full resolution while steady
+ * readings stay on report-on-change.
+ *
+ * The counter "anomalies" counts onsets and the "anomaly_check" histogram
+ * times the check of one sample. Channel statistics are kept in RAM, so in
+ * the deep sleep power mode (one sample per boot) the detector stays in its
+ * warm-up.
+ */
+
+#define ANOMALY_WINDOW_SHIFT     4      // Rolling statistics over 2^shift samples
+#define ANOMALY_WINDOW_SAMPLES   (1 << ANOMALY_WINDOW_SHIFT)
+#define ANOMALY_WARMUP_SAMPLES   (2 * ANOMALY_WINDOW_SAMPLES)
+#define ANOMALY_EVENT_QUEUE      8      // Onsets waiting for the network task, power of two
+#ifndef ANOMALY_FLAG_WINDOW_MS
+#define ANOMALY_FLAG_WINDOW_MS   10000  // Full-resolution telemetry after an onset
+#endif
+#ifndef ANOMALY_ALERT_HOLDOFF_MS
+#define ANOMALY_ALERT_HOLDOFF_MS 10000  // Between ALERT messages of one channel
+#endif
+
+/**
+ * @brief What was detected (bits)
+ */
+typedef enum {
+    ANOMALY_OUTLIER = 0x01,             // Beyond z_limit of the rolling statistics
+    ANOMALY_RATE    = 0x02,             // Faster than rate_limit
+    ANOMALY_FALLING = 0x04              // Below the mean / decreasing
+} anomaly_kind_t;
+
+/**
+ * @brief Limits of one channel; a zero limit disables that check
+ */
+typedef struct {
+    float z_limit;                      // Standard deviations from the rolling mean
+    sensor_value_t rate_limit;          // Change per second, sample units
+} anomaly_rule_t;
+
+/**
+ * @brief Module binding
+ */
+typedef struct {
+    uint8_t channel_count;              // <= TELEMETRY_BATCH_MAX_FLOATS
+    const anomaly_rule_t* rules;        // Per channel
+    const sensor_value_t* deadband;     // Per channel, smallest outlier deviation
+    const char* const* fields;          // Per channel, for alerts
+    telemetry_batch_t* batch;           // Publishes the flagged windows
+    bool (*busy)();                     // Actuation running or settling: onsets go
+                                        // to the state machine
+    void (*send_status)(const char* state, const char* message);
+} anomaly_detector_config_t;
+
+/**
+ * @brief Bind the detector to the module (before sampling starts)
+ * @param config Module binding (must stay valid)
+ */
+void anomaly_detector_init(const anomaly_detector_config_t* config);
+
+/**
+ * @brief Check one calibrated sample (acquisition task)
+ * @param timestamp_us Acquisition time of the sample
+ * @param values config->channel_count values
+ * @return Channels whose anomaly started with this sample, bit i = channel i
+ */
+uint8_t anomaly_detector_check(int64_t timestamp_us, const sensor_value_t* values);
+
+/**
+ * @brief Alerts and flagged windows (network task, before draining samples)
+ * @param now_ms Monotonic time in milliseconds
+ * @return true while a flagged window is open (stay awake)
+ */
+bool anomaly_detector_poll(uint32_t now_ms);
+
+/**
+ * @brief Forget the channel statistics (warm up again), e.g. after a
+ *        calibration change
+ */
+void anomaly_detector_reset();
+
+#endif // ANOMALY_DETECTOR_H
@@ -7,23 +7,15 @@
  * and system pressure monitoring for precise repair solution application.
  */
 
-#include "mqtt_helper.h"
+#include "module_runtime.h"
 #include "debug_helper.h"
-#include "sensor_filter_c.h"
 #include "sensor_calibration.h"
+#include "telemetry_frame.h"
+#include "actuator_task.h"
 #include <cJSON.h>
 #include <driver/ledc.h>
 #include <driver/adc.h>
-#include <esp_adc_cal.h>
 #include <driver/gpio.h>
-#include <esp_timer.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-
-// Sensor filter instances for noise reduction
-sensor_filter_t pressureFilter;
-sensor_filter_t flowFilter;
-sensor_filter_t tankLevelFilter;
 
 // ==================== Hardware Configuration ====================
 #define NOZZLE_PIN         12    // Spray nozzle control pin
@@ -36,70 +28,91 @@ sensor_filter_t tankLevelFilter;
 #define PWM_FREQ 5000
 #define PWM_RESOLUTION LEDC_TIMER_8_BIT
 
-// ==================== Network Configuration ====================
-const char* WIFI_SSID = "Your_WiFi_SSID";
-const char* WIFI_PASS = "Your_WiFi_Password";
-const char* MQTT_BROKER = "192.168.1.100";
-const int   MQTT_PORT = 1883;
+#ifndef SAMPLE_PERIOD_MS
+#define SAMPLE_PERIOD_MS   1000   // Acquisition period (1 Hz)
+#endif
+#define ACTIVE_SAMPLE_PERIOD_MS 100  // Acquisition period while actuating (10 Hz)
+
+// Spray sensors (filter chosen per channel; field order is the telemetry
+// field order shared by JSON and binary payloads)
+enum { CHANNEL_FLOW, CHANNEL_TANK_LEVEL, CHANNEL_PRESSURE };
+static const module_channel_t SENSOR_CHANNELS[] = {
+    {   // CHANNEL_FLOW: low-lag smoothing; a collapse while spraying is a pressure loss
+        .field = "flow_rate", .calibration_name = "flow",
+        .source = MODULE_SOURCE_ADC, .pin = FLOW_SENSOR_PIN,
+        .filter = MODULE_FILTER_EMA,
+        .default_curve = &CALIBRATION_DEFAULT_FLOW,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(1.0f),      // 1 L/min
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(100.0f)},  // L/min per s
+    },
+    {   // CHANNEL_TANK_LEVEL: slow level, rejects sloshing; a fast drop is a leak
+        .field = "tank_level", .calibration_name = "tank_level",
+        .source = MODULE_SOURCE_ADC, .pin = TANK_LEVEL_PIN,
+        .filter = MODULE_FILTER_KALMAN, .process_variance = 1e-4f, .measurement_variance = 1e-1f,
+        .default_curve = &CALIBRATION_DEFAULT_FLOW,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(1.0f),      // 1 %
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(5.0f)},    // % per s
+    },
+    {   // CHANNEL_PRESSURE: debounces the digital pressure switch (its edge
+        // interrupt already stops spraying, so it has no anomaly limits)
+        .field = "system_pressure", .calibration_name = "pressure",
+        .source = MODULE_SOURCE_GPIO, .pin = PRESSURE_PIN,
+        .filter = MODULE_FILTER_MEDIAN,
+        .default_curve = &CALIBRATION_DEFAULT_PRESSURE,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(1.0f),      // 1 kPa
+    },
+};
 
-// MQTT Topics for communication with central control system
-const char* TOPIC_COMMAND = "exoskeleton/bubble/command";
-const char* TOPIC_STATUS = "exoskeleton/bubble/status";
-const char* TOPIC_SENSORS = "exoskeleton/bubble/sensors";
+// Actuator state machine (runs on the actuator task)
+enum { EVENT_SPRAY = ACTUATOR_EVENT_USER };
+typedef enum { SPRAY_IDLE, SPRAY_ACTIVE } spray_state_t;
+static spray_state_t actuatorState = SPRAY_IDLE;
 
 // ==================== Function Declarations ====================
 void app_main();
-void bubble_task(void *pvParameter);
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length);
-void publishSensorData();
-void processCommand(cJSON* command);
+void handleSpray(const cJSON* params);
 void sprayBubbles(int duration, int intensity);
-void sendStatus(const char* state, const char* message);
+void sprayStateMachine(const actuator_event_t* event);
 void initializeHardware();
 
+// Module commands (the runtime adds the ones listed in module_runtime.h)
+static const command_entry_t COMMANDS[] = {
+    {"spray", handleSpray},
+};
+
+static const module_descriptor_t BUBBLE_MODULE = {
+    .name = "bubble",
+    .client_id = "BubbleMachineClient",
+    .telemetry_id = TELEMETRY_MODULE_BUBBLE,
+    .channels = SENSOR_CHANNELS,
+    .channel_count = sizeof(SENSOR_CHANNELS) / sizeof(SENSOR_CHANNELS[0]),
+    .flags = NULL,
+    .flag_count = 0,
+    .commands = COMMANDS,
+    .command_count = sizeof(COMMANDS) / sizeof(COMMANDS[0]),
+    .state_machine = sprayStateMachine,
+    .init_hardware = initializeHardware,
+    .sample_period_ms = SAMPLE_PERIOD_MS,
+    .active_sample_period_ms = ACTIVE_SAMPLE_PERIOD_MS,
+    .power_mode = POWER_MODE,
+};
+
 // ==================== Main Program ====================
 void app_main() {
-    DebugHelper::initialize();
-    
-    // Initialize sensor filters for noise reduction
-    sensor_filter_init(&pressureFilter);
-    sensor_filter_init(&flowFilter);
-    sensor_filter_init(&tankLevelFilter);
-    
-    // Initialize hardware peripherals
-    initializeHardware();
-    
-    // Initialize MQTT helper with network credentials
-    mqtt_helper_init(WIFI_SSID, WIFI_PASS, MQTT_BROKER, MQTT_PORT, 
-                    "BubbleMachineClient", mqttCallback);
-    
-    // Connect to WiFi and MQTT broker
-    if (mqtt_helper_connect_wifi() && mqtt_helper_connect_broker()) {
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-    }
-    
-    DebugHelper::info("Bubble machine module initialization complete");
-    sendStatus("IDLE", "System startup");
-    
-    // Create main task for continuous operation
-    xTaskCreate(bubble_task, "bubble_task", 4096, NULL, 5, NULL);
+    module_start(&BUBBLE_MODULE);
 }
 
 void initializeHardware() {
-    // Configure ADC for sensor readings
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(FLOW_SENSOR_PIN, ADC_ATTEN_DB_0);
-    adc1_config_channel_atten(TANK_LEVEL_PIN, ADC_ATTEN_DB_0);
-    
-    // Configure pressure sensor GPIO as input
+    // Configure pressure sensor GPIO as input, interrupting on pressure loss
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << PRESSURE_PIN),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+        .intr_type = GPIO_INTR_NEGEDGE
     };
     gpio_config(&io_conf);
+    actuator_watch_gpio(PRESSURE_PIN);
     
     // Configure spray nozzle PWM
     ledc_timer_config_t ledc_timer = {
@@ -122,147 +135,92 @@ void initializeHardware() {
     ledc_channel_config(&ledc_channel);
 }
 
-void bubble_task(void *pvParameter) {
-    while (1) {
-        // Process MQTT messages
-        mqtt_helper_loop();
-        
-        static unsigned long lastUpdate = 0;
-        unsigned long current_time = (unsigned long)(esp_timer_get_time() / 1000);
-        if (current_time - lastUpdate > 1000) { // Update sensor data every second
-            publishSensorData();
-            lastUpdate = current_time;
-        }
-        
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+// ==================== Command Processing ====================
+void handleSpray(const cJSON* params) {
+    cJSON* duration = cJSON_GetObjectItem(params, "duration");
+    cJSON* intensity = cJSON_GetObjectItem(params, "intensity");
+    
+    if (cJSON_IsNumber(duration) && cJSON_IsNumber(intensity)) {
+        sprayBubbles(duration->valueint, intensity->valueint);
     }
 }
 
-// ==================== MQTT Callback ====================
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
-            // Handle internal resubscription message for connection recovery
-        if (strcmp(topic, "internal/resubscribe") == 0) {
-            DebugHelper::info("Resubscribing to topic: %s", TOPIC_COMMAND);
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-        return;
-    }
-    
-    // Create null-terminated string from payload
-    char* json_string = (char*)malloc(length + 1);
-    memcpy(json_string, payload, length);
-    json_string[length] = '\0';
-    
-    // Parse JSON command
-    cJSON* json = cJSON_Parse(json_string);
-    free(json_string);
-    
-    if (json == NULL) {
-        DebugHelper::error("JSON parsing failed");
-        return;
-    }
-    
-    // Process command
-    if (strcmp(topic, TOPIC_COMMAND) == 0) {
-        processCommand(json);
-    }
-    
-    cJSON_Delete(json);
+// ==================== Spray Control ====================
+// Spraying runs as a state machine on the actuator task: the command posts
+// an event and returns, the duration timer or a pressure drop ends it.
+void sprayBubbles(int duration, int intensity) {
+    actuator_post(EVENT_SPRAY, duration, intensity);
 }
 
-// ==================== Sensor Data Publishing ====================
-void publishSensorData() {
-    // Create JSON object for sensor readings
-    cJSON* json = cJSON_CreateObject();
-    
-    // Read raw sensor values
-    float rawPressure = gpio_get_level(PRESSURE_PIN);
-    float rawFlow = adc1_get_raw(FLOW_SENSOR_PIN);
-    float rawTank = adc1_get_raw(TANK_LEVEL_PIN);
-    
-    // Apply filtering for noise reduction
-    sensor_filter_add_value(&pressureFilter, rawPressure);
-    sensor_filter_add_value(&flowFilter, rawFlow);
-    sensor_filter_add_value(&tankLevelFilter, rawTank);
-    
-    // Calibrate sensor readings to real-world units
-    float calibratedPressure = calibrate_pressure(sensor_filter_get_filtered(&pressureFilter));
-    float calibratedFlow = calibrate_flow(sensor_filter_get_filtered(&flowFilter));
-    float calibratedTank = calibrate_flow(sensor_filter_get_filtered(&tankLevelFilter));
-    
-    // Add sensor data to JSON
-    cJSON_AddNumberToObject(json, "flow_rate", calibratedFlow);
-    cJSON_AddNumberToObject(json, "tank_level", calibratedTank);
-    cJSON_AddNumberToObject(json, "system_pressure", calibratedPressure);
-    
-    // Serialize and publish sensor data
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_SENSORS, json_string);
+static void endSpray() {
+    // Stop spraying - turn off nozzle
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL, 0);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL);
+    actuator_cancel_timers();
+    actuatorState = SPRAY_IDLE;
     
-    free(json_string);
-    cJSON_Delete(json);
+    DebugHelper::info("Spraying operation completed");
+    module_send_status("COMPLETED", "Spraying completed");
 }
 
-// ==================== Command Processing ====================
-void processCommand(cJSON* command) {
-    cJSON* action = cJSON_GetObjectItem(command, "action");
-    
-    if (cJSON_IsString(action) && strcmp(action->valuestring, "spray") == 0) {
-        cJSON* params = cJSON_GetObjectItem(command, "params");
-        cJSON* duration = cJSON_GetObjectItem(params, "duration");
-        cJSON* intensity = cJSON_GetObjectItem(params, "intensity");
-        
-        if (cJSON_IsNumber(duration) && cJSON_IsNumber(intensity)) {
-            sprayBubbles(duration->valueint, intensity->valueint);
-        }
+static void checkPressure() {
+    // Check if system pressure is adequate
+    int pressure = gpio_get_level(PRESSURE_PIN);
+    if (actuatorState == SPRAY_ACTIVE && pressure == 0) { // Pressure too low
+        DebugHelper::error("Insufficient system pressure: %d", pressure);
+        module_send_status("ERROR", "Insufficient system pressure");
+        endSpray();
     }
 }
 
-// ==================== Spray Control ====================
-void sprayBubbles(int duration, int intensity) {
+static void checkAnomaly(int channel, int kind) {
+    // Flow collapsing mid-spray: the line lost pressure or the tank ran dry
+    if (actuatorState == SPRAY_ACTIVE && channel == CHANNEL_FLOW && (kind & ANOMALY_FALLING)) {
+        DebugHelper::error("Flow rate dropped while spraying");
+        module_send_status("ERROR", "Flow lost while spraying");
+        endSpray();
+    }
+}
+
+static void beginSpray(int duration, int intensity) {
     DebugHelper::info("Spraying repair solution - Duration: %dms, Intensity: %d%%", duration, intensity);
-    sendStatus("SPRAYING", "Spraying repair solution...");
+    module_send_status("SPRAYING", "Spraying repair solution...");
     
     // Adjust nozzle intensity based on target (PWM control)
     int pwmValue = (intensity * 255) / 100;  // Map 0-100% to 0-255 PWM range
     ledc_set_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL, pwmValue);
     ledc_update_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL);
     
-    // Record start time for duration monitoring
-    unsigned long startTime = (unsigned long)(esp_timer_get_time() / 1000);
-    
-    // Monitor spraying process with safety checks
-    while ((unsigned long)(esp_timer_get_time() / 1000) - startTime < duration) {
-        // Check if system pressure is adequate
-        int pressure = gpio_get_level(PRESSURE_PIN);
-        if (pressure == 0) { // Pressure too low
-            DebugHelper::error("Insufficient system pressure: %d", pressure);
-            sendStatus("ERROR", "Insufficient system pressure");
+    // Spray for the requested duration; the pressure interrupt aborts early
+    actuatorState = SPRAY_ACTIVE;
+    actuator_set_timeout(duration > 0 ? duration : 0);
+    checkPressure();
+}
+
+void sprayStateMachine(const actuator_event_t* event) {
+    switch (event->type) {
+        case EVENT_SPRAY:
+            if (actuatorState != SPRAY_IDLE) {
+                DebugHelper::warning("Spraying in progress, command ignored");
+                module_send_status("SPRAYING", "Command ignored, spraying in progress");
+                break;
+            }
+            beginSpray(event->args[0], event->args[1]);
+            break;
+        
+        case ACTUATOR_EVENT_GPIO:
+            checkPressure();
+            break;
+        
+        case ACTUATOR_EVENT_ANOMALY:
+            checkAnomaly(event->args[0], event->args[1]);
             break;
-        }
         
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        case ACTUATOR_EVENT_TIMEOUT:
+            if (actuatorState == SPRAY_ACTIVE) {
+                endSpray();
+            }
+            break;
     }
-    
-    // Stop spraying - turn off nozzle
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL, 0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, NOZZLE_PWM_CHANNEL);
-    DebugHelper::info("Spraying operation completed");
-    sendStatus("COMPLETED", "Spraying completed");
 }
 
-// ==================== Status Reporting ====================
-void sendStatus(const char* state, const char* message) {
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddStringToObject(json, "module", "bubble");
-    cJSON_AddStringToObject(json, "state", state);
-    cJSON_AddStringToObject(json, "message", message);
-    cJSON_AddNumberToObject(json, "timestamp", (unsigned long)(esp_timer_get_time() / 1000));
-    
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_STATUS, json_string);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    
-    DebugHelper::info("Status report: %s - %s", state, message);
-}
@@ -0,0 +1,248 @@
+#include "calibration_table.h"
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <nvs.h>
+
+static const char* NVS_NAMESPACE = "calibration";
+
+// Next update's table (network task); a retired table takes its place
+static sensor_value_t* spare = nullptr;
+
+// ==================== Curve Evaluation ====================
+
+// Linear interpolation through (x[i], y[i]), extrapolating the end segments
+static double interpolate(const float* x, const float* y, uint8_t count, double raw) {
+    uint8_t i = 1;
+    while (i < count - 1 && raw > x[i]) {
+        i++;
+    }
+    double x0 = x[i - 1], x1 = x[i];
+    double y0 = y[i - 1], y1 = y[i];
+    return y0 + (raw - x0) * (y1 - y0) / (x1 - x0);
+}
+
+static double evaluate(const calibration_curve_t* curve, double raw) {
+    switch (curve->type) {
+        case CALIBRATION_CURVE_LINEAR:
+        case CALIBRATION_CURVE_POLYNOMIAL: {
+            // Horner's rule, highest coefficient first
+            double y = 0;
+            for (int i = curve->count - 1; i >= 0; i--) {
+                y = y * raw + curve->coefficients[i];
+            }
+            return y;
+        }
+        case CALIBRATION_CURVE_PIECEWISE:
+            return interpolate(curve->point_x, curve->point_y, curve->count, raw);
+        case CALIBRATION_CURVE_LUT: {
+            double step = (double)(CALIBRATION_TABLE_SIZE - 1) / (curve->count - 1);
+            double position = raw / step;
+            int index = (int)position;
+            if (index >= curve->count - 1) {
+                return curve->point_y[curve->count - 1];
+            }
+            double frac = position - index;
+            return curve->point_y[index] + frac * (curve->point_y[index + 1] - curve->point_y[index]);
+        }
+        default:
+            return 0;
+    }
+}
+
+static void expand(const calibration_curve_t* curve, sensor_value_t* table) {
+    for (int raw = 0; raw < CALIBRATION_TABLE_SIZE; raw++) {
+        double y = evaluate(curve, raw);
+#if SENSOR_FIXED_POINT
+        table[raw] = (sensor_value_t)lround(y * 1000.0);
+#else
+        table[raw] = (sensor_value_t)y;
+#endif
+    }
+}
+
+// Expand a curve into the spare and swap it in as the channel's table
+static bool publish(calibration_channel_t* channel, const calibration_curve_t* curve) {
+    if (spare == nullptr) {
+        DebugHelper::error("Calibration %s: no spare table", channel->name);
+        return false;
+    }
+    expand(curve, spare);
+    spare = channel->table.exchange(spare, std::memory_order_acq_rel);
+    channel->curve = *curve;
+    return true;
+}
+
+bool calibration_validate(const calibration_curve_t* curve) {
+    switch (curve->type) {
+        case CALIBRATION_CURVE_LINEAR:
+            return curve->count == 2;
+        case CALIBRATION_CURVE_POLYNOMIAL:
+            return curve->count >= 1 && curve->count <= CALIBRATION_MAX_COEFFS;
+        case CALIBRATION_CURVE_PIECEWISE:
+            if (curve->count < 2 || curve->count > CALIBRATION_MAX_POINTS) {
+                return false;
+            }
+            for (uint8_t i = 1; i < curve->count; i++) {
+                if (!(curve->point_x[i] > curve->point_x[i - 1])) {
+                    return false;
+                }
+            }
+            return true;
+        case CALIBRATION_CURVE_LUT:
+            return curve->count >= 2 && curve->count <= CALIBRATION_MAX_POINTS;
+        default:
+            return false;
+    }
+}
+
+// ==================== Persistence ====================
+
+static bool load_curve(const char* name, calibration_curve_t* curve) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(*curve);
+    esp_err_t ret = nvs_get_blob(nvs_handle, name, curve, &size);
+    nvs_close(nvs_handle);
+    return ret == ESP_OK && size == sizeof(*curve) && calibration_validate(curve);
+}
+
+static bool save_curve(const char* name, const calibration_curve_t* curve) {
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret == ESP_OK) {
+        ret = curve != nullptr ? nvs_set_blob(nvs_handle, name, curve, sizeof(*curve))
+                               : nvs_erase_key(nvs_handle, name);
+        if (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    return ret == ESP_OK;
+}
+
+// ==================== Channel API ====================
+
+bool calibration_init(calibration_channel_t* channel, const char* name,
+                      const calibration_curve_t* default_curve) {
+    channel->name = name;
+    channel->default_curve = default_curve;
+
+    bool loaded = load_curve(name, &channel->curve);
+    if (!loaded) {
+        channel->curve = *default_curve;
+    }
+    expand(&channel->curve, channel->storage);
+    channel->table.store(channel->storage, std::memory_order_release);
+    if (spare == nullptr) {
+        spare = new (std::nothrow) sensor_value_t[CALIBRATION_TABLE_SIZE];
+    }
+
+    DebugHelper::info("Calibration %s: %s curve (type %u)", name,
+                      loaded ? "saved" : "default", (unsigned)channel->curve.type);
+    return loaded;
+}
+
+bool calibration_set_curve(calibration_channel_t* channel, const calibration_curve_t* curve,
+                           bool persist) {
+    if (!calibration_validate(curve)) {
+        DebugHelper::warning("Calibration %s: invalid curve rejected", channel->name);
+        return false;
+    }
+
+    if (!publish(channel, curve)) {
+        return false;
+    }
+
+    if (persist && !save_curve(channel->name, curve)) {
+        DebugHelper::warning("Calibration %s: failed to save curve", channel->name);
+    }
+    DebugHelper::info("Calibration %s updated (type %u)", channel->name, (unsigned)curve->type);
+    return true;
+}
+
+void calibration_reset(calibration_channel_t* channel) {
+    if (!publish(channel, channel->default_curve)) {
+        return;
+    }
+    save_curve(channel->name, nullptr);
+    DebugHelper::info("Calibration %s reset to default", channel->name);
+}
+
+// ==================== Command Parsing ====================
+
+static uint8_t parse_floats(const cJSON* array, float* dst, size_t max) {
+    uint8_t count = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, array) {
+        if (count == max || !cJSON_IsNumber(item)) {
+            return 0;
+        }
+        dst[count++] = (float)cJSON_GetNumberValue(item);
+    }
+    return count;
+}
+
+static bool parse_curve(const cJSON* params, calibration_curve_t* curve) {
+    const char* type = cJSON_GetStringValue(cJSON_GetObjectItem(params, "type"));
+    if (type == nullptr) {
+        return false;
+    }
+
+    memset(curve, 0, sizeof(*curve));
+    if (strcmp(type, "linear") == 0 || strcmp(type, "polynomial") == 0) {
+        curve->type = type[0] == 'l' ? CALIBRATION_CURVE_LINEAR : CALIBRATION_CURVE_POLYNOMIAL;
+        curve->count = parse_floats(cJSON_GetObjectItem(params, "coefficients"),
+                                    curve->coefficients, CALIBRATION_MAX_COEFFS);
+    } else if (strcmp(type, "lut") == 0) {
+        curve->type = CALIBRATION_CURVE_LUT;
+        curve->count = parse_floats(cJSON_GetObjectItem(params, "values"),
+                                    curve->point_y, CALIBRATION_MAX_POINTS);
+    } else if (strcmp(type, "piecewise") == 0) {
+        curve->type = CALIBRATION_CURVE_PIECEWISE;
+        const cJSON* point;
+        cJSON_ArrayForEach(point, cJSON_GetObjectItem(params, "points")) {
+            float xy[2];
+            if (curve->count == CALIBRATION_MAX_POINTS || parse_floats(point, xy, 2) != 2) {
+                return false;
+            }
+            curve->point_x[curve->count] = xy[0];
+            curve->point_y[curve->count] = xy[1];
+            curve->count++;
+        }
+    } else {
+        return false;
+    }
+    return calibration_validate(curve);
+}
+
+bool calibration_handle_command(calibration_channel_t* const* channels, size_t count,
+                                const cJSON* params) {
+    const char* name = cJSON_GetStringValue(cJSON_GetObjectItem(params, "channel"));
+    calibration_channel_t* channel = nullptr;
+    for (size_t i = 0; name != nullptr && i < count; i++) {
+        if (strcmp(channels[i]->name, name) == 0) {
+            channel = channels[i];
+            break;
+        }
+    }
+    if (channel == nullptr) {
+        DebugHelper::warning("Calibration: unknown channel");
+        return false;
+    }
+
+    const char* type = cJSON_GetStringValue(cJSON_GetObjectItem(params, "type"));
+    if (type != nullptr && strcmp(type, "default") == 0) {
+        calibration_reset(channel);
+        return true;
+    }
+
+    calibration_curve_t curve;
+    if (!parse_curve(params, &curve)) {
+        DebugHelper::warning("Calibration %s: malformed curve", channel->name);
+        return false;
+    }
+    return calibration_set_curve(channel, &curve, true);
+}
@@ -0,0 +1,158 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+#include <atomic>
+#include "debug_helper.h"
+#include "sensor_value.h"
+
+/**
+ * @file calibration_table.h
+ * @brief Table-driven sensor calibration with NVS-persisted curves
+ *
+ * Each calibrated channel is described by a small curve descriptor (linear,
+ * polynomial, piecewise linear or evenly spaced lookup points). At boot the
+ * descriptor saved in NVS, or the channel's compiled-in default, is expanded
+ * into a CALIBRATION_TABLE_SIZE entry table indexed by the raw 12-bit ADC
+ * value, so calibrating a sample is a single table read. A new curve can be
+ * sent over MQTT ("calibrate" command) and is persisted, so field
+ * recalibration needs no reflash.
+ *
+ * Curves are always specified in engineering units (°C, kPa, ...); with
+ * SENSOR_FIXED_POINT the table holds the matching milli-units.
+ *
+ * An update expands the new curve into a spare table and then swaps it in
+ * with one pointer store, so the acquisition task and the control loops
+ * never see a half-written curve. The table it replaces becomes the spare
+ * for the next update, of any channel; a reader holds the pointer only for
+ * one calibration_apply(), far shorter than an expansion plus a command
+ * round trip. The spare is allocated with the first channel's table.
+ */
+
+#define CALIBRATION_TABLE_SIZE   4096   // 12-bit ADC range
+#define CALIBRATION_MAX_COEFFS   8      // Polynomial degree + 1
+#define CALIBRATION_MAX_POINTS   16     // Piecewise / lookup points
+#define CALIBRATION_NAME_MAX     15     // NVS key limit
+
+/**
+ * @brief Curve kinds
+ */
+typedef enum {
+    CALIBRATION_CURVE_LINEAR = 0,       // y = c0 + c1 x
+    CALIBRATION_CURVE_POLYNOMIAL = 1,   // y = c0 + c1 x + c2 x² + ...
+    CALIBRATION_CURVE_PIECEWISE = 2,    // Linear interpolation between (x, y) points
+    CALIBRATION_CURVE_LUT = 3           // y points evenly spaced over the ADC range
+} calibration_curve_type_t;
+
+/**
+ * @brief Curve descriptor (stored verbatim in NVS)
+ */
+typedef struct {
+    uint8_t type;                                   // calibration_curve_type_t
+    uint8_t count;                                  // Coefficients or points used
+    float coefficients[CALIBRATION_MAX_COEFFS];     // LINEAR / POLYNOMIAL, c0 first
+    float point_x[CALIBRATION_MAX_POINTS];          // PIECEWISE raw values, ascending
+    float point_y[CALIBRATION_MAX_POINTS];          // PIECEWISE / LUT outputs
+} calibration_curve_t;
+
+/**
+ * @brief One calibrated channel and its expanded table
+ */
+typedef struct {
+    const char* name;                               // Channel name and NVS key
+    const calibration_curve_t* default_curve;       // Used when nothing is saved
+    calibration_curve_t curve;                      // Active descriptor (network task)
+    std::atomic<sensor_value_t*> table;             // Expanded curve: storage or a former spare
+    sensor_value_t storage[CALIBRATION_TABLE_SIZE];
+} calibration_channel_t;
+
+/**
+ * @brief Load a channel's curve from NVS (or its default) and expand it
+ *
+ * Requires NVS to be initialised (DebugHelper::initialize()).
+ *
+ * @param channel Pointer to channel state
+ * @param name Channel name, also the NVS key (<= CALIBRATION_NAME_MAX chars)
+ * @param default_curve Curve used when none is saved or the saved one is invalid
+ * @return true if a saved curve was loaded, false if the default is in use
+ */
+bool calibration_init(calibration_channel_t* channel, const char* name,
+                      const calibration_curve_t* default_curve);
+
+/**
+ * @brief Replace a channel's curve, expanding it into the spare table
+ * @param channel Pointer to channel state
+ * @param curve New curve descriptor
+ * @param persist Save the curve to NVS
+ * @return true if the curve was valid and applied, false if invalid or
+ *         there is no spare table
+ */
+bool calibration_set_curve(calibration_channel_t* channel, const calibration_curve_t* curve,
+                           bool persist);
+
+/**
+ * @brief Revert a channel to its default curve and erase the saved one
+ * @param channel Pointer to channel state
+ */
+void calibration_reset(calibration_channel_t* channel);
+
+/**
+ * @brief Check a curve descriptor for consistency
+ * @param curve Curve descriptor
+ * @return true if the curve can be expanded
+ */
+bool calibration_validate(const calibration_curve_t* curve);
+
+/**
+ * @brief Apply a "calibrate" command to one of a module's channels
+ *
+ * Parameters: {"channel": name, "type": "linear"|"polynomial"|"piecewise"|
+ * "lut"|"default", "coefficients": [c0, c1, ...], "points": [[x, y], ...],
+ * "values": [y0, y1, ...]}. "default" restores the compiled-in curve.
+ *
+ * @param channels The module's calibrated channels
+ * @param count Number of channels
+ * @param params Command parameters object
+ * @return true if a channel was recalibrated
+ */
+bool calibration_handle_command(calibration_channel_t* const* channels, size_t count,
+                                const cJSON* params);
+
+/**
+ * @brief Calibrate a raw reading
+ *
+ * Fixed-point builds index the table directly; float builds interpolate
+ * between neighbouring entries to keep the oversampled sub-LSB resolution.
+ *
+ * @param channel Pointer to channel state
+ * @param raw Filtered raw ADC value
+ * @return Calibrated value in the channel's units
+ */
+static inline sensor_value_t calibration_apply(const calibration_channel_t* channel,
+                                               sensor_value_t raw) {
+    const sensor_value_t* table = channel->table.load(std::memory_order_acquire);
+    sensor_value_t calibrated;
+    if (raw <= 0) {
+        calibrated = table[0];
+    } else if (raw >= CALIBRATION_TABLE_SIZE - 1) {
+        calibrated = table[CALIBRATION_TABLE_SIZE - 1];
+    } else {
+#if SENSOR_FIXED_POINT
+        calibrated = table[raw];
+#else
+        int index = (int)raw;
+        float frac = raw - index;
+        calibrated = table[index] + frac * (table[index + 1] - table[index]);
+#endif
+    }
+#if DEBUG_LEVEL >= DEBUG_LEVEL_VERBOSE
+    DebugHelper::logCalibration(channel->name, SENSOR_VALUE_TO_FLOAT(raw),
+                                SENSOR_VALUE_TO_FLOAT(calibrated));
+#endif
+    return calibrated;
+}
+
+#endif // CALIBRATION_TABLE_H
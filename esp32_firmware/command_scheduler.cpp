@@ -0,0 +1,287 @@
+#include "command_scheduler.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "json_arena.h"
+#include "json_writer.h"
+#include "time_sync.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    STEP_PENDING,
+    STEP_RUNNING,
+    STEP_DONE,
+    STEP_SKIPPED
+} step_phase_t;
+
+typedef struct {
+    uint8_t command;                    // Command table index
+    uint8_t phase;                      // step_phase_t
+    uint32_t at_ms;                     // Earliest start, from batch arrival
+    uint32_t start_ms;                  // Actual start, from batch arrival
+    uint32_t duration_ms;
+    char params[COMMAND_SCHEDULER_PARAMS_SIZE];     // "" for none
+    char state[16];                     // Last status reported by the step
+    char message[48];
+} scheduled_step_t;
+
+static const command_scheduler_config_t* scheduler_config = nullptr;
+
+// Network task only, except where noted
+static scheduled_step_t steps[COMMAND_SCHEDULER_LENGTH];
+static size_t step_count = 0;
+static size_t current = 0;              // Step running or next to run
+static uint32_t batch_start_ms = 0;
+static bool stop_on_error = true;
+static bool cancelled = false;
+static char batch_id[24];
+static char report[COMMAND_SCHEDULER_REPORT_SIZE];
+
+// Shared with capture_status() on any task
+static bool active = false;
+static int captured_step = -1;          // Step running, receives its status reports
+static TaskHandle_t handler_task = nullptr;     // Network task while a step's handler runs
+static TaskHandle_t network_task = nullptr;
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void copy_text(char* dst, size_t size, const char* src) {
+    strncpy(dst, src != nullptr ? src : "", size - 1);
+    dst[size - 1] = '\0';
+}
+
+void command_scheduler_init(const command_scheduler_config_t* config) {
+    scheduler_config = config;
+}
+
+bool command_scheduler_active() {
+    return active;
+}
+
+// ==================== Queueing ====================
+
+static bool queue_step(scheduled_step_t* step, const cJSON* command) {
+    const char* action = cJSON_GetStringValue(cJSON_GetObjectItem(command, "action"));
+    if (action == nullptr || strcmp(action, COMMAND_SCHEDULER_ACTION) == 0) {
+        DebugHelper::warning("Batch: step without a valid action");
+        return false;
+    }
+    int index = command_table_find(scheduler_config->table, action);
+    if (index < 0) {
+        DebugHelper::warning("Batch: unknown command %s", action);
+        return false;
+    }
+
+    *step = {};
+    step->command = (uint8_t)index;
+    cJSON* at = cJSON_GetObjectItem(command, "at_ms");
+    step->at_ms = cJSON_IsNumber(at) && at->valuedouble > 0 ? (uint32_t)at->valuedouble : 0;
+
+    // Params outlive the message, so they are kept as text and parsed again to run
+    cJSON* params = cJSON_GetObjectItem(command, "params");
+    if (params != nullptr &&
+        !cJSON_PrintPreallocated(params, step->params, sizeof(step->params), false)) {
+        DebugHelper::warning("Batch: %s params exceed %u bytes", action,
+                             (unsigned)COMMAND_SCHEDULER_PARAMS_SIZE);
+        return false;
+    }
+    return true;
+}
+
+bool command_scheduler_handle_command(const cJSON* params) {
+    if (cJSON_IsTrue(cJSON_GetObjectItem(params, "cancel"))) {
+        if (!active) {
+            return false;
+        }
+        cancelled = true;
+        DebugHelper::info("Batch %s cancelled", batch_id);
+        return true;
+    }
+    if (active) {
+        DebugHelper::warning("Batch ignored, batch %s in progress", batch_id);
+        return false;
+    }
+
+    cJSON* commands = cJSON_GetObjectItem(params, "commands");
+    int count = cJSON_GetArraySize(commands);
+    if (!cJSON_IsArray(commands) || count == 0 || count > COMMAND_SCHEDULER_LENGTH) {
+        DebugHelper::warning("Batch needs 1 to %u commands", (unsigned)COMMAND_SCHEDULER_LENGTH);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!queue_step(&steps[i], cJSON_GetArrayItem(commands, i))) {
+            return false;
+        }
+    }
+
+    copy_text(batch_id, sizeof(batch_id), cJSON_GetStringValue(cJSON_GetObjectItem(params, "id")));
+    stop_on_error = !cJSON_IsFalse(cJSON_GetObjectItem(params, "stop_on_error"));
+    cancelled = false;
+    step_count = (size_t)count;
+    current = 0;
+    batch_start_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL(&status_lock);
+    captured_step = -1;
+    network_task = xTaskGetCurrentTaskHandle();
+    active = true;
+    portEXIT_CRITICAL(&status_lock);
+
+    DebugHelper::info("Batch %s queued: %u commands", batch_id, (unsigned)count);
+    return true;
+}
+
+bool command_scheduler_capture_status(const char* state, const char* message) {
+    portENTER_CRITICAL(&status_lock);
+    // Only the running step's reports: from its handler, or from its actuation
+    // on another task. Network task reports outside the handler (manual
+    // commands, replay) and reports between steps are published.
+    TaskHandle_t caller = xTaskGetCurrentTaskHandle();
+    bool captured = active && captured_step >= 0 &&
+                    (caller == handler_task || caller != network_task);
+    // The last report is the step's outcome, except that an error sticks
+    if (captured && strcmp(steps[captured_step].state, "ERROR") != 0) {
+        scheduled_step_t* step = &steps[captured_step];
+        copy_text(step->state, sizeof(step->state), state);
+        copy_text(step->message, sizeof(step->message), message);
+    }
+    portEXIT_CRITICAL(&status_lock);
+    return captured;
+}
+
+// ==================== Execution ====================
+
+static void run_step(scheduled_step_t* step, uint32_t elapsed_ms) {
+    const command_entry_t* entry = &scheduler_config->table->entries[step->command];
+    step->phase = STEP_RUNNING;
+    step->start_ms = elapsed_ms;
+
+    portENTER_CRITICAL(&status_lock);
+    captured_step = (int)(step - steps);
+    handler_task = network_task;
+    portEXIT_CRITICAL(&status_lock);
+
+    DebugHelper::info("Batch %s step %u: %s", batch_id, (unsigned)(current + 1), entry->action);
+    JsonArenaScope arena;
+    cJSON* params = step->params[0] != '\0' ? cJSON_Parse(step->params) : nullptr;
+    entry->handler(params);
+    cJSON_Delete(params);
+
+    portENTER_CRITICAL(&status_lock);
+    handler_task = nullptr;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+static bool step_failed(const scheduled_step_t* step) {
+    return strcmp(step->state, "ERROR") == 0;
+}
+
+static void publish_report(uint32_t now_ms) {
+    uint32_t elapsed_ms = now_ms - batch_start_ms;
+    size_t executed = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < step_count; i++) {
+        executed += steps[i].phase == STEP_DONE;
+        failed += steps[i].phase == STEP_DONE && step_failed(&steps[i]);
+    }
+    const char* state = failed > 0 ? "ERROR" : (cancelled ? "IDLE" : "COMPLETED");
+
+    char message[96];
+    snprintf(message, sizeof(message), "Batch %s: %u of %u commands %s", batch_id,
+             (unsigned)(executed - failed), (unsigned)step_count,
+             cancelled && failed == 0 ? "run before cancel" : "completed");
+
+    json_writer_t writer;
+    json_writer_init(&writer, report, sizeof(report));
+    json_writer_begin_object(&writer, nullptr);
+    json_writer_string(&writer, "module", scheduler_config->module);
+    json_writer_string(&writer, "state", state);
+    json_writer_string(&writer, "message", message);
+    json_writer_int(&writer, "timestamp", time_sync_now_ms());
+
+    json_writer_begin_object(&writer, "batch");
+    json_writer_string(&writer, "id", batch_id);
+    json_writer_int(&writer, "total", step_count);
+    json_writer_int(&writer, "executed", executed);
+    json_writer_int(&writer, "failed", failed);
+    json_writer_bool(&writer, "cancelled", cancelled);
+    json_writer_int(&writer, "duration_ms", elapsed_ms);
+    json_writer_begin_array(&writer, "steps");
+    for (size_t i = 0; i < step_count; i++) {
+        const scheduled_step_t* step = &steps[i];
+        json_writer_begin_object(&writer, nullptr);
+        json_writer_string(&writer, "action", scheduler_config->table->entries[step->command].action);
+        if (step->phase == STEP_DONE) {
+            json_writer_string(&writer, "state", step->state[0] != '\0' ? step->state : "OK");
+            json_writer_string(&writer, "message", step->message);
+            json_writer_int(&writer, "start_ms", step->start_ms);
+            json_writer_int(&writer, "duration_ms", step->duration_ms);
+        } else {
+            json_writer_string(&writer, "state", "SKIPPED");
+        }
+        json_writer_end_object(&writer);
+    }
+    json_writer_end_array(&writer);
+    json_writer_end_object(&writer);
+    json_writer_end_object(&writer);
+
+    const char* json = json_writer_finish(&writer, nullptr);
+    if (json == nullptr) {
+        DebugHelper::error("Batch %s: report exceeds %u bytes", batch_id,
+                           (unsigned)COMMAND_SCHEDULER_REPORT_SIZE);
+        return;
+    }
+    mqtt_helper_publish(scheduler_config->status_topic, json);
+    DebugHelper::info("Status report: %s - %s", state, message);
+}
+
+bool command_scheduler_poll(uint32_t now_ms) {
+    if (!active) {
+        return false;
+    }
+    uint32_t elapsed_ms = now_ms - batch_start_ms;
+
+    scheduled_step_t* step = &steps[current];
+    if (step->phase == STEP_RUNNING) {
+        if (scheduler_config->busy()) {
+            return true;
+        }
+        portENTER_CRITICAL(&status_lock);
+        captured_step = -1;
+        portEXIT_CRITICAL(&status_lock);
+        step->phase = STEP_DONE;
+        step->duration_ms = elapsed_ms - step->start_ms;
+        if (stop_on_error && step_failed(step)) {
+            for (size_t i = current + 1; i < step_count; i++) {
+                steps[i].phase = STEP_SKIPPED;
+            }
+            current = step_count;
+        } else {
+            current++;
+        }
+    }
+
+    if (current < step_count && !cancelled) {
+        step = &steps[current];
+        // Wait for the step's time and for any actuation (even a manual one) to end
+        if ((int32_t)(elapsed_ms - step->at_ms) < 0 || scheduler_config->busy()) {
+            return true;
+        }
+        run_step(step, elapsed_ms);
+        return true;
+    }
+
+    for (size_t i = current; i < step_count; i++) {
+        steps[i].phase = STEP_SKIPPED;
+    }
+    publish_report(now_ms);
+    DebugHelper::info("Batch %s finished", batch_id);
+
+    portENTER_CRITICAL(&status_lock);
+    active = false;
+    captured_step = -1;
+    portEXIT_CRITICAL(&status_lock);
+    return false;
+}
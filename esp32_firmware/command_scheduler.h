@@ -0,0 +1,88 @@
+#ifndef COMMAND_SCHEDULER_H
+#define COMMAND_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+#include "command_table.h"
+
+/**
+ * @file command_scheduler.h
+ * @brief Batched commands run back-to-back from an on-device queue
+ *
+ * The "batch" command carries a list of ordinary commands, each with an
+ * optional execution time:
+ *
+ *   {"action": "batch", "params": {"id": "plan-7", "commands": [
+ *       {"action": "inject", "params": {"depth": 10, "pressure": 200}},
+ *       {"action": "inject", "params": {"depth": 15}, "at_ms": 30000}]}}
+ *
+ * The whole list is validated and copied into a bounded queue when it
+ * arrives (an unknown action or an oversized step rejects the batch). The
+ * network task then runs one step at a time through the module's command
+ * table: a step starts once at_ms have passed since the batch arrived and
+ * the actuator is idle, and is done when the actuator is idle again. So a
+ * sequence of injections runs without a broker round trip per step.
+ *
+ * While a step's handler or its actuation runs, the module's status reports
+ * are captured for that step instead of published. Reports between steps,
+ * from manual commands and from the network task outside the handler are
+ * published as usual, as are alerts and OTA reports, which bypass the
+ * scheduler (module_runtime.cpp). When the batch ends, one consolidated status report is
+ * published: state COMPLETED (ERROR if a step reported ERROR, IDLE if the
+ * batch was cancelled) plus a "batch" object with every step's outcome.
+ * A step that reports ERROR skips the rest unless "stop_on_error" is false.
+ * {"action": "batch", "params": {"cancel": true}} skips the steps not yet
+ * started. Only one batch is queued at a time.
+ */
+
+#define COMMAND_SCHEDULER_ACTION       "batch"
+#define COMMAND_SCHEDULER_LENGTH       16   // Steps per batch
+#define COMMAND_SCHEDULER_PARAMS_SIZE  128  // Step params, as compact JSON
+#define COMMAND_SCHEDULER_REPORT_SIZE  2048 // Consolidated status report
+
+/**
+ * @brief Module binding
+ */
+typedef struct {
+    const char* module;                 // "module" field of the report
+    const char* status_topic;           // Report topic (must stay valid)
+    const command_table_t* table;       // Commands a batch may contain
+    bool (*busy)();                     // Whether an actuation is in progress
+} command_scheduler_config_t;
+
+/**
+ * @brief Bind the scheduler to the module (before the first command)
+ * @param config Module binding (must stay valid)
+ */
+void command_scheduler_init(const command_scheduler_config_t* config);
+
+/**
+ * @brief Handle the "batch" command (network task)
+ * @param params Command parameters
+ * @return true if a batch was queued or cancelled
+ */
+bool command_scheduler_handle_command(const cJSON* params);
+
+/**
+ * @brief Record a status report for the running step instead of publishing it
+ * @param state Module state
+ * @param message Detail
+ * @return true if captured (a step is running), false to publish it as usual
+ */
+bool command_scheduler_capture_status(const char* state, const char* message);
+
+/**
+ * @brief Start due steps and publish the report at the end (network task)
+ * @param now_ms Current time in milliseconds
+ * @return true while a batch is active
+ */
+bool command_scheduler_poll(uint32_t now_ms);
+
+/**
+ * @brief Whether a batch is active
+ */
+bool command_scheduler_active();
+
+#endif // COMMAND_SCHEDULER_H
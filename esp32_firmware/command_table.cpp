@@ -0,0 +1,64 @@
+#include "command_table.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include "json_arena.h"
+#include <string.h>
+
+bool command_table_init(command_table_t* table, const command_entry_t* entries, size_t count) {
+    if (count > COMMAND_TABLE_MAX_ENTRIES) {
+        DebugHelper::error("Command table: %u entries exceed limit", (unsigned)count);
+        return false;
+    }
+
+    table->entries = entries;
+    table->count = count;
+    for (size_t i = 0; i < count; i++) {
+        table->hashes[i] = mqtt_topic_hash_str(entries[i].action);
+    }
+    return true;
+}
+
+int command_table_find(const command_table_t* table, const char* action) {
+    uint32_t hash = mqtt_topic_hash_str(action);
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->hashes[i] == hash && strcmp(table->entries[i].action, action) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool command_table_dispatch(const command_table_t* table, const cJSON* command) {
+    const char* action = cJSON_GetStringValue(cJSON_GetObjectItem(command, "action"));
+    if (action == nullptr) {
+        DebugHelper::warning("Command without action");
+        return false;
+    }
+
+    int index = command_table_find(table, action);
+    if (index < 0) {
+        DebugHelper::warning("Unknown command: %s", action);
+        return false;
+    }
+    DebugHelper::info("Executing command: %s", action);
+    table->entries[index].handler(cJSON_GetObjectItem(command, "params"));
+    return true;
+}
+
+bool command_table_dispatch_message(const command_table_t* table, const mqtt_message_t* message) {
+    MetricsScope timer(METRIC_COMMAND);
+    metrics_count(METRIC_COMMANDS, 1);
+    
+    // Parse JSON command straight from the receive buffer; the tree lives in
+    // an arena for the whole dispatch (json_arena.h)
+    JsonArenaScope arena;
+    cJSON* json = cJSON_ParseWithLength((const char*)message->payload, message->payload_len);
+    if (json == nullptr) {
+        DebugHelper::error("JSON parsing failed");
+        return false;
+    }
+
+    bool handled = command_table_dispatch(table, json);
+    cJSON_Delete(json);
+    return handled;
+}
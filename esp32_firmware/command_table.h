@@ -0,0 +1,78 @@
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+#include "mqtt_helper.h"
+
+/**
+ * @file command_table.h
+ * @brief Action-name dispatch table for module commands
+ *
+ * Modules describe their commands as a static array of {action, handler}
+ * entries. Action names are hashed once at init; dispatching a command
+ * hashes its "action" string and scans the hash array, verifying the name
+ * only on a hash match. Handlers receive the command's "params" object
+ * (may be NULL).
+ */
+
+#define COMMAND_TABLE_MAX_ENTRIES 16
+
+/**
+ * @brief Command handler signature
+ */
+typedef void (*command_handler_t)(const cJSON* params);
+
+/**
+ * @brief One command
+ */
+typedef struct {
+    const char* action;             // Value of the command's "action" field
+    command_handler_t handler;
+} command_entry_t;
+
+/**
+ * @brief Dispatch table state
+ */
+typedef struct {
+    const command_entry_t* entries;
+    size_t count;
+    uint32_t hashes[COMMAND_TABLE_MAX_ENTRIES];   // mqtt_topic_hash() of each action
+} command_table_t;
+
+/**
+ * @brief Build a dispatch table over a static entry array
+ * @param table Pointer to table state
+ * @param entries Command entries (must outlive the table)
+ * @param count Number of entries (<= COMMAND_TABLE_MAX_ENTRIES)
+ * @return true if the table was built
+ */
+bool command_table_init(command_table_t* table, const command_entry_t* entries, size_t count);
+
+/**
+ * @brief Look up an action
+ * @param table Pointer to table state
+ * @param action Action name
+ * @return Entry index, -1 if the action is unknown
+ */
+int command_table_find(const command_table_t* table, const char* action);
+
+/**
+ * @brief Run the handler for a parsed command
+ * @param table Pointer to table state
+ * @param command Command object with "action" and optional "params"
+ * @return true if a handler was found and called
+ */
+bool command_table_dispatch(const command_table_t* table, const cJSON* command);
+
+/**
+ * @brief Parse a JSON command message and dispatch it
+ * @param table Pointer to table state
+ * @param message Received message
+ * @return true if a handler was found and called
+ */
+bool command_table_dispatch_message(const command_table_t* table, const mqtt_message_t* message);
+
+#endif // COMMAND_TABLE_H
@@ -0,0 +1,134 @@
+#include "control_loop.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include <atomic>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+static control_step_t control_step = nullptr;
+static TaskHandle_t control_task = nullptr;
+static esp_timer_handle_t control_timer = nullptr;
+static SemaphoreHandle_t step_lock = nullptr;   // Held for the duration of a step
+
+// Under step_lock, except the unlocked reads by control_loop_missed_ticks()
+// and control_loop_max_jitter_us() on other tasks
+static std::atomic<bool> running{false};
+static uint32_t iteration = 0;
+static std::atomic<uint32_t> missed_ticks{0};
+static uint32_t loop_period_us = 0;
+static int64_t last_step_us = 0;
+static std::atomic<uint32_t> max_jitter_us{0};
+
+// esp_timer callback: keep it minimal, the task does the work. With ISR
+// dispatch it runs in the timer interrupt on APP_CPU, not on the esp_timer
+// task that shares PRO_CPU with WiFi.
+static void IRAM_ATTR control_timer_cb(void* arg) {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(control_task, &woken);
+    if (woken == pdTRUE) {
+        esp_timer_isr_dispatch_need_yield();
+    }
+#else
+    xTaskNotifyGive(control_task);
+#endif
+}
+
+static void control_task_fn(void* pvParameter) {
+    while (1) {
+        uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(step_lock, portMAX_DELAY);
+        if (running.load(std::memory_order_relaxed)) {
+            if (ticks > 1) {
+                missed_ticks.fetch_add(ticks - 1, std::memory_order_relaxed);
+            }
+
+            // Deviation of this step's start from one period after the last
+            int64_t now_us = esp_timer_get_time();
+            if (iteration > 0) {
+                int64_t deviation = now_us - last_step_us - loop_period_us;
+                uint32_t jitter_us = (uint32_t)(deviation < 0 ? -deviation : deviation);
+                metrics_record(METRIC_CONTROL_JITTER, jitter_us);
+                if (jitter_us > max_jitter_us.load(std::memory_order_relaxed)) {
+                    max_jitter_us.store(jitter_us, std::memory_order_relaxed);
+                }
+            }
+            last_step_us = now_us;
+            if (!control_step(iteration++)) {
+                esp_timer_stop(control_timer);
+                running.store(false, std::memory_order_relaxed);
+            }
+        }
+        xSemaphoreGive(step_lock);
+    }
+}
+
+bool control_loop_start(uint32_t period_us, control_step_t step) {
+    if (control_task == nullptr) {
+        step_lock = xSemaphoreCreateMutex();
+        if (step_lock == nullptr) {
+            DebugHelper::error("Failed to create control loop lock");
+            return false;
+        }
+        if (xTaskCreatePinnedToCore(control_task_fn, "control_task", CONTROL_TASK_STACK,
+                                    nullptr, CONTROL_TASK_PRIORITY, &control_task,
+                                    CONTROL_TASK_CORE) != pdPASS) {
+            DebugHelper::error("Failed to create control task");
+            return false;
+        }
+        metrics_watch_task("control", control_task);
+
+        esp_timer_create_args_t timer_args = {};
+        timer_args.callback = control_timer_cb;
+        timer_args.name = "control";
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        timer_args.dispatch_method = ESP_TIMER_ISR;
+#endif
+        if (esp_timer_create(&timer_args, &control_timer) != ESP_OK) {
+            DebugHelper::error("Failed to create control timer");
+            return false;
+        }
+    }
+
+    control_loop_stop();
+
+    xSemaphoreTake(step_lock, portMAX_DELAY);
+    control_step = step;
+    iteration = 0;
+    missed_ticks.store(0, std::memory_order_relaxed);
+    max_jitter_us.store(0, std::memory_order_relaxed);
+    loop_period_us = period_us;
+    running.store(true, std::memory_order_relaxed);
+    xSemaphoreGive(step_lock);
+
+    if (esp_timer_start_periodic(control_timer, period_us) != ESP_OK) {
+        DebugHelper::error("Failed to start control timer");
+        running.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void control_loop_stop() {
+    if (control_timer == nullptr) {
+        return;
+    }
+    esp_timer_stop(control_timer);
+
+    // Wait out a step in progress; later wake-ups see running == false
+    xSemaphoreTake(step_lock, portMAX_DELAY);
+    running.store(false, std::memory_order_relaxed);
+    xSemaphoreGive(step_lock);
+}
+
+uint32_t control_loop_missed_ticks() {
+    return missed_ticks.load(std::memory_order_relaxed);
+}
+
+uint32_t control_loop_max_jitter_us() {
+    return max_jitter_us.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef CONTROL_LOOP_H
+#define CONTROL_LOOP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "task_config.h"
+
+/**
+ * @file control_loop.h
+ * @brief High-rate closed-loop control task
+ *
+ * A periodic esp_timer wakes a dedicated control task, which runs the
+ * module's control step (read feedback, update controllers, write the
+ * actuator output) once per period. The loop runs only while the actuator
+ * state machine has it started; the step can end the run itself by returning
+ * false, and control_loop_stop() waits for a running step to finish so the
+ * caller may safely take over the output afterwards.
+ *
+ * The task is pinned to APP_CPU and its timer is ISR-dispatched where the
+ * build allows it (task_config.h). How far each step starts from its nominal
+ * time is recorded in METRIC_CONTROL_JITTER and its maximum kept per run.
+ */
+
+#ifndef CONTROL_TASK_STACK
+#define CONTROL_TASK_STACK      4096
+#endif
+#define CONTROL_TASK_PRIORITY   15      // Highest on APP_CPU (task_config.h)
+#define CONTROL_TASK_CORE       TASK_CORE_CONTROL
+
+/**
+ * @brief Control step, runs on the control task
+ * @param iteration Iteration count since control_loop_start() (first is 0)
+ * @return false to end the run (the timer is stopped)
+ */
+typedef bool (*control_step_t)(uint32_t iteration);
+
+/**
+ * @brief Start running a control step at a fixed period
+ * @param period_us Loop period in microseconds
+ * @param step Control step
+ * @return true if the task and timer were started
+ */
+bool control_loop_start(uint32_t period_us, control_step_t step);
+
+/**
+ * @brief Stop the loop and wait for a running step to finish
+ */
+void control_loop_stop();
+
+/**
+ * @brief Timer periods missed because a step overran, since the last start
+ */
+uint32_t control_loop_missed_ticks();
+
+/**
+ * @brief Largest step start deviation from the period, since the last start
+ * @return Microseconds
+ */
+uint32_t control_loop_max_jitter_us();
+
+#endif // CONTROL_LOOP_H
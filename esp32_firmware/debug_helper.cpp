@@ -1,4 +1,6 @@
 #include "debug_helper.h"
+#include "mpsc_queue.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <string.h>
 #include <esp_log.h>
@@ -6,6 +8,7 @@
 #include <nvs.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 
 static const char* TAG = "DebugHelper";
 static const char* PREFS_NAMESPACE = "debug_settings";
@@ -14,6 +17,243 @@ static const char* DEBUG_LEVEL_KEY = "debug_level";
 int DebugHelper::debugLevel = DEBUG_LEVEL;
 bool DebugHelper::initialized = false;
 
+static const char* const LEVEL_NAMES[] = {"OFF", "ERROR", "WARN", "INFO", "VERBOSE"};
+static debug_log_sink_t log_sink = nullptr;
+
+#define LOG_LINE_LENGTH 256
+
+static void write_line(const char* line, size_t length) {
+    if (log_sink != nullptr) {
+        log_sink(line, length);
+    } else {
+        printf("%.*s\n", (int)length, line);
+    }
+}
+
+#if DEBUG_LOG_DEFERRED
+static MpscQueue<debug_log_record_t, DEBUG_LOG_QUEUE_LENGTH> log_queue;
+static SemaphoreHandle_t drain_lock = nullptr;     // Single consumer: drain task or flush()
+static std::atomic<uint32_t> dropped_records{0};
+
+// Sequential reader over a record's tagged arguments
+typedef struct {
+    const debug_log_record_t* record;
+    size_t pos;
+} arg_reader_t;
+
+static bool next_arg(arg_reader_t* reader, debug_arg_type_t* type, const uint8_t** value, size_t* size) {
+    const debug_log_record_t* r = reader->record;
+    if (reader->pos >= r->length) {
+        return false;
+    }
+    *type = (debug_arg_type_t)r->data[reader->pos++];
+    switch (*type) {
+        case DEBUG_ARG_INT32:
+        case DEBUG_ARG_UINT32:  *size = 4; break;
+        case DEBUG_ARG_STRING:  *size = r->data[reader->pos++]; break;
+        case DEBUG_ARG_POINTER: *size = sizeof(void*); break;
+        default:                *size = 8; break;
+    }
+    *value = &r->data[reader->pos];
+    reader->pos += *size;
+    return true;
+}
+
+// Numeric argument in its recorded type (strings read as 0)
+typedef union { int32_t i32; uint32_t u32; int64_t i64; uint64_t u64; double d; uintptr_t p; } arg_value_t;
+
+static bool next_scalar(arg_reader_t* reader, debug_arg_type_t* type, arg_value_t* v) {
+    const uint8_t* value;
+    size_t size;
+    if (!next_arg(reader, type, &value, &size)) {
+        return false;
+    }
+    memset(v, 0, sizeof(*v));
+    if (*type != DEBUG_ARG_STRING) {
+        memcpy(v, value, size);
+    }
+    return true;
+}
+
+static bool next_integer(arg_reader_t* reader, bool as_unsigned, long long* out) {
+    debug_arg_type_t type;
+    arg_value_t v;
+    if (!next_scalar(reader, &type, &v)) {
+        return false;
+    }
+    switch (type) {
+        // A negative int printed with %u/%x shows its 32-bit pattern, as printf would
+        case DEBUG_ARG_INT32:   *out = as_unsigned ? (long long)(uint32_t)v.i32 : v.i32; break;
+        case DEBUG_ARG_UINT32:  *out = v.u32; break;
+        case DEBUG_ARG_INT64:   *out = v.i64; break;
+        case DEBUG_ARG_UINT64:  *out = (long long)v.u64; break;
+        case DEBUG_ARG_DOUBLE:  *out = (long long)v.d; break;
+        case DEBUG_ARG_POINTER: *out = (long long)v.p; break;
+        default:                *out = 0; break;
+    }
+    return true;
+}
+
+static bool next_double(arg_reader_t* reader, double* out) {
+    debug_arg_type_t type;
+    arg_value_t v;
+    if (!next_scalar(reader, &type, &v)) {
+        return false;
+    }
+    switch (type) {
+        case DEBUG_ARG_DOUBLE:  *out = v.d; break;
+        case DEBUG_ARG_INT32:   *out = v.i32; break;
+        case DEBUG_ARG_UINT32:  *out = v.u32; break;
+        case DEBUG_ARG_INT64:   *out = (double)v.i64; break;
+        case DEBUG_ARG_UINT64:  *out = (double)v.u64; break;
+        default:                *out = 0.0; break;
+    }
+    return true;
+}
+
+// Expand a record's format string, one conversion at a time through snprintf
+static size_t format_record(const debug_log_record_t* record, char* out, size_t capacity) {
+    arg_reader_t reader = {record, 0};
+    size_t n = 0;
+    const char* f = record->format;
+
+    while (*f != '\0' && n + 1 < capacity) {
+        if (*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[n++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Rebuild the conversion spec with '*' resolved and length modifiers
+        // replaced by the recorded argument type
+        char spec[24];
+        size_t s = 0;
+        bool missing = false;
+        spec[s++] = *f++;
+        while (*f != '\0' && strchr("-+ #0", *f) != nullptr && s < 8) spec[s++] = *f++;
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*f != '.') break;
+                spec[s++] = *f++;
+            }
+            if (*f == '*') {
+                long long star = 0;
+                missing |= !next_integer(&reader, false, &star);
+                s += snprintf(&spec[s], sizeof(spec) - s - 4, "%d", (int)star);
+                f++;
+            } else {
+                while (*f >= '0' && *f <= '9' && s < sizeof(spec) - 8) spec[s++] = *f++;
+            }
+        }
+        while (*f != '\0' && strchr("hlLqjzt", *f) != nullptr) f++;
+
+        char conversion = *f;
+        if (conversion == '\0') {
+            break;
+        }
+        f++;
+
+        int written = 0;
+        if (strchr("diouxXc", conversion) != nullptr) {
+            long long value = 0;
+            missing |= !next_integer(&reader, strchr("ouxX", conversion) != nullptr, &value);
+            if (conversion == 'c') {
+                spec[s++] = 'c';
+                spec[s] = '\0';
+                written = snprintf(&out[n], capacity - n, spec, (int)value);
+            } else {
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = conversion;
+                spec[s] = '\0';
+                written = snprintf(&out[n], capacity - n, spec, value);
+            }
+        } else if (strchr("fFeEgGaA", conversion) != nullptr) {
+            double value = 0.0;
+            missing |= !next_double(&reader, &value);
+            spec[s++] = conversion;
+            spec[s] = '\0';
+            written = snprintf(&out[n], capacity - n, spec, value);
+        } else if (conversion == 's') {
+            debug_arg_type_t type;
+            const uint8_t* value;
+            size_t size;
+            char text[DEBUG_LOG_RECORD_DATA];
+            text[0] = '\0';
+            if (next_arg(&reader, &type, &value, &size) && type == DEBUG_ARG_STRING) {
+                memcpy(text, value, size);
+                text[size] = '\0';
+            } else {
+                missing = true;
+            }
+            spec[s++] = 's';
+            spec[s] = '\0';
+            written = snprintf(&out[n], capacity - n, spec, text);
+        } else if (conversion == 'p') {
+            long long value = 0;
+            missing |= !next_integer(&reader, true, &value);
+            written = snprintf(&out[n], capacity - n, "%p", (void*)(uintptr_t)value);
+        }
+
+        if (written > 0) {
+            n += (size_t)written < capacity - n ? (size_t)written : capacity - n - 1;
+        }
+        if (missing) {
+            break;
+        }
+    }
+
+    if (record->truncated) {
+        n += snprintf(&out[n], capacity - n, " [truncated]");
+        if (n >= capacity) n = capacity - 1;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Drain every queued record; caller holds drain_lock
+static void drain_records() {
+    debug_log_record_t record;
+    char line[LOG_LINE_LENGTH];
+
+    uint32_t dropped = dropped_records.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        int n = snprintf(line, sizeof(line), "[%lu][WARN] %lu log records dropped",
+                         (unsigned long)(esp_timer_get_time() / 1000), (unsigned long)dropped);
+        write_line(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+
+    while (log_queue.pop(record)) {
+        int n = snprintf(line, sizeof(line), "[%lu][%s] ",
+                         (unsigned long)record.timestamp_ms, LEVEL_NAMES[record.level]);
+        size_t length = (size_t)n + format_record(&record, &line[n], sizeof(line) - n);
+        write_line(line, length);
+    }
+}
+
+static void log_drain_task(void* pvParameter) {
+    while (1) {
+        xSemaphoreTake(drain_lock, portMAX_DELAY);
+        drain_records();
+        xSemaphoreGive(drain_lock);
+        vTaskDelay(DEBUG_LOG_DRAIN_MS / portTICK_PERIOD_MS);
+    }
+}
+
+void DebugHelper::enqueue(debug_log_record_t& record) {
+    if (!initialized) return;
+
+    record.timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (!log_queue.push(record)) {
+        dropped_records.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+#endif
+
 void DebugHelper::initialize() {
     if (!initialized) {
         // Initialize NVS
@@ -24,6 +264,15 @@ void DebugHelper::initialize() {
         }
         ESP_ERROR_CHECK(ret);
         
+#if DEBUG_LOG_DEFERRED
+        // Formatting and UART output happen on the drain task
+        drain_lock = xSemaphoreCreateMutex();
+        TaskHandle_t drain_task = nullptr;
+        xTaskCreatePinnedToCore(log_drain_task, "log_drain", DEBUG_LOG_TASK_STACK, nullptr,
+                                DEBUG_LOG_TASK_PRIORITY, &drain_task, DEBUG_LOG_TASK_CORE);
+        metrics_watch_task("log_drain", drain_task);
+#endif
+        
         // Load saved debug level from NVS
         nvs_handle_t nvs_handle;
         ret = nvs_open(PREFS_NAMESPACE, NVS_READONLY, &nvs_handle);
@@ -59,52 +308,42 @@ void DebugHelper::setLevel(int level) {
     info("Debug level set to: %d", level);
 }
 
-void DebugHelper::print(const char* level, const char* format, va_list args) {
-    if (!initialized) return;
-    
-    char buffer[256];
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    
-    // Get current time in milliseconds
-    uint32_t time_ms = (uint32_t)(esp_timer_get_time() / 1000);
-    
-    printf("[%lu][%s] %s\n", time_ms, level, buffer);
-}
-
-void DebugHelper::error(const char* format, ...) {
-    if (debugLevel >= DEBUG_LEVEL_ERROR) {
-        va_list args;
-        va_start(args, format);
-        print("ERROR", format, args);
-        va_end(args);
-    }
+void DebugHelper::setSink(debug_log_sink_t sink) {
+    log_sink = sink;
 }
 
-void DebugHelper::warning(const char* format, ...) {
-    if (debugLevel >= DEBUG_LEVEL_WARNING) {
-        va_list args;
-        va_start(args, format);
-        print("WARN", format, args);
-        va_end(args);
-    }
+void DebugHelper::flush() {
+#if DEBUG_LOG_DEFERRED
+    if (drain_lock == nullptr) return;
+    xSemaphoreTake(drain_lock, portMAX_DELAY);
+    drain_records();
+    xSemaphoreGive(drain_lock);
+#endif
 }
 
-void DebugHelper::info(const char* format, ...) {
-    if (debugLevel >= DEBUG_LEVEL_INFO) {
-        va_list args;
-        va_start(args, format);
-        print("INFO", format, args);
-        va_end(args);
-    }
+uint32_t DebugHelper::droppedRecords() {
+#if DEBUG_LOG_DEFERRED
+    return dropped_records.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
 }
 
-void DebugHelper::verbose(const char* format, ...) {
-    if (debugLevel >= DEBUG_LEVEL_VERBOSE) {
-        va_list args;
-        va_start(args, format);
-        print("VERBOSE", format, args);
-        va_end(args);
-    }
+void DebugHelper::print(int level, const char* format, ...) {
+    if (!initialized) return;
+    
+    char buffer[LOG_LINE_LENGTH];
+    
+    // Get current time in milliseconds
+    uint32_t time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    int n = snprintf(buffer, sizeof(buffer), "[%lu][%s] ", (unsigned long)time_ms, LEVEL_NAMES[level]);
+    
+    va_list args;
+    va_start(args, format);
+    n += vsnprintf(&buffer[n], sizeof(buffer) - n, format, args);
+    va_end(args);
+    
+    write_line(buffer, (size_t)n < sizeof(buffer) ? (size_t)n : sizeof(buffer) - 1);
 }
 
 void DebugHelper::logSensor(const char* name, float value, const char* unit) {
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include "debug_log.h"
+#include "task_config.h"
 
 /**
  * @file debug_helper.h
@@ -12,6 +14,15 @@
  * This helper provides multi-level debugging capabilities with support for
  * sensor data logging, calibration logging, and hex dump functionality.
  * Debug levels can be configured and persisted to NVS storage.
+ *
+ * DEBUG_LEVEL is the compile-time ceiling: calls above it are compiled out,
+ * and the runtime level (setLevel()) filters further below it.
+ *
+ * With DEBUG_LOG_DEFERRED, a log call only copies its format pointer and
+ * arguments into a lock-free ring (debug_log.h); a low-priority task formats
+ * the records and writes them to the sink, so logging never blocks the
+ * calling task on the UART. Records are dropped, and counted, when the ring
+ * is full.
  */
 
 // Debug levels - Control verbosity of debug output
@@ -25,6 +36,23 @@
 #define DEBUG_LEVEL DEBUG_LEVEL_INFO  // Default debug level
 #endif
 
+#ifndef DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED 0
+#endif
+
+#define DEBUG_LOG_QUEUE_LENGTH   64     // Deferred records, power of two
+#ifndef DEBUG_LOG_TASK_STACK
+#define DEBUG_LOG_TASK_STACK     3072
+#endif
+#define DEBUG_LOG_TASK_PRIORITY  1      // Below every module task
+#define DEBUG_LOG_TASK_CORE      TASK_CORE_NETWORK
+#define DEBUG_LOG_DRAIN_MS       20     // Drain task poll period when idle
+
+/**
+ * @brief Log output, one formatted line without newline
+ */
+typedef void (*debug_log_sink_t)(const char* line, size_t length);
+
 /**
  * @brief Debug helper utility class
  * 
@@ -48,35 +76,63 @@ public:
      */
     static void setLevel(int level);
 
+    /**
+     * @brief Route formatted log lines to a sink instead of the UART
+     * @param sink Sink (runs on the drain task when deferred), nullptr for UART
+     */
+    static void setSink(debug_log_sink_t sink);
+
+    /**
+     * @brief Write out all pending deferred records (e.g. before a restart)
+     */
+    static void flush();
+
+    /**
+     * @brief Deferred records dropped because the ring was full
+     */
+    static uint32_t droppedRecords();
+
     // Logging functions for different severity levels
     
     /**
      * @brief Log error message (always shown unless OFF)
-     * @param format Printf-style format string
-     * @param ... Variable arguments for format string
+     * @param format Printf-style format string (must be a string literal)
+     * @param args Arguments for the format string
      */
-    static void error(const char* format, ...);
+    template <typename... Args>
+    static void error(const char* format, Args... args) {
+        log<DEBUG_LEVEL_ERROR>(format, args...);
+    }
     
     /**
      * @brief Log warning message (shown at WARNING level and above)
-     * @param format Printf-style format string
-     * @param ... Variable arguments for format string
+     * @param format Printf-style format string (must be a string literal)
+     * @param args Arguments for the format string
      */
-    static void warning(const char* format, ...);
+    template <typename... Args>
+    static void warning(const char* format, Args... args) {
+        log<DEBUG_LEVEL_WARNING>(format, args...);
+    }
     
     /**
      * @brief Log informational message (shown at INFO level and above)
-     * @param format Printf-style format string
-     * @param ... Variable arguments for format string
+     * @param format Printf-style format string (must be a string literal)
+     * @param args Arguments for the format string
      */
-    static void info(const char* format, ...);
+    template <typename... Args>
+    static void info(const char* format, Args... args) {
+        log<DEBUG_LEVEL_INFO>(format, args...);
+    }
     
     /**
      * @brief Log verbose debug message (shown only at VERBOSE level)
-     * @param format Printf-style format string
-     * @param ... Variable arguments for format string
+     * @param format Printf-style format string (must be a string literal)
+     * @param args Arguments for the format string
      */
-    static void verbose(const char* format, ...);
+    template <typename... Args>
+    static void verbose(const char* format, Args... args) {
+        log<DEBUG_LEVEL_VERBOSE>(format, args...);
+    }
 
     // Specialized logging functions for sensor data and diagnostics
     
@@ -105,13 +161,38 @@ public:
     static void hexDump(const uint8_t* data, size_t length, const char* label = nullptr);
 
 private:
+    template <int Level, typename... Args>
+    static void log(const char* format, Args... args) {
+        if constexpr (Level <= DEBUG_LEVEL) {
+            if (debugLevel >= Level) {
+#if DEBUG_LOG_DEFERRED
+                debug_log_record_t record;
+                record.format = format;
+                record.level = Level;
+                record.length = 0;
+                record.truncated = false;
+                (debug_log::put_arg(record, args), ...);
+                enqueue(record);
+#else
+                print(Level, format, args...);
+#endif
+            }
+        }
+    }
+
+    /**
+     * @brief Timestamp a record and queue it for the drain task
+     * @param record Record with format, level and arguments filled in
+     */
+    static void enqueue(debug_log_record_t& record);
+
     /**
      * @brief Internal print function with timestamp and level formatting
-     * @param level Debug level string (ERROR, WARN, INFO, VERBOSE)
+     * @param level Debug level (DEBUG_LEVEL_*)
      * @param format Printf-style format string
-     * @param args Variable argument list
+     * @param ... Variable arguments for format string
      */
-    static void print(const char* level, const char* format, va_list args);
+    static void print(int level, const char* format, ...);
 };
 
 #endif // DEBUG_HELPER_H
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+/**
+ * @file debug_log.h
+ * @brief Binary log records for the deferred DebugHelper backend
+ *
+ * A record holds the format string pointer (string literals live in flash
+ * for the life of the image, so the pointer is the format id), a timestamp,
+ * the level and the raw arguments, each tagged with its type. String
+ * arguments are copied into the record, truncated to fit, since the caller's
+ * buffer may be gone by the time the record is formatted.
+ */
+
+#ifndef DEBUG_LOG_RECORD_DATA
+#define DEBUG_LOG_RECORD_DATA 52        // Argument bytes per record (64-byte records)
+#endif
+
+typedef enum : uint8_t {
+    DEBUG_ARG_INT32,
+    DEBUG_ARG_UINT32,
+    DEBUG_ARG_INT64,
+    DEBUG_ARG_UINT64,
+    DEBUG_ARG_DOUBLE,
+    DEBUG_ARG_STRING,       // Followed by a length byte and the characters
+    DEBUG_ARG_POINTER
+} debug_arg_type_t;
+
+/**
+ * @brief One deferred log call
+ */
+typedef struct {
+    const char* format;
+    uint32_t timestamp_ms;
+    uint8_t level;                      // DEBUG_LEVEL_*
+    uint8_t length;                     // Bytes used in data
+    bool truncated;                     // Arguments did not fit
+    uint8_t data[DEBUG_LOG_RECORD_DATA];
+} debug_log_record_t;
+
+namespace debug_log {
+
+inline void put(debug_log_record_t& record, debug_arg_type_t type, const void* value, size_t size) {
+    if (record.truncated || record.length + 1 + size > DEBUG_LOG_RECORD_DATA) {
+        record.truncated = true;
+        return;
+    }
+    record.data[record.length++] = type;
+    memcpy(&record.data[record.length], value, size);
+    record.length += size;
+}
+
+inline void put_string(debug_log_record_t& record, const char* value) {
+    if (value == nullptr) value = "(null)";
+    if (record.truncated || record.length + 2 > DEBUG_LOG_RECORD_DATA) {
+        record.truncated = true;
+        return;
+    }
+    size_t room = DEBUG_LOG_RECORD_DATA - record.length - 2;
+    record.data[record.length++] = DEBUG_ARG_STRING;
+    uint8_t* size = &record.data[record.length++];
+    // Byte loop, not strnlen(): room may exceed an inlined literal's size,
+    // which GCC reports as an overread even though the copy stops at NUL
+    size_t n = 0;
+    for (; n < room && value[n] != '\0'; n++) {
+        record.data[record.length + n] = (uint8_t)value[n];
+    }
+    *size = (uint8_t)n;
+    record.length += n;
+    if (value[n] != '\0') {
+        record.truncated = true;
+    }
+}
+
+template <typename T>
+inline void put_arg(debug_log_record_t& record, T value) {
+    if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+        put_string(record, value);
+    } else if constexpr (std::is_null_pointer_v<T>) {
+        put_string(record, nullptr);    // Formatted as "(null)", as printf does
+    } else if constexpr (std::is_enum_v<T>) {
+        put_arg(record, (std::underlying_type_t<T>)value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double v = value;
+        put(record, DEBUG_ARG_DOUBLE, &v, sizeof(v));
+    } else if constexpr (std::is_pointer_v<T>) {
+        const void* v = value;
+        put(record, DEBUG_ARG_POINTER, &v, sizeof(v));
+    } else if constexpr (sizeof(T) > 4 && std::is_signed_v<T>) {
+        int64_t v = value;
+        put(record, DEBUG_ARG_INT64, &v, sizeof(v));
+    } else if constexpr (sizeof(T) > 4) {
+        uint64_t v = value;
+        put(record, DEBUG_ARG_UINT64, &v, sizeof(v));
+    } else if constexpr (std::is_signed_v<T>) {
+        int32_t v = value;
+        put(record, DEBUG_ARG_INT32, &v, sizeof(v));
+    } else {
+        uint32_t v = value;     // Also bool and unsigned char/short
+        put(record, DEBUG_ARG_UINT32, &v, sizeof(v));
+    }
+}
+
+} // namespace debug_log
+
+#endif // DEBUG_LOG_H
@@ -8,21 +8,14 @@
  * protection systems.
  */
 
-#include "mqtt_helper.h"
+#include "module_runtime.h"
 #include "debug_helper.h"
-#include "sensor_filter_c.h"
 #include "sensor_calibration.h"
+#include "telemetry_frame.h"
+#include "actuator_task.h"
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <driver/adc.h>
-#include <esp_adc_cal.h>
-#include <esp_timer.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-
-// Sensor filter instances for environmental monitoring
-sensor_filter_t tempFilter;
-sensor_filter_t humidityFilter;
 
 // ==================== Hardware Configuration ====================
 #define DEPLOY_PIN         12    // Greenhouse deployment control pin
@@ -32,53 +25,79 @@ sensor_filter_t humidityFilter;
 #define TEMP_SENSOR_PIN    ADC1_CHANNEL_0    // Temperature sensor (ADC1_CH0 - GPIO36)
 #define HUMIDITY_PIN       ADC1_CHANNEL_3    // Humidity sensor (ADC1_CH3 - GPIO39)
 
-// ==================== Network Configuration ====================
-const char* WIFI_SSID = "Your_WiFi_SSID";
-const char* WIFI_PASS = "Your_WiFi_Password";
-const char* MQTT_BROKER = "192.168.1.100";
-const int   MQTT_PORT = 1883;
+#ifndef SAMPLE_PERIOD_MS
+#define SAMPLE_PERIOD_MS   1000   // Acquisition period (1 Hz)
+#endif
+#define ACTIVE_SAMPLE_PERIOD_MS 200  // Acquisition period while actuating (5 Hz)
+#define MOTION_TIMEOUT_MS  5000   // Deploy/retract must finish within 5 s
+
+// Environmental sensors (filter chosen per channel; field order is the
+// telemetry field order shared by JSON and binary payloads)
+static const module_channel_t SENSOR_CHANNELS[] = {
+    {   // Slow signal, heavy smoothing
+        .field = "temperature", .calibration_name = "temperature",
+        .source = MODULE_SOURCE_ADC, .pin = TEMP_SENSOR_PIN,
+        .filter = MODULE_FILTER_KALMAN, .process_variance = 1e-3f, .measurement_variance = 1e-1f,
+        .default_curve = &CALIBRATION_DEFAULT_TEMPERATURE,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(0.25f),     // 0.25 °C
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(1.0f)},    // °C per s
+    },
+    {   // Low-lag smoothing
+        .field = "humidity", .calibration_name = "humidity",
+        .source = MODULE_SOURCE_ADC, .pin = HUMIDITY_PIN,
+        .filter = MODULE_FILTER_EMA,
+        .default_curve = &CALIBRATION_DEFAULT_HUMIDITY,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(1.0f),      // 1 %RH
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(5.0f)},    // %RH per s
+    },
+};
 
-// MQTT Topics for communication with central control system
-const char* TOPIC_COMMAND = "exoskeleton/greenhouse/command";
-const char* TOPIC_STATUS = "exoskeleton/greenhouse/status";
-const char* TOPIC_SENSORS = "exoskeleton/greenhouse/sensors";
+// Position feedback, published as bools
+static const module_flag_t SENSOR_FLAGS[] = {
+    {"deployed", DEPLOY_FEEDBACK_PIN},
+    {"retracted", RETRACT_FEEDBACK_PIN},
+};
+
+// Actuator state machine (runs on the actuator task)
+enum { EVENT_DEPLOY = ACTUATOR_EVENT_USER, EVENT_RETRACT };
+typedef enum { GREENHOUSE_IDLE, GREENHOUSE_DEPLOYING, GREENHOUSE_RETRACTING } greenhouse_state_t;
+static greenhouse_state_t actuatorState = GREENHOUSE_IDLE;
 
 // ==================== Function Declarations ====================
 void app_main();
-void greenhouse_task(void *pvParameter);
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length);
-void publishSensorData();
-void processCommand(cJSON* command);
+void handleDeploy(const cJSON* params);
+void handleRetract(const cJSON* params);
 void deployGreenhouse();
 void retractGreenhouse();
-void sendStatus(const char* state, const char* message);
+void greenhouseStateMachine(const actuator_event_t* event);
 void initializeHardware();
 
+// Module commands (the runtime adds the ones listed in module_runtime.h)
+static const command_entry_t COMMANDS[] = {
+    {"deploy", handleDeploy},
+    {"retract", handleRetract},
+};
+
+static const module_descriptor_t GREENHOUSE_MODULE = {
+    .name = "greenhouse",
+    .client_id = "ESP32_Greenhouse",
+    .telemetry_id = TELEMETRY_MODULE_GREENHOUSE,
+    .channels = SENSOR_CHANNELS,
+    .channel_count = sizeof(SENSOR_CHANNELS) / sizeof(SENSOR_CHANNELS[0]),
+    .flags = SENSOR_FLAGS,
+    .flag_count = sizeof(SENSOR_FLAGS) / sizeof(SENSOR_FLAGS[0]),
+    .commands = COMMANDS,
+    .command_count = sizeof(COMMANDS) / sizeof(COMMANDS[0]),
+    .state_machine = greenhouseStateMachine,
+    .init_hardware = initializeHardware,
+    .sample_period_ms = SAMPLE_PERIOD_MS,
+    .active_sample_period_ms = ACTIVE_SAMPLE_PERIOD_MS,
+    .power_mode = POWER_MODE,
+};
+
 // ==================== Main Program ====================
 void app_main() {
-    DebugHelper::initialize();
-    
-    // Initialize sensor filters for environmental monitoring
-    sensor_filter_init(&tempFilter);
-    sensor_filter_init(&humidityFilter);
-    
-    // Initialize hardware peripherals
-    initializeHardware();
-    
-    // Initialize MQTT helper with network credentials
-    mqtt_helper_init(WIFI_SSID, WIFI_PASS, MQTT_BROKER, MQTT_PORT, 
-                    "ESP32_Greenhouse", mqttCallback);
-    
-    // Connect to WiFi and MQTT broker
-    if (mqtt_helper_connect_wifi() && mqtt_helper_connect_broker()) {
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-    }
-    
-    DebugHelper::info("Greenhouse module initialization complete");
-    sendStatus("IDLE", "System startup");
-    
-    // Create main task for continuous operation
-    xTaskCreate(greenhouse_task, "greenhouse_task", 4096, NULL, 5, NULL);
+    module_start(&GREENHOUSE_MODULE);
 }
 
 void initializeHardware() {
@@ -92,191 +111,111 @@ void initializeHardware() {
     };
     gpio_config(&output_conf);
     
-    // Configure feedback pins as inputs with pullup
+    // Configure feedback pins as inputs with pullup, interrupting on arrival
     gpio_config_t input_conf = {
         .pin_bit_mask = (1ULL << DEPLOY_FEEDBACK_PIN) | (1ULL << RETRACT_FEEDBACK_PIN),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_ENABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+        .intr_type = GPIO_INTR_POSEDGE
     };
     gpio_config(&input_conf);
+    actuator_watch_gpio(DEPLOY_FEEDBACK_PIN);
+    actuator_watch_gpio(RETRACT_FEEDBACK_PIN);
     
     // Set initial state - both actuators off
     gpio_set_level(DEPLOY_PIN, 0);
     gpio_set_level(RETRACT_PIN, 0);
-    
-    // Configure ADC for environmental sensors
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(TEMP_SENSOR_PIN, ADC_ATTEN_DB_0);
-    adc1_config_channel_atten(HUMIDITY_PIN, ADC_ATTEN_DB_0);
 }
 
-void greenhouse_task(void *pvParameter) {
-    while (1) {
-        // Process MQTT messages
-        mqtt_helper_loop();
-        
-        static unsigned long lastUpdate = 0;
-        unsigned long current_time = (unsigned long)(esp_timer_get_time() / 1000);
-        if (current_time - lastUpdate > 1000) { // Update sensor data every second
-            publishSensorData();
-            lastUpdate = current_time;
-        }
-        
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+// ==================== Command Processing ====================
+void handleDeploy(const cJSON* params) {
+    deployGreenhouse();
 }
 
-// ==================== MQTT Callback ====================
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
-    DebugHelper::info("Received message [%s]", topic);
-    
-    // Handle internal resubscription message for connection recovery
-    if (strcmp(topic, "internal/resubscribe") == 0) {
-        DebugHelper::info("Resubscribing to topic: %s", TOPIC_COMMAND);
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-        return;
-    }
-    
-    // Create null-terminated string from payload
-    char* json_string = (char*)malloc(length + 1);
-    memcpy(json_string, payload, length);
-    json_string[length] = '\0';
-    
-    // Parse JSON command
-    cJSON* json = cJSON_Parse(json_string);
-    free(json_string);
-    
-    if (json == NULL) {
-        DebugHelper::error("JSON parsing failed");
-        return;
-    }
-    
-    // Process command
-    if (strcmp(topic, TOPIC_COMMAND) == 0) {
-        processCommand(json);
-    }
-    
-    cJSON_Delete(json);
+void handleRetract(const cJSON* params) {
+    retractGreenhouse();
 }
 
-// ==================== Sensor Data Publishing ====================
-void publishSensorData() {
-    // Create JSON object for environmental readings
-    cJSON* json = cJSON_CreateObject();
-    
-    // Read raw sensor values
-    float rawTemp = adc1_get_raw(TEMP_SENSOR_PIN);
-    float rawHumidity = adc1_get_raw(HUMIDITY_PIN);
-    
-    // Apply filtering for stable readings
-    sensor_filter_add_value(&tempFilter, rawTemp);
-    sensor_filter_add_value(&humidityFilter, rawHumidity);
-    
-    // Calibrate sensor readings to real-world units
-    float calibratedTemp = calibrate_temperature(sensor_filter_get_filtered(&tempFilter));
-    float calibratedHumidity = (sensor_filter_get_filtered(&humidityFilter) / 4095.0) * 100.0;  // Convert to percentage
-    
-    // Read position feedback sensors
-    bool isDeployed = gpio_get_level(DEPLOY_FEEDBACK_PIN) == 1;
-    bool isRetracted = gpio_get_level(RETRACT_FEEDBACK_PIN) == 1;
-    
-    // Add sensor data to JSON
-    cJSON_AddNumberToObject(json, "temperature", calibratedTemp);
-    cJSON_AddNumberToObject(json, "humidity", calibratedHumidity);
-    cJSON_AddBoolToObject(json, "deployed", isDeployed);
-    cJSON_AddBoolToObject(json, "retracted", isRetracted);
-    
-    // Serialize and publish sensor data
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_SENSORS, json_string);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    
-    DebugHelper::info("Greenhouse sensor data published");
+// ==================== Greenhouse Control ====================
+// Deploy/retract run as a state machine on the actuator task: commands post
+// an event and return, feedback edges and the timeout finish the motion.
+void deployGreenhouse() {
+    actuator_post(EVENT_DEPLOY, 0, 0);
 }
 
-// ==================== Command Processing ====================
-void processCommand(cJSON* command) {
-    cJSON* action = cJSON_GetObjectItem(command, "action");
-    
-    DebugHelper::info("Executing command: %s", cJSON_GetStringValue(action));
-    
-    if (cJSON_IsString(action) && strcmp(action->valuestring, "deploy") == 0) {
-        deployGreenhouse();
-    }
-    else if (cJSON_IsString(action) && strcmp(action->valuestring, "retract") == 0) {
-        retractGreenhouse();
-    }
-    else {
-        DebugHelper::warning("Unknown command: %s", cJSON_GetStringValue(action));
+void retractGreenhouse() {
+    actuator_post(EVENT_RETRACT, 0, 0);
+}
+
+static void endMotion(bool completed) {
+    bool deploying = actuatorState == GREENHOUSE_DEPLOYING;
+    
+    // Stop the active mechanism
+    gpio_set_level(deploying ? DEPLOY_PIN : RETRACT_PIN, 0);
+    actuator_cancel_timers();
+    actuatorState = GREENHOUSE_IDLE;
+    
+    if (!completed) {
+        module_send_status("ERROR", deploying ? "Greenhouse deployment timeout" : "Greenhouse retraction timeout");
+        DebugHelper::error(deploying ? "Deployment timeout - operation aborted"
+                                     : "Retraction timeout - operation aborted");
+    } else if (deploying) {
+        DebugHelper::info("Greenhouse deployment completed successfully");
+        module_send_status("DEPLOYED", "Greenhouse deployment complete");
+    } else {
+        DebugHelper::info("Greenhouse retraction completed successfully");
+        module_send_status("RETRACTED", "Greenhouse retraction complete");
     }
 }
 
-// ==================== Greenhouse Control ====================
-void deployGreenhouse() {
-    sendStatus("DEPLOYING", "Deploying greenhouse...");
+static void beginMotion(greenhouse_state_t state) {
+    bool deploying = state == GREENHOUSE_DEPLOYING;
+    int feedbackPin = deploying ? DEPLOY_FEEDBACK_PIN : RETRACT_FEEDBACK_PIN;
     
-    // Activate deployment mechanism
-    gpio_set_level(DEPLOY_PIN, 1);
+    module_send_status(deploying ? "DEPLOYING" : "RETRACTING",
+                       deploying ? "Deploying greenhouse..." : "Retracting greenhouse...");
     
-    // Wait for deployment completion signal with timeout
-    unsigned long startTime = (unsigned long)(esp_timer_get_time() / 1000);
-    while (gpio_get_level(DEPLOY_FEEDBACK_PIN) == 0) {
-        if ((unsigned long)(esp_timer_get_time() / 1000) - startTime > 5000) { // 5 second timeout
-            sendStatus("ERROR", "Greenhouse deployment timeout");
-            gpio_set_level(DEPLOY_PIN, 0);
-            DebugHelper::error("Deployment timeout - operation aborted");
-            return;
-        }
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
+    // Activate mechanism and arm the completion timeout
+    gpio_set_level(deploying ? DEPLOY_PIN : RETRACT_PIN, 1);
+    actuatorState = state;
+    actuator_set_timeout(MOTION_TIMEOUT_MS);
     
-    // Stop deployment mechanism
-    gpio_set_level(DEPLOY_PIN, 0);
-    DebugHelper::info("Greenhouse deployment completed successfully");
-    sendStatus("DEPLOYED", "Greenhouse deployment complete");
+    // Already at the end position: no edge will follow
+    if (gpio_get_level(feedbackPin) == 1) {
+        endMotion(true);
+    }
 }
 
-void retractGreenhouse() {
-    sendStatus("RETRACTING", "Retracting greenhouse...");
-    
-    // Activate retraction mechanism
-    gpio_set_level(RETRACT_PIN, 1);
-    
-    // Wait for retraction completion signal with timeout
-    unsigned long startTime = (unsigned long)(esp_timer_get_time() / 1000);
-    while (gpio_get_level(RETRACT_FEEDBACK_PIN) == 0) {
-        if ((unsigned long)(esp_timer_get_time() / 1000) - startTime > 5000) { // 5 second timeout
-            sendStatus("ERROR", "Greenhouse retraction timeout");
-            gpio_set_level(RETRACT_PIN, 0);
-            DebugHelper::error("Retraction timeout - operation aborted");
-            return;
+void greenhouseStateMachine(const actuator_event_t* event) {
+    switch (event->type) {
+        case EVENT_DEPLOY:
+        case EVENT_RETRACT:
+            if (actuatorState != GREENHOUSE_IDLE) {
+                DebugHelper::warning("Greenhouse busy, command ignored");
+                module_send_status(actuatorState == GREENHOUSE_DEPLOYING ? "DEPLOYING" : "RETRACTING",
+                                   "Command ignored, motion in progress");
+                break;
+            }
+            beginMotion(event->type == EVENT_DEPLOY ? GREENHOUSE_DEPLOYING : GREENHOUSE_RETRACTING);
+            break;
+        
+        case ACTUATOR_EVENT_GPIO: {
+            // Completion signal from the feedback switch of the active motion
+            int pin = event->args[0];
+            bool expected = (actuatorState == GREENHOUSE_DEPLOYING && pin == DEPLOY_FEEDBACK_PIN) ||
+                            (actuatorState == GREENHOUSE_RETRACTING && pin == RETRACT_FEEDBACK_PIN);
+            if (expected && gpio_get_level(pin) == 1) {
+                endMotion(true);
+            }
+            break;
         }
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        
+        case ACTUATOR_EVENT_TIMEOUT:
+            if (actuatorState != GREENHOUSE_IDLE) {
+                endMotion(false);
+            }
+            break;
     }
-    
-    // Stop retraction mechanism
-    gpio_set_level(RETRACT_PIN, 0);
-    DebugHelper::info("Greenhouse retraction completed successfully");
-    sendStatus("RETRACTED", "Greenhouse retraction complete");
 }
 
-// ==================== Status Reporting ====================
-void sendStatus(const char* state, const char* message) {
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddStringToObject(json, "module", "greenhouse");
-    cJSON_AddStringToObject(json, "state", state);
-    cJSON_AddStringToObject(json, "message", message);
-    cJSON_AddNumberToObject(json, "timestamp", (unsigned long)(esp_timer_get_time() / 1000));
-    
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_STATUS, json_string);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    
-    DebugHelper::info("Status report: %s - %s", state, message);
-}
@@ -0,0 +1,441 @@
+/**
+ * @file bench_main.cpp
+ * @brief Hot-path micro-benchmarks of the shared components (host build)
+ *
+ * Measures what runs for every sample or message on the firmware:
+ *  - filter/<kind>       add + read of one sample (sensor_filter_c.h)
+ *  - calibrate/apply     calibration_apply() of one sample
+ *  - calibrate/expand_*  calibration_set_curve() of a full table
+ *  - anomaly/check_4     anomaly_detector_check() of a 4-channel sample
+ *  - serialize/<format>_<n>  push of n samples + telemetry_batch_flush()
+ *                        through mqtt_helper into the mock broker; bytes
+ *                        is the published payload size (delta, delta_lz:
+ *                        binary with that codec, telemetry_codec.h)
+ *  - codec/lz_*          LZ stage alone on a delta-encoded 64-sample frame
+ *                        body; the run fails if the round trip differs
+ *  - log/<call>          DebugHelper calls into a discarding sink
+ *
+ * Each benchmark runs BENCH_REPEATS times and reports its fastest run, which
+ * is the least disturbed by the host scheduler.
+ *
+ * Usage: bench [--baseline FILE [--tolerance PERCENT]] [--write-baseline FILE]
+ *
+ * With a baseline (CSV "name,ns_per_op,bytes"), the run fails when a
+ * benchmark is more than PERCENT slower (default 200, timing is machine
+ * dependent; plus BENCH_SLACK_NS) or a payload size differs at all (sizes
+ * are deterministic). Regenerate the baseline with --write-baseline on the
+ * machine that runs the check.
+ */
+
+#include "anomaly_detector.h"
+#include "debug_helper.h"
+#include "json_arena.h"
+#include "mqtt_helper.h"
+#include "offline_queue.h"
+#include "sensor_calibration.h"
+#include "sensor_filter_c.h"
+#include "telemetry_batch.h"
+#include "telemetry_frame.h"
+#include "telemetry_codec.h"
+#include <mock_mqtt.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_REPEATS       7
+#define BENCH_SAMPLES       4096        // Input samples, cycled
+#define BENCH_TOLERANCE     200         // Default allowed slowdown (percent)
+#define BENCH_SLACK_NS      2.0         // Absolute allowance for near-zero timings
+
+typedef struct {
+    std::string name;
+    double ns_per_op;
+    size_t bytes;                       // Payload size, 0 when not applicable
+} bench_result_t;
+
+static std::vector<bench_result_t> results;
+static sensor_value_t inputs[BENCH_SAMPLES];
+static volatile sensor_value_t sink;    // Keeps results observable
+
+// Raw ADC-like input: a slow ramp with noise and occasional spikes
+static void make_inputs() {
+    uint32_t state = 12345;
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        state = state * 1664525u + 1013904223u;
+        int noise = (int)(state >> 24) % 16 - 8;
+        int spike = (state & 0xff) == 0 ? 900 : 0;
+        int raw = (int)(i % 4000) + noise + spike;
+        raw = raw < 0 ? 0 : (raw > 4095 ? 4095 : raw);
+#if SENSOR_FIXED_POINT
+        inputs[i] = raw;
+#else
+        inputs[i] = (float)raw + (float)(state & 0xff) / 256.0f;     // Oversampled fraction
+#endif
+    }
+}
+
+// Fastest ns per operation of fn(ops) over BENCH_REPEATS runs
+template <typename Fn>
+static double measure(size_t ops, Fn&& fn) {
+    double best = 1e300;
+    fn(ops / 8 + 1);                    // Warm caches and branch predictors
+    for (int run = 0; run < BENCH_REPEATS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        fn(ops);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (double)ops;
+        if (ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+static void report(const char* name, double ns_per_op, size_t bytes = 0) {
+    results.push_back({name, ns_per_op, bytes});
+    if (bytes > 0) {
+        printf("%-28s %12.1f %8u\n", name, ns_per_op, (unsigned)bytes);
+    } else {
+        printf("%-28s %12.1f %8s\n", name, ns_per_op, "-");
+    }
+}
+
+// ==================== Filters ====================
+template <typename Filter, typename Add, typename Get>
+static void bench_filter(const char* name, Filter* filter, Add add, Get get) {
+    report(name, measure(1000000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            add(filter, inputs[i % BENCH_SAMPLES]);
+            sink = get(filter);
+        }
+    }));
+}
+
+static void bench_filters() {
+    static sensor_filter_t average;
+    static sensor_ema_t ema;
+    static sensor_median_t median;
+    static sensor_kalman_t kalman(1e-4f, 1e-1f);
+    sensor_filter_init(&average);
+    sensor_ema_init(&ema);
+    sensor_median_init(&median);
+
+    bench_filter("filter/average", &average, sensor_filter_add_value, sensor_filter_get_filtered);
+    bench_filter("filter/ema", &ema, sensor_ema_add_value, sensor_ema_get_filtered);
+    bench_filter("filter/median", &median, sensor_median_add_value, sensor_median_get_filtered);
+    bench_filter("filter/kalman", &kalman, sensor_kalman_add_value, sensor_kalman_get_filtered);
+}
+
+// ==================== Calibration ====================
+static const calibration_curve_t LUT_CURVE = {
+    .type = CALIBRATION_CURVE_LUT,
+    .count = 16,
+    .coefficients = {},
+    .point_x = {},
+    .point_y = {0, 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 66, 78, 91, 105, 120},
+};
+
+static void bench_calibration() {
+    static calibration_channel_t channel;     // 16 KB table
+    calibration_init(&channel, "bench", &CALIBRATION_DEFAULT_PRESSURE);
+
+    report("calibrate/apply", measure(1000000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            sink = calibration_apply(&channel, inputs[i % BENCH_SAMPLES]);
+        }
+    }));
+
+    const struct {
+        const char* name;
+        const calibration_curve_t* curve;
+    } curves[] = {
+        {"calibrate/expand_linear", &CALIBRATION_DEFAULT_TEMPERATURE},
+        {"calibrate/expand_poly", &CALIBRATION_DEFAULT_PRESSURE},
+        {"calibrate/expand_piecewise", &CALIBRATION_DEFAULT_FLOW},
+        {"calibrate/expand_lut", &LUT_CURVE},
+    };
+    for (const auto& entry : curves) {
+        report(entry.name, measure(200, [&](size_t ops) {
+            for (size_t i = 0; i < ops; i++) {
+                calibration_set_curve(&channel, entry.curve, false);
+            }
+        }));
+    }
+}
+
+// ==================== Anomaly Detection ====================
+static void bench_anomaly() {
+    static const anomaly_rule_t rules[4] = {
+        {4.0f, SENSOR_VALUE_FROM_FLOAT(1000.0f)}, {4.0f, 0}, {0.0f, SENSOR_VALUE_FROM_FLOAT(1000.0f)},
+        {4.0f, SENSOR_VALUE_FROM_FLOAT(1000.0f)},
+    };
+    static const sensor_value_t deadband[4] = {
+        SENSOR_VALUE_FROM_FLOAT(1.0f), SENSOR_VALUE_FROM_FLOAT(1.0f),
+        SENSOR_VALUE_FROM_FLOAT(1.0f), SENSOR_VALUE_FROM_FLOAT(1.0f),
+    };
+    static const char* const fields[4] = {"a", "b", "c", "d"};
+    static const anomaly_detector_config_t config = {4, rules, deadband, fields, nullptr,
+                                                     nullptr, nullptr};
+    anomaly_detector_init(&config);
+
+    // Onsets only queue a report here: nothing is busy and poll() is not called
+    int64_t timestamp_us = 0;
+    report("anomaly/check_4", measure(1000000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            timestamp_us += 10000;
+            sink = anomaly_detector_check(timestamp_us, &inputs[i % (BENCH_SAMPLES - 4)]);
+        }
+    }));
+}
+
+// ==================== Serialization ====================
+static const char* const FLOAT_FIELDS[] = {"temperature", "humidity", "soil_moisture", "light_level"};
+static const char* const BOOL_FIELDS[] = {"pump_active", "fan_active"};
+static const telemetry_schema_t SCHEMA = {
+    .module_id = TELEMETRY_MODULE_GREENHOUSE,
+    .float_names = FLOAT_FIELDS,
+    .float_count = 4,
+    .bool_names = BOOL_FIELDS,
+    .bool_count = 2,
+};
+
+// Returns the payload whose size is reported
+static std::string bench_serialize(const char* name, telemetry_format_t format,
+                                   telemetry_codec_t codec, size_t batch_size) {
+    static telemetry_batch_t batch;
+    telemetry_batch_init(&batch, &SCHEMA, "exoskeleton/bench/sensors");
+    telemetry_batch_configure(&batch, batch_size, TELEMETRY_BATCH_FLUSH_MS);
+    telemetry_set_format(format);
+    telemetry_set_codec(codec);
+
+    int64_t timestamp_us = 0;
+    size_t next = 0;
+    auto publish_one = [&]() {
+        for (size_t s = 0; s < batch_size; s++) {
+            sensor_value_t values[4];
+            for (int f = 0; f < 4; f++) {
+                values[f] = inputs[next++ % BENCH_SAMPLES] / 40;
+            }
+            timestamp_us += 100000;
+            telemetry_batch_push(&batch, timestamp_us, values, (uint8_t)(next & 3));
+        }
+        telemetry_batch_flush(&batch, (uint32_t)(timestamp_us / 1000), true);
+    };
+
+    // Size of one message, then time without recording payloads
+    mock_mqtt_clear();
+    mock_mqtt_set_recording(true);
+    publish_one();
+    std::vector<mock_mqtt_message_t> published = mock_mqtt_published();
+    std::string payload = published.empty() ? std::string() : published.back().payload;
+    size_t bytes = payload.size();
+    if (bytes == 0) {
+        fprintf(stderr, "%s: nothing published\n", name);
+    }
+
+    mock_mqtt_set_recording(false);
+    next = 0;
+    double ns = measure(20000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            publish_one();
+        }
+    });
+    mock_mqtt_set_recording(true);
+    report(name, ns, bytes);
+    return payload;
+}
+
+static bool bench_lz(const std::string& frame) {
+    const uint8_t* body = (const uint8_t*)frame.data() + TELEMETRY_FRAME_HEADER_SIZE;
+    size_t length = frame.size() - TELEMETRY_FRAME_HEADER_SIZE;
+    static uint8_t packed[TELEMETRY_BATCH_MAX_FRAME_SIZE];
+    static uint8_t unpacked[TELEMETRY_BATCH_MAX_FRAME_SIZE];
+
+    size_t packed_length = 0;
+    double ns = measure(20000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            packed_length = telemetry_lz_compress(body, length, packed, sizeof(packed));
+        }
+    });
+    report("codec/lz_compress", ns, packed_length);
+    size_t unpacked_length = 0;
+    ns = measure(20000, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            unpacked_length = telemetry_lz_decompress(packed, packed_length, unpacked, sizeof(unpacked));
+        }
+    });
+    report("codec/lz_decompress", ns, unpacked_length);
+
+    if (packed_length == 0 || unpacked_length != length || memcmp(unpacked, body, length) != 0) {
+        fprintf(stderr, "codec/lz: round trip of %u bytes failed\n", (unsigned)length);
+        return false;
+    }
+    return true;
+}
+
+static bool bench_serialization() {
+    bench_serialize("serialize/json_1", TELEMETRY_FORMAT_JSON, TELEMETRY_CODEC_RAW, 1);
+    bench_serialize("serialize/json_10", TELEMETRY_FORMAT_JSON, TELEMETRY_CODEC_RAW, 10);
+    bench_serialize("serialize/binary_1", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_RAW, 1);
+    bench_serialize("serialize/binary_10", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_RAW, 10);
+    bench_serialize("serialize/delta_10", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_DELTA, 10);
+    bench_serialize("serialize/delta_lz_10", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_DELTA_LZ, 10);
+    bench_serialize("serialize/binary_64", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_RAW, 64);
+    std::string delta = bench_serialize("serialize/delta_64", TELEMETRY_FORMAT_BINARY,
+                                        TELEMETRY_CODEC_DELTA, 64);
+    bench_serialize("serialize/delta_lz_64", TELEMETRY_FORMAT_BINARY, TELEMETRY_CODEC_DELTA_LZ, 64);
+    telemetry_set_format(TELEMETRY_DEFAULT_FORMAT);
+    telemetry_set_codec(TELEMETRY_DEFAULT_CODEC);
+    return bench_lz(delta);
+}
+
+// ==================== Logging ====================
+static size_t logged_bytes = 0;
+
+static void discard_sink(const char* line, size_t length) {
+    (void)line;
+    logged_bytes += length;
+}
+
+static void bench_logging() {
+    DebugHelper::setSink(discard_sink);
+    DebugHelper::debugLevel = DEBUG_LEVEL_INFO;
+
+    report("log/info_text", measure(200000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            DebugHelper::info("MQTT connected!");
+        }
+    }));
+    report("log/info_format", measure(200000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            DebugHelper::info("Injecting - depth %d mm, pressure %.2f kPa (%s)",
+                              (int)(i & 127), SENSOR_VALUE_TO_FLOAT(inputs[i % BENCH_SAMPLES]), "ok");
+        }
+    }));
+    report("log/sensor", measure(200000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            DebugHelper::logSensor("temperature", SENSOR_VALUE_TO_FLOAT(inputs[i % BENCH_SAMPLES]), "C");
+        }
+    }));
+    report("log/verbose_filtered", measure(1000000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            DebugHelper::verbose("Telemetry batch published: %u samples", (unsigned)i);
+        }
+    }));
+    DebugHelper::flush();
+}
+
+// ==================== Baseline ====================
+static bool load_baseline(const char* path, std::map<std::string, bench_result_t>* baseline) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Cannot open baseline %s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char name[128];
+        double ns;
+        unsigned bytes;
+        if (line[0] != '#' && sscanf(line, "%127[^,],%lf,%u", name, &ns, &bytes) == 3) {
+            (*baseline)[name] = {name, ns, bytes};
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool write_baseline(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Cannot write baseline %s\n", path);
+        return false;
+    }
+    fprintf(file, "# name,ns_per_op,bytes (host/bench/bench_main.cpp)\n");
+    for (const bench_result_t& result : results) {
+        fprintf(file, "%s,%.1f,%u\n", result.name.c_str(), result.ns_per_op, (unsigned)result.bytes);
+    }
+    fclose(file);
+    return true;
+}
+
+static int check_baseline(const char* path, double tolerance) {
+    std::map<std::string, bench_result_t> baseline;
+    if (!load_baseline(path, &baseline)) {
+        return 1;
+    }
+    int failures = 0;
+    for (const bench_result_t& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end()) {
+            printf("NEW   %s (not in baseline)\n", result.name.c_str());
+            continue;
+        }
+        const bench_result_t& expected = it->second;
+        double limit = expected.ns_per_op * (1.0 + tolerance / 100.0) + BENCH_SLACK_NS;
+        if (result.ns_per_op > limit) {
+            printf("SLOW  %s: %.1f ns/op, baseline %.1f (limit %.1f)\n",
+                   result.name.c_str(), result.ns_per_op, expected.ns_per_op, limit);
+            failures++;
+        }
+        if (result.bytes != expected.bytes) {
+            printf("SIZE  %s: %u bytes, baseline %u\n",
+                   result.name.c_str(), (unsigned)result.bytes, (unsigned)expected.bytes);
+            failures++;
+        }
+    }
+    printf("%d regression%s against %s\n", failures, failures == 1 ? "" : "s", path);
+    return failures > 0 ? 1 : 0;
+}
+
+// ==================== Main ====================
+static void connect_mock_broker() {
+    json_arena_init();
+    mqtt_helper_init("bench", "bench", "127.0.0.1", 1883, "bench", nullptr);
+    offline_queue_init(OFFLINE_POLICY_DROP_OLDEST);
+    if (!mqtt_helper_connect_wifi() || !mqtt_helper_connect_broker()) {
+        fprintf(stderr, "Mock broker connection failed\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* baseline = nullptr;
+    const char* output = nullptr;
+    double tolerance = BENCH_TOLERANCE;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--baseline FILE [--tolerance PERCENT]] [--write-baseline FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    connect_mock_broker();
+    make_inputs();
+    DebugHelper::setSink(discard_sink);     // Keep setup chatter out of the table
+
+    printf("%-28s %12s %8s\n", "benchmark", "ns/op", "bytes");
+    bench_filters();
+    bench_calibration();
+    bench_anomaly();
+    bool codec_ok = bench_serialization();
+    bench_logging();
+    if (!codec_ok) {
+        return 1;
+    }
+
+    if (output != nullptr && !write_baseline(output)) {
+        return 1;
+    }
+    return baseline != nullptr ? check_baseline(baseline, tolerance) : 0;
+}
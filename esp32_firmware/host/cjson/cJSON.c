@@ -0,0 +1,795 @@
+/*
+ * Host build: cJSON API subset used by the firmware (see cJSON.h)
+ */
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* (*cjson_malloc)(size_t) = malloc;
+static void (*cjson_free)(void*) = free;
+static const char* error_ptr = NULL;
+
+const char* cJSON_Version(void) {
+    static char version[16];
+    snprintf(version, sizeof(version), "%d.%d.%d", CJSON_VERSION_MAJOR, CJSON_VERSION_MINOR, CJSON_VERSION_PATCH);
+    return version;
+}
+
+void cJSON_InitHooks(cJSON_Hooks* hooks) {
+    cjson_malloc = (hooks != NULL && hooks->malloc_fn != NULL) ? hooks->malloc_fn : malloc;
+    cjson_free = (hooks != NULL && hooks->free_fn != NULL) ? hooks->free_fn : free;
+}
+
+void* cJSON_malloc(size_t size) {
+    return cjson_malloc(size);
+}
+
+void cJSON_free(void* object) {
+    cjson_free(object);
+}
+
+static char* duplicate(const char* string) {
+    size_t length = strlen(string) + 1;
+    char* copy = (char*)cjson_malloc(length);
+    if (copy != NULL) {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+static cJSON* new_item(int type) {
+    cJSON* item = (cJSON*)cjson_malloc(sizeof(cJSON));
+    if (item != NULL) {
+        memset(item, 0, sizeof(cJSON));
+        item->type = type;
+    }
+    return item;
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != NULL) {
+        cJSON* next = item->next;
+        if (!(item->type & cJSON_IsReference) && item->child != NULL) {
+            cJSON_Delete(item->child);
+        }
+        if (!(item->type & cJSON_IsReference) && item->valuestring != NULL) {
+            cjson_free(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst) && item->string != NULL) {
+            cjson_free(item->string);
+        }
+        cjson_free(item);
+        item = next;
+    }
+}
+
+// ==================== Parsing ====================
+typedef struct {
+    const unsigned char* content;
+    size_t length;
+    size_t offset;
+    size_t depth;
+} parse_buffer;
+
+#define can_read(buffer, size) ((buffer)->offset + (size) <= (buffer)->length)
+#define at(buffer) ((buffer)->content[(buffer)->offset])
+
+static void skip_whitespace(parse_buffer* buffer) {
+    while (can_read(buffer, 1) && at(buffer) <= 32) {
+        buffer->offset++;
+    }
+}
+
+static cJSON_bool parse_value(cJSON* item, parse_buffer* buffer);
+
+static cJSON_bool parse_number(cJSON* item, parse_buffer* buffer) {
+    char number[64];
+    size_t length = 0;
+    while (can_read(buffer, length + 1) && length < sizeof(number) - 1) {
+        char c = (char)buffer->content[buffer->offset + length];
+        if (!(isdigit((unsigned char)c) || c == '+' || c == '-' || c == 'e' || c == 'E' || c == '.')) {
+            break;
+        }
+        number[length++] = c;
+    }
+    number[length] = '\0';
+    char* end = NULL;
+    double value = strtod(number, &end);
+    if (end == number) {
+        return 0;
+    }
+    item->type = cJSON_Number;
+    cJSON_SetNumberHelper(item, value);
+    buffer->offset += (size_t)(end - number);
+    return 1;
+}
+
+static unsigned parse_hex4(const unsigned char* input) {
+    unsigned value = 0;
+    for (int i = 0; i < 4; i++) {
+        value <<= 4;
+        if (input[i] >= '0' && input[i] <= '9') value += input[i] - '0';
+        else if (input[i] >= 'A' && input[i] <= 'F') value += 10 + input[i] - 'A';
+        else if (input[i] >= 'a' && input[i] <= 'f') value += 10 + input[i] - 'a';
+        else return 0;
+    }
+    return value;
+}
+
+static size_t utf8_encode(unsigned long codepoint, unsigned char* out) {
+    if (codepoint < 0x80) {
+        out[0] = (unsigned char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (unsigned char)(0xc0 | (codepoint >> 6));
+        out[1] = (unsigned char)(0x80 | (codepoint & 0x3f));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (unsigned char)(0xe0 | (codepoint >> 12));
+        out[1] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3f));
+        out[2] = (unsigned char)(0x80 | (codepoint & 0x3f));
+        return 3;
+    }
+    out[0] = (unsigned char)(0xf0 | (codepoint >> 18));
+    out[1] = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3f));
+    out[2] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3f));
+    out[3] = (unsigned char)(0x80 | (codepoint & 0x3f));
+    return 4;
+}
+
+// Parses the string at the buffer (opening quote) into a new allocation
+static char* parse_string_value(parse_buffer* buffer) {
+    if (!can_read(buffer, 1) || at(buffer) != '"') {
+        return NULL;
+    }
+    size_t end = buffer->offset + 1;
+    while (end < buffer->length && buffer->content[end] != '"') {
+        end += buffer->content[end] == '\\' ? 2 : 1;
+    }
+    if (end >= buffer->length) {
+        return NULL;
+    }
+    // Escapes only shrink the text
+    unsigned char* out = (unsigned char*)cjson_malloc(end - buffer->offset);
+    if (out == NULL) {
+        return NULL;
+    }
+    size_t n = 0;
+    const unsigned char* p = &buffer->content[buffer->offset + 1];
+    const unsigned char* stop = &buffer->content[end];
+    while (p < stop) {
+        if (*p != '\\') {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p + 1 >= stop) {
+            goto fail;
+        }
+        switch (p[1]) {
+            case 'b': out[n++] = '\b'; p += 2; break;
+            case 'f': out[n++] = '\f'; p += 2; break;
+            case 'n': out[n++] = '\n'; p += 2; break;
+            case 'r': out[n++] = '\r'; p += 2; break;
+            case 't': out[n++] = '\t'; p += 2; break;
+            case '"': case '\\': case '/': out[n++] = p[1]; p += 2; break;
+            case 'u': {
+                if (stop - p < 6) goto fail;
+                unsigned long codepoint = parse_hex4(p + 2);
+                p += 6;
+                if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+                    if (stop - p < 6 || p[0] != '\\' || p[1] != 'u') goto fail;
+                    unsigned long low = parse_hex4(p + 2);
+                    if (low < 0xdc00 || low > 0xdfff) goto fail;
+                    codepoint = 0x10000 + (((codepoint & 0x3ff) << 10) | (low & 0x3ff));
+                    p += 6;
+                }
+                n += utf8_encode(codepoint, &out[n]);
+                break;
+            }
+            default:
+                goto fail;
+        }
+    }
+    out[n] = '\0';
+    buffer->offset = end + 1;
+    return (char*)out;
+fail:
+    cjson_free(out);
+    return NULL;
+}
+
+static cJSON_bool parse_array(cJSON* item, parse_buffer* buffer) {
+    if (buffer->depth >= CJSON_NESTING_LIMIT) {
+        return 0;
+    }
+    buffer->depth++;
+    item->type = cJSON_Array;
+    buffer->offset++;
+    skip_whitespace(buffer);
+    if (can_read(buffer, 1) && at(buffer) == ']') {
+        buffer->offset++;
+        buffer->depth--;
+        return 1;
+    }
+    cJSON* tail = NULL;
+    for (;;) {
+        cJSON* child = new_item(cJSON_Invalid);
+        if (child == NULL) {
+            return 0;
+        }
+        if (tail == NULL) {
+            item->child = child;
+        } else {
+            tail->next = child;
+            child->prev = tail;
+        }
+        tail = child;
+        item->child->prev = tail;
+        skip_whitespace(buffer);
+        if (!parse_value(child, buffer)) {
+            return 0;
+        }
+        skip_whitespace(buffer);
+        if (!can_read(buffer, 1)) {
+            return 0;
+        }
+        if (at(buffer) == ',') {
+            buffer->offset++;
+            continue;
+        }
+        if (at(buffer) != ']') {
+            return 0;
+        }
+        buffer->offset++;
+        buffer->depth--;
+        return 1;
+    }
+}
+
+static cJSON_bool parse_object(cJSON* item, parse_buffer* buffer) {
+    if (buffer->depth >= CJSON_NESTING_LIMIT) {
+        return 0;
+    }
+    buffer->depth++;
+    item->type = cJSON_Object;
+    buffer->offset++;
+    skip_whitespace(buffer);
+    if (can_read(buffer, 1) && at(buffer) == '}') {
+        buffer->offset++;
+        buffer->depth--;
+        return 1;
+    }
+    cJSON* tail = NULL;
+    for (;;) {
+        cJSON* child = new_item(cJSON_Invalid);
+        if (child == NULL) {
+            return 0;
+        }
+        if (tail == NULL) {
+            item->child = child;
+        } else {
+            tail->next = child;
+            child->prev = tail;
+        }
+        tail = child;
+        item->child->prev = tail;
+        skip_whitespace(buffer);
+        child->string = parse_string_value(buffer);
+        if (child->string == NULL) {
+            return 0;
+        }
+        skip_whitespace(buffer);
+        if (!can_read(buffer, 1) || at(buffer) != ':') {
+            return 0;
+        }
+        buffer->offset++;
+        skip_whitespace(buffer);
+        if (!parse_value(child, buffer)) {
+            return 0;
+        }
+        skip_whitespace(buffer);
+        if (!can_read(buffer, 1)) {
+            return 0;
+        }
+        if (at(buffer) == ',') {
+            buffer->offset++;
+            continue;
+        }
+        if (at(buffer) != '}') {
+            return 0;
+        }
+        buffer->offset++;
+        buffer->depth--;
+        return 1;
+    }
+}
+
+static cJSON_bool starts_with(parse_buffer* buffer, const char* literal) {
+    size_t length = strlen(literal);
+    return can_read(buffer, length) && memcmp(&at(buffer), literal, length) == 0;
+}
+
+static cJSON_bool parse_value(cJSON* item, parse_buffer* buffer) {
+    if (!can_read(buffer, 1)) {
+        return 0;
+    }
+    if (starts_with(buffer, "null")) {
+        item->type = cJSON_NULL;
+        buffer->offset += 4;
+        return 1;
+    }
+    if (starts_with(buffer, "false")) {
+        item->type = cJSON_False;
+        buffer->offset += 5;
+        return 1;
+    }
+    if (starts_with(buffer, "true")) {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        buffer->offset += 4;
+        return 1;
+    }
+    unsigned char c = at(buffer);
+    if (c == '"') {
+        item->type = cJSON_String;
+        item->valuestring = parse_string_value(buffer);
+        return item->valuestring != NULL;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        return parse_number(item, buffer);
+    }
+    if (c == '[') {
+        return parse_array(item, buffer);
+    }
+    if (c == '{') {
+        return parse_object(item, buffer);
+    }
+    return 0;
+}
+
+cJSON* cJSON_ParseWithLength(const char* value, size_t buffer_length) {
+    error_ptr = NULL;
+    if (value == NULL || buffer_length == 0) {
+        return NULL;
+    }
+    parse_buffer buffer = {(const unsigned char*)value, buffer_length, 0, 0};
+    cJSON* item = new_item(cJSON_Invalid);
+    if (item == NULL) {
+        return NULL;
+    }
+    skip_whitespace(&buffer);
+    if (!parse_value(item, &buffer)) {
+        error_ptr = value + (buffer.offset < buffer_length ? buffer.offset : buffer_length - 1);
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON* cJSON_Parse(const char* value) {
+    return value != NULL ? cJSON_ParseWithLength(value, strlen(value) + 1) : NULL;
+}
+
+const char* cJSON_GetErrorPtr(void) {
+    return error_ptr;
+}
+
+// ==================== Printing ====================
+typedef struct {
+    char* buffer;
+    size_t length;
+    size_t offset;
+    cJSON_bool format;
+    cJSON_bool fixed;               // Preallocated: never grows
+} print_buffer;
+
+static char* ensure(print_buffer* p, size_t needed) {
+    needed += p->offset + 1;
+    if (needed <= p->length) {
+        return &p->buffer[p->offset];
+    }
+    if (p->fixed) {
+        return NULL;
+    }
+    size_t length = p->length * 2 > needed ? p->length * 2 : needed;
+    char* grown = (char*)cjson_malloc(length);
+    if (grown == NULL) {
+        return NULL;
+    }
+    memcpy(grown, p->buffer, p->offset);
+    cjson_free(p->buffer);
+    p->buffer = grown;
+    p->length = length;
+    return &p->buffer[p->offset];
+}
+
+static cJSON_bool append(print_buffer* p, const char* text, size_t length) {
+    char* out = ensure(p, length);
+    if (out == NULL) {
+        return 0;
+    }
+    memcpy(out, text, length);
+    p->offset += length;
+    p->buffer[p->offset] = '\0';
+    return 1;
+}
+
+static cJSON_bool print_number(const cJSON* item, print_buffer* p) {
+    char number[26];
+    double d = item->valuedouble;
+    int length;
+    if (isnan(d) || isinf(d)) {
+        length = snprintf(number, sizeof(number), "null");
+    } else if (d == (double)item->valueint) {
+        length = snprintf(number, sizeof(number), "%d", item->valueint);
+    } else {
+        double test = 0.0;
+        length = snprintf(number, sizeof(number), "%1.15g", d);
+        if (sscanf(number, "%lg", &test) != 1 || test != d) {
+            length = snprintf(number, sizeof(number), "%1.17g", d);
+        }
+    }
+    return length > 0 && append(p, number, (size_t)length);
+}
+
+static cJSON_bool print_string(const char* text, print_buffer* p) {
+    if (text == NULL) {
+        return append(p, "\"\"", 2);
+    }
+    if (!append(p, "\"", 1)) {
+        return 0;
+    }
+    for (const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++) {
+        char escaped[7];
+        size_t length = 2;
+        escaped[0] = '\\';
+        switch (*c) {
+            case '"': escaped[1] = '"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                if (*c < 32) {
+                    length = (size_t)snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                } else {
+                    escaped[0] = (char)*c;
+                    length = 1;
+                }
+                break;
+        }
+        if (!append(p, escaped, length)) {
+            return 0;
+        }
+    }
+    return append(p, "\"", 1);
+}
+
+static cJSON_bool print_value(const cJSON* item, print_buffer* p, size_t depth);
+
+static cJSON_bool indent(print_buffer* p, size_t depth) {
+    for (size_t i = 0; i < depth; i++) {
+        if (!append(p, "\t", 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static cJSON_bool print_array(const cJSON* item, print_buffer* p, size_t depth) {
+    if (!append(p, "[", 1)) {
+        return 0;
+    }
+    for (const cJSON* child = item->child; child != NULL; child = child->next) {
+        if (!print_value(child, p, depth + 1)) {
+            return 0;
+        }
+        if (child->next != NULL && !append(p, ", ", p->format ? 2 : 1)) {
+            return 0;
+        }
+    }
+    return append(p, "]", 1);
+}
+
+static cJSON_bool print_object(const cJSON* item, print_buffer* p, size_t depth) {
+    if (!append(p, p->format ? "{\n" : "{", p->format ? 2 : 1)) {
+        return 0;
+    }
+    for (const cJSON* child = item->child; child != NULL; child = child->next) {
+        if (p->format && !indent(p, depth + 1)) {
+            return 0;
+        }
+        if (!print_string(child->string, p) || !append(p, ":\t", p->format ? 2 : 1) ||
+            !print_value(child, p, depth + 1)) {
+            return 0;
+        }
+        if (child->next != NULL && !append(p, ",", 1)) {
+            return 0;
+        }
+        if (p->format && !append(p, "\n", 1)) {
+            return 0;
+        }
+    }
+    if (p->format && !indent(p, depth)) {
+        return 0;
+    }
+    return append(p, "}", 1);
+}
+
+static cJSON_bool print_value(const cJSON* item, print_buffer* p, size_t depth) {
+    switch (item->type & 0xff) {
+        case cJSON_NULL: return append(p, "null", 4);
+        case cJSON_False: return append(p, "false", 5);
+        case cJSON_True: return append(p, "true", 4);
+        case cJSON_Number: return print_number(item, p);
+        case cJSON_String: return print_string(item->valuestring, p);
+        case cJSON_Raw:
+            return item->valuestring != NULL && append(p, item->valuestring, strlen(item->valuestring));
+        case cJSON_Array: return print_array(item, p, depth);
+        case cJSON_Object: return print_object(item, p, depth);
+        default: return 0;
+    }
+}
+
+static char* print(const cJSON* item, cJSON_bool format) {
+    if (item == NULL) {
+        return NULL;
+    }
+    print_buffer p = {(char*)cjson_malloc(256), 256, 0, format, 0};
+    if (p.buffer == NULL) {
+        return NULL;
+    }
+    p.buffer[0] = '\0';
+    if (!print_value(item, &p, 0)) {
+        cjson_free(p.buffer);
+        return NULL;
+    }
+    return p.buffer;
+}
+
+char* cJSON_Print(const cJSON* item) {
+    return print(item, 1);
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    return print(item, 0);
+}
+
+cJSON_bool cJSON_PrintPreallocated(cJSON* item, char* buffer, const int length, const cJSON_bool format) {
+    if (item == NULL || buffer == NULL || length <= 0) {
+        return 0;
+    }
+    print_buffer p = {buffer, (size_t)length, 0, format, 1};
+    buffer[0] = '\0';
+    return print_value(item, &p, 0);
+}
+
+// ==================== Access ====================
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    for (const cJSON* child = array != NULL ? array->child : NULL; child != NULL; child = child->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index) {
+    cJSON* child = array != NULL ? array->child : NULL;
+    if (index < 0) {
+        return NULL;
+    }
+    while (child != NULL && index > 0) {
+        child = child->next;
+        index--;
+    }
+    return child;
+}
+
+static int case_compare(const char* a, const char* b) {
+    for (; tolower((unsigned char)*a) == tolower((unsigned char)*b); a++, b++) {
+        if (*a == '\0') {
+            return 0;
+        }
+    }
+    return tolower((unsigned char)*a) - tolower((unsigned char)*b);
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* const object, const char* const string) {
+    if (object == NULL || string == NULL) {
+        return NULL;
+    }
+    for (cJSON* child = object->child; child != NULL; child = child->next) {
+        if (child->string != NULL && case_compare(child->string, string) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON* const object, const char* const string) {
+    if (object == NULL || string == NULL) {
+        return NULL;
+    }
+    for (cJSON* child = object->child; child != NULL; child = child->next) {
+        if (child->string != NULL && strcmp(child->string, string) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+cJSON_bool cJSON_HasObjectItem(const cJSON* object, const char* string) {
+    return cJSON_GetObjectItem(object, string) != NULL;
+}
+
+char* cJSON_GetStringValue(const cJSON* const item) {
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+double cJSON_GetNumberValue(const cJSON* const item) {
+    return cJSON_IsNumber(item) ? item->valuedouble : (double)NAN;
+}
+
+cJSON_bool cJSON_IsInvalid(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_Invalid; }
+cJSON_bool cJSON_IsFalse(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_False; }
+cJSON_bool cJSON_IsTrue(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_True; }
+cJSON_bool cJSON_IsBool(const cJSON* const item) { return item != NULL && (item->type & (cJSON_True | cJSON_False)) != 0; }
+cJSON_bool cJSON_IsNull(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_NULL; }
+cJSON_bool cJSON_IsNumber(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_Number; }
+cJSON_bool cJSON_IsString(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_String; }
+cJSON_bool cJSON_IsArray(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_Array; }
+cJSON_bool cJSON_IsObject(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_Object; }
+cJSON_bool cJSON_IsRaw(const cJSON* const item) { return item != NULL && (item->type & 0xff) == cJSON_Raw; }
+
+// ==================== Construction ====================
+double cJSON_SetNumberHelper(cJSON* object, double number) {
+    if (number >= INT_MAX) {
+        object->valueint = INT_MAX;
+    } else if (number <= (double)INT_MIN) {
+        object->valueint = INT_MIN;
+    } else {
+        object->valueint = (int)number;
+    }
+    object->valuedouble = number;
+    return number;
+}
+
+cJSON* cJSON_CreateNull(void) { return new_item(cJSON_NULL); }
+cJSON* cJSON_CreateTrue(void) { return new_item(cJSON_True); }
+cJSON* cJSON_CreateFalse(void) { return new_item(cJSON_False); }
+cJSON* cJSON_CreateBool(cJSON_bool boolean) { return new_item(boolean ? cJSON_True : cJSON_False); }
+cJSON* cJSON_CreateArray(void) { return new_item(cJSON_Array); }
+cJSON* cJSON_CreateObject(void) { return new_item(cJSON_Object); }
+
+cJSON* cJSON_CreateNumber(double num) {
+    cJSON* item = new_item(cJSON_Number);
+    if (item != NULL) {
+        cJSON_SetNumberHelper(item, num);
+    }
+    return item;
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    cJSON* item = new_item(cJSON_String);
+    if (item != NULL) {
+        item->valuestring = duplicate(string != NULL ? string : "");
+        if (item->valuestring == NULL) {
+            cJSON_Delete(item);
+            return NULL;
+        }
+    }
+    return item;
+}
+
+// Children keep the head's prev pointing at the tail, as in cJSON
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    if (array == NULL || item == NULL || array == item) {
+        return 0;
+    }
+    cJSON* head = array->child;
+    if (head == NULL) {
+        array->child = item;
+        item->prev = item;
+        item->next = NULL;
+    } else {
+        cJSON* tail = head->prev;
+        tail->next = item;
+        item->prev = tail;
+        item->next = NULL;
+        head->prev = item;
+    }
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item) {
+    if (object == NULL || string == NULL || item == NULL) {
+        return 0;
+    }
+    char* key = duplicate(string);
+    if (key == NULL) {
+        return 0;
+    }
+    if (!(item->type & cJSON_StringIsConst) && item->string != NULL) {
+        cjson_free(item->string);
+    }
+    item->string = key;
+    item->type &= ~cJSON_StringIsConst;
+    return cJSON_AddItemToArray(object, item);
+}
+
+cJSON* cJSON_DetachItemFromObject(cJSON* object, const char* string) {
+    cJSON* item = cJSON_GetObjectItem(object, string);
+    if (item == NULL) {
+        return NULL;
+    }
+    if (item == object->child) {
+        object->child = item->next;
+        if (item->next != NULL) {
+            item->next->prev = item->prev;
+        }
+    } else {
+        item->prev->next = item->next;
+        if (item->next != NULL) {
+            item->next->prev = item->prev;
+        } else {
+            object->child->prev = item->prev;
+        }
+    }
+    item->next = NULL;
+    item->prev = NULL;
+    return item;
+}
+
+void cJSON_DeleteItemFromObject(cJSON* object, const char* string) {
+    cJSON_Delete(cJSON_DetachItemFromObject(object, string));
+}
+
+static cJSON* add_to_object(cJSON* object, const char* name, cJSON* item) {
+    if (cJSON_AddItemToObject(object, name, item)) {
+        return item;
+    }
+    cJSON_Delete(item);
+    return NULL;
+}
+
+cJSON* cJSON_AddNullToObject(cJSON* const object, const char* const name) {
+    return add_to_object(object, name, cJSON_CreateNull());
+}
+
+cJSON* cJSON_AddTrueToObject(cJSON* const object, const char* const name) {
+    return add_to_object(object, name, cJSON_CreateTrue());
+}
+
+cJSON* cJSON_AddFalseToObject(cJSON* const object, const char* const name) {
+    return add_to_object(object, name, cJSON_CreateFalse());
+}
+
+cJSON* cJSON_AddBoolToObject(cJSON* const object, const char* const name, const cJSON_bool boolean) {
+    return add_to_object(object, name, cJSON_CreateBool(boolean));
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* const object, const char* const name, const double number) {
+    return add_to_object(object, name, cJSON_CreateNumber(number));
+}
+
+cJSON* cJSON_AddStringToObject(cJSON* const object, const char* const name, const char* const string) {
+    return add_to_object(object, name, cJSON_CreateString(string));
+}
+
+cJSON* cJSON_AddObjectToObject(cJSON* const object, const char* const name) {
+    return add_to_object(object, name, cJSON_CreateObject());
+}
+
+cJSON* cJSON_AddArrayToObject(cJSON* const object, const char* const name) {
+    return add_to_object(object, name, cJSON_CreateArray());
+}
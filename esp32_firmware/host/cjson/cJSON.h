@@ -0,0 +1,126 @@
+/*
+ * Host build: cJSON API subset used by the firmware
+ *
+ * Used only when the ESP-IDF cJSON sources are not available (see
+ * host/CMakeLists.txt). Types, struct layout, case-insensitive lookup and
+ * number/whitespace formatting follow cJSON 1.7, so payload bytes and sizes
+ * measured on the host match the firmware's.
+ */
+#ifndef cJSON__h
+#define cJSON__h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#define CJSON_VERSION_MAJOR 1
+#define CJSON_VERSION_MINOR 7
+#define CJSON_VERSION_PATCH 15
+
+#define cJSON_Invalid (0)
+#define cJSON_False   (1 << 0)
+#define cJSON_True    (1 << 1)
+#define cJSON_NULL    (1 << 2)
+#define cJSON_Number  (1 << 3)
+#define cJSON_String  (1 << 4)
+#define cJSON_Array   (1 << 5)
+#define cJSON_Object  (1 << 6)
+#define cJSON_Raw     (1 << 7)
+
+#define cJSON_IsReference   256
+#define cJSON_StringIsConst 512
+
+typedef int cJSON_bool;
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* prev;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+typedef struct cJSON_Hooks {
+    void* (*malloc_fn)(size_t sz);
+    void (*free_fn)(void* ptr);
+} cJSON_Hooks;
+
+#ifndef CJSON_NESTING_LIMIT
+#define CJSON_NESTING_LIMIT 1000
+#endif
+
+const char* cJSON_Version(void);
+void cJSON_InitHooks(cJSON_Hooks* hooks);
+
+cJSON* cJSON_Parse(const char* value);
+cJSON* cJSON_ParseWithLength(const char* value, size_t buffer_length);
+
+char* cJSON_Print(const cJSON* item);
+char* cJSON_PrintUnformatted(const cJSON* item);
+cJSON_bool cJSON_PrintPreallocated(cJSON* item, char* buffer, const int length, const cJSON_bool format);
+void cJSON_Delete(cJSON* item);
+
+int cJSON_GetArraySize(const cJSON* array);
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index);
+cJSON* cJSON_GetObjectItem(const cJSON* const object, const char* const string);
+cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON* const object, const char* const string);
+cJSON_bool cJSON_HasObjectItem(const cJSON* object, const char* string);
+const char* cJSON_GetErrorPtr(void);
+
+char* cJSON_GetStringValue(const cJSON* const item);
+double cJSON_GetNumberValue(const cJSON* const item);
+
+cJSON_bool cJSON_IsInvalid(const cJSON* const item);
+cJSON_bool cJSON_IsFalse(const cJSON* const item);
+cJSON_bool cJSON_IsTrue(const cJSON* const item);
+cJSON_bool cJSON_IsBool(const cJSON* const item);
+cJSON_bool cJSON_IsNull(const cJSON* const item);
+cJSON_bool cJSON_IsNumber(const cJSON* const item);
+cJSON_bool cJSON_IsString(const cJSON* const item);
+cJSON_bool cJSON_IsArray(const cJSON* const item);
+cJSON_bool cJSON_IsObject(const cJSON* const item);
+cJSON_bool cJSON_IsRaw(const cJSON* const item);
+
+cJSON* cJSON_CreateNull(void);
+cJSON* cJSON_CreateTrue(void);
+cJSON* cJSON_CreateFalse(void);
+cJSON* cJSON_CreateBool(cJSON_bool boolean);
+cJSON* cJSON_CreateNumber(double num);
+cJSON* cJSON_CreateString(const char* string);
+cJSON* cJSON_CreateArray(void);
+cJSON* cJSON_CreateObject(void);
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item);
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item);
+cJSON* cJSON_DetachItemFromObject(cJSON* object, const char* string);
+void cJSON_DeleteItemFromObject(cJSON* object, const char* string);
+
+cJSON* cJSON_AddNullToObject(cJSON* const object, const char* const name);
+cJSON* cJSON_AddTrueToObject(cJSON* const object, const char* const name);
+cJSON* cJSON_AddFalseToObject(cJSON* const object, const char* const name);
+cJSON* cJSON_AddBoolToObject(cJSON* const object, const char* const name, const cJSON_bool boolean);
+cJSON* cJSON_AddNumberToObject(cJSON* const object, const char* const name, const double number);
+cJSON* cJSON_AddStringToObject(cJSON* const object, const char* const name, const char* const string);
+cJSON* cJSON_AddObjectToObject(cJSON* const object, const char* const name);
+cJSON* cJSON_AddArrayToObject(cJSON* const object, const char* const name);
+
+double cJSON_SetNumberHelper(cJSON* object, double number);
+#define cJSON_SetIntValue(object, number) ((object) ? (object)->valueint = (object)->valuedouble = (number) : (number))
+#define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (double)number) : (number))
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+
+void* cJSON_malloc(size_t size);
+void cJSON_free(void* object);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+// Host build: LEDC duty readable with host_ledc_duty() (host_hal.h)
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum { LEDC_LOW_SPEED_MODE = 0 } ledc_mode_t;
+typedef enum { LEDC_TIMER_0 = 0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3 } ledc_timer_t;
+typedef enum { LEDC_TIMER_8_BIT = 8, LEDC_TIMER_10_BIT = 10, LEDC_TIMER_12_BIT = 12 } ledc_timer_bit_t;
+typedef enum { LEDC_AUTO_CLK = 0 } ledc_clk_cfg_t;
+typedef int ledc_channel_t;
+
+#define LEDC_CHANNEL_MAX 8
+
+typedef struct {
+    ledc_mode_t speed_mode;
+    ledc_timer_t timer_num;
+    ledc_timer_bit_t duty_resolution;
+    uint32_t freq_hz;
+    ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+
+typedef struct {
+    int channel;
+    uint32_t duty;
+    int gpio_num;
+    ledc_mode_t speed_mode;
+    int hpoint;
+    ledc_timer_t timer_sel;
+} ledc_channel_config_t;
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config);
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config);
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty);
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel);
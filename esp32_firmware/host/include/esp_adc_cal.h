@@ -0,0 +1,3 @@
+#pragma once
+// Host build: calibration characteristics are not used by the firmware
+#include "driver/adc.h"
@@ -0,0 +1,6 @@
+#pragma once
+// Host build: placement attributes have no effect
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,5 @@
+#pragma once
+// Host build: no TLS, the certificate bundle hook does nothing
+#include "esp_err.h"
+
+esp_err_t esp_crt_bundle_attach(void* conf);
@@ -0,0 +1,18 @@
+#pragma once
+// Host build: default event loop on its own thread (host/src/esp_system_host.cpp)
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef const char* esp_event_base_t;
+typedef void (*esp_event_handler_t)(void* arg, esp_event_base_t base, int32_t id, void* data);
+typedef void* esp_event_handler_instance_t;
+
+#define ESP_EVENT_ANY_ID -1
+
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void* arg,
+                                              esp_event_handler_instance_t* instance);
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void* data,
+                         size_t size, uint32_t ticks_to_wait);
@@ -0,0 +1,4 @@
+#pragma once
+// Host build: DebugHelper writes through its own sink, nothing to declare
+#include "esp_err.h"
+#include "esp_timer.h"
@@ -0,0 +1,18 @@
+#pragma once
+// Host build: SNTP client answered by the host clock (host/src/network_host.cpp)
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+typedef enum { ESP_SNTP_OPMODE_POLL = 0 } esp_sntp_operatingmode_t;
+typedef enum { SNTP_SYNC_MODE_IMMED, SNTP_SYNC_MODE_SMOOTH } sntp_sync_mode_t;
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode);
+void esp_sntp_setservername(uint8_t index, const char* server);
+void sntp_set_sync_mode(sntp_sync_mode_t mode);
+void sntp_set_sync_interval(uint32_t interval_ms);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+void esp_sntp_init();
+void esp_sntp_stop();
+bool esp_sntp_enabled();
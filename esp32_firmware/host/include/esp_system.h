@@ -0,0 +1,13 @@
+#pragma once
+// Host build: system services (host/src/esp_system_host.cpp)
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+void esp_restart(void);
+uint32_t esp_random(void);
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
@@ -0,0 +1,51 @@
+#pragma once
+// Host build: FreeRTOS kernel on std::thread (host/src/freertos_host.cpp)
+//
+// Ticks are 1 ms. Tasks are threads that ignore priority and core; critical
+// sections take one process-wide recursive lock, so code written for two
+// cores stays correct on any number of host threads.
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define configTICK_RATE_HZ      1000
+#define configMAX_PRIORITIES    25
+#define portTICK_PERIOD_MS      1
+#define portMAX_DELAY           0xffffffffu
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define errQUEUE_FULL           0
+
+#define BIT0 (1u << 0)
+#define BIT1 (1u << 1)
+#define BIT2 (1u << 2)
+#define BIT3 (1u << 3)
+#define BIT4 (1u << 4)
+#define BIT5 (1u << 5)
+#define BIT6 (1u << 6)
+#define BIT7 (1u << 7)
+
+#define PRO_CPU_NUM             0
+#define APP_CPU_NUM             1
+#define tskNO_AFFINITY          0x7fffffff
+
+typedef struct {
+    int owner;                          // Unused; the lock is process-wide
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+
+#define portENTER_CRITICAL(mux)     ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL(mux)      ((void)(mux), host_critical_exit())
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)  portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(woken)   (void)(woken)
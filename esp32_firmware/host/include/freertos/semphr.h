@@ -0,0 +1,10 @@
+#pragma once
+// Host build: mutexes are one-item queues, as in FreeRTOS
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
@@ -0,0 +1,44 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @file host_hal.h
+ * @brief Test-side control of the host build's peripherals
+ *
+ * The host shims stand in for the ESP32 drivers: ADC channels return the
+ * raw level last set here (one-shot and continuous drivers alike), GPIO
+ * inputs read the level set here and fire their edge interrupts, and LEDC
+ * duty writes are recorded for inspection.
+ */
+
+/**
+ * @brief Set the raw 12-bit reading of an ADC1 channel
+ */
+void host_adc_set(uint8_t channel, uint16_t raw);
+
+/**
+ * @brief Drive a GPIO input, running its ISR handler on a matching edge
+ */
+void host_gpio_set(int pin, int level);
+
+/**
+ * @brief Last duty written to an LEDC channel (after ledc_update_duty)
+ */
+uint32_t host_ledc_duty(int channel);
+
+/**
+ * @brief Remove every key from the in-memory NVS
+ */
+void host_nvs_reset();
+
+/**
+ * @brief Flash an application image into an app partition ("ota_0" runs)
+ * @return false if the label is unknown or the image does not fit
+ */
+bool host_flash_load_app(const char* label, const void* image, size_t size);
+
+#endif // HOST_HAL_H
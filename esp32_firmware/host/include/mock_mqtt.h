@@ -0,0 +1,68 @@
+#ifndef MOCK_MQTT_H
+#define MOCK_MQTT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * @file mock_mqtt.h
+ * @brief In-process MQTT broker behind the host build's esp_mqtt_client API
+ *
+ * esp_mqtt_client_start() connects at once. Publishes are recorded instead of
+ * sent (QoS 1 publishes while disconnected wait in the outbox until the next
+ * connection), subscriptions are remembered, and tests inject incoming
+ * messages and connection changes. Events reach the client's handler on the
+ * calling thread, in the order ESP-MQTT delivers them on its task; payloads
+ * larger than the client buffer arrive as several MQTT_EVENT_DATA fragments.
+ */
+
+typedef struct {
+    std::string topic;
+    std::string payload;                // Raw bytes (JSON or binary telemetry)
+    int qos;
+    bool retain;
+} mock_mqtt_message_t;
+
+/**
+ * @brief Messages published since the last mock_mqtt_clear()
+ */
+std::vector<mock_mqtt_message_t> mock_mqtt_published();
+
+/**
+ * @brief Number of messages published since the last mock_mqtt_clear()
+ */
+size_t mock_mqtt_publish_count();
+
+/**
+ * @brief Forget the recorded messages
+ */
+void mock_mqtt_clear();
+
+/**
+ * @brief Topics the client subscribed to
+ */
+std::vector<std::string> mock_mqtt_subscriptions();
+
+/**
+ * @brief Deliver a message as MQTT_EVENT_DATA
+ * @return false if no client is running or the topic was not subscribed
+ */
+bool mock_mqtt_inject(const char* topic, const void* payload, size_t length);
+
+/**
+ * @brief Take the broker down or bring it back
+ *
+ * Going down disconnects the client (MQTT_EVENT_DISCONNECTED) and refuses
+ * reconnects. Coming back lets the next esp_mqtt_client_reconnect() succeed,
+ * or connects at once when the client reconnects automatically.
+ */
+void mock_mqtt_set_broker_up(bool up);
+
+/**
+ * @brief Discard publishes without recording them (for benchmarks)
+ */
+void mock_mqtt_set_recording(bool recording);
+
+#endif // MOCK_MQTT_H
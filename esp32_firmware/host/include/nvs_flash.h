@@ -0,0 +1,6 @@
+#pragma once
+// Host build: NVS in RAM (host/src/nvs_host.cpp)
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
@@ -0,0 +1,454 @@
+// Host build: system services, RAM flash partitions and OTA, sleep and the event loop
+
+#include <esp_system.h>
+#include <esp_app_desc.h>
+#include <esp_event.h>
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <host_hal.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#define HOST_HEAP_SIZE (320 * 1024)     // Reported free heap, ESP32 DRAM order of magnitude
+
+// ==================== System ====================
+static std::vector<shutdown_handler_t> shutdown_handlers;
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                        return "ESP_OK";
+        case ESP_FAIL:                      return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_NO_FREE_PAGES:     return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        case ESP_ERR_OTA_VALIDATE_FAILED:   return "ESP_ERR_OTA_VALIDATE_FAILED";
+        default:                            return "UNKNOWN ERROR";
+    }
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    shutdown_handlers.push_back(handler);
+    return ESP_OK;
+}
+
+// A restart ends the process after the shutdown handlers, like a reboot
+// ends the firmware; the exit status tells a harness it was not a crash
+void esp_restart() {
+    for (shutdown_handler_t handler : shutdown_handlers) {
+        handler();
+    }
+    fprintf(stderr, "esp_restart()\n");
+    fflush(stdout);
+    _Exit(0);
+}
+
+uint32_t esp_random() {
+    static std::mutex lock;
+    static std::mt19937 generator{std::random_device{}()};
+    std::lock_guard<std::mutex> guard(lock);
+    return (uint32_t)generator();
+}
+
+uint32_t esp_get_free_heap_size() {
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t esp_get_minimum_free_heap_size() {
+    return HOST_HEAP_SIZE;
+}
+
+// One unfragmented region: the largest block is all of it
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return HOST_HEAP_SIZE;
+}
+
+const esp_app_desc_t* esp_app_get_description() {
+    static const esp_app_desc_t desc = {"host", "esp32_exoskeleton_firmware"};
+    return &desc;
+}
+
+// ==================== Sleep and Power ====================
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_us) {
+    (void)time_us;
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    fprintf(stderr, "esp_deep_sleep_start()\n");
+    fflush(stdout);
+    _Exit(0);
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+    (void)config;
+    return ESP_OK;
+}
+
+// ==================== Partitions ====================
+// The OTA and data partitions of partitions.csv, in RAM with NOR flash
+// semantics (erase sets bytes to 0xFF, writes can only clear bits)
+#define HOST_FLASH_SECTOR_SIZE 4096
+#define HOST_APP_SIZE          0x180000
+
+struct host_partition_t {
+    esp_partition_t info;
+    std::vector<uint8_t> data;
+};
+
+static host_partition_t* partitions() {
+    static host_partition_t table[] = {
+        {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x20000, HOST_APP_SIZE,
+          HOST_FLASH_SECTOR_SIZE, "ota_0", false}, std::vector<uint8_t>(HOST_APP_SIZE, 0xff)},
+        {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x1a0000, HOST_APP_SIZE,
+          HOST_FLASH_SECTOR_SIZE, "ota_1", false}, std::vector<uint8_t>(HOST_APP_SIZE, 0xff)},
+        {{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_OTA, 0xf000, 0x2000,
+          HOST_FLASH_SECTOR_SIZE, "otadata", false}, std::vector<uint8_t>(0x2000, 0xff)},
+        {{ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x320000, 0x40000,
+          HOST_FLASH_SECTOR_SIZE, "offline", false}, std::vector<uint8_t>(0x40000, 0xff)},
+    };
+    return table;
+}
+static const size_t PARTITION_COUNT = 4;
+static const size_t APP_PARTITION_COUNT = 2;    // The first entries
+
+static host_partition_t* find_partition(const esp_partition_t* partition) {
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        if (&partitions()[i].info == partition) {
+            return &partitions()[i];
+        }
+    }
+    return nullptr;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        const esp_partition_t& info = partitions()[i].info;
+        if ((type == ESP_PARTITION_TYPE_ANY || info.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || info.subtype == subtype) &&
+            (label == nullptr || strcmp(info.label, label) == 0)) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    host_partition_t* host = find_partition(partition);
+    if (host == nullptr || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, &host->data[offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+    host_partition_t* host = find_partition(partition);
+    if (host == nullptr || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        host->data[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    host_partition_t* host = find_partition(partition);
+    if (host == nullptr || offset + size > partition->size ||
+        offset % partition->erase_size != 0 || size % partition->erase_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&host->data[offset], 0xff, size);
+    return ESP_OK;
+}
+
+// App partition images; the process runs from ota_0, as flashed over serial
+#define HOST_IMAGE_MAGIC        0xE9
+#define HOST_IMAGE_HEADER_SIZE  24          // esp_image_header_t, hash_appended last
+#define HOST_APP_DESC_OFFSET    32          // After the first segment header
+#define HOST_APP_DESC_MAGIC     0xABCD5432
+
+struct host_app_t {
+    size_t image_size;
+    esp_ota_img_states_t state;
+};
+
+static std::mutex ota_lock;
+static host_app_t apps[APP_PARTITION_COUNT] = {{0, ESP_OTA_IMG_UNDEFINED}, {0, ESP_OTA_IMG_UNDEFINED}};
+static size_t boot_app = 0;
+static const size_t RUNNING_APP = 0;
+static const esp_partition_t* ota_partition = nullptr;     // Open update, one at a time
+static size_t ota_written = 0;
+
+static int app_index(const esp_partition_t* partition) {
+    for (size_t i = 0; i < APP_PARTITION_COUNT; i++) {
+        if (&partitions()[i].info == partition) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t* partition, uint8_t* sha_256) {
+    std::lock_guard<std::mutex> guard(ota_lock);
+    int index = app_index(partition);
+    if (index < 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const std::vector<uint8_t>& data = partitions()[index].data;
+    size_t size = apps[index].image_size;
+    if (size < HOST_IMAGE_HEADER_SIZE + 32 || data[HOST_IMAGE_HEADER_SIZE - 1] != 1) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    memcpy(sha_256, &data[size - 32], 32);
+    return ESP_OK;
+}
+
+bool host_flash_load_app(const char* label, const void* image, size_t size) {
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP,
+                                                                ESP_PARTITION_SUBTYPE_ANY, label);
+    int index = app_index(partition);
+    if (index < 0 || size > partition->size) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(ota_lock);
+    std::vector<uint8_t>& data = partitions()[index].data;
+    std::fill(data.begin(), data.end(), 0xff);
+    memcpy(data.data(), image, size);
+    apps[index] = {size, ESP_OTA_IMG_UNDEFINED};
+    return true;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &partitions()[RUNNING_APP].info;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+    std::lock_guard<std::mutex> guard(ota_lock);
+    return &partitions()[boot_app].info;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+    (void)start_from;
+    return &partitions()[(RUNNING_APP + 1) % APP_PARTITION_COUNT].info;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* handle) {
+    int index = app_index(partition);
+    if (index < 0 || (size_t)index == RUNNING_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (image_size != OTA_SIZE_UNKNOWN && image_size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (ota_partition != nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    std::vector<uint8_t>& data = partitions()[index].data;
+    std::fill(data.begin(), data.end(), 0xff);
+    apps[index] = {0, ESP_OTA_IMG_UNDEFINED};
+    ota_partition = partition;
+    ota_written = 0;
+    *handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    const esp_partition_t* partition;
+    {
+        std::lock_guard<std::mutex> guard(ota_lock);
+        if (handle != 1 || ota_partition == nullptr) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        partition = ota_partition;
+    }
+    esp_err_t ret = esp_partition_write(partition, ota_written, data, size);
+    if (ret == ESP_OK) {
+        ota_written += size;
+    }
+    return ret;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (handle != 1 || ota_partition == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int index = app_index(ota_partition);
+    ota_partition = nullptr;
+    if (ota_written == 0 || partitions()[index].data[0] != HOST_IMAGE_MAGIC) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    apps[index] = {ota_written, ESP_OTA_IMG_NEW};
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (handle != 1 || ota_partition == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ota_partition = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    int index = app_index(partition);
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (index < 0 || apps[index].image_size == 0) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    boot_app = (size_t)index;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_partition_description(const esp_partition_t* partition, esp_app_desc_t* desc) {
+    int index = app_index(partition);
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (index < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const std::vector<uint8_t>& data = partitions()[index].data;
+    const size_t version_offset = HOST_APP_DESC_OFFSET + 16;
+    uint32_t magic;
+    memcpy(&magic, &data[HOST_APP_DESC_OFFSET], sizeof(magic));
+    if (apps[index].image_size < version_offset + sizeof(desc->version) + sizeof(desc->project_name) ||
+        magic != HOST_APP_DESC_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memcpy(desc->version, &data[version_offset], sizeof(desc->version));
+    memcpy(desc->project_name, &data[version_offset + sizeof(desc->version)], sizeof(desc->project_name));
+    desc->version[sizeof(desc->version) - 1] = '\0';
+    desc->project_name[sizeof(desc->project_name) - 1] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* state) {
+    int index = app_index(partition);
+    std::lock_guard<std::mutex> guard(ota_lock);
+    if (index < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *state = apps[index].state;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    std::lock_guard<std::mutex> guard(ota_lock);
+    apps[RUNNING_APP].state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot() {
+    {
+        std::lock_guard<std::mutex> guard(ota_lock);
+        apps[RUNNING_APP].state = ESP_OTA_IMG_INVALID;
+    }
+    esp_restart();
+    return ESP_OK;
+}
+
+// ==================== Default Event Loop ====================
+struct event_handler_t {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void* arg;
+};
+
+struct posted_event_t {
+    esp_event_base_t base;
+    int32_t id;
+    std::vector<uint8_t> data;
+};
+
+// Never destroyed: the loop thread still waits on them during exit()
+static std::mutex& event_lock = *new std::mutex();
+static std::condition_variable& event_posted = *new std::condition_variable();
+static std::vector<event_handler_t> event_handlers;
+static std::deque<posted_event_t> event_queue;
+static bool event_loop_started = false;
+
+static void event_loop() {
+    std::unique_lock<std::mutex> guard(event_lock);
+    for (;;) {
+        event_posted.wait(guard, [] { return !event_queue.empty(); });
+        posted_event_t event = std::move(event_queue.front());
+        event_queue.pop_front();
+        std::vector<event_handler_t> handlers = event_handlers;
+        guard.unlock();
+        for (const event_handler_t& entry : handlers) {
+            if (entry.base == event.base && (entry.id == ESP_EVENT_ANY_ID || entry.id == event.id)) {
+                entry.handler(entry.arg, event.base, event.id,
+                              event.data.empty() ? nullptr : event.data.data());
+            }
+        }
+        guard.lock();
+    }
+}
+
+esp_err_t esp_event_loop_create_default() {
+    std::lock_guard<std::mutex> guard(event_lock);
+    if (event_loop_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    event_loop_started = true;
+    std::thread(event_loop).detach();
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void* arg,
+                                              esp_event_handler_instance_t* instance) {
+    std::lock_guard<std::mutex> guard(event_lock);
+    event_handlers.push_back({base, id, handler, arg});
+    if (instance != nullptr) {
+        *instance = (esp_event_handler_instance_t)handler;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void* data,
+                         size_t size, uint32_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    std::lock_guard<std::mutex> guard(event_lock);
+    if (!event_loop_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    event_queue.push_back({base, id, std::vector<uint8_t>(bytes, bytes + (bytes != nullptr ? size : 0))});
+    event_posted.notify_one();
+    return ESP_OK;
+}
@@ -0,0 +1,133 @@
+// Host build: esp_timer on one dispatch thread
+//
+// Callbacks run in deadline order on the "esp_timer" thread whatever their
+// dispatch method, like ESP_TIMER_TASK dispatch; a late periodic timer is
+// rescheduled from its previous deadline, so it catches up without drift.
+
+#include <esp_timer.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    int64_t deadline_us;
+    uint64_t period_us;                 // 0 for one-shot
+    bool active;
+};
+
+// Never destroyed: the dispatch thread still waits on them during exit()
+static std::mutex& timer_lock = *new std::mutex();
+static std::condition_variable& timer_changed = *new std::condition_variable();
+static std::vector<esp_timer*> timers;
+static bool dispatch_started = false;
+
+static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - boot).count();
+}
+
+static esp_timer* next_due(std::unique_lock<std::mutex>& guard) {
+    for (;;) {
+        esp_timer* next = nullptr;
+        for (esp_timer* timer : timers) {
+            if (timer->active && (next == nullptr || timer->deadline_us < next->deadline_us)) {
+                next = timer;
+            }
+        }
+        if (next == nullptr) {
+            timer_changed.wait(guard);
+            continue;
+        }
+        int64_t wait_us = next->deadline_us - esp_timer_get_time();
+        if (wait_us <= 0) {
+            return next;
+        }
+        timer_changed.wait_for(guard, std::chrono::microseconds(wait_us));
+    }
+}
+
+static void dispatch_thread() {
+    std::unique_lock<std::mutex> guard(timer_lock);
+    for (;;) {
+        esp_timer* timer = next_due(guard);
+        if (timer->period_us > 0) {
+            timer->deadline_us += timer->period_us;
+        } else {
+            timer->active = false;
+        }
+        esp_timer_cb_t callback = timer->callback;
+        void* arg = timer->arg;
+        guard.unlock();
+        callback(arg);              // May start or stop timers
+        guard.lock();
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    if (args == nullptr || args->callback == nullptr || out == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer* timer = new esp_timer{args->callback, args->arg, 0, 0, false};
+    std::lock_guard<std::mutex> guard(timer_lock);
+    timers.push_back(timer);
+    if (!dispatch_started) {
+        dispatch_started = true;
+        std::thread(dispatch_thread).detach();
+    }
+    *out = timer;
+    return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t delay_us, uint64_t period_us) {
+    std::lock_guard<std::mutex> guard(timer_lock);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = esp_timer_get_time() + (int64_t)delay_us;
+    timer->period_us = period_us;
+    timer->active = true;
+    timer_changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    return start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> guard(timer_lock);
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    timer_changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> guard(timer_lock);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    std::erase(timers, timer);
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> guard(timer_lock);
+    return timer->active;
+}
+
+void esp_timer_isr_dispatch_need_yield() {
+}
@@ -0,0 +1,295 @@
+// Host build: FreeRTOS kernel services on std::thread
+//
+// Every task is a detached thread with a thread_local control block for
+// notifications. Queues, mutexes and event groups are condition-variable
+// protected; ticks are milliseconds of esp_timer_get_time().
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include <esp_timer.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+struct tskTaskControlBlock {
+    std::string name;
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+    uint32_t stack_depth = 0;
+};
+
+struct QueueDefinition {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+};
+
+struct EventGroupDef_t {
+    std::mutex lock;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+static std::recursive_mutex critical_lock;
+static std::mutex registry_lock;
+static std::vector<tskTaskControlBlock*> registry;
+
+static thread_local tskTaskControlBlock* current_task = nullptr;
+
+// Deadline of a wait of `ticks` (portMAX_DELAY waits forever)
+static std::chrono::steady_clock::time_point deadline(TickType_t ticks) {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+}
+
+template <typename Predicate>
+static bool wait_for(std::condition_variable& cv, std::unique_lock<std::mutex>& guard,
+                     TickType_t ticks, Predicate ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(guard, ready);
+        return true;
+    }
+    return cv.wait_until(guard, deadline(ticks), ready);
+}
+
+void host_critical_enter() {
+    critical_lock.lock();
+}
+
+void host_critical_exit() {
+    critical_lock.unlock();
+}
+
+// ==================== Tasks ====================
+static tskTaskControlBlock* register_task(const char* name, uint32_t stack_depth) {
+    tskTaskControlBlock* task = new tskTaskControlBlock();
+    task->name = name != nullptr ? name : "";
+    task->stack_depth = stack_depth;
+    std::lock_guard<std::mutex> guard(registry_lock);
+    registry.push_back(task);
+    return task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core) {
+    (void)priority;
+    (void)core;
+    tskTaskControlBlock* task = register_task(name, stack_depth);
+    if (created != nullptr) {
+        *created = task;
+    }
+    std::thread([task, code, arg]() {
+        current_task = task;
+        code(arg);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(code, name, stack_depth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == current_task) {
+        // A host thread cannot be killed from outside; the calling task parks
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t increment) {
+    *previous_wake += increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*previous_wake - now) > 0) {
+        vTaskDelay(*previous_wake - now);
+    }
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (current_task == nullptr) {
+        // The main thread and driver threads get a block on first use
+        current_task = register_task("main", 0);
+    }
+    return current_task;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (tskTaskControlBlock* task : registry) {
+        if (task->name == name) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host stacks are megabytes; report the configured size as untouched
+    return task != nullptr ? task->stack_depth : 0;
+}
+
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+// ==================== Notifications ====================
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    tskTaskControlBlock* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+    if (!wait_for(task->wake, guard, ticks, [task] { return task->notifications > 0; })) {
+        return 0;
+    }
+    uint32_t value = task->notifications;
+    task->notifications = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifications++;
+    }
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_woken != nullptr) {
+        *higher_priority_woken = pdTRUE;
+    }
+}
+
+// ==================== Queues ====================
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueDefinition* queue = new QueueDefinition();
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!wait_for(queue->changed, guard, ticks, [queue] { return queue->items.size() < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_woken) {
+    if (higher_priority_woken != nullptr) {
+        *higher_priority_woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!wait_for(queue->changed, guard, ticks, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    if (queue->item_size > 0) {
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    }
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!wait_for(queue->changed, guard, ticks, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    if (queue->item_size > 0) {
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    }
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return (UBaseType_t)queue->items.size();
+}
+
+// ==================== Mutexes ====================
+// A mutex is a one-item queue that starts full: take receives, give sends
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    QueueHandle_t queue = xQueueCreate(1, 0);
+    queue->items.emplace_back();
+    return queue;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return xQueueReceive(semaphore, nullptr, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, nullptr, 0);
+}
+
+// ==================== Event Groups ====================
+EventGroupHandle_t xEventGroupCreate() {
+    return new EventGroupDef_t();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(group->lock);
+    auto satisfied = [group, bits, wait_for_all] {
+        return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool met = wait_for(group->changed, guard, ticks, satisfied);
+    EventBits_t value = group->bits;
+    if (met && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    return value;
+}
@@ -0,0 +1,308 @@
+// Host build: ADC, GPIO and LEDC drivers over levels set through host_hal.h
+
+#include <host_hal.h>
+#include <driver/adc.h>
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <esp_adc/adc_continuous.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+static std::atomic<uint16_t> adc_levels[ADC1_CHANNEL_MAX];
+
+// ==================== One-shot ADC ====================
+void host_adc_set(uint8_t channel, uint16_t raw) {
+    if (channel < ADC1_CHANNEL_MAX) {
+        adc_levels[channel].store(raw & 0x0fff, std::memory_order_relaxed);
+    }
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width) {
+    (void)width;
+    return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten) {
+    (void)atten;
+    return channel < ADC1_CHANNEL_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int adc1_get_raw(adc1_channel_t channel) {
+    return channel < ADC1_CHANNEL_MAX ? adc_levels[channel].load(std::memory_order_relaxed) : -1;
+}
+
+// ==================== GPIO ====================
+struct gpio_pin_t {
+    int level = 0;
+    gpio_int_type_t intr_type = GPIO_INTR_DISABLE;
+    bool intr_enabled = true;
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+};
+
+static std::mutex gpio_lock;
+static gpio_pin_t pins[GPIO_NUM_MAX];
+
+static bool valid_pin(gpio_num_t pin) {
+    return pin >= 0 && pin < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (config->pin_bit_mask & (1ULL << pin)) {
+            pins[pin].intr_type = config->intr_type;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    if (!valid_pin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    pins[pin].level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    if (!valid_pin(pin)) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    return pins[pin].level;
+}
+
+void host_gpio_set(int pin, int level) {
+    if (!valid_pin(pin)) {
+        return;
+    }
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(gpio_lock);
+        gpio_pin_t& state = pins[pin];
+        int previous = state.level;
+        state.level = level ? 1 : 0;
+        bool rising = previous == 0 && state.level == 1;
+        bool falling = previous == 1 && state.level == 0;
+        bool fires = (state.intr_type == GPIO_INTR_ANYEDGE && (rising || falling)) ||
+                     (state.intr_type == GPIO_INTR_POSEDGE && rising) ||
+                     (state.intr_type == GPIO_INTR_NEGEDGE && falling);
+        if (fires && state.intr_enabled) {
+            handler = state.handler;
+            arg = state.arg;
+        }
+    }
+    if (handler != nullptr) {
+        handler(arg);               // "ISR" context is the calling thread
+    }
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+    if (!valid_pin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    pins[pin].intr_type = type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin) {
+    if (!valid_pin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    pins[pin].intr_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t pin) {
+    if (!valid_pin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    pins[pin].intr_enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    (void)flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    if (!valid_pin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(gpio_lock);
+    pins[pin].handler = handler;
+    pins[pin].arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    return gpio_isr_handler_add(pin, nullptr, nullptr);
+}
+
+// ==================== LEDC ====================
+static std::atomic<uint32_t> ledc_pending[LEDC_CHANNEL_MAX];
+static std::atomic<uint32_t> ledc_duty[LEDC_CHANNEL_MAX];
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config) {
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config) {
+    if (config->channel < 0 || config->channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_pending[config->channel] = config->duty;
+    ledc_duty[config->channel] = config->duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty) {
+    (void)mode;
+    if (channel < 0 || channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_pending[channel] = duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel) {
+    (void)mode;
+    if (channel < 0 || channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_duty[channel] = ledc_pending[channel].load();
+    return ESP_OK;
+}
+
+uint32_t host_ledc_duty(int channel) {
+    return channel >= 0 && channel < LEDC_CHANNEL_MAX ? ledc_duty[channel].load() : 0;
+}
+
+// ==================== Continuous ADC ====================
+// A converter thread produces one frame of the pattern's channels at the
+// configured rate into a bounded pool, like the DMA does.
+struct adc_continuous_ctx_t {
+    uint32_t pool_size;
+    uint32_t frame_size;
+    std::vector<adc_digi_pattern_config_t> pattern;
+    uint32_t sample_freq_hz = 0;
+    adc_continuous_evt_cbs_t callbacks = {};
+    void* user_data = nullptr;
+    std::mutex lock;
+    std::deque<uint8_t> pool;
+    std::atomic<bool> running{false};
+    std::thread converter;
+};
+
+static void convert(adc_continuous_ctx_t* adc) {
+    const uint32_t results = adc->frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+    const auto frame_period = std::chrono::microseconds(
+        (int64_t)results * 1000000 / (adc->sample_freq_hz > 0 ? adc->sample_freq_hz : 1));
+    std::vector<uint8_t> frame(adc->frame_size);
+    size_t next = 0;
+    auto deadline = std::chrono::steady_clock::now();
+    while (adc->running) {
+        for (uint32_t i = 0; i < results; i++) {
+            const adc_digi_pattern_config_t& entry = adc->pattern[next];
+            next = (next + 1) % adc->pattern.size();
+            adc_digi_output_data_t out = {};
+            out.type1.channel = entry.channel;
+            out.type1.data = adc_levels[entry.channel].load(std::memory_order_relaxed);
+            memcpy(&frame[i * SOC_ADC_DIGI_RESULT_BYTES], &out, SOC_ADC_DIGI_RESULT_BYTES);
+        }
+        bool overflow;
+        {
+            std::lock_guard<std::mutex> guard(adc->lock);
+            overflow = adc->pool.size() + frame.size() > adc->pool_size;
+            if (!overflow) {
+                adc->pool.insert(adc->pool.end(), frame.begin(), frame.end());
+            }
+        }
+        adc_continuous_evt_data_t event = {frame.data(), (uint32_t)frame.size()};
+        adc_continuous_callback_t callback = overflow ? adc->callbacks.on_pool_ovf : adc->callbacks.on_conv_done;
+        if (callback != nullptr) {
+            callback(adc, &event, adc->user_data);
+        }
+        deadline += frame_period;
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t* config, adc_continuous_handle_t* out) {
+    adc_continuous_ctx_t* adc = new adc_continuous_ctx_t();
+    adc->pool_size = config->max_store_buf_size;
+    adc->frame_size = config->conv_frame_size;
+    *out = adc;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t* config) {
+    if (config->pattern_num == 0 || handle->running) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->pattern.assign(config->adc_pattern, config->adc_pattern + config->pattern_num);
+    handle->sample_freq_hz = config->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t handle,
+                                                  const adc_continuous_evt_cbs_t* callbacks, void* user_data) {
+    handle->callbacks = *callbacks;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle) {
+    if (handle->pattern.empty() || handle->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->running = true;
+    handle->converter = std::thread(convert, handle);
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle) {
+    if (!handle->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->running = false;
+    handle->converter.join();
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t handle) {
+    if (handle->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t* buffer, uint32_t length,
+                              uint32_t* out_length, uint32_t timeout_ms) {
+    (void)timeout_ms;               // The firmware only polls (timeout 0)
+    std::lock_guard<std::mutex> guard(handle->lock);
+    if (handle->pool.empty()) {
+        *out_length = 0;
+        return ESP_ERR_TIMEOUT;
+    }
+    uint32_t count = std::min<uint32_t>(length, (uint32_t)handle->pool.size());
+    std::copy_n(handle->pool.begin(), count, buffer);
+    handle->pool.erase(handle->pool.begin(), handle->pool.begin() + count);
+    *out_length = count;
+    return ESP_OK;
+}
@@ -0,0 +1,104 @@
+// Host build: process entry point of the module executables
+//
+// Runs app_main() on the main thread like the ESP-IDF main task, then keeps
+// the process alive for the tasks it started (Ctrl+C to stop).
+//
+//   <module>_host [--image FILE] [--gpio PIN LEVEL]... [--inject TOPIC PAYLOAD]...
+//                 [--offline SECONDS] [--run SECONDS]
+//
+// --image flashes an application image into ota_0 before startup, the base
+// for OTA delta images; --gpio sets an input level before startup (e.g. a
+// pressure switch that reads healthy); --inject delivers a message from the mock broker
+// once the module is up (a command, a replay upload as hex with a "hex:"
+// prefix); --offline then takes the broker down for that long;
+// --run exits after that long instead of running forever.
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mock_mqtt.h>
+#include <host_hal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+void app_main();
+
+static std::string decode_payload(const char* arg) {
+    if (strncmp(arg, "hex:", 4) != 0) {
+        return arg;
+    }
+    std::string bytes;
+    for (const char* p = arg + 4; p[0] != '\0' && p[1] != '\0'; p += 2) {
+        char pair[3] = {p[0], p[1], '\0'};
+        bytes.push_back((char)strtoul(pair, nullptr, 16));
+    }
+    return bytes;
+}
+
+static bool load_image(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> image;
+    uint8_t chunk[4096];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+        image.insert(image.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return host_flash_load_app("ota_0", image.data(), image.size());
+}
+
+int main(int argc, char** argv) {
+    setvbuf(stdout, nullptr, _IOLBF, 0);    // Lines appear as they are logged, like the UART
+    mock_mqtt_set_recording(false);         // Nothing reads them back; keep memory flat
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--image") == 0 && !load_image(argv[i + 1])) {
+            fprintf(stderr, "cannot flash image: %s\n", argv[i + 1]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--gpio") == 0 && i + 2 < argc) {
+            host_gpio_set(atoi(argv[i + 1]), atoi(argv[i + 2]));
+        }
+    }
+    app_main();
+
+    long offline_seconds = 0;
+    long run_seconds = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--inject") == 0 && i + 2 < argc) {
+            std::string payload = decode_payload(argv[i + 2]);
+            if (!mock_mqtt_inject(argv[i + 1], payload.data(), payload.size())) {
+                fprintf(stderr, "not subscribed: %s\n", argv[i + 1]);
+            }
+            i += 2;
+        } else if (strcmp(argv[i], "--offline") == 0 && i + 1 < argc) {
+            offline_seconds = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--run") == 0 && i + 1 < argc) {
+            run_seconds = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            i++;                                // Flashed before startup
+        } else if (strcmp(argv[i], "--gpio") == 0 && i + 2 < argc) {
+            i += 2;                             // Set before startup
+        } else {
+            fprintf(stderr, "usage: %s [--image FILE] [--gpio PIN LEVEL]... "
+                    "[--inject TOPIC PAYLOAD]... [--offline SECONDS] [--run SECONDS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (offline_seconds > 0) {
+        mock_mqtt_set_broker_up(false);
+        vTaskDelay(offline_seconds * 1000 / portTICK_PERIOD_MS);
+        mock_mqtt_set_broker_up(true);
+    }
+    if (run_seconds > 0) {
+        vTaskDelay(run_seconds * 1000 / portTICK_PERIOD_MS);
+        exit(0);
+    }
+    for (;;) {
+        vTaskDelay(portMAX_DELAY);
+    }
+}
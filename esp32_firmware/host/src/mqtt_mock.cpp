@@ -0,0 +1,290 @@
+// Host build: ESP-MQTT client API over an in-process broker (mock_mqtt.h)
+
+#include <mqtt_client.h>
+#include <mock_mqtt.h>
+#include <algorithm>
+#include <mutex>
+#include <string.h>
+
+#define MOCK_MQTT_DEFAULT_BUFFER 1024   // ESP-MQTT default buffer.size
+
+struct esp_mqtt_client {
+    esp_mqtt_client_config_t config;
+    esp_event_handler_t handler = nullptr;
+    void* handler_arg = nullptr;
+    bool started = false;
+    bool connected = false;
+    bool session = false;               // Broker holds a session for this client
+    int next_msg_id = 1;
+    std::vector<mock_mqtt_message_t> outbox;
+};
+
+static std::mutex mock_lock;
+static esp_mqtt_client* active_client = nullptr;
+static std::vector<mock_mqtt_message_t> published;
+static size_t publish_count = 0;
+static std::vector<std::string> subscriptions;
+static bool broker_up = true;
+static bool recording = true;
+
+// Handlers run without mock_lock held: they publish and subscribe
+static void dispatch(esp_mqtt_client* client, esp_mqtt_event_t& event) {
+    event.client = client;
+    if (client->handler != nullptr) {
+        client->handler(client->handler_arg, "MQTT_EVENTS", event.event_id, &event);
+    }
+}
+
+static void record(const mock_mqtt_message_t& message) {
+    publish_count++;
+    if (recording) {
+        published.push_back(message);
+    }
+}
+
+static void connect(esp_mqtt_client* client) {
+    esp_mqtt_event_t event = {};
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        if (!broker_up || client->connected) {
+            return;
+        }
+        client->connected = true;
+        event.session_present = client->session && client->config.session.disable_clean_session;
+        client->session = true;
+        if (!client->config.session.disable_clean_session) {
+            subscriptions.clear();
+        }
+        for (const mock_mqtt_message_t& message : client->outbox) {
+            record(message);
+        }
+        client->outbox.clear();
+    }
+    event.event_id = MQTT_EVENT_CONNECTED;
+    dispatch(client, event);
+}
+
+static void disconnect(esp_mqtt_client* client) {
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        if (!client->connected) {
+            return;
+        }
+        client->connected = false;
+    }
+    esp_mqtt_event_t event = {};
+    event.event_id = MQTT_EVENT_DISCONNECTED;
+    dispatch(client, event);
+}
+
+// MQTT topic filter match (+ one level, # the rest)
+static bool topic_matches(const std::string& filter, const char* topic) {
+    size_t f = 0;
+    const char* t = topic;
+    while (f < filter.size()) {
+        if (filter[f] == '#') {
+            return true;
+        }
+        if (filter[f] == '+') {
+            while (*t != '\0' && *t != '/') t++;
+            f++;
+            continue;
+        }
+        if (*t != filter[f]) {
+            return false;
+        }
+        t++;
+        f++;
+    }
+    return *t == '\0';
+}
+
+// ==================== Client API ====================
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    esp_mqtt_client* client = new esp_mqtt_client();
+    client->config = *config;
+    if (client->config.buffer.size <= 0) {
+        client->config.buffer.size = MOCK_MQTT_DEFAULT_BUFFER;
+    }
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void* arg) {
+    (void)event;                        // Every event goes to the one handler
+    client->handler = handler;
+    client->handler_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        if (client->started) {
+            return ESP_FAIL;
+        }
+        client->started = true;
+        active_client = client;
+    }
+    connect(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+    disconnect(client);
+    std::lock_guard<std::mutex> guard(mock_lock);
+    client->started = false;
+    if (active_client == client) {
+        active_client = nullptr;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+    if (!client->started) {
+        return ESP_FAIL;
+    }
+    connect(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+    esp_mqtt_client_stop(client);
+    delete client;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int length, int qos, int retain) {
+    if (length <= 0 && data != nullptr) {
+        length = (int)strlen(data);
+    }
+    mock_mqtt_message_t message = {topic, std::string(data != nullptr ? data : "", length), qos, retain != 0};
+    std::lock_guard<std::mutex> guard(mock_lock);
+    if (!client->connected) {
+        if (qos == 0) {
+            return -1;
+        }
+        client->outbox.push_back(std::move(message));
+        return client->next_msg_id++;
+    }
+    record(message);
+    return qos > 0 ? client->next_msg_id++ : 0;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int length, int qos, int retain, bool store) {
+    (void)store;
+    return esp_mqtt_client_publish(client, topic, data, length, qos, retain);
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos) {
+    (void)qos;
+    int msg_id;
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        if (!client->connected) {
+            return -1;
+        }
+        if (std::find(subscriptions.begin(), subscriptions.end(), topic) == subscriptions.end()) {
+            subscriptions.push_back(topic);
+        }
+        msg_id = client->next_msg_id++;
+    }
+    esp_mqtt_event_t event = {};
+    event.event_id = MQTT_EVENT_SUBSCRIBED;
+    event.msg_id = msg_id;
+    dispatch(client, event);
+    return msg_id;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    int bytes = 0;
+    for (const mock_mqtt_message_t& message : client->outbox) {
+        bytes += (int)(message.topic.size() + message.payload.size());
+    }
+    return bytes;
+}
+
+// ==================== Test Control ====================
+std::vector<mock_mqtt_message_t> mock_mqtt_published() {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    return published;
+}
+
+size_t mock_mqtt_publish_count() {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    return publish_count;
+}
+
+void mock_mqtt_clear() {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    published.clear();
+    publish_count = 0;
+}
+
+std::vector<std::string> mock_mqtt_subscriptions() {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    return subscriptions;
+}
+
+void mock_mqtt_set_recording(bool enable) {
+    std::lock_guard<std::mutex> guard(mock_lock);
+    recording = enable;
+}
+
+bool mock_mqtt_inject(const char* topic, const void* payload, size_t length) {
+    esp_mqtt_client* client;
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        client = active_client;
+        if (client == nullptr || !client->connected) {
+            return false;
+        }
+        bool subscribed = false;
+        for (const std::string& filter : subscriptions) {
+            subscribed = subscribed || topic_matches(filter, topic);
+        }
+        if (!subscribed) {
+            return false;
+        }
+    }
+    // Fragment like ESP-MQTT: the topic comes with the first chunk only
+    std::string data((const char*)payload, length);
+    std::string topic_copy(topic);
+    size_t offset = 0;
+    do {
+        size_t chunk = std::min(length - offset, (size_t)client->config.buffer.size);
+        esp_mqtt_event_t event = {};
+        event.event_id = MQTT_EVENT_DATA;
+        event.data = &data[offset];
+        event.data_len = (int)chunk;
+        event.total_data_len = (int)length;
+        event.current_data_offset = (int)offset;
+        if (offset == 0) {
+            event.topic = &topic_copy[0];
+            event.topic_len = (int)topic_copy.size();
+        }
+        dispatch(client, event);
+        offset += chunk;
+    } while (offset < length);
+    return true;
+}
+
+void mock_mqtt_set_broker_up(bool up) {
+    esp_mqtt_client* client;
+    {
+        std::lock_guard<std::mutex> guard(mock_lock);
+        broker_up = up;
+        client = active_client;
+    }
+    if (client == nullptr) {
+        return;
+    }
+    if (!up) {
+        disconnect(client);
+    } else if (!client->config.network.disable_auto_reconnect) {
+        connect(client);
+    }
+}
@@ -0,0 +1,237 @@
+// Host build: a WiFi station that associates at once, an lwIP-less netif,
+// SNTP from the host clock and an HTTP client for file:// URLs
+//
+// esp_wifi_start() posts WIFI_EVENT_STA_START; esp_wifi_connect() posts
+// WIFI_EVENT_STA_CONNECTED and IP_EVENT_STA_GOT_IP with 127.0.0.1 (or the
+// static address), so mqtt_helper runs its whole connect path.
+
+#include <esp_wifi.h>
+#include <esp_netif.h>
+#include <esp_sntp.h>
+#include <esp_http_client.h>
+#include <esp_crt_bundle.h>
+#include <string.h>
+#include <string>
+#include <stdio.h>
+
+esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t IP_EVENT = "IP_EVENT";
+
+struct esp_netif_obj {
+    esp_netif_ip_info_t ip_info;
+    bool dhcp;
+};
+
+static esp_netif_obj station = {{{0x0100007f}, {0x000000ff}, {0x0100007f}}, true};
+static wifi_ap_record_t associated = {{0x02, 0x00, 0x00, 0x00, 0x00, 0x01}, 6};
+static bool started = false;
+static wifi_ps_type_t power_save = WIFI_PS_MIN_MODEM;
+
+esp_err_t esp_netif_init() {
+    return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta() {
+    return &station;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t* netif) {
+    netif->dhcp = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t* netif, const esp_netif_ip_info_t* info) {
+    netif->ip_info = *info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_str_to_ip4(const char* text, esp_ip4_addr_t* addr) {
+    unsigned a, b, c, d;
+    char extra;
+    if (text == nullptr || sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 ||
+        a > 255 || b > 255 || c > 255 || d > 255) {
+        return ESP_FAIL;
+    }
+    addr->addr = a | (b << 8) | (c << 16) | (d << 24);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t* netif, esp_netif_dns_type_t type, esp_netif_dns_info_t* dns) {
+    (void)netif;
+    (void)type;
+    (void)dns;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) {
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* config) {
+    (void)interface;
+    if (config->sta.bssid_set) {
+        for (int i = 0; i < 6; i++) {
+            associated.bssid[i] = config->sta.bssid[i];
+        }
+        associated.primary = config->sta.channel;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start() {
+    started = true;
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, nullptr, 0, 0);
+}
+
+esp_err_t esp_wifi_stop() {
+    started = false;
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, nullptr, 0, 0);
+}
+
+esp_err_t esp_wifi_connect() {
+    if (!started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ip_event_got_ip_t got_ip = {station.ip_info};
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, nullptr, 0, 0);
+    return esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+}
+
+esp_err_t esp_wifi_disconnect() {
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, nullptr, 0, 0);
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+    power_save = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type) {
+    *type = power_save;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* info) {
+    *info = associated;
+    return ESP_OK;
+}
+
+static sntp_sync_time_cb_t sntp_callback = nullptr;
+static bool sntp_enabled = false;
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t mode) {
+    (void)mode;
+}
+
+void esp_sntp_setservername(uint8_t index, const char* server) {
+    (void)index;
+    (void)server;
+}
+
+void sntp_set_sync_mode(sntp_sync_mode_t mode) {
+    (void)mode;
+}
+
+void sntp_set_sync_interval(uint32_t interval_ms) {
+    (void)interval_ms;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sntp_callback = callback;
+}
+
+void esp_sntp_init() {
+    sntp_enabled = true;
+    if (sntp_callback != nullptr) {
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        sntp_callback(&now);
+    }
+}
+
+void esp_sntp_stop() {
+    sntp_enabled = false;
+}
+
+bool esp_sntp_enabled() {
+    return sntp_enabled;
+}
+
+// ==================== HTTP Client ====================
+// file:///path reads the file; any other URL fails to connect
+
+struct esp_http_client {
+    std::string path;
+    FILE* file;
+    int64_t length;
+    int64_t read;
+};
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config) {
+    if (config == nullptr || config->url == nullptr) {
+        return nullptr;
+    }
+    esp_http_client_handle_t client = new esp_http_client{};
+    if (strncmp(config->url, "file://", 7) == 0) {
+        client->path = config->url + 7;
+    }
+    return client;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len) {
+    (void)write_len;
+    client->file = client->path.empty() ? nullptr : fopen(client->path.c_str(), "rb");
+    if (client->file == nullptr) {
+        return ESP_FAIL;
+    }
+    fseek(client->file, 0, SEEK_END);
+    client->length = ftell(client->file);
+    fseek(client->file, 0, SEEK_SET);
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client) {
+    return client->length;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->file != nullptr ? 200 : 0;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer, int len) {
+    if (client->file == nullptr) {
+        return -1;
+    }
+    size_t n = fread(buffer, 1, (size_t)len, client->file);
+    client->read += (int64_t)n;
+    return ferror(client->file) ? -1 : (int)n;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client) {
+    return client->file != nullptr && client->read == client->length;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+    if (client->file != nullptr) {
+        fclose(client->file);
+        client->file = nullptr;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    esp_http_client_close(client);
+    delete client;
+    return ESP_OK;
+}
+
+esp_err_t esp_crt_bundle_attach(void* conf) {
+    (void)conf;
+    return ESP_OK;
+}
@@ -0,0 +1,79 @@
+// Host build: NVS as an in-memory map of namespace/key to blob
+
+#include <nvs.h>
+#include <nvs_flash.h>
+#include <host_hal.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <string.h>
+
+static std::mutex nvs_lock;
+static std::map<std::string, std::vector<uint8_t>> store;     // "<namespace>/<key>"
+static std::vector<std::string> namespaces;                   // Indexed by handle - 1
+
+static std::string key_of(nvs_handle_t handle, const char* key) {
+    return namespaces[handle - 1] + "/" + key;
+}
+
+esp_err_t nvs_flash_init() {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase() {
+    host_nvs_reset();
+    return ESP_OK;
+}
+
+void host_nvs_reset() {
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    store.clear();
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    (void)mode;
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    namespaces.push_back(name);
+    *handle = (nvs_handle_t)namespaces.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length) {
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    auto it = store.find(key_of(handle, key));
+    if (it == store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out == nullptr) {
+        *length = it->second.size();
+        return ESP_OK;
+    }
+    if (*length < it->second.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out, it->second.data(), it->second.size());
+    *length = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    const uint8_t* bytes = (const uint8_t*)value;
+    store[key_of(handle, key)].assign(bytes, bytes + length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    return store.erase(key_of(handle, key)) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
@@ -7,22 +7,26 @@
  * position feedback for accurate nutrient delivery in agricultural applications.
  */
 
+#include "module_runtime.h"
 #include "mqtt_helper.h"
 #include "debug_helper.h"
-#include "sensor_filter_c.h"
+#include "json_arena.h"
+#include "time_sync.h"
 #include "sensor_calibration.h"
+#include "telemetry_frame.h"
+#include "adc_stream.h"
+#include "actuator_task.h"
+#include "control_loop.h"
+#include "pid_controller.h"
 #include <cJSON.h>
 #include <driver/ledc.h>
 #include <driver/adc.h>
-#include <esp_adc_cal.h>
 #include <driver/gpio.h>
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-
-// Sensor filter instances for smoothing readings
-sensor_filter_t depthFilter;
-sensor_filter_t pressureFilter;
+#include <math.h>
+#include <string.h>
 
 // ==================== Hardware Configuration ====================
 #define MOTOR_PIN          12    // Injection motor control (PWM)
@@ -35,60 +39,133 @@ sensor_filter_t pressureFilter;
 #define PWM_FREQ 5000
 #define PWM_RESOLUTION LEDC_TIMER_8_BIT
 
-// ==================== Network Configuration ====================
-const char* WIFI_SSID = "Your_WiFi_SSID";
-const char* WIFI_PASS = "Your_WiFi_Password";
-const char* MQTT_BROKER = "192.168.1.100";
-const int   MQTT_PORT = 1883;
+#define SAMPLE_PERIOD_MS   200   // Acquisition period (5 Hz)
+#define ACTIVE_SAMPLE_PERIOD_MS 50  // Acquisition period while actuating (20 Hz)
+#define INJECTION_TIMEOUT_MS 10000  // Stroke must settle at depth within 10 s
+
+// Injection sensors (filter chosen per channel; field order is the telemetry
+// field order shared by JSON and binary payloads)
+enum { CHANNEL_DEPTH, CHANNEL_PRESSURE };
+static const module_channel_t SENSOR_CHANNELS[] = {
+    {   // CHANNEL_DEPTH: moving average
+        .field = "depth", .calibration_name = "depth",
+        .source = MODULE_SOURCE_ADC, .pin = DEPTH_SENSOR_PIN,
+        .filter = MODULE_FILTER_AVERAGE,
+        .default_curve = &CALIBRATION_DEFAULT_DEPTH,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(0.5f),      // 0.5 mm
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(20.0f)},   // mm per s
+    },
+    {   // CHANNEL_PRESSURE: rejects pressure spikes
+        .field = "pressure", .calibration_name = "pressure",
+        .source = MODULE_SOURCE_ADC, .pin = PRESSURE_PIN,
+        .filter = MODULE_FILTER_MEDIAN,
+        .default_curve = &CALIBRATION_DEFAULT_PRESSURE,
+        .deadband = SENSOR_VALUE_FROM_FLOAT(1.0f),      // 1 kPa
+        .anomaly = {.z_limit = 4.0f, .rate_limit = SENSOR_VALUE_FROM_FLOAT(100.0f)},  // kPa per s
+    },
+};
+
+// Needle position feedback, published as a bool
+static const module_flag_t SENSOR_FLAGS[] = {
+    {"needle_position", NEEDLE_FEEDBACK_PIN},
+};
+
+// ==================== Injection Control Loop ====================
+// Depth and pressure are in calibrated units (default curves: mm, kPa).
+// Gains are starting points; tune per rig by overriding at build time.
+#ifndef INJECTION_CONTROL_HZ
+#define INJECTION_CONTROL_HZ 1000
+#endif
+#define CONTROL_DT         (1.0f / INJECTION_CONTROL_HZ)
+#define DUTY_MAX           255.0f   // LEDC_TIMER_8_BIT
+#define MOTOR_MIN_DUTY     150.0f   // Minimum power for operation (depth feedforward)
+
+#ifndef DEPTH_KP
+#define DEPTH_KP           40.0f    // Duty per mm
+#define DEPTH_KI           20.0f
+#define DEPTH_KD           0.5f
+#endif
+#ifndef PRESSURE_KP
+#define PRESSURE_KP        1.0f     // Duty per kPa
+#define PRESSURE_KI        5.0f
+#endif
+#define PRESSURE_FULL_SCALE 300.0f  // kPa at full duty (feedforward)
+
+#define DEPTH_RAMP_RATE    20.0f    // Setpoint ramp (mm/s)
+#define DEPTH_TOLERANCE    0.5f     // Settled band around the target (mm)
+#define SETTLE_TIME_MS     100      // Time in band before the stroke ends
+#define SETTLE_ITERATIONS  (SETTLE_TIME_MS * INJECTION_CONTROL_HZ / 1000)
+
+static const pid_config_t DEPTH_PID = {DEPTH_KP, DEPTH_KI, DEPTH_KD, 0.0f, DUTY_MAX, 0.2f};
+static const pid_config_t PRESSURE_PID = {PRESSURE_KP, PRESSURE_KI, 0.0f, 0.0f, DUTY_MAX, 1.0f};
+
+// Per-injection statistics, written by the control task while it runs
+typedef struct {
+    float target_depth;
+    float max_depth;
+    float peak_pressure;
+    float energy;               // Integral of duty fraction (full-duty seconds)
+    uint32_t settle_ms;
+    int64_t start_us;
+} injection_stats_t;
+
+// Actuator state machine (runs on the actuator task)
+enum { EVENT_INJECT = ACTUATOR_EVENT_USER, EVENT_RETRACT, EVENT_SETTLED };
+typedef enum { INJECTION_IDLE, INJECTION_ACTIVE } injection_state_t;
+static injection_state_t actuatorState = INJECTION_IDLE;
+static int32_t injectionSequence = 0;   // Tags EVENT_SETTLED with the injection it belongs to
+
+// Control loop state, owned by the control task while the loop runs
+static pid_controller_t depthPid;
+static pid_controller_t pressurePid;
+static setpoint_ramp_t depthRamp;
+static float targetPressure = 0.0f;
+static float pressureFeedforward = 0.0f;
+static uint32_t bandEntered = 0;
+static bool inBand = false;
+static injection_stats_t injectionStats;
 
-// MQTT Topics for communication with central control system
-const char* TOPIC_COMMAND = "exoskeleton/injection/command";
-const char* TOPIC_STATUS = "exoskeleton/injection/status";
-const char* TOPIC_SENSORS = "exoskeleton/injection/sensors";
+// Per-injection statistics topic, next to the runtime's topics
+static const char* TOPIC_STATS = MODULE_TOPIC_PREFIX "injection/stats";
 
 // ==================== Function Declarations ====================
 void app_main();
-void injection_task(void *pvParameter);
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length);
-void publishSensorData();
-void processCommand(cJSON* command);
+void handleInject(const cJSON* params);
+void handleRetract(const cJSON* params);
 void injectSoil(int targetDepth, int targetPressure);
-void sendStatus(const char* state, const char* message);
+void injectionStateMachine(const actuator_event_t* event);
 void initializeHardware();
 
+// Module commands (the runtime adds the ones listed in module_runtime.h)
+static const command_entry_t COMMANDS[] = {
+    {"inject", handleInject},
+    {"retract", handleRetract},
+};
+
+// Always awake: the control loop and watchdog must run between samples
+static const module_descriptor_t INJECTION_MODULE = {
+    .name = "injection",
+    .client_id = "InjectionClient",
+    .telemetry_id = TELEMETRY_MODULE_INJECTION,
+    .channels = SENSOR_CHANNELS,
+    .channel_count = sizeof(SENSOR_CHANNELS) / sizeof(SENSOR_CHANNELS[0]),
+    .flags = SENSOR_FLAGS,
+    .flag_count = sizeof(SENSOR_FLAGS) / sizeof(SENSOR_FLAGS[0]),
+    .commands = COMMANDS,
+    .command_count = sizeof(COMMANDS) / sizeof(COMMANDS[0]),
+    .state_machine = injectionStateMachine,
+    .init_hardware = initializeHardware,
+    .sample_period_ms = SAMPLE_PERIOD_MS,
+    .active_sample_period_ms = ACTIVE_SAMPLE_PERIOD_MS,
+    .power_mode = POWER_MODE_ACTIVE,
+};
+
 // ==================== Main Program ====================
 void app_main() {
-    DebugHelper::initialize();
-    
-    // Initialize sensor filters for noise reduction
-    sensor_filter_init(&depthFilter);
-    sensor_filter_init(&pressureFilter);
-    
-    // Initialize hardware peripherals
-    initializeHardware();
-    
-    // Initialize MQTT helper with network credentials
-    mqtt_helper_init(WIFI_SSID, WIFI_PASS, MQTT_BROKER, MQTT_PORT, 
-                    "InjectionClient", mqttCallback);
-    
-    // Connect to WiFi and MQTT broker
-    if (mqtt_helper_connect_wifi() && mqtt_helper_connect_broker()) {
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-    }
-    
-    DebugHelper::info("Injection module initialization complete");
-    sendStatus("IDLE", "System startup");
-    
-    // Create main task for continuous operation
-    xTaskCreate(injection_task, "injection_task", 4096, NULL, 5, NULL);
+    module_start(&INJECTION_MODULE);
 }
 
 void initializeHardware() {
-    // Configure ADC for sensor readings
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(DEPTH_SENSOR_PIN, ADC_ATTEN_DB_0);
-    adc1_config_channel_atten(PRESSURE_PIN, ADC_ATTEN_DB_0);
-    
     // Configure needle feedback pin as input with pullup
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << NEEDLE_FEEDBACK_PIN),
@@ -120,162 +197,191 @@ void initializeHardware() {
     ledc_channel_config(&ledc_channel);
 }
 
-void injection_task(void *pvParameter) {
-    while (1) {
-        // Process MQTT messages
-        mqtt_helper_loop();
-        
-        static unsigned long lastUpdate = 0;
-        unsigned long current_time = (unsigned long)(esp_timer_get_time() / 1000);
-        if (current_time - lastUpdate > 200) { // Update sensor data at 5Hz
-            publishSensorData();
-            lastUpdate = current_time;
-        }
-        
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+// ==================== Command Processing ====================
+void handleInject(const cJSON* params) {
+    cJSON* depth = cJSON_GetObjectItem(params, "depth");
+    cJSON* pressure = cJSON_GetObjectItem(params, "pressure");
+    
+    if (cJSON_IsNumber(depth) && cJSON_IsNumber(pressure)) {
+        injectSoil(depth->valueint, pressure->valueint);
     }
 }
 
-// ==================== MQTT Callback ====================
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
-    // Handle internal resubscription message for connection recovery
-    if (strcmp(topic, "internal/resubscribe") == 0) {
-        DebugHelper::info("Resubscribing to topic: %s", TOPIC_COMMAND);
-        mqtt_helper_subscribe(TOPIC_COMMAND);
-        return;
-    }
+void handleRetract(const cJSON* params) {
+    actuator_post(EVENT_RETRACT, 0, 0);
+}
+
+// ==================== Injection Control ====================
+// Injection runs as a state machine on the actuator task: the command posts
+// an event and returns. The control task closes the loop on calibrated depth
+// and pressure at INJECTION_CONTROL_HZ and reports when the depth settles;
+// the actuator timeout is the watchdog.
+void injectSoil(int targetDepth, int targetPressure) {
+    actuator_post(EVENT_INJECT, targetDepth, targetPressure);
+}
+
+static void stopMotor() {
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL, 0);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL);
+}
+
+// Fresh depth/pressure for every control step while injecting, the module
+// default otherwise (no-op with ADC_STREAM, which converts continuously)
+static void setSensorScanPeriod(uint32_t period_us) {
+    uint32_t rest_us = ACTIVE_SAMPLE_PERIOD_MS * 1000;
+    adc_scheduler_set_period(DEPTH_SENSOR_PIN, period_us != 0 ? period_us : rest_us);
+    adc_scheduler_set_period(PRESSURE_PIN, period_us != 0 ? period_us : rest_us);
+}
+
+static float readDepth() {
+    return SENSOR_VALUE_TO_FLOAT(calibration_apply(module_calibration(CHANNEL_DEPTH), adc_read_value(DEPTH_SENSOR_PIN)));
+}
+
+static float readPressure() {
+    return SENSOR_VALUE_TO_FLOAT(calibration_apply(module_calibration(CHANNEL_PRESSURE), adc_read_value(PRESSURE_PIN)));
+}
+
+// Runs on the control task every 1/INJECTION_CONTROL_HZ
+static bool injectionControlStep(uint32_t iteration) {
+    float depth = readDepth();
+    float pressure = readPressure();
     
-    // Create null-terminated string from payload
-    char* json_string = (char*)malloc(length + 1);
-    memcpy(json_string, payload, length);
-    json_string[length] = '\0';
+    // Depth PID on the ramped setpoint, pressure PI around the open-loop duty;
+    // the lower output drives the motor and both integrators track it
+    float depthDuty = pid_update(&depthPid, ramp_step(&depthRamp), depth, MOTOR_MIN_DUTY);
+    float pressureDuty = pid_update(&pressurePid, targetPressure, pressure, pressureFeedforward);
+    float duty = depthDuty < pressureDuty ? depthDuty : pressureDuty;
+    pid_track(&depthPid, duty);
+    pid_track(&pressurePid, duty);
     
-    // Parse JSON command
-    cJSON* json = cJSON_Parse(json_string);
-    free(json_string);
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL, (uint32_t)(duty + 0.5f));
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL);
     
-    if (json == NULL) {
-        DebugHelper::error("JSON parsing failed");
-        return;
-    }
+    if (depth > injectionStats.max_depth) injectionStats.max_depth = depth;
+    if (pressure > injectionStats.peak_pressure) injectionStats.peak_pressure = pressure;
+    injectionStats.energy += duty / DUTY_MAX * CONTROL_DT;
     
-    // Process command
-    if (strcmp(topic, TOPIC_COMMAND) == 0) {
-        processCommand(json);
+    // Settled once the depth stays in band for SETTLE_TIME_MS
+    if (fabsf(depth - injectionStats.target_depth) > DEPTH_TOLERANCE) {
+        inBand = false;
+        return true;
     }
-    
-    cJSON_Delete(json);
+    if (!inBand) {
+        inBand = true;
+        bandEntered = iteration;
+    }
+    if (iteration - bandEntered < SETTLE_ITERATIONS) {
+        return true;
+    }
+    injectionStats.settle_ms = bandEntered * 1000 / INJECTION_CONTROL_HZ;
+    actuator_post(EVENT_SETTLED, injectionSequence, 0);
+    return false;
 }
 
-// ==================== Sensor Data Publishing ====================
-void publishSensorData() {
-    // Create JSON object for sensor readings
-    cJSON* json = cJSON_CreateObject();
+static void publishInjectionStats(const char* result) {
+    float overshoot = injectionStats.max_depth - injectionStats.target_depth;
     
-    // Read raw sensor values
-    float rawDepth = adc1_get_raw(DEPTH_SENSOR_PIN);
-    float rawPressure = adc1_get_raw(PRESSURE_PIN);
-    int needlePosition = gpio_get_level(NEEDLE_FEEDBACK_PIN);
+    JsonArenaScope arena;
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "module", "injection");
+    cJSON_AddStringToObject(json, "result", result);
+    cJSON_AddNumberToObject(json, "target_depth", injectionStats.target_depth);
+    cJSON_AddNumberToObject(json, "max_depth", injectionStats.max_depth);
+    cJSON_AddNumberToObject(json, "overshoot", overshoot > 0.0f ? overshoot : 0.0f);
+    cJSON_AddNumberToObject(json, "settle_time_ms", injectionStats.settle_ms);
+    cJSON_AddNumberToObject(json, "duration_ms",
+                            (unsigned long)((esp_timer_get_time() - injectionStats.start_us) / 1000));
+    cJSON_AddNumberToObject(json, "peak_pressure", injectionStats.peak_pressure);
+    cJSON_AddNumberToObject(json, "energy", injectionStats.energy);
+    cJSON_AddNumberToObject(json, "missed_ticks", control_loop_missed_ticks());
+    cJSON_AddNumberToObject(json, "max_jitter_us", control_loop_max_jitter_us());
+    cJSON_AddNumberToObject(json, "timestamp", (double)time_sync_now_ms());
     
-    // Apply filtering for noise reduction
-    sensor_filter_add_value(&depthFilter, rawDepth);
-    sensor_filter_add_value(&pressureFilter, rawPressure);
+    char* json_string = json_print(json, false);
+    mqtt_helper_publish(TOPIC_STATS, json_string);
     
-    // Calibrate sensor readings to real-world units
-    float calibratedDepth = calibrate_pressure(sensor_filter_get_filtered(&depthFilter));  // Reuse pressure calibration
-    float calibratedPressure = calibrate_pressure(sensor_filter_get_filtered(&pressureFilter));
+    cJSON_free(json_string);
+    cJSON_Delete(json);
+}
+
+static void beginInjection(int targetDepth, int targetPressureKpa) {
+    DebugHelper::info("Starting soil injection - Target depth: %d, Target pressure: %d", 
+                     targetDepth, targetPressureKpa);
+    module_send_status("INJECTING", "Starting injection...");
     
-    // Add sensor data to JSON
-    cJSON_AddNumberToObject(json, "depth", calibratedDepth);
-    cJSON_AddNumberToObject(json, "pressure", calibratedPressure);
-    cJSON_AddBoolToObject(json, "needle_position", needlePosition);
+    // Ramp from the current depth so the stroke starts without a duty step
+    float depth = readDepth();
+    pid_init(&depthPid, &DEPTH_PID, CONTROL_DT);
+    pid_init(&pressurePid, &PRESSURE_PID, CONTROL_DT);
+    ramp_init(&depthRamp, depth, (float)targetDepth, DEPTH_RAMP_RATE, CONTROL_DT);
+    targetPressure = (float)targetPressureKpa;
+    pressureFeedforward = fminf(targetPressure * DUTY_MAX / PRESSURE_FULL_SCALE, DUTY_MAX);
+    inBand = false;
     
-    // Serialize and publish sensor data
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_SENSORS, json_string);
+    memset(&injectionStats, 0, sizeof(injectionStats));
+    injectionStats.target_depth = (float)targetDepth;
+    injectionStats.max_depth = depth;
+    injectionStats.start_us = esp_timer_get_time();
     
-    free(json_string);
-    cJSON_Delete(json);
+    injectionSequence++;
+    actuatorState = INJECTION_ACTIVE;
+    actuator_set_timeout(INJECTION_TIMEOUT_MS);
+    setSensorScanPeriod(1000000 / INJECTION_CONTROL_HZ);
+    control_loop_start(1000000 / INJECTION_CONTROL_HZ, injectionControlStep);
 }
 
-// ==================== Command Processing ====================
-void processCommand(cJSON* command) {
-    cJSON* action = cJSON_GetObjectItem(command, "action");
+static void endInjection(const char* result) {
+    // Take the motor back from the control loop, then stop it
+    control_loop_stop();
+    stopMotor();
+    setSensorScanPeriod(0);
+    actuator_cancel_timers();
+    actuatorState = INJECTION_IDLE;
     
-    if (cJSON_IsString(action) && strcmp(action->valuestring, "inject") == 0) {
-        cJSON* params = cJSON_GetObjectItem(command, "params");
-        cJSON* depth = cJSON_GetObjectItem(params, "depth");
-        cJSON* pressure = cJSON_GetObjectItem(params, "pressure");
-        
-        if (cJSON_IsNumber(depth) && cJSON_IsNumber(pressure)) {
-            injectSoil(depth->valueint, pressure->valueint);
-        }
-    }
-    else if (cJSON_IsString(action) && strcmp(action->valuestring, "retract") == 0) {
-        // Stop motor and retract needle
-        ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL, 0);
-        ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL);
-        sendStatus("RETRACTING", "Retracting needle");
-        DebugHelper::info("Needle retraction initiated");
-    }
+    publishInjectionStats(result);
 }
 
-// ==================== Injection Control ====================
-void injectSoil(int targetDepth, int targetPressure) {
-    DebugHelper::info("Starting soil injection - Target depth: %d, Target pressure: %d", 
-                     targetDepth, targetPressure);
-    sendStatus("INJECTING", "Starting injection...");
-    
-    // Calculate motor power based on target pressure (PWM control)
-    int motorPower = (targetPressure * 255) / 300;  // Map 0-300 to 0-255 PWM range
-    if (motorPower > 255) motorPower = 255;  // Clamp to maximum
-    if (motorPower < 150) motorPower = 150;  // Minimum power for operation
-    
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL, motorPower);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL);
-    
-    // Monitor injection progress with timeout protection
-    unsigned long startTime = (unsigned long)(esp_timer_get_time() / 1000);
-    while (true) {
-        int currentDepth = adc1_get_raw(DEPTH_SENSOR_PIN);
+void injectionStateMachine(const actuator_event_t* event) {
+    switch (event->type) {
+        case EVENT_INJECT:
+            if (actuatorState != INJECTION_IDLE) {
+                DebugHelper::warning("Injection in progress, command ignored");
+                module_send_status("INJECTING", "Command ignored, injection in progress");
+                break;
+            }
+            beginInjection(event->args[0], event->args[1]);
+            break;
         
-        // Check if target depth reached
-        if (currentDepth >= targetDepth) {
-            DebugHelper::info("Target depth reached: %d", currentDepth);
+        case EVENT_RETRACT:
+            // Stop motor and retract needle, aborting any injection
+            if (actuatorState == INJECTION_ACTIVE) {
+                endInjection("aborted");
+            } else {
+                stopMotor();
+            }
+            module_send_status("RETRACTING", "Retracting needle");
+            DebugHelper::info("Needle retraction initiated");
             break;
-        }
         
-        // Timeout protection - prevent infinite operation
-        if ((unsigned long)(esp_timer_get_time() / 1000) - startTime > 10000) { // 10 second timeout
-            DebugHelper::error("Injection timeout - operation aborted");
-            sendStatus("ERROR", "Injection timeout");
+        case EVENT_SETTLED:
+            if (actuatorState == INJECTION_ACTIVE && event->args[0] == injectionSequence) {
+                DebugHelper::info("Target depth reached: settled in %lu ms",
+                                 (unsigned long)injectionStats.settle_ms);
+                endInjection("completed");
+                DebugHelper::info("Injection operation completed");
+                module_send_status("COMPLETED", "Injection completed");
+            }
             break;
-        }
         
-        vTaskDelay(50 / portTICK_PERIOD_MS);  // 50ms monitoring interval
+        case ACTUATOR_EVENT_TIMEOUT:
+            // Timeout protection - prevent infinite operation
+            if (actuatorState == INJECTION_ACTIVE) {
+                DebugHelper::error("Injection timeout - operation aborted");
+                module_send_status("ERROR", "Injection timeout");
+                endInjection("timeout");
+                module_send_status("COMPLETED", "Injection completed");
+            }
+            break;
     }
-    
-    // Stop injection motor
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL, 0);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, MOTOR_PWM_CHANNEL);
-    
-    DebugHelper::info("Injection operation completed");
-    sendStatus("COMPLETED", "Injection completed");
 }
 
-// ==================== Status Reporting ====================
-void sendStatus(const char* state, const char* message) {
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddStringToObject(json, "module", "injection");
-    cJSON_AddStringToObject(json, "state", state);
-    cJSON_AddStringToObject(json, "message", message);
-    cJSON_AddNumberToObject(json, "timestamp", (unsigned long)(esp_timer_get_time() / 1000));
-    
-    char* json_string = cJSON_Print(json);
-    mqtt_helper_publish(TOPIC_STATUS, json_string);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    
-    DebugHelper::info("Status report: %s - %s", state, message);
-}
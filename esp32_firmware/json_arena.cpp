@@ -0,0 +1,116 @@
+#include "json_arena.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+static std::atomic<uint32_t> high_water{0};
+
+uint32_t json_arena_high_water() {
+    return high_water.load(std::memory_order_relaxed);
+}
+
+#if STATIC_MEMORY_ENABLED
+
+#define ARENA_ALIGN 8
+
+typedef struct {
+    alignas(ARENA_ALIGN) uint8_t buffer[JSON_ARENA_SIZE];
+    size_t used;
+    std::atomic<bool> busy;
+} json_arena_t;
+
+static json_arena_t arenas[JSON_ARENA_COUNT];
+
+// Arena of the innermost scope on this task (FreeRTOS TLS on ESP-IDF)
+static thread_local json_arena_t* current = nullptr;
+
+static void note_high_water(uint32_t used) {
+    uint32_t mark = high_water.load(std::memory_order_relaxed);
+    while (used > mark &&
+           !high_water.compare_exchange_weak(mark, used, std::memory_order_relaxed)) {
+    }
+}
+
+static inline bool in_arenas(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return p >= (const uint8_t*)&arenas[0] && p < (const uint8_t*)&arenas[JSON_ARENA_COUNT];
+}
+
+static void* arena_malloc(size_t size) {
+    json_arena_t* arena = current;
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (arena != nullptr && JSON_ARENA_SIZE - arena->used >= aligned) {
+        void* ptr = &arena->buffer[arena->used];
+        arena->used += aligned;
+        return ptr;
+    }
+    metrics_count(METRIC_JSON_ARENA_FALLBACKS, 1);
+    return malloc(size);
+}
+
+// Arena memory is reclaimed all at once when its scope ends
+static void arena_free(void* ptr) {
+    if (!in_arenas(ptr)) {
+        free(ptr);
+    }
+}
+
+void json_arena_init() {
+    cJSON_Hooks hooks = {};
+    hooks.malloc_fn = arena_malloc;
+    hooks.free_fn = arena_free;
+    cJSON_InitHooks(&hooks);
+}
+
+char* json_print(const cJSON* json, bool formatted) {
+    json_arena_t* arena = current;
+    if (arena != nullptr && arena->used < JSON_ARENA_SIZE) {
+        // Print straight into the rest of the arena: no growing buffer, no copy
+        char* text = (char*)&arena->buffer[arena->used];
+        size_t space = JSON_ARENA_SIZE - arena->used;
+        if (cJSON_PrintPreallocated((cJSON*)json, text, (int)space, formatted)) {
+            size_t length = strlen(text) + 1;
+            arena->used += (length + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+            if (arena->used > JSON_ARENA_SIZE) {
+                arena->used = JSON_ARENA_SIZE;
+            }
+            return text;
+        }
+    }
+    return formatted ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+}
+
+JsonArenaScope::JsonArenaScope() : arena(nullptr), previous(current) {
+    for (size_t i = 0; i < JSON_ARENA_COUNT; i++) {
+        bool expected = false;
+        if (arenas[i].busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            arenas[i].used = 0;
+            arena = &arenas[i];
+            current = &arenas[i];
+            return;
+        }
+    }
+    // Pool empty: keep allocating from the enclosing scope's arena, if any
+}
+
+JsonArenaScope::~JsonArenaScope() {
+    if (arena == nullptr) {
+        return;
+    }
+    json_arena_t* own = (json_arena_t*)arena;
+    note_high_water((uint32_t)own->used);
+    current = (json_arena_t*)previous;
+    own->busy.store(false, std::memory_order_release);
+}
+
+#else // !STATIC_MEMORY_ENABLED
+
+void json_arena_init() {
+}
+
+char* json_print(const cJSON* json, bool formatted) {
+    return formatted ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+}
+
+#endif // STATIC_MEMORY_ENABLED
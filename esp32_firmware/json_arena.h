@@ -0,0 +1,90 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+
+/**
+ * @file json_arena.h
+ * @brief Fixed arenas for cJSON messages (static memory builds)
+ *
+ * With the STATIC_MEMORY CMake option (defines STATIC_MEMORY_ENABLED=1)
+ * cJSON allocates from a pool of JSON_ARENA_COUNT preallocated arenas
+ * instead of the heap. A JsonArenaScope around the code that builds,
+ * prints or parses one message takes a free arena from the pool; cJSON
+ * nodes and the printed string are bump-allocated in it, cJSON_free() of
+ * arena memory does nothing, and the whole arena is reset when the scope
+ * ends. Steady-state messaging therefore never touches the heap and cannot
+ * fragment it.
+ *
+ * Scopes nest (a command handler that publishes a status takes a second
+ * arena) and are per task. When the pool is empty a scope keeps using the
+ * enclosing one; allocations that fit nowhere, or happen outside any scope,
+ * fall back to malloc() and are counted as "json_arena_fallbacks" in the
+ * metrics, next to the arena high-water mark.
+ *
+ * Without STATIC_MEMORY the scope is empty and cJSON uses the heap as before.
+ * Either way, print with json_print() and release the string with
+ * cJSON_free(), never free().
+ */
+
+#ifndef STATIC_MEMORY_ENABLED
+#define STATIC_MEMORY_ENABLED 0
+#endif
+
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE  12288          // Bytes per message (tree + printed text)
+#endif
+#ifndef JSON_ARENA_COUNT
+#define JSON_ARENA_COUNT 4              // Messages in flight across tasks, nesting included
+#endif
+
+/**
+ * @brief Route cJSON allocations through the arenas (call once at boot)
+ */
+void json_arena_init();
+
+/**
+ * @brief Print a cJSON tree into the current arena, or on the heap
+ * @param json Tree to print
+ * @param formatted true for indented output
+ * @return NUL-terminated text (release with cJSON_free()), nullptr on failure
+ */
+char* json_print(const cJSON* json, bool formatted);
+
+/**
+ * @brief Most arena bytes one message has used since boot
+ */
+uint32_t json_arena_high_water();
+
+#if STATIC_MEMORY_ENABLED
+
+/**
+ * @brief Lends an arena from the pool to the enclosing block
+ */
+class JsonArenaScope {
+public:
+    JsonArenaScope();
+    ~JsonArenaScope();
+    JsonArenaScope(const JsonArenaScope&) = delete;
+    JsonArenaScope& operator=(const JsonArenaScope&) = delete;
+
+private:
+    void* arena;                        // Taken from the pool, nullptr if none was free
+    void* previous;                     // Enclosing scope's arena on this task
+};
+
+#else
+
+class JsonArenaScope {
+public:
+    JsonArenaScope() {}
+    JsonArenaScope(const JsonArenaScope&) = delete;
+    JsonArenaScope& operator=(const JsonArenaScope&) = delete;
+};
+
+#endif
+
+#endif // JSON_ARENA_H
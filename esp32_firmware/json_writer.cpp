@@ -0,0 +1,172 @@
+#include "json_writer.h"
+#include <math.h>
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static inline void put(json_writer_t* writer, char c) {
+    if (writer->length + 1 < writer->size) {
+        writer->buffer[writer->length++] = c;
+    } else {
+        writer->overflow = true;
+    }
+}
+
+static inline void put_text(json_writer_t* writer, const char* text, size_t length) {
+    if (writer->length + length < writer->size) {
+        memcpy(&writer->buffer[writer->length], text, length);
+        writer->length += length;
+    } else {
+        writer->overflow = true;
+    }
+}
+
+static void put_escaped(json_writer_t* writer, const char* text) {
+    put(writer, '"');
+    for (const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++) {
+        switch (*c) {
+            case '"':  put_text(writer, "\\\"", 2); break;
+            case '\\': put_text(writer, "\\\\", 2); break;
+            case '\b': put_text(writer, "\\b", 2); break;
+            case '\f': put_text(writer, "\\f", 2); break;
+            case '\n': put_text(writer, "\\n", 2); break;
+            case '\r': put_text(writer, "\\r", 2); break;
+            case '\t': put_text(writer, "\\t", 2); break;
+            default:
+                if (*c < 0x20) {
+                    char escape[6] = {'\\', 'u', '0', '0', HEX_DIGITS[*c >> 4], HEX_DIGITS[*c & 0xF]};
+                    put_text(writer, escape, sizeof(escape));
+                } else {
+                    put(writer, (char)*c);
+                }
+        }
+    }
+    put(writer, '"');
+}
+
+// Comma and key before every member
+static void put_key(json_writer_t* writer, const char* key) {
+    if (writer->need_comma) {
+        put(writer, ',');
+    }
+    if (key != nullptr) {
+        put_escaped(writer, key);
+        put(writer, ':');
+    }
+    writer->need_comma = true;
+}
+
+// Decimal digits of value, written backwards from end; returns the first one
+static char* format_unsigned(uint64_t value, char* end) {
+    char* p = end;
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return p;
+}
+
+static void put_int(json_writer_t* writer, int64_t value) {
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    if (value < 0) {
+        put(writer, '-');
+    }
+    char* first = format_unsigned(magnitude, end);
+    put_text(writer, first, end - first);
+}
+
+void json_writer_init(json_writer_t* writer, char* buffer, size_t size) {
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->length = 0;
+    writer->need_comma = false;
+    writer->overflow = size == 0;
+}
+
+void json_writer_begin_object(json_writer_t* writer, const char* key) {
+    put_key(writer, key);
+    put(writer, '{');
+    writer->need_comma = false;
+}
+
+void json_writer_end_object(json_writer_t* writer) {
+    put(writer, '}');
+    writer->need_comma = true;
+}
+
+void json_writer_begin_array(json_writer_t* writer, const char* key) {
+    put_key(writer, key);
+    put(writer, '[');
+    writer->need_comma = false;
+}
+
+void json_writer_end_array(json_writer_t* writer) {
+    put(writer, ']');
+    writer->need_comma = true;
+}
+
+void json_writer_string(json_writer_t* writer, const char* key, const char* value) {
+    put_key(writer, key);
+    put_escaped(writer, value != nullptr ? value : "");
+}
+
+void json_writer_int(json_writer_t* writer, const char* key, int64_t value) {
+    put_key(writer, key);
+    put_int(writer, value);
+}
+
+void json_writer_milli(json_writer_t* writer, const char* key, int64_t value) {
+    put_key(writer, key);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    if (value < 0) {
+        put(writer, '-');
+    }
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* first = format_unsigned(magnitude / 1000, end);
+    put_text(writer, first, end - first);
+
+    uint32_t fraction = (uint32_t)(magnitude % 1000);
+    if (fraction != 0) {
+        char decimals[4] = {'.', (char)('0' + fraction / 100), (char)('0' + fraction / 10 % 10),
+                            (char)('0' + fraction % 10)};
+        size_t length = sizeof(decimals);
+        while (decimals[length - 1] == '0') {
+            length--;
+        }
+        put_text(writer, decimals, length);
+    }
+}
+
+void json_writer_float(json_writer_t* writer, const char* key, float value) {
+    // Beyond int64 milli-units (no sensor reading is) there is no exact value to write
+    if (!isfinite(value) || fabsf(value) > 9.0e15f) {
+        put_key(writer, key);
+        put_text(writer, "null", 4);
+        return;
+    }
+    double scaled = (double)value * 1000.0;
+    json_writer_milli(writer, key, (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5));
+}
+
+void json_writer_bool(json_writer_t* writer, const char* key, bool value) {
+    put_key(writer, key);
+    if (value) {
+        put_text(writer, "true", 4);
+    } else {
+        put_text(writer, "false", 5);
+    }
+}
+
+const char* json_writer_finish(json_writer_t* writer, size_t* length) {
+    if (writer->overflow) {
+        return nullptr;
+    }
+    writer->buffer[writer->length] = '\0';
+    if (length != nullptr) {
+        *length = writer->length;
+    }
+    return writer->buffer;
+}
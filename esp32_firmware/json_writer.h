@@ -0,0 +1,85 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file json_writer.h
+ * @brief Streaming, allocation-free JSON writer for small fixed messages
+ *
+ * Writes compact JSON straight into a caller buffer, one member at a time,
+ * with no tree, no heap and no printf. Meant for the messages sent often
+ * with a handful of known keys (status, JSON sensor telemetry); anything
+ * parsed or nested arbitrarily still uses cJSON.
+ *
+ * Each call takes the member key (nullptr inside arrays and for the root
+ * object); commas are inserted automatically. When the buffer fills up the
+ * writer stops writing and json_writer_finish() returns nullptr, so a
+ * message is never published truncated.
+ *
+ * Numbers: integers are exact. Real values are written with three decimals
+ * at most, trailing zeros dropped (21.5, 0.125, 3), which is the resolution
+ * of the fixed-point sample path (sensor_value.h); NaN and infinity become
+ * null, as cJSON prints them.
+ */
+
+/**
+ * @brief Writer state over a caller-owned buffer
+ */
+typedef struct {
+    char* buffer;
+    size_t size;                        // Buffer capacity including the NUL
+    size_t length;                      // Bytes written
+    bool need_comma;                    // A member precedes the next one
+    bool overflow;                      // Something did not fit
+} json_writer_t;
+
+/**
+ * @brief Start writing into a buffer
+ * @param writer Writer state
+ * @param buffer Output buffer
+ * @param size Buffer size in bytes (output is NUL-terminated)
+ */
+void json_writer_init(json_writer_t* writer, char* buffer, size_t size);
+
+void json_writer_begin_object(json_writer_t* writer, const char* key);
+void json_writer_end_object(json_writer_t* writer);
+void json_writer_begin_array(json_writer_t* writer, const char* key);
+void json_writer_end_array(json_writer_t* writer);
+
+/**
+ * @brief String member, escaped as needed
+ */
+void json_writer_string(json_writer_t* writer, const char* key, const char* value);
+
+/**
+ * @brief Integer member
+ */
+void json_writer_int(json_writer_t* writer, const char* key, int64_t value);
+
+/**
+ * @brief Real member given in milli-units (21500 -> 21.5)
+ */
+void json_writer_milli(json_writer_t* writer, const char* key, int64_t value);
+
+/**
+ * @brief Real member, rounded to three decimals
+ */
+void json_writer_float(json_writer_t* writer, const char* key, float value);
+
+/**
+ * @brief Boolean member
+ */
+void json_writer_bool(json_writer_t* writer, const char* key, bool value);
+
+/**
+ * @brief End the output
+ * @param writer Writer state
+ * @param length Receives the output length (optional)
+ * @return NUL-terminated JSON in the buffer, nullptr if it did not fit
+ */
+const char* json_writer_finish(json_writer_t* writer, size_t* length);
+
+#endif // JSON_WRITER_H
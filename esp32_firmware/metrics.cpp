@@ -0,0 +1,216 @@
+#include "metrics.h"
+
+#if METRICS_ENABLED
+
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "json_arena.h"
+#include "time_sync.h"
+#include <cJSON.h>
+#include <esp_app_desc.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+
+static const char* const HISTOGRAM_NAMES[METRIC_HISTOGRAM_COUNT] = {
+    "adc_read", "filter", "calibrate", "json_build",
+    "publish", "command", "actuation", "reconnect",
+    "control_jitter", "sample_jitter", "adc_scan", "time_sync",
+    "anomaly_check"
+};
+static const char* const COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+    "published", "publish_failed", "commands", "disconnects",
+    "offline_stored", "offline_replayed", "offline_dropped",
+    "telemetry_suppressed", "json_arena_fallbacks", "time_syncs",
+    "ota_updates", "ota_failed", "ota_rollbacks", "anomalies"
+};
+static const char* const GAUGE_NAMES[METRIC_GAUGE_COUNT] = {
+    "wifi_connect_ms", "wifi_fast", "first_publish_ms",
+    "ota_progress_pct", "ota_download_bytes", "ota_download_ms", "ota_image_bytes"
+};
+
+typedef struct {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> sum_us;
+    std::atomic<uint32_t> max_us;
+    std::atomic<uint32_t> buckets[METRICS_BUCKETS];
+} histogram_state_t;
+
+static histogram_state_t histograms[METRIC_HISTOGRAM_COUNT];
+static std::atomic<uint32_t> counters[METRIC_COUNTER_COUNT];
+static std::atomic<uint32_t> gauges[METRIC_GAUGE_COUNT];
+
+typedef struct {
+    const char* name;
+    TaskHandle_t task;                  // nullptr: xTaskGetHandle(name)
+} watched_task_t;
+
+static watched_task_t watched_tasks[METRICS_MAX_TASKS];
+static size_t watched_count = 0;
+static portMUX_TYPE watch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Snapshot configuration (network task only)
+static const char* metrics_module = nullptr;
+static const char* metrics_topic = nullptr;
+static uint32_t metrics_interval_ms = 0;
+static uint32_t last_snapshot_ms = 0;
+
+static inline size_t bucket_index(uint32_t duration_us) {
+    size_t index = duration_us == 0 ? 0 : 32 - __builtin_clz(duration_us);
+    return index < METRICS_BUCKETS ? index : METRICS_BUCKETS - 1;
+}
+
+void metrics_init(const char* module, const char* topic, uint32_t interval_ms) {
+    metrics_module = module;
+    metrics_topic = topic;
+    metrics_interval_ms = interval_ms;
+    last_snapshot_ms = (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void metrics_record(metric_histogram_t histogram, uint32_t duration_us) {
+    histogram_state_t* h = &histograms[histogram];
+    h->count.fetch_add(1, std::memory_order_relaxed);
+    h->sum_us.fetch_add(duration_us, std::memory_order_relaxed);
+    h->buckets[bucket_index(duration_us)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max = h->max_us.load(std::memory_order_relaxed);
+    while (duration_us > max &&
+           !h->max_us.compare_exchange_weak(max, duration_us, std::memory_order_relaxed)) {
+    }
+}
+
+void metrics_count(metric_counter_t counter, uint32_t amount) {
+    counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void metrics_set(metric_gauge_t gauge, uint32_t value) {
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+void metrics_watch_task(const char* name, TaskHandle_t task) {
+    portENTER_CRITICAL(&watch_lock);
+    if (watched_count < METRICS_MAX_TASKS) {
+        watched_tasks[watched_count++] = {name, task};
+    }
+    portEXIT_CRITICAL(&watch_lock);
+}
+
+static void add_stack_free(cJSON* parent) {
+    portENTER_CRITICAL(&watch_lock);
+    size_t count = watched_count;
+    portEXIT_CRITICAL(&watch_lock);
+
+    cJSON* stack_json = cJSON_AddObjectToObject(parent, "stack_free");
+    for (size_t i = 0; i < count; i++) {
+        TaskHandle_t task = watched_tasks[i].task;
+        if (task == nullptr) {
+            task = xTaskGetHandle(watched_tasks[i].name);
+        }
+        if (task != nullptr) {
+            // ESP-IDF stacks are byte-addressed: the mark is in bytes
+            cJSON_AddNumberToObject(stack_json, watched_tasks[i].name,
+                                    uxTaskGetStackHighWaterMark(task));
+        }
+    }
+}
+
+static void add_heap(cJSON* parent) {
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    cJSON* heap_json = cJSON_AddObjectToObject(parent, "heap");
+    cJSON_AddNumberToObject(heap_json, "free", free_bytes);
+    cJSON_AddNumberToObject(heap_json, "min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    cJSON_AddNumberToObject(heap_json, "largest_block", largest);
+    cJSON_AddNumberToObject(heap_json, "fragmentation_pct",
+                            free_bytes > 0 ? 100 - (uint32_t)(largest * 100 / free_bytes) : 0);
+    cJSON_AddNumberToObject(heap_json, "json_arena_high_water", json_arena_high_water());
+}
+
+// Upper bound of the bucket holding the given quantile (max for the last one)
+static uint32_t bucket_quantile(const uint32_t* buckets, uint32_t count, uint32_t max_us, float q) {
+    uint32_t rank = (uint32_t)(q * count);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < METRICS_BUCKETS - 1; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            uint32_t bound = 1u << i;
+            return bound < max_us ? bound : max_us;
+        }
+    }
+    return max_us;
+}
+
+static void add_histogram(cJSON* parent, size_t index) {
+    histogram_state_t* h = &histograms[index];
+    uint32_t count = h->count.exchange(0, std::memory_order_relaxed);
+    uint32_t sum_us = h->sum_us.exchange(0, std::memory_order_relaxed);
+    uint32_t max_us = h->max_us.exchange(0, std::memory_order_relaxed);
+    uint32_t buckets[METRICS_BUCKETS];
+    size_t used = 0;
+    for (size_t i = 0; i < METRICS_BUCKETS; i++) {
+        buckets[i] = h->buckets[i].exchange(0, std::memory_order_relaxed);
+        if (buckets[i] != 0) used = i + 1;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    cJSON* item = cJSON_AddObjectToObject(parent, HISTOGRAM_NAMES[index]);
+    cJSON_AddNumberToObject(item, "count", count);
+    cJSON_AddNumberToObject(item, "mean", sum_us / count);
+    cJSON_AddNumberToObject(item, "max", max_us);
+    cJSON_AddNumberToObject(item, "p50", bucket_quantile(buckets, count, max_us, 0.50f));
+    cJSON_AddNumberToObject(item, "p99", bucket_quantile(buckets, count, max_us, 0.99f));
+
+    // Trailing empty buckets are omitted
+    cJSON* array = cJSON_AddArrayToObject(item, "buckets");
+    for (size_t i = 0; i < used; i++) {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(buckets[i]));
+    }
+}
+
+bool metrics_poll(uint32_t now_ms) {
+    if (metrics_topic == nullptr || metrics_interval_ms == 0 ||
+        now_ms - last_snapshot_ms < metrics_interval_ms) {
+        return false;
+    }
+    uint32_t interval_ms = now_ms - last_snapshot_ms;
+    last_snapshot_ms = now_ms;
+
+    JsonArenaScope arena;
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "module", metrics_module);
+    cJSON_AddStringToObject(json, "firmware", esp_app_get_description()->version);
+    cJSON_AddNumberToObject(json, "interval_ms", interval_ms);
+    cJSON_AddNumberToObject(json, "timestamp", (double)time_sync_now_ms());
+
+    cJSON* counter_json = cJSON_AddObjectToObject(json, "counters");
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        cJSON_AddNumberToObject(counter_json, COUNTER_NAMES[i],
+                                counters[i].exchange(0, std::memory_order_relaxed));
+    }
+
+    cJSON* gauge_json = cJSON_AddObjectToObject(json, "gauges");
+    for (size_t i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        cJSON_AddNumberToObject(gauge_json, GAUGE_NAMES[i], gauges[i].load(std::memory_order_relaxed));
+    }
+
+    add_stack_free(json);
+    add_heap(json);
+
+    cJSON* latency_json = cJSON_AddObjectToObject(json, "latency_us");
+    for (size_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        add_histogram(latency_json, i);
+    }
+
+    char* json_string = json_print(json, false);
+    bool ok = mqtt_helper_publish(metrics_topic, json_string);
+
+    cJSON_free(json_string);
+    cJSON_Delete(json);
+
+    DebugHelper::verbose("Metrics snapshot %s", ok ? "published" : "not published");
+    return ok;
+}
+
+#endif // METRICS_ENABLED
@@ -0,0 +1,197 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @file metrics.h
+ * @brief Hot-path counters and latency histograms with MQTT snapshots
+ *
+ * A fixed set of latency histograms and counters, identified by enum so that
+ * recording is an array index plus a few relaxed atomic adds and is safe from
+ * any task. Latencies are in microseconds (esp_timer) and land in log2
+ * buckets: bucket 0 counts values below 1 us, bucket i values in
+ * [2^(i-1), 2^i) us, and the last bucket everything above.
+ *
+ * The network task calls metrics_poll(); every interval it publishes a
+ * snapshot of the interval's counts on the module's metrics topic and resets
+ * them, so each message stands alone and counters never wrap in practice.
+ *
+ * Gauges hold the last value set and are reported in every snapshot without
+ * being reset (boot timings, configuration). Watched tasks report their
+ * stack high-water mark (bytes never used) in every snapshot, and the
+ * "heap" object reports free and minimum free heap, the largest free block,
+ * fragmentation (share of free heap not in the largest block, percent) and
+ * the JSON arena high-water mark.
+ *
+ * Build with -DMETRICS_ENABLED=0 to compile all recording out.
+ */
+
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1
+#endif
+
+#ifndef METRICS_INTERVAL_MS
+#define METRICS_INTERVAL_MS 60000       // Snapshot period
+#endif
+
+#define METRICS_BUCKETS 24              // < 1 us ... >= 2^22 us (~4 s)
+#define METRICS_MAX_TASKS 12            // Tasks in the "stack_free" object
+
+/**
+ * @brief Latency histograms
+ */
+typedef enum {
+    METRIC_ADC_READ,            // One sampling pass of a module's ADC channels
+    METRIC_FILTER,              // Filtering of one sample
+    METRIC_CALIBRATE,           // Calibration of one sample
+    METRIC_JSON_BUILD,          // Building and printing a JSON payload
+    METRIC_PUBLISH,             // esp_mqtt_client_publish() call
+    METRIC_COMMAND,             // Command parse and dispatch
+    METRIC_ACTUATION,           // Actuator event post to state machine
+    METRIC_RECONNECT,           // Broker disconnect to reconnect
+    METRIC_CONTROL_JITTER,      // Control step start vs. its period (|actual - nominal|)
+    METRIC_SAMPLE_JITTER,       // Acquisition tick vs. the sample period
+    METRIC_ADC_SCAN,            // One ADC scheduler pass over the channels due
+    METRIC_TIME_SYNC,           // Wall clock error found by an SNTP sync (time_sync.h)
+    METRIC_ANOMALY_CHECK,       // Anomaly check of one sample (anomaly_detector.h)
+    METRIC_HISTOGRAM_COUNT
+} metric_histogram_t;
+
+/**
+ * @brief Event counters
+ */
+typedef enum {
+    METRIC_PUBLISHED,           // Messages handed to the MQTT client
+    METRIC_PUBLISH_FAILED,      // Publishes refused (disconnected / outbox full)
+    METRIC_COMMANDS,            // Commands received
+    METRIC_DISCONNECTS,         // Broker connections lost
+    METRIC_OFFLINE_STORED,      // Messages queued for later (offline_queue.h)
+    METRIC_OFFLINE_REPLAYED,    // Queued messages published after reconnect
+    METRIC_OFFLINE_DROPPED,     // Messages discarded when full, or too large to queue
+    METRIC_TELEMETRY_SUPPRESSED, // Samples within the deadband, not published
+    METRIC_JSON_ARENA_FALLBACKS, // cJSON allocations that went to the heap (json_arena.h)
+    METRIC_TIME_SYNCS,          // SNTP syncs
+    METRIC_OTA_UPDATES,         // Firmware updates confirmed (ota_update.h)
+    METRIC_OTA_FAILED,          // Firmware downloads that failed
+    METRIC_OTA_ROLLBACKS,       // Updates rolled back to the previous image
+    METRIC_ANOMALIES,           // Sensor anomaly onsets (anomaly_detector.h)
+    METRIC_COUNTER_COUNT
+} metric_counter_t;
+
+/**
+ * @brief Gauges
+ */
+typedef enum {
+    METRIC_WIFI_CONNECT_MS,     // WiFi start to IP at boot
+    METRIC_WIFI_FAST,           // 1 if the cached AP was joined without a scan
+    METRIC_FIRST_PUBLISH_MS,    // Application start to first successful publish
+    METRIC_OTA_PROGRESS_PCT,    // Share of the firmware image written
+    METRIC_OTA_DOWNLOAD_BYTES,  // Bytes downloaded by the last update (delta or full)
+    METRIC_OTA_DOWNLOAD_MS,     // Download and flash time of the last update
+    METRIC_OTA_IMAGE_BYTES,     // Size of the last image written
+    METRIC_GAUGE_COUNT
+} metric_gauge_t;
+
+#if METRICS_ENABLED
+
+/**
+ * @brief Configure snapshot publishing
+ * @param module Module name reported in snapshots
+ * @param topic Metrics topic (exoskeleton/<module>/metrics, must stay valid)
+ * @param interval_ms Snapshot period, 0 to disable publishing
+ */
+void metrics_init(const char* module, const char* topic, uint32_t interval_ms);
+
+/**
+ * @brief Record one latency sample
+ * @param histogram Histogram id
+ * @param duration_us Duration in microseconds
+ */
+void metrics_record(metric_histogram_t histogram, uint32_t duration_us);
+
+/**
+ * @brief Increment a counter
+ * @param counter Counter id
+ * @param amount Increment
+ */
+void metrics_count(metric_counter_t counter, uint32_t amount);
+
+/**
+ * @brief Set a gauge
+ * @param gauge Gauge id
+ * @param value New value
+ */
+void metrics_set(metric_gauge_t gauge, uint32_t value);
+
+/**
+ * @brief Report a task's stack headroom in every snapshot
+ * @param name Key in the "stack_free" object (must stay valid)
+ * @param task Task handle, or nullptr to look the task up by name at each
+ *             snapshot (ESP-IDF tasks such as "wifi" or "mqtt_task")
+ */
+void metrics_watch_task(const char* name, TaskHandle_t task);
+
+/**
+ * @brief Publish a snapshot if the interval elapsed (network task only)
+ * @param now_ms Current time in milliseconds
+ * @return true if a snapshot was published
+ */
+bool metrics_poll(uint32_t now_ms);
+
+#else
+
+static inline void metrics_init(const char* module, const char* topic, uint32_t interval_ms) {}
+static inline void metrics_record(metric_histogram_t histogram, uint32_t duration_us) {}
+static inline void metrics_count(metric_counter_t counter, uint32_t amount) {}
+static inline void metrics_set(metric_gauge_t gauge, uint32_t value) {}
+static inline void metrics_watch_task(const char* name, TaskHandle_t task) {}
+static inline bool metrics_poll(uint32_t now_ms) { return false; }
+
+#endif
+
+/**
+ * @brief Start timestamp for metrics_record_since()
+ */
+static inline uint32_t metrics_now() {
+#if METRICS_ENABLED
+    return (uint32_t)esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Record the time elapsed since a metrics_now() timestamp
+ * @param histogram Histogram id
+ * @param start_us Value returned by metrics_now()
+ */
+static inline void metrics_record_since(metric_histogram_t histogram, uint32_t start_us) {
+#if METRICS_ENABLED
+    metrics_record(histogram, (uint32_t)esp_timer_get_time() - start_us);
+#endif
+}
+
+/**
+ * @brief Records the lifetime of a scope into a histogram
+ */
+class MetricsScope {
+public:
+    explicit MetricsScope(metric_histogram_t histogram)
+        : histogram(histogram), start_us(metrics_now()) {}
+    ~MetricsScope() { metrics_record_since(histogram, start_us); }
+
+    MetricsScope(const MetricsScope&) = delete;
+    MetricsScope& operator=(const MetricsScope&) = delete;
+
+private:
+    metric_histogram_t histogram;
+    uint32_t start_us;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,503 @@
+#include "module_runtime.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "sensor_filter_c.h"
+#include "telemetry_frame.h"
+#include "telemetry_batch.h"
+#include "telemetry_codec.h"
+#include "telemetry_rate.h"
+#include "sensor_acquisition.h"
+#include "adc_stream.h"
+#include "anomaly_detector.h"
+#include "metrics.h"
+#include "json_arena.h"
+#include "json_writer.h"
+#include "command_scheduler.h"
+#include "offline_queue.h"
+#include "ota_update.h"
+#include "time_sync.h"
+#include <cJSON.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <new>
+#include <stdio.h>
+#include <type_traits>
+#include <variant>
+
+#define MODULE_TOPIC_MAX 64
+
+// Filter of one channel; the variant index follows module_filter_t
+typedef std::variant<std::monostate, sensor_filter_t, sensor_ema_t,
+                     sensor_median_t, sensor_kalman_t> channel_filter_t;
+
+typedef struct {
+    channel_filter_t filter;
+    sensor_value_t raw;                 // Latest unfiltered reading
+    calibration_channel_t calibration;
+} channel_state_t;
+
+static const module_descriptor_t* module = nullptr;
+
+// Channel state is allocated once at boot: calibration tables are 16 KB each,
+// too much to reserve statically for MODULE_MAX_CHANNELS
+static channel_state_t* channels = nullptr;
+static calibration_channel_t* calibration_channels[MODULE_MAX_CHANNELS];
+
+static char topics[MODULE_TOPIC_COUNT][MODULE_TOPIC_MAX];
+static const char* TOPIC_LEAVES[MODULE_TOPIC_COUNT] = {"command", "status", "sensors", "metrics",
+                                                        "replay"};
+
+static const char* float_fields[MODULE_MAX_CHANNELS];
+static const char* bool_fields[MODULE_MAX_FLAGS];
+static sensor_value_t deadband[MODULE_MAX_CHANNELS];
+static anomaly_rule_t anomaly_rules[MODULE_MAX_CHANNELS];
+static telemetry_schema_t schema;
+static telemetry_batch_t batch;
+static telemetry_rate_config_t rate_config;
+static anomaly_detector_config_t anomaly_config;
+static power_config_t power_config;
+static sample_replay_config_t replay_config;
+static command_scheduler_config_t scheduler_config;
+static ota_update_config_t ota_config;
+
+static command_entry_t commands[COMMAND_TABLE_MAX_ENTRIES];
+static command_table_t command_table;
+
+static inline uint32_t now_ms() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Actuation running, or the rate still lingering after it (filters settling)
+static bool actuation_active() {
+    return actuator_busy() || telemetry_rate_active();
+}
+
+// ==================== Sampling ====================
+
+static void init_filter(channel_state_t* state, const module_channel_t* channel) {
+    switch (channel->filter) {
+        case MODULE_FILTER_AVERAGE:
+            state->filter.emplace<sensor_filter_t>();
+            break;
+        case MODULE_FILTER_EMA:
+            state->filter.emplace<sensor_ema_t>();
+            break;
+        case MODULE_FILTER_MEDIAN:
+            state->filter.emplace<sensor_median_t>();
+            break;
+        case MODULE_FILTER_KALMAN:
+            state->filter.emplace<sensor_kalman_t>(channel->process_variance,
+                                                   channel->measurement_variance);
+            break;
+        default:
+            state->filter.emplace<std::monostate>();
+            break;
+    }
+}
+
+static inline void filter_add(channel_state_t* state) {
+    std::visit([state](auto& filter) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(filter)>, std::monostate>) {
+            filter.addValue(state->raw);
+        }
+    }, state->filter);
+}
+
+static inline sensor_value_t filter_get(channel_state_t* state) {
+    return std::visit([state](auto& filter) -> sensor_value_t {
+        if constexpr (std::is_same_v<std::decay_t<decltype(filter)>, std::monostate>) {
+            return state->raw;
+        } else {
+            return filter.getFiltered();
+        }
+    }, state->filter);
+}
+
+// Runs on the acquisition task; stages are timed separately as before
+static void sample_channels(telemetry_sample_t* sample) {
+    // Read raw sensor values (oversampled DMA stream or one-shot, see adc_stream.h),
+    // or take the next recorded frame while a replay run is active
+    sensor_value_t replay_raw[MODULE_MAX_CHANNELS];
+    uint8_t replay_flags = 0;
+    bool replaying = sample_replay_next(replay_raw, &replay_flags);
+
+    uint32_t stage_start = metrics_now();
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        const module_channel_t* channel = &module->channels[i];
+        channels[i].raw = replaying ? replay_raw[i]
+            : channel->source == MODULE_SOURCE_GPIO ? (sensor_value_t)gpio_get_level((gpio_num_t)channel->pin)
+            : adc_read_value(channel->pin);
+    }
+    metrics_record_since(METRIC_ADC_READ, stage_start);
+
+    stage_start = metrics_now();
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        filter_add(&channels[i]);
+    }
+    metrics_record_since(METRIC_FILTER, stage_start);
+
+    stage_start = metrics_now();
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        sample->values[i] = calibration_apply(&channels[i].calibration, filter_get(&channels[i]));
+    }
+    metrics_record_since(METRIC_CALIBRATE, stage_start);
+
+    // Local reaction to faults, before the sample is queued for publishing
+    stage_start = metrics_now();
+    anomaly_detector_check(sample->timestamp_us, sample->values);
+    metrics_record_since(METRIC_ANOMALY_CHECK, stage_start);
+
+    if (replaying) {
+        sample->bools = (uint8_t)(replay_flags & ((1u << module->flag_count) - 1));
+        return;
+    }
+    uint8_t bools = 0;
+    for (uint8_t i = 0; i < module->flag_count; i++) {
+        if (gpio_get_level((gpio_num_t)module->flags[i].pin) == 1) {
+            bools |= (uint8_t)(1u << i);
+        }
+    }
+    sample->bools = bools;
+}
+
+static void configure_adc() {
+#if ADC_STREAM_ENABLED
+    static adc_stream_channel_t stream_channels[ADC_STREAM_MAX_CHANNELS];
+    size_t count = 0;
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        const module_channel_t* channel = &module->channels[i];
+        if (channel->source != MODULE_SOURCE_ADC) continue;
+        if (count == ADC_STREAM_MAX_CHANNELS) {
+            DebugHelper::error("Module: more than %d ADC channels", ADC_STREAM_MAX_CHANNELS);
+            break;
+        }
+        stream_channels[count++] = {channel->pin, channel->atten};
+    }
+    if (count > 0) {
+        adc_stream_start(stream_channels, count, ADC_STREAM_SAMPLE_RATE_HZ, ADC_STREAM_OVERSAMPLE);
+    }
+#else
+    // The scheduler converts each channel at its own rate; sampling and
+    // control loops read its snapshot
+    adc_scan_entry_t scan_table[MODULE_MAX_CHANNELS];
+    size_t count = 0;
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        const module_channel_t* channel = &module->channels[i];
+        if (channel->source != MODULE_SOURCE_ADC) continue;
+        uint32_t period_us = channel->scan_period_us != 0 ? channel->scan_period_us
+                                                          : module->active_sample_period_ms * 1000;
+        scan_table[count++] = {channel->pin, channel->atten, period_us};
+    }
+    if (count > 0) {
+        adc_scheduler_start(scan_table, count);
+    }
+#endif
+}
+
+// ==================== Commands ====================
+
+static void handle_set_format(const cJSON* params) {
+    telemetry_format_t format;
+    if (telemetry_parse_format(cJSON_GetStringValue(cJSON_GetObjectItem(params, "format")), &format)) {
+        telemetry_set_format(format);
+    } else {
+        DebugHelper::warning("Unknown telemetry format");
+    }
+
+    // Optional: batched binary frame codec
+    const char* codec_name = cJSON_GetStringValue(cJSON_GetObjectItem(params, "codec"));
+    telemetry_codec_t codec;
+    if (codec_name == nullptr) {
+        return;
+    }
+    if (telemetry_parse_codec(codec_name, &codec)) {
+        telemetry_set_codec(codec);
+    } else {
+        DebugHelper::warning("Unknown telemetry codec %s", codec_name);
+    }
+}
+
+static void handle_set_batch(const cJSON* params) {
+    cJSON* size = cJSON_GetObjectItem(params, "size");
+    cJSON* interval = cJSON_GetObjectItem(params, "interval_ms");
+
+    if (cJSON_IsNumber(size) && cJSON_IsNumber(interval)) {
+        telemetry_batch_configure(&batch, size->valueint, interval->valueint);
+    }
+}
+
+static void handle_calibrate(const cJSON* params) {
+    calibration_handle_command(calibration_channels, module->channel_count, params);
+    anomaly_detector_reset();           // Old statistics are in the old units
+}
+
+static void handle_replay(const cJSON* params) {
+    if (power_manager_mode() == POWER_MODE_DEEP_SLEEP) {
+        DebugHelper::warning("Replay needs continuous sampling, not deep sleep");
+        return;
+    }
+    sample_replay_handle_command(params);
+}
+
+static void handle_batch(const cJSON* params) {
+    command_scheduler_handle_command(params);
+}
+
+static void handle_ota_update(const cJSON* params) {
+    ota_update_handle_command(params);
+}
+
+static const command_entry_t COMMON_COMMANDS[] = {
+    {"set_format", handle_set_format},
+    {"set_batch", handle_set_batch},
+    {"calibrate", handle_calibrate},
+    {"replay", handle_replay},
+    {COMMAND_SCHEDULER_ACTION, handle_batch},
+    {"ota_update", handle_ota_update},
+};
+#define COMMON_COMMAND_COUNT (sizeof(COMMON_COMMANDS) / sizeof(COMMON_COMMANDS[0]))
+
+static void on_command_message(const mqtt_message_t* message) {
+    DebugHelper::info("Received message [%.*s]", (int)message->topic_len, message->topic);
+    command_table_dispatch_message(&command_table, message);
+}
+
+static void on_replay_message(const mqtt_message_t* message) {
+    sample_replay_upload(message->payload, message->payload_len);
+}
+
+static bool init_commands() {
+    if (module->command_count + COMMON_COMMAND_COUNT > COMMAND_TABLE_MAX_ENTRIES) {
+        DebugHelper::error("Module: too many commands (%u)", (unsigned)module->command_count);
+        return false;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < module->command_count; i++) {
+        commands[count++] = module->commands[i];
+    }
+    for (size_t i = 0; i < COMMON_COMMAND_COUNT; i++) {
+        commands[count++] = COMMON_COMMANDS[i];
+    }
+    return command_table_init(&command_table, commands, count);
+}
+
+// ==================== Network Task ====================
+
+static void module_task(void* parameter) {
+    while (1) {
+        // Process MQTT messages (may block while reconnecting; sampling continues)
+        mqtt_helper_loop();
+
+        // A replay run owns the sampling rate and keeps the module awake
+        bool replaying = sample_replay_poll(now_ms());
+        if (!replaying) {
+            telemetry_rate_poll(now_ms());
+        }
+
+        // Queued batch steps, one at a time as the actuator frees up
+        bool batching = command_scheduler_poll(now_ms());
+
+        // Firmware download, reboot and first-boot confirmation keep the module awake
+        bool updating = ota_update_poll(now_ms());
+
+        // Alerts, and full-resolution windows around anomalies
+        bool flagged = anomaly_detector_poll(now_ms());
+
+        // Publish whatever the acquisition task has collected
+        sensor_acquisition_drain(&batch);
+        size_t published = telemetry_batch_flush(&batch, now_ms(), false);
+        if (published > 0) {
+            sample_replay_count_published(published);
+            DebugHelper::verbose("Sensor data published");
+        }
+        offline_queue_poll(now_ms());
+        metrics_poll(now_ms());
+        if (!replaying && !batching && !updating && !flagged) {
+            power_manager_poll(now_ms());
+        }
+
+        power_manager_idle();
+    }
+}
+
+// ==================== Status ====================
+
+// Alerts and OTA reports go out at once, even during a batch step
+static void publish_status(const char* state, const char* message) {
+    char buffer[MODULE_STATUS_MAX_SIZE];
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, sizeof(buffer));
+    json_writer_begin_object(&writer, nullptr);
+    json_writer_string(&writer, "module", module->name);
+    json_writer_string(&writer, "state", state);
+    json_writer_string(&writer, "message", message);
+    json_writer_int(&writer, "timestamp", time_sync_now_ms());
+    json_writer_end_object(&writer);
+
+    const char* json = json_writer_finish(&writer, nullptr);
+    if (json == nullptr) {
+        DebugHelper::error("Status report too long: %s - %s", state, message);
+        return;
+    }
+    mqtt_helper_publish(topics[MODULE_TOPIC_STATUS], json);
+
+    DebugHelper::info("Status report: %s - %s", state, message);
+}
+
+// ==================== Startup ====================
+
+static bool init_channels() {
+    if (module->channel_count > MODULE_MAX_CHANNELS || module->flag_count > MODULE_MAX_FLAGS) {
+        DebugHelper::error("Module: too many channels (%u) or flags (%u)",
+                           (unsigned)module->channel_count, (unsigned)module->flag_count);
+        return false;
+    }
+
+    channels = new (std::nothrow) channel_state_t[module->channel_count];
+    if (channels == nullptr) {
+        DebugHelper::error("Module: no memory for %u channels", (unsigned)module->channel_count);
+        return false;
+    }
+
+    // Filters, calibration tables (NVS or default) and the sample layout
+    for (uint8_t i = 0; i < module->channel_count; i++) {
+        const module_channel_t* channel = &module->channels[i];
+        init_filter(&channels[i], channel);
+        channels[i].raw = 0;
+        calibration_init(&channels[i].calibration, channel->calibration_name, channel->default_curve);
+        calibration_channels[i] = &channels[i].calibration;
+        float_fields[i] = channel->field;
+        deadband[i] = channel->deadband;
+        anomaly_rules[i] = channel->anomaly;
+    }
+    for (uint8_t i = 0; i < module->flag_count; i++) {
+        bool_fields[i] = module->flags[i].field;
+    }
+    schema = {module->telemetry_id, float_fields, module->channel_count,
+              bool_fields, module->flag_count};
+    return true;
+}
+
+static void init_topics() {
+    for (size_t i = 0; i < MODULE_TOPIC_COUNT; i++) {
+        snprintf(topics[i], MODULE_TOPIC_MAX, MODULE_TOPIC_PREFIX "%s/%s",
+                 module->name, TOPIC_LEAVES[i]);
+    }
+}
+
+bool module_start(const module_descriptor_t* descriptor) {
+    module = descriptor;
+    DebugHelper::initialize();
+    json_arena_init();
+    init_topics();
+
+    if (!init_channels() || !init_commands()) {
+        return false;
+    }
+
+    // Select sensor payload format and batching (compile-time defaults, changeable by command)
+    telemetry_set_format(TELEMETRY_DEFAULT_FORMAT);
+    telemetry_set_codec(TELEMETRY_DEFAULT_CODEC);
+    telemetry_batch_init(&batch, &schema, topics[MODULE_TOPIC_SENSORS]);
+    telemetry_batch_configure(&batch, TELEMETRY_BATCH_SIZE, TELEMETRY_BATCH_FLUSH_MS);
+
+    // Report on change with a heartbeat; every sample, faster, while actuating
+    telemetry_batch_set_deadband(&batch, deadband, TELEMETRY_HEARTBEAT_MS);
+    rate_config = {module->sample_period_ms, module->active_sample_period_ms,
+                   TELEMETRY_RATE_LINGER_MS};
+    telemetry_rate_init(&rate_config, &batch);
+
+    // Anomalies stop the actuation they happen in, or raise an alert
+    anomaly_config = {module->channel_count, anomaly_rules, deadband, float_fields, &batch,
+                      actuation_active, publish_status};
+    anomaly_detector_init(&anomaly_config);
+
+    // Recorded samples through the same path on command, reported with the metrics
+    replay_config = {module->name, topics[MODULE_TOPIC_METRICS], module->channel_count,
+                     module->replay_recording, &batch, telemetry_rate_resume};
+    if (!sample_replay_init(&replay_config)) {
+        return false;
+    }
+
+    // Batched commands run through the same table, one actuation at a time
+    scheduler_config = {module->name, topics[MODULE_TOPIC_STATUS], &command_table, actuator_busy};
+    command_scheduler_init(&scheduler_config);
+
+    // Keep telemetry through outages (RAM, then the "offline" flash partition)
+    offline_queue_init(OFFLINE_DEFAULT_POLICY);
+
+    // Periodic latency/counter snapshots on the metrics topic
+    metrics_init(module->name, topics[MODULE_TOPIC_METRICS], METRICS_INTERVAL_MS);
+
+    // A/B firmware updates; reports how the last one ended once connected
+    ota_config = {module->name, publish_status, actuator_busy};
+    ota_update_init(&ota_config);
+
+    // Start the actuator state machine before its interrupts are enabled
+    actuator_start(module->state_machine);
+    if (module->init_hardware != nullptr) {
+        module->init_hardware();
+    }
+    configure_adc();
+
+    // Wall clock kept through deep sleep, if any, before the first sample
+    time_sync_init();
+
+    // Start sampling in the module's power mode; a deep-sleep wake with
+    // nothing to publish goes back to sleep from here
+    power_config = {module->power_mode, module->sample_period_ms,
+                    POWER_PUBLISH_INTERVAL_MS, &batch};
+    power_manager_begin(&power_config, sample_channels);
+
+    // Route command messages through the dispatch table (subscribed on every connect)
+    mqtt_helper_init(MODULE_WIFI_SSID, MODULE_WIFI_PASS, MODULE_MQTT_BROKER, MODULE_MQTT_PORT,
+                     module->client_id, nullptr);
+    mqtt_helper_register(topics[MODULE_TOPIC_COMMAND], on_command_message);
+    mqtt_helper_register(topics[MODULE_TOPIC_REPLAY], on_replay_message);
+
+    // SNTP keeps retrying on its own if the network is not up yet
+    if (mqtt_helper_connect_wifi()) {
+        mqtt_helper_connect_broker();
+    }
+    time_sync_start(TIME_SYNC_SERVER);
+
+    DebugHelper::info("Module %s initialization complete", module->name);
+    if (!power_manager_resumed()) {
+        module_send_status("IDLE", "System startup");
+    }
+
+    // Stack headroom of the ESP-IDF network tasks, looked up by name
+    metrics_watch_task("wifi", nullptr);
+    metrics_watch_task("tiT", nullptr);
+    metrics_watch_task("mqtt_task", nullptr);
+
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(module_task, "module_task", MODULE_TASK_STACK, NULL,
+                                MODULE_TASK_PRIORITY, &task, MODULE_TASK_CORE) != pdPASS) {
+        DebugHelper::error("Module: failed to create network task");
+        return false;
+    }
+    metrics_watch_task("network", task);
+    return true;
+}
+
+// ==================== Public API ====================
+
+void module_send_status(const char* state, const char* message) {
+    // A running batch step reports in the consolidated report (command_scheduler.h)
+    if (command_scheduler_capture_status(state, message)) {
+        DebugHelper::info("Batch step status: %s - %s", state, message);
+        return;
+    }
+    publish_status(state, message);
+}
+
+const calibration_channel_t* module_calibration(size_t channel) {
+    return &channels[channel].calibration;
+}
+
+const char* module_topic(module_topic_t topic) {
+    return topics[topic];
+}
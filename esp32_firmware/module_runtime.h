@@ -0,0 +1,172 @@
+#ifndef MODULE_RUNTIME_H
+#define MODULE_RUNTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <driver/adc.h>
+#include "calibration_table.h"
+#include "command_table.h"
+#include "actuator_task.h"
+#include "anomaly_detector.h"
+#include "power_manager.h"
+#include "sample_replay.h"
+#include "sensor_value.h"
+#include "task_config.h"
+
+/**
+ * @file module_runtime.h
+ * @brief Shared startup, sampling, publishing and command plumbing for modules
+ *
+ * A module is described by a static module_descriptor_t: its sensor
+ * channels (source pin, filter, default calibration curve, telemetry field,
+ * deadband), GPIO flags, module-specific commands, actuator state machine and
+ * hardware setup hook. module_start() does everything else for every module:
+ *  - NVS/logging, filters and calibration tables for each channel
+ *  - ADC configuration of the channels (DMA stream or the ADC scheduler)
+ *  - telemetry batch, report-on-change, adaptive rate, offline queue, metrics
+ *  - anomaly checks after calibration, with alerts and flagged windows
+ *  - sampling under the power manager, on the acquisition task
+ *  - MQTT with topics exoskeleton/<name>/{command,status,sensors,metrics,replay}
+ *  - the set_format, set_batch, calibrate, replay, batch and ota_update commands
+ *  - the network task loop
+ *
+ * One module runs per firmware image, so the runtime state is static.
+ */
+
+// ==================== Network Configuration ====================
+// Shared by all modules; override per build (-DMODULE_WIFI_SSID=\"...\")
+#ifndef MODULE_WIFI_SSID
+#define MODULE_WIFI_SSID    "Your_WiFi_SSID"
+#endif
+#ifndef MODULE_WIFI_PASS
+#define MODULE_WIFI_PASS    "Your_WiFi_Password"
+#endif
+#ifndef MODULE_MQTT_BROKER
+#define MODULE_MQTT_BROKER  "192.168.1.100"
+#endif
+#ifndef MODULE_MQTT_PORT
+#define MODULE_MQTT_PORT    1883
+#endif
+
+#define MODULE_TOPIC_PREFIX "exoskeleton/"     // Topics are <prefix><module>/<leaf>
+#define MODULE_MAX_CHANNELS 8                  // TELEMETRY_BATCH_MAX_FLOATS
+#define MODULE_MAX_FLAGS    8                  // TELEMETRY_BATCH_MAX_BOOLS
+#ifndef MODULE_TASK_STACK
+#define MODULE_TASK_STACK   4096
+#endif
+#define MODULE_TASK_PRIORITY 5                 // Network task, next to esp-mqtt (task_config.h)
+#define MODULE_TASK_CORE    TASK_CORE_NETWORK
+#define MODULE_STATUS_MAX_SIZE 256              // Status message JSON, on the caller's stack
+
+/**
+ * @brief Where a channel's raw value comes from
+ */
+typedef enum {
+    MODULE_SOURCE_ADC,                  // adc_read_value() of an ADC1 channel
+    MODULE_SOURCE_GPIO                  // gpio_get_level() (0/1)
+} module_source_t;
+
+/**
+ * @brief Filter applied before calibration (all FILTER_WINDOW_SIZE samples)
+ */
+typedef enum {
+    MODULE_FILTER_NONE,
+    MODULE_FILTER_AVERAGE,              // Moving average
+    MODULE_FILTER_EMA,                  // Low-lag smoothing
+    MODULE_FILTER_MEDIAN,               // Spike rejection
+    MODULE_FILTER_KALMAN                // Slow signals (process/measurement variance)
+} module_filter_t;
+
+/**
+ * @brief One sensor channel, published as a float telemetry field
+ */
+typedef struct {
+    const char* field;                  // Telemetry field name
+    const char* calibration_name;       // Calibration channel and NVS key
+    module_source_t source;
+    uint8_t pin;                        // ADC1 channel or GPIO number
+    module_filter_t filter;
+    float process_variance;             // MODULE_FILTER_KALMAN only
+    float measurement_variance;
+    const calibration_curve_t* default_curve;
+    sensor_value_t deadband;            // Change reported before the heartbeat
+    adc_atten_t atten;                  // ADC input attenuation (default 0 dB)
+    uint32_t scan_period_us;            // ADC scheduler period, 0 = active sample period
+    anomaly_rule_t anomaly;             // On-device anomaly limits, zero = unchecked
+} module_channel_t;
+
+/**
+ * @brief One GPIO level published as a bool telemetry field
+ */
+typedef struct {
+    const char* field;
+    uint8_t pin;
+} module_flag_t;
+
+/**
+ * @brief Everything that differs between modules
+ */
+typedef struct {
+    const char* name;                   // Topic segment, status/metrics "module" field
+    const char* client_id;              // MQTT client id
+    uint8_t telemetry_id;               // telemetry_module_id_t
+    const module_channel_t* channels;
+    uint8_t channel_count;              // <= MODULE_MAX_CHANNELS
+    const module_flag_t* flags;
+    uint8_t flag_count;                 // <= MODULE_MAX_FLAGS
+    const command_entry_t* commands;    // Module actions (common ones are added)
+    size_t command_count;
+    actuator_handler_t state_machine;   // Runs on the actuator task
+    void (*init_hardware)();            // Actuator GPIO/PWM; runs after actuator_start()
+    uint32_t sample_period_ms;          // Acquisition period at rest
+    uint32_t active_sample_period_ms;   // Acquisition period while actuating
+    power_mode_t power_mode;
+    const sample_replay_recording_t* replay_recording;  // Embedded replay, nullptr for the sweep
+} module_descriptor_t;
+
+/**
+ * @brief Topics derived from the module name
+ */
+typedef enum {
+    MODULE_TOPIC_COMMAND,
+    MODULE_TOPIC_STATUS,
+    MODULE_TOPIC_SENSORS,
+    MODULE_TOPIC_METRICS,
+    MODULE_TOPIC_REPLAY,                // Replay uploads (sample_replay.h)
+    MODULE_TOPIC_COUNT
+} module_topic_t;
+
+/**
+ * @brief Bring the module up and start its network task (call from app_main)
+ * @param module Module description (must stay valid)
+ * @return true if startup completed
+ */
+bool module_start(const module_descriptor_t* module);
+
+/**
+ * @brief Publish {"module", "state", "message", "timestamp"} on the status topic
+ *
+ * The timestamp is Unix time in ms once synchronised (time_sync.h), ms since
+ * boot before that.
+ * Written with json_writer.h, so it is cheap enough to call from the
+ * actuator task; a status that exceeds MODULE_STATUS_MAX_SIZE is not sent.
+ * While a batch step runs, its reports go into the batch report instead
+ * (command_scheduler.h).
+ * @param state Module state (IDLE, DEPLOYING, ...)
+ * @param message Human-readable detail
+ */
+void module_send_status(const char* state, const char* message);
+
+/**
+ * @brief Calibration table of a channel, for control loops
+ * @param channel Index into module_descriptor_t::channels
+ */
+const calibration_channel_t* module_calibration(size_t channel);
+
+/**
+ * @brief Full topic name
+ */
+const char* module_topic(module_topic_t topic);
+
+#endif // MODULE_RUNTIME_H
@@ -0,0 +1,86 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Lock-free multi-producer / single-consumer ring queue
+ *
+ * Any number of tasks may call push() concurrently while one task calls
+ * pop(). Each slot carries a sequence number: producers claim a slot with a
+ * CAS on the head index and publish it by advancing its sequence, so a
+ * producer preempted mid-copy never exposes a partial element and never
+ * blocks other producers (bounded queue after D. Vyukov).
+ *
+ * @tparam T Element type (copied by value)
+ * @tparam N Capacity, must be a power of two
+ */
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot slots[N];
+    std::atomic<size_t> head{0};    // Next slot to claim (producers)
+    size_t tail = 0;                // Next slot to read (consumer only)
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < N; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Enqueue an element (any producer)
+     * @param value Element to copy into the queue
+     * @return false if the queue is full
+     */
+    bool push(const T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[h & (N - 1)];
+            intptr_t diff = (intptr_t)slot->sequence.load(std::memory_order_acquire) - (intptr_t)h;
+            if (diff == 0) {
+                if (head.compare_exchange_weak(h, h + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                h = head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Dequeue the oldest element (consumer side)
+     * @param value Receives the element
+     * @return false if the queue is empty (or the oldest push is still in progress)
+     */
+    bool pop(T& value) {
+        Slot* slot = &slots[tail & (N - 1)];
+        if (slot->sequence.load(std::memory_order_acquire) != tail + 1) {
+            return false;
+        }
+        value = slot->value;
+        slot->sequence.store(tail + N, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return N; }
+};
+
+#endif // MPSC_QUEUE_H
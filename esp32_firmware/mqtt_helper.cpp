@@ -1,21 +1,28 @@
 #include "mqtt_helper.h"
 #include "debug_helper.h"
+#include "metrics.h"
+#include <atomic>
+#include <stdio.h>
 #include <string.h>
 #include <esp_wifi.h>
 #include <esp_netif.h>
 #include <esp_event.h>
 #include <mqtt_client.h>
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <nvs.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
 
 static const char* TAG = "mqtt_helper";
 
-// WiFi event group to signal connection status
+// Event group to signal WiFi and broker connection status
 static EventGroupHandle_t s_wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
+#define MQTT_CONNECTED_BIT BIT2
 
 // Configuration variables
 static const char* wifi_ssid = nullptr;
@@ -23,19 +30,111 @@ static const char* wifi_password = nullptr;
 static const char* mqtt_server = nullptr;
 static int mqtt_port = 1883;
 static const char* client_id = nullptr;
-static void (*user_callback)(char*, uint8_t*, unsigned int) = nullptr;
+static mqtt_message_callback_t user_callback = nullptr;
 
 static esp_mqtt_client_handle_t mqtt_client = nullptr;
-static bool mqtt_connected = false;
+// Written by the esp-mqtt event handler, read by the network task and publishers
+static std::atomic<bool> mqtt_connected{false};
+static std::atomic<int64_t> disconnected_us{0};     // Start of the current outage, 0 if none
+
+// Reconnect engine state (network task, except the resets by MQTT events)
+static std::atomic<uint32_t> reconnect_attempts{0};
+static std::atomic<int64_t> next_attempt_us{0};
 static int wifi_retry_num = 0;
 
+// Fast WiFi startup, persisted in NVS
+#define WIFI_NVS_NAMESPACE "wifi"
+#define WIFI_AP_KEY        "ap"
+#define WIFI_STATIC_KEY    "static_ip"
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+typedef struct {
+    esp_netif_ip_info_t ip_info;
+    esp_ip4_addr_t dns;
+} wifi_static_ip_t;
+
+static wifi_ap_cache_t ap_cache = {};   // Last AP joined (event task)
+static bool wifi_started = false;
+static bool wifi_power_save = false;
+static uint16_t wifi_listen_interval = 0;
+static bool first_publish_done = false;
+
+// Registered topic handlers, resubscribed on every connection
+typedef struct {
+    const char* topic;
+    size_t topic_len;
+    uint32_t hash;
+    mqtt_message_callback_t handler;
+} topic_handler_t;
+
+static topic_handler_t topic_handlers[MQTT_HELPER_MAX_HANDLERS];
+static size_t topic_handler_count = 0;
+
+// Fragment reassembly state (only touched from the MQTT client task)
+static uint8_t rx_buffer[MQTT_HELPER_RX_BUFFER_SIZE];
+static char rx_topic[MQTT_HELPER_MAX_TOPIC_LEN];
+static size_t rx_topic_len = 0;
+static bool rx_dropping = false;
+
+// Topic for forwarded log lines (mqtt_helper_forward_logs)
+static const char* log_topic = nullptr;
+
+// WiFi NVS cache: reads a fixed-size blob, false if missing or resized
+static bool load_wifi_blob(const char* key, void* value, size_t size) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    size_t length = size;
+    esp_err_t ret = nvs_get_blob(nvs_handle, key, value, &length);
+    nvs_close(nvs_handle);
+    return ret == ESP_OK && length == size;
+}
+
+// Saves value, or erases the key if value is nullptr
+static bool save_wifi_blob(const char* key, const void* value, size_t size) {
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret == ESP_OK) {
+        ret = value != nullptr ? nvs_set_blob(nvs_handle, key, value, size)
+                               : nvs_erase_key(nvs_handle, key);
+        if (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    return ret == ESP_OK;
+}
+
+// Remember the AP just joined; only written when it changed, to spare flash
+static void save_ap_cache() {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    if (ap.primary == ap_cache.channel && memcmp(ap.bssid, ap_cache.bssid, sizeof(ap_cache.bssid)) == 0) {
+        return;
+    }
+    memcpy(ap_cache.bssid, ap.bssid, sizeof(ap_cache.bssid));
+    ap_cache.channel = ap.primary;
+    if (!save_wifi_blob(WIFI_AP_KEY, &ap_cache, sizeof(ap_cache))) {
+        DebugHelper::warning("Failed to save WiFi AP cache");
+    }
+}
+
 // WiFi event handler
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                               int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (wifi_retry_num < 20) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        // Retry straight away for short AP blips, then leave it to the backoff
+        if (wifi_retry_num < MQTT_HELPER_WIFI_RETRIES) {
             esp_wifi_connect();
             wifi_retry_num++;
             DebugHelper::info("retry to connect to the AP");
@@ -47,10 +146,81 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         DebugHelper::info("got ip:" IPSTR, IP2STR(&event->ip_info.ip));
         wifi_retry_num = 0;
+        save_ap_cache();
+        xEventGroupClearBits(s_wifi_event_group, WIFI_FAIL_BIT);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        
+        // Network is back: reconnect the broker now instead of waiting for the backoff
+        if (mqtt_client != nullptr && !mqtt_connected.load()) {
+            esp_mqtt_client_reconnect(mqtt_client);
+        }
+    }
+}
+
+// Hand a message to its registered handler, or the init callback
+static void dispatch_message(const mqtt_message_t* message) {
+    for (size_t i = 0; i < topic_handler_count; i++) {
+        const topic_handler_t* entry = &topic_handlers[i];
+        if (entry->hash == message->topic_hash && entry->topic_len == message->topic_len &&
+            memcmp(entry->topic, message->topic, message->topic_len) == 0) {
+            entry->handler(message);
+            return;
+        }
+    }
+    if (user_callback) {
+        user_callback(message);
     }
 }
 
+static void subscribe_registered() {
+    for (size_t i = 0; i < topic_handler_count; i++) {
+        esp_mqtt_client_subscribe(mqtt_client, topic_handlers[i].topic, 0);
+    }
+}
+
+// Deliver MQTT_EVENT_DATA to the module callback, reassembling fragments
+static void handle_data_event(esp_mqtt_event_handle_t event) {
+    mqtt_message_t message;
+
+    // Common case: whole message in one event, hand out the client's buffers
+    if (event->current_data_offset == 0 && event->data_len == event->total_data_len) {
+        message.topic = event->topic;
+        message.topic_len = event->topic_len;
+        message.topic_hash = mqtt_topic_hash(event->topic, event->topic_len);
+        message.payload = (const uint8_t*)event->data;
+        message.payload_len = event->data_len;
+        dispatch_message(&message);
+        return;
+    }
+
+    // Only the first fragment carries the topic
+    if (event->current_data_offset == 0) {
+        rx_dropping = event->topic_len > MQTT_HELPER_MAX_TOPIC_LEN ||
+                      event->total_data_len > MQTT_HELPER_RX_BUFFER_SIZE;
+        if (rx_dropping) {
+            DebugHelper::warning("MQTT message too large (%d bytes), dropped", event->total_data_len);
+            return;
+        }
+        memcpy(rx_topic, event->topic, event->topic_len);
+        rx_topic_len = event->topic_len;
+    }
+    if (rx_dropping || event->current_data_offset + event->data_len > event->total_data_len) {
+        return;
+    }
+
+    memcpy(&rx_buffer[event->current_data_offset], event->data, event->data_len);
+    if (event->current_data_offset + event->data_len < event->total_data_len) {
+        return;
+    }
+
+    message.topic = rx_topic;
+    message.topic_len = rx_topic_len;
+    message.topic_hash = mqtt_topic_hash(rx_topic, rx_topic_len);
+    message.payload = rx_buffer;
+    message.payload_len = event->total_data_len;
+    dispatch_message(&message);
+}
+
 // MQTT event handler
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
     esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
@@ -58,11 +228,25 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
             DebugHelper::info("MQTT_EVENT_CONNECTED");
-            mqtt_connected = true;
+            mqtt_connected.store(true);
+            reconnect_attempts.store(0);
+            xEventGroupSetBits(s_wifi_event_group, MQTT_CONNECTED_BIT);
+            if (int64_t since_us = disconnected_us.exchange(0); since_us != 0) {
+                metrics_record(METRIC_RECONNECT, (uint32_t)(esp_timer_get_time() - since_us));
+            }
+            // A resumed persistent session still has its subscriptions
+            if (!event->session_present) {
+                subscribe_registered();
+            }
             break;
         case MQTT_EVENT_DISCONNECTED:
             DebugHelper::info("MQTT_EVENT_DISCONNECTED");
-            mqtt_connected = false;
+            if (mqtt_connected.exchange(false)) {
+                metrics_count(METRIC_DISCONNECTS, 1);
+                disconnected_us.store(esp_timer_get_time());
+                next_attempt_us.store(0);   // First retry is immediate
+            }
+            xEventGroupClearBits(s_wifi_event_group, MQTT_CONNECTED_BIT);
             break;
         case MQTT_EVENT_SUBSCRIBED:
             DebugHelper::info("MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
@@ -71,18 +255,11 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             DebugHelper::info("MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
             break;
         case MQTT_EVENT_PUBLISHED:
-            DebugHelper::info("MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+            DebugHelper::verbose("MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
             break;
         case MQTT_EVENT_DATA:
-            DebugHelper::info("MQTT_EVENT_DATA");
-            if (user_callback) {
-                // Create null-terminated topic string
-                char topic[event->topic_len + 1];
-                memcpy(topic, event->topic, event->topic_len);
-                topic[event->topic_len] = '\0';
-                
-                user_callback(topic, (uint8_t*)event->data, event->data_len);
-            }
+            DebugHelper::verbose("MQTT_EVENT_DATA");
+            handle_data_event(event);
             break;
         case MQTT_EVENT_ERROR:
             DebugHelper::error("MQTT_EVENT_ERROR");
@@ -96,7 +273,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 void mqtt_helper_init(const char* ssid, const char* password, 
                       const char* server, int port, 
                       const char* id,
-                      void (*callback)(char*, uint8_t*, unsigned int)) {
+                      mqtt_message_callback_t callback) {
     wifi_ssid = ssid;
     wifi_password = password;
     mqtt_server = server;
@@ -119,9 +296,37 @@ void mqtt_helper_init(const char* ssid, const char* password,
     DebugHelper::info("MQTT Helper initialized");
 }
 
+static void apply_static_ip(esp_netif_t* netif) {
+    wifi_static_ip_t config;
+    if (!load_wifi_blob(WIFI_STATIC_KEY, &config, sizeof(config))) {
+        return;
+    }
+    esp_netif_dhcpc_stop(netif);
+    if (esp_netif_set_ip_info(netif, &config.ip_info) != ESP_OK) {
+        DebugHelper::error("Invalid static IP, using DHCP");
+        return;
+    }
+    esp_netif_dns_info_t dns = {};
+    dns.ip.u_addr.ip4 = config.dns;
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns);
+    DebugHelper::info("Static IP " IPSTR, IP2STR(&config.ip_info.ip));
+}
+
+static EventBits_t wait_wifi(uint32_t timeout_ms) {
+    return xEventGroupWaitBits(s_wifi_event_group,
+            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+            pdFALSE,
+            pdFALSE,
+            timeout_ms / portTICK_PERIOD_MS);
+}
+
 bool mqtt_helper_connect_wifi() {
+    int64_t start_us = esp_timer_get_time();
+    
     // Create default WiFi STA interface
-    esp_netif_create_default_wifi_sta();
+    esp_netif_t* netif = esp_netif_create_default_wifi_sta();
+    apply_static_ip(netif);
     
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -144,41 +349,100 @@ bool mqtt_helper_connect_wifi() {
     strcpy((char*)wifi_config.sta.password, wifi_password);
     wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
     
+    // Join the cached AP directly: no scan, straight to the known channel
+    bool fast = MQTT_HELPER_FAST_CONNECT && load_wifi_blob(WIFI_AP_KEY, &ap_cache, sizeof(ap_cache));
+    if (fast) {
+        memcpy(wifi_config.sta.bssid, ap_cache.bssid, sizeof(ap_cache.bssid));
+        wifi_config.sta.bssid_set = true;
+        wifi_config.sta.channel = ap_cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    
+    wifi_config.sta.listen_interval = wifi_listen_interval;
+    
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    wifi_started = true;
+    esp_wifi_set_ps(wifi_power_save ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
     
-    DebugHelper::info("Connecting to WiFi: %s", wifi_ssid);
+    DebugHelper::info("Connecting to WiFi: %s%s", wifi_ssid, fast ? " (cached AP)" : "");
     
     // Wait for connection or failure
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE,
-            pdFALSE,
-            portMAX_DELAY);
+    EventBits_t bits = wait_wifi(fast ? MQTT_HELPER_FAST_TIMEOUT_MS : MQTT_HELPER_WIFI_TIMEOUT_MS);
+    
+    if (fast && !(bits & WIFI_CONNECTED_BIT)) {
+        // AP moved or changed channel: forget it and scan everything
+        DebugHelper::warning("Cached AP not reachable, scanning");
+        fast = false;
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        ap_cache = {};
+        save_wifi_blob(WIFI_AP_KEY, nullptr, 0);
+        
+        esp_wifi_disconnect();
+        ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+        wifi_retry_num = 0;
+        xEventGroupClearBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        esp_wifi_connect();
+        bits = wait_wifi(MQTT_HELPER_WIFI_TIMEOUT_MS);
+    }
     
     if (bits & WIFI_CONNECTED_BIT) {
-        DebugHelper::info("WiFi connected successfully");
+        uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+        DebugHelper::info("WiFi connected successfully in %lu ms", (unsigned long)elapsed_ms);
+        metrics_set(METRIC_WIFI_CONNECT_MS, elapsed_ms);
+        metrics_set(METRIC_WIFI_FAST, fast ? 1 : 0);
         return true;
     } else if (bits & WIFI_FAIL_BIT) {
         DebugHelper::error("WiFi connection failed");
         return false;
     }
     
+    DebugHelper::error("WiFi connection timeout");
     return false;
 }
 
-bool mqtt_helper_connect_broker() {
-    if (mqtt_connected) {
-        return true;
+void mqtt_helper_set_power_save(bool enable, uint16_t listen_interval) {
+    wifi_power_save = enable;
+    wifi_listen_interval = enable ? listen_interval : 0;
+    if (wifi_started) {
+        // The listen interval only takes effect at the next association
+        esp_wifi_set_ps(enable ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    }
+}
+
+bool mqtt_helper_set_static_ip(const char* ip, const char* netmask,
+                               const char* gateway, const char* dns) {
+    if (ip == nullptr) {
+        return save_wifi_blob(WIFI_STATIC_KEY, nullptr, 0);
     }
     
-    char mqtt_uri[128];
+    wifi_static_ip_t config = {};
+    if (esp_netif_str_to_ip4(ip, &config.ip_info.ip) != ESP_OK ||
+        esp_netif_str_to_ip4(netmask, &config.ip_info.netmask) != ESP_OK ||
+        esp_netif_str_to_ip4(gateway, &config.ip_info.gw) != ESP_OK ||
+        esp_netif_str_to_ip4(dns != nullptr ? dns : gateway, &config.dns) != ESP_OK) {
+        DebugHelper::error("Invalid static IP configuration");
+        return false;
+    }
+    return save_wifi_blob(WIFI_STATIC_KEY, &config, sizeof(config));
+}
+
+// Create the one client used for the life of the firmware
+static bool start_client() {
+    static char mqtt_uri[128];
     snprintf(mqtt_uri, sizeof(mqtt_uri), "mqtt://%s:%d", mqtt_server, mqtt_port);
     
     esp_mqtt_client_config_t mqtt_cfg = {};
-    mqtt_cfg.uri = mqtt_uri;
-    mqtt_cfg.client_id = client_id;
+    mqtt_cfg.broker.address.uri = mqtt_uri;
+    mqtt_cfg.credentials.client_id = client_id;
+    mqtt_cfg.session.keepalive = MQTT_HELPER_KEEPALIVE_S;
+    mqtt_cfg.session.disable_clean_session = MQTT_HELPER_PERSISTENT_SESSION;
+    mqtt_cfg.network.disable_auto_reconnect = true;     // Reconnects are paced by mqtt_helper_reconnect()
     
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
     if (mqtt_client == nullptr) {
@@ -188,17 +452,28 @@ bool mqtt_helper_connect_broker() {
     
     ESP_ERROR_CHECK(esp_mqtt_client_register_event(mqtt_client, MQTT_EVENT_ANY, mqtt_event_handler, nullptr));
     ESP_ERROR_CHECK(esp_mqtt_client_start(mqtt_client));
+    return true;
+}
+
+bool mqtt_helper_connect_broker() {
+    if (mqtt_connected.load()) {
+        return true;
+    }
     
     DebugHelper::info("Connecting to MQTT broker: %s:%d", mqtt_server, mqtt_port);
-    
-    // Wait for connection (with timeout)
-    int timeout_count = 0;
-    while (!mqtt_connected && timeout_count < 50) { // 5 second timeout
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-        timeout_count++;
+    if (mqtt_client == nullptr) {
+        if (!start_client()) {
+            return false;
+        }
+    } else {
+        esp_mqtt_client_reconnect(mqtt_client);
     }
     
-    if (mqtt_connected) {
+    // Wait for MQTT_EVENT_CONNECTED (with timeout)
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group, MQTT_CONNECTED_BIT, pdFALSE, pdFALSE,
+                                           MQTT_HELPER_CONNECT_TIMEOUT_MS / portTICK_PERIOD_MS);
+    
+    if (bits & MQTT_CONNECTED_BIT) {
         DebugHelper::info("MQTT connected!");
         return true;
     } else {
@@ -207,55 +482,136 @@ bool mqtt_helper_connect_broker() {
     }
 }
 
+// Exponential backoff with jitter in [delay/2, delay], so a fleet that lost
+// the same AP does not retry in lockstep
+static uint32_t backoff_ms(uint32_t attempt) {
+    uint32_t delay = MQTT_HELPER_BACKOFF_MIN_MS;
+    while (attempt-- > 0 && delay < MQTT_HELPER_BACKOFF_MAX_MS) {
+        delay *= 2;
+    }
+    if (delay > MQTT_HELPER_BACKOFF_MAX_MS) {
+        delay = MQTT_HELPER_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
 void mqtt_helper_reconnect() {
-    static int reconnectAttempts = 0;
+    if (mqtt_connected.load()) {
+        return;
+    }
     
-    while (!mqtt_connected) {
-        DebugHelper::warning("MQTT connection lost. Reconnecting... (Attempt %d)", reconnectAttempts+1);
-        
-        if (mqtt_helper_connect_broker()) {
-            DebugHelper::info("Re-subscribing to topics");
-            // Notify modules to resubscribe
-            if (user_callback) {
-                user_callback((char*)"internal/resubscribe", nullptr, 0);
-            }
-            reconnectAttempts = 0;
-        } else {
-            reconnectAttempts++;
-            DebugHelper::warning("Retrying in 5 seconds...");
-            vTaskDelay(5000 / portTICK_PERIOD_MS);
-            
-            // Reset after 5 attempts
-            if (reconnectAttempts >= 5) {
-                DebugHelper::error("Resetting after 5 failed attempts");
-                esp_restart();
-            }
-        }
+    int64_t now = esp_timer_get_time();
+    int64_t expected = 0;
+    disconnected_us.compare_exchange_strong(expected, now);    // Never connected since boot
+    if (MQTT_HELPER_RESTART_AFTER_MS > 0 &&
+        now - disconnected_us.load() > (int64_t)MQTT_HELPER_RESTART_AFTER_MS * 1000) {
+        DebugHelper::error("Offline for %lu s, restarting", (unsigned long)(MQTT_HELPER_RESTART_AFTER_MS / 1000));
+        DebugHelper::flush();
+        esp_restart();
+    }
+    if (now < next_attempt_us.load()) {
+        return;
+    }
+    
+    DebugHelper::warning("MQTT connection lost. Reconnecting... (Attempt %lu)",
+                         (unsigned long)reconnect_attempts.load() + 1);
+    if (!(xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT)) {
+        // The broker reconnect follows from IP_EVENT_STA_GOT_IP
+        esp_wifi_connect();
+    } else if (mqtt_client == nullptr) {
+        start_client();
+    } else {
+        esp_mqtt_client_reconnect(mqtt_client);
     }
+    
+    uint32_t delay = backoff_ms(reconnect_attempts.fetch_add(1));
+    next_attempt_us.store(now + (int64_t)delay * 1000);
+    DebugHelper::verbose("Next reconnect attempt in %lu ms", (unsigned long)delay);
 }
 
 void mqtt_helper_loop() {
-    if (!mqtt_connected) {
+    if (!mqtt_connected.load()) {
         mqtt_helper_reconnect();
     }
     // ESP-IDF MQTT client handles message processing automatically
     vTaskDelay(10 / portTICK_PERIOD_MS);
 }
 
-bool mqtt_helper_publish(const char* topic, const char* payload) {
-    if (!mqtt_connected || mqtt_client == nullptr) {
+// Time the client call and count the outcome
+static bool publish_timed(const char* topic, const char* data, int length) {
+    if (!mqtt_connected.load() || mqtt_client == nullptr) {
+        metrics_count(METRIC_PUBLISH_FAILED, 1);
         return false;
     }
     
-    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 0);
+    uint32_t start = metrics_now();
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, data, length, 1, 0);
+    metrics_record_since(METRIC_PUBLISH, start);
+    metrics_count(msg_id != -1 ? METRIC_PUBLISHED : METRIC_PUBLISH_FAILED, 1);
+    
+    if (msg_id != -1 && !first_publish_done) {
+        first_publish_done = true;
+        uint32_t boot_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        metrics_set(METRIC_FIRST_PUBLISH_MS, boot_ms);
+        DebugHelper::info("First publish %lu ms after boot", (unsigned long)boot_ms);
+    }
     return msg_id != -1;
 }
 
+bool mqtt_helper_publish(const char* topic, const char* payload) {
+    return publish_timed(topic, payload, 0);
+}
+
+bool mqtt_helper_publish_binary(const char* topic, const uint8_t* data, size_t length) {
+    return publish_timed(topic, (const char*)data, (int)length);
+}
+
+bool mqtt_helper_is_connected() {
+    return mqtt_connected.load();
+}
+
+int mqtt_helper_outbox_size() {
+    return mqtt_client != nullptr ? esp_mqtt_client_get_outbox_size(mqtt_client) : 0;
+}
+
+bool mqtt_helper_register(const char* topic, mqtt_message_callback_t handler) {
+    if (topic_handler_count == MQTT_HELPER_MAX_HANDLERS) {
+        DebugHelper::error("MQTT handler table full, %s not registered", topic);
+        return false;
+    }
+
+    // Fill the entry before publishing it to the MQTT task
+    topic_handler_t* entry = &topic_handlers[topic_handler_count];
+    entry->topic = topic;
+    entry->topic_len = strlen(topic);
+    entry->hash = mqtt_topic_hash(topic, entry->topic_len);
+    entry->handler = handler;
+    topic_handler_count++;
+
+    if (mqtt_connected.load() && mqtt_client != nullptr) {
+        esp_mqtt_client_subscribe(mqtt_client, topic, 0);
+    }
+    return true;
+}
+
 bool mqtt_helper_subscribe(const char* topic) {
-    if (!mqtt_connected || mqtt_client == nullptr) {
+    if (!mqtt_connected.load() || mqtt_client == nullptr) {
         return false;
     }
     
     int msg_id = esp_mqtt_client_subscribe(mqtt_client, topic, 0);
     return msg_id != -1;
-}
\ No newline at end of file
+}
+
+// DebugHelper sink: UART as before, plus the log topic while connected
+static void mqtt_log_sink(const char* line, size_t length) {
+    printf("%.*s\n", (int)length, line);
+    if (mqtt_connected.load() && mqtt_client != nullptr) {
+        esp_mqtt_client_publish(mqtt_client, log_topic, line, (int)length, 0, 0);
+    }
+}
+
+void mqtt_helper_forward_logs(const char* topic) {
+    log_topic = topic;
+    DebugHelper::setSink(topic != nullptr ? mqtt_log_sink : nullptr);
+}
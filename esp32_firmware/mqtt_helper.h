@@ -13,8 +13,95 @@
  * ESP-IDF native WiFi and MQTT client libraries. It handles WiFi connection,
  * MQTT broker connection, message publishing/subscribing, and automatic
  * reconnection with retry logic.
+ *
+ * Incoming messages are handed to the module callback as an mqtt_message_t
+ * view: topic and payload are not copied or NUL-terminated, and messages
+ * larger than the client's receive buffer are reassembled from their
+ * MQTT_EVENT_DATA fragments into a preallocated buffer. Nothing is allocated
+ * per message. Parse JSON payloads with cJSON_ParseWithLength().
+ *
+ * One MQTT client is created and kept for the life of the firmware; after a
+ * connection loss it is reconnected with esp_mqtt_client_reconnect(), so
+ * its outbox (unacknowledged QoS 1 messages) is kept. A reconnect is tried
+ * as soon as WiFi has an IP again, then with jittered exponential backoff.
+ * Connection state is signalled through event-group bits rather than polled.
  */
 
+#ifndef MQTT_HELPER_RX_BUFFER_SIZE
+#define MQTT_HELPER_RX_BUFFER_SIZE 2048   // Largest reassembled payload (bytes)
+#endif
+
+#define MQTT_HELPER_MAX_TOPIC_LEN  128    // Longest topic kept across fragments
+#define MQTT_HELPER_MAX_HANDLERS   8      // Registered topic handlers
+
+// Reconnect engine
+#ifndef MQTT_HELPER_PERSISTENT_SESSION
+#define MQTT_HELPER_PERSISTENT_SESSION 0  // clean_session=false: broker keeps subscriptions
+#endif                                    // and QoS 1 state (needs stable client id)
+#define MQTT_HELPER_KEEPALIVE_S        30     // Dead connection detected within ~1.5x this
+#define MQTT_HELPER_CONNECT_TIMEOUT_MS 5000   // Initial connect wait in mqtt_helper_connect_broker()
+#define MQTT_HELPER_BACKOFF_MIN_MS     250    // First retry delay after a failed attempt
+#define MQTT_HELPER_BACKOFF_MAX_MS     30000  // Backoff ceiling
+#define MQTT_HELPER_WIFI_RETRIES       20     // Immediate WiFi reconnects before backing off
+// Fast WiFi startup
+#ifndef MQTT_HELPER_FAST_CONNECT
+#define MQTT_HELPER_FAST_CONNECT       1      // Connect to the cached channel/BSSID first
+#endif
+#define MQTT_HELPER_FAST_TIMEOUT_MS    3000   // Fast attempt before falling back to a full scan
+#define MQTT_HELPER_WIFI_TIMEOUT_MS    30000  // Full scan connect wait in mqtt_helper_connect_wifi()
+#ifndef MQTT_HELPER_RESTART_AFTER_MS
+#define MQTT_HELPER_RESTART_AFTER_MS   600000 // Restart after this long offline, 0 = never
+#endif
+
+/**
+ * @brief Received message view
+ *
+ * Only valid for the duration of the callback.
+ */
+typedef struct {
+    const char* topic;          // Topic bytes (not NUL-terminated)
+    size_t topic_len;
+    uint32_t topic_hash;        // mqtt_topic_hash() of the topic
+    const uint8_t* payload;     // Payload bytes (not NUL-terminated)
+    size_t payload_len;
+} mqtt_message_t;
+
+/**
+ * @brief Message callback signature
+ */
+typedef void (*mqtt_message_callback_t)(const mqtt_message_t* message);
+
+/**
+ * @brief FNV-1a hash of a topic
+ *
+ * constexpr so modules can hash their topic constants at compile time and
+ * dispatch on message->topic_hash instead of comparing strings.
+ *
+ * @param topic Topic bytes
+ * @param length Topic length
+ * @return 32-bit topic hash
+ */
+static constexpr uint32_t mqtt_topic_hash(const char* topic, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)topic[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief FNV-1a hash of a NUL-terminated topic
+ * @param topic Topic string
+ * @return 32-bit topic hash, equal to mqtt_topic_hash(topic, strlen(topic))
+ */
+static constexpr uint32_t mqtt_topic_hash_str(const char* topic) {
+    size_t length = 0;
+    while (topic[length] != '\0') {
+        length++;
+    }
+    return mqtt_topic_hash(topic, length);
+}
+
 /**
  * @brief Initialize MQTT helper with network and broker configuration
  * 
@@ -26,42 +113,72 @@
  * @param server MQTT broker IP address or hostname
  * @param port MQTT broker port (typically 1883 for non-TLS)
  * @param id Unique client ID for MQTT connection
- * @param callback Function to handle incoming MQTT messages
- *                 Signature: void callback(char* topic, uint8_t* payload, unsigned int length)
+ * @param callback Fallback for messages on topics without a registered
+ *                 handler (see mqtt_helper_register()); may be NULL
  */
 void mqtt_helper_init(const char* ssid, 
                      const char* password,
                      const char* server, 
                      int port,
                      const char* id,
-                     void (*callback)(char*, uint8_t*, unsigned int));
+                     mqtt_message_callback_t callback);
 
 /**
  * @brief Connect to WiFi network
  * 
  * Attempts to connect to the WiFi network using credentials provided
- * in mqtt_helper_init(). Will retry up to 20 times with 500ms delays.
+ * in mqtt_helper_init(). The channel and BSSID of the last successful
+ * connection are kept in NVS; when present, the AP is joined directly
+ * without a scan, and a full scan is only done if that fails within
+ * MQTT_HELPER_FAST_TIMEOUT_MS. A static IP set with
+ * mqtt_helper_set_static_ip() also skips DHCP.
  * 
  * @return true if WiFi connection successful, false if failed after retries
  */
 bool mqtt_helper_connect_wifi();
 
+/**
+ * @brief Store a static IP configuration in NVS, used from the next boot
+ * 
+ * @param ip Address ("192.168.1.50"), nullptr to return to DHCP
+ * @param netmask Netmask
+ * @param gateway Gateway
+ * @param dns DNS server, nullptr to use the gateway
+ * @return true if the configuration was valid and saved
+ */
+bool mqtt_helper_set_static_ip(const char* ip, const char* netmask,
+                               const char* gateway, const char* dns);
+
+/**
+ * @brief Select WiFi modem sleep
+ * 
+ * With power save on, the radio sleeps between beacons and wakes every
+ * listen_interval beacons (max modem sleep), trading receive latency for
+ * current. Applies immediately if WiFi is running, else at the next connect.
+ * 
+ * @param enable true for max modem sleep, false for the default (min modem)
+ * @param listen_interval Beacon intervals between wakes (0 = AP DTIM period)
+ */
+void mqtt_helper_set_power_save(bool enable, uint16_t listen_interval);
+
 /**
  * @brief Connect to MQTT broker
  * 
- * Establishes connection to the MQTT broker using settings from 
- * mqtt_helper_init(). Sets up event handlers for connection management.
+ * Creates the MQTT client on first use (later calls reconnect the same
+ * client) and waits up to MQTT_HELPER_CONNECT_TIMEOUT_MS for the connection.
  * 
  * @return true if MQTT connection successful, false if failed
  */
 bool mqtt_helper_connect_broker();
 
 /**
- * @brief Handle MQTT reconnection logic
+ * @brief Run one step of the reconnect engine
  * 
- * Called automatically when connection is lost. Attempts to reconnect
- * with exponential backoff. Will restart the device after 5 failed attempts.
- * Also handles WiFi reconnection if needed.
+ * Never blocks. When an attempt is due, reconnects WiFi or the MQTT client,
+ * and schedules the next attempt with jittered exponential backoff (reset
+ * on success). The outcome arrives asynchronously through the event handlers.
+ * Restarts the device after MQTT_HELPER_RESTART_AFTER_MS without a connection.
+ * Called from mqtt_helper_loop() while disconnected.
  */
 void mqtt_helper_reconnect();
 
@@ -86,6 +203,43 @@ void mqtt_helper_loop();
  */
 bool mqtt_helper_publish(const char* topic, const char* payload);
 
+/**
+ * @brief Publish binary message to MQTT topic
+ * 
+ * Same delivery semantics as mqtt_helper_publish() (QoS 1, no retain), but
+ * the payload length is given explicitly so it may contain zero bytes.
+ * 
+ * @param topic MQTT topic to publish to (null-terminated string)
+ * @param data Pointer to payload bytes
+ * @param length Number of payload bytes
+ * @return true if message was queued for transmission, false if failed
+ */
+bool mqtt_helper_publish_binary(const char* topic, const uint8_t* data, size_t length);
+
+/**
+ * @brief Whether the broker connection is up
+ */
+bool mqtt_helper_is_connected();
+
+/**
+ * @brief Bytes waiting in the MQTT client outbox (unacknowledged QoS 1)
+ */
+int mqtt_helper_outbox_size();
+
+/**
+ * @brief Register a handler for an exact topic
+ * 
+ * Subscribes now if connected and again after every (re)connection, so
+ * modules never resubscribe themselves. Incoming messages are matched by
+ * topic hash. Wildcard topics are not supported here; use
+ * mqtt_helper_subscribe() and the init callback for those.
+ * 
+ * @param topic MQTT topic (null-terminated string, must stay valid)
+ * @param handler Function called with each message on the topic
+ * @return true if registered, false if the table is full
+ */
+bool mqtt_helper_register(const char* topic, mqtt_message_callback_t handler);
+
 /**
  * @brief Subscribe to MQTT topic
  * 
@@ -97,4 +251,15 @@ bool mqtt_helper_publish(const char* topic, const char* payload);
  */
 bool mqtt_helper_subscribe(const char* topic);
 
+/**
+ * @brief Forward DebugHelper output to an MQTT topic
+ * 
+ * Log lines still go to the UART; while connected they are also published
+ * with QoS 0. Intended for deferred logging (DEBUG_LOG_DEFERRED), where the
+ * publish runs on the log drain task instead of the logging task.
+ * 
+ * @param topic Log topic (must stay valid), nullptr to stop forwarding
+ */
+void mqtt_helper_forward_logs(const char* topic);
+
 #endif // MQTT_HELPER_H
\ No newline at end of file
@@ -0,0 +1,402 @@
+#include "offline_queue.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include <string.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+
+#define FLASH_SECTOR_SIZE   4096
+#define SECTOR_MAGIC        0x514C464FUL    // "OFLQ"
+#define RECORD_VALID        0xFE            // Written, not yet replayed
+#define RECORD_CONSUMED     0x00            // Replayed (bits cleared without erase)
+#define RECORD_ERASED       0xFF            // End of the sector's records
+
+// Record layout, shared by RAM and flash: header, topic, payload.
+// Flash records are padded to 4 bytes.
+typedef struct {
+    uint16_t length;                        // Payload bytes
+    uint8_t topic_len;
+    uint8_t state;
+} record_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;                      // Allocation order, survives reboot
+} sector_header_t;
+
+#define RECORD_MAX_SIZE (sizeof(record_header_t) + MQTT_HELPER_MAX_TOPIC_LEN + OFFLINE_MAX_RECORD)
+
+static_assert(RECORD_MAX_SIZE <= FLASH_SECTOR_SIZE - sizeof(sector_header_t),
+              "largest record must fit one flash sector");
+static_assert(OFFLINE_MAX_RECORD <= UINT16_MAX, "record length is 16 bits");
+
+static offline_policy_t fill_policy = OFFLINE_DEFAULT_POLICY;
+static offline_queue_stats_t stats = {};
+static uint32_t downsample_counter = 0;
+
+// Record being moved or replayed (network task only)
+static uint8_t scratch[RECORD_MAX_SIZE];
+
+// RAM ring; offsets run freely and are reduced on access
+static uint8_t ram_ring[OFFLINE_RAM_BYTES];
+static uint32_t ram_head = 0;
+static uint32_t ram_tail = 0;
+static uint32_t ram_count = 0;
+
+// Flash log: sectors are allocated in circular order
+static const esp_partition_t* partition = nullptr;
+static uint32_t sector_count = 0;
+static uint32_t next_sequence = 0;
+static uint32_t write_sector = 0;
+static uint32_t write_offset = 0;
+static uint32_t read_sector = 0;
+static uint32_t read_offset = 0;
+static uint32_t flash_count = 0;
+
+// Drain rate limiter, in thousandths of a message
+static uint32_t drain_tokens = OFFLINE_DRAIN_BURST * 1000;
+static uint32_t last_poll_ms = 0;
+
+static inline size_t record_size(const record_header_t* header) {
+    return sizeof(record_header_t) + header->topic_len + header->length;
+}
+
+static inline size_t padded(size_t size) {
+    return (size + 3) & ~(size_t)3;
+}
+
+// ==================== RAM Ring ====================
+
+static size_t ram_free() {
+    return OFFLINE_RAM_BYTES - (ram_head - ram_tail);
+}
+
+static void ram_write(uint32_t offset, const void* src, size_t n) {
+    size_t start = offset % OFFLINE_RAM_BYTES;
+    size_t first = n < OFFLINE_RAM_BYTES - start ? n : OFFLINE_RAM_BYTES - start;
+    memcpy(&ram_ring[start], src, first);
+    memcpy(ram_ring, (const uint8_t*)src + first, n - first);
+}
+
+static void ram_read(uint32_t offset, void* dst, size_t n) {
+    size_t start = offset % OFFLINE_RAM_BYTES;
+    size_t first = n < OFFLINE_RAM_BYTES - start ? n : OFFLINE_RAM_BYTES - start;
+    memcpy(dst, &ram_ring[start], first);
+    memcpy((uint8_t*)dst + first, ram_ring, n - first);
+}
+
+// Copy the oldest RAM record into dst, returns its size (0 if empty)
+static size_t ram_peek(uint8_t* dst) {
+    if (ram_count == 0) {
+        return 0;
+    }
+    record_header_t header;
+    ram_read(ram_tail, &header, sizeof(header));
+    size_t size = record_size(&header);
+    ram_read(ram_tail, dst, size);
+    return size;
+}
+
+static void ram_pop(size_t size) {
+    ram_tail += size;
+    ram_count--;
+}
+
+// ==================== Flash Log ====================
+
+static size_t sector_address(uint32_t sector) {
+    return (size_t)sector * FLASH_SECTOR_SIZE;
+}
+
+static bool read_record_header(uint32_t sector, uint32_t offset, record_header_t* header) {
+    if (offset + sizeof(record_header_t) > FLASH_SECTOR_SIZE ||
+        esp_partition_read(partition, sector_address(sector) + offset, header, sizeof(*header)) != ESP_OK) {
+        return false;
+    }
+    return header->state != RECORD_ERASED &&
+           offset + record_size(header) <= FLASH_SECTOR_SIZE;
+}
+
+// Count valid records from offset to the end of a sector; returns the end offset
+static uint32_t scan_sector(uint32_t sector, uint32_t offset, uint32_t* valid) {
+    record_header_t header;
+    while (read_record_header(sector, offset, &header)) {
+        if (header.state == RECORD_VALID) {
+            (*valid)++;
+        }
+        offset += padded(record_size(&header));
+    }
+    return offset;
+}
+
+static bool open_sector(uint32_t sector) {
+    sector_header_t header = {SECTOR_MAGIC, next_sequence++};
+    if (esp_partition_erase_range(partition, sector_address(sector), FLASH_SECTOR_SIZE) != ESP_OK ||
+        esp_partition_write(partition, sector_address(sector), &header, sizeof(header)) != ESP_OK) {
+        DebugHelper::error("Offline queue: flash sector %lu unusable", (unsigned long)sector);
+        return false;
+    }
+    write_sector = sector;
+    write_offset = sizeof(sector_header_t);
+    return true;
+}
+
+// Discard the unread records of the oldest sector and move the reader on
+static void drop_read_sector() {
+    uint32_t lost = 0;
+    scan_sector(read_sector, read_offset, &lost);
+    flash_count -= lost;
+    stats.dropped += lost;
+    metrics_count(METRIC_OFFLINE_DROPPED, lost);
+
+    read_sector = (read_sector + 1) % sector_count;
+    read_offset = sizeof(sector_header_t);
+}
+
+static bool flash_append(const uint8_t* record, size_t size) {
+    if (write_offset + padded(size) > FLASH_SECTOR_SIZE) {
+        uint32_t next = (write_sector + 1) % sector_count;
+        if (next == read_sector) {
+            drop_read_sector();
+        }
+        if (!open_sector(next)) {
+            return false;
+        }
+    }
+
+    record_header_t header;
+    memcpy(&header, record, sizeof(header));
+    header.state = RECORD_VALID;
+    size_t address = sector_address(write_sector) + write_offset;
+    if (esp_partition_write(partition, address, &header, sizeof(header)) != ESP_OK ||
+        esp_partition_write(partition, address + sizeof(header), record + sizeof(header),
+                            size - sizeof(header)) != ESP_OK) {
+        return false;
+    }
+    write_offset += padded(size);
+    flash_count++;
+    return true;
+}
+
+// Copy the oldest flash record into dst, returns its size (0 if empty)
+static size_t flash_peek(uint8_t* dst) {
+    record_header_t header;
+    while (flash_count > 0) {
+        if (!read_record_header(read_sector, read_offset, &header)) {
+            if (read_sector == write_sector) {
+                flash_count = 0;        // Count out of step with the log
+                return 0;
+            }
+            read_sector = (read_sector + 1) % sector_count;
+            read_offset = sizeof(sector_header_t);
+            continue;
+        }
+        size_t size = record_size(&header);
+        if (header.state != RECORD_VALID || size > RECORD_MAX_SIZE) {
+            read_offset += padded(size);
+            continue;
+        }
+        esp_partition_read(partition, sector_address(read_sector) + read_offset, dst, size);
+        return size;
+    }
+    return 0;
+}
+
+static void flash_pop(size_t size) {
+    uint8_t consumed = RECORD_CONSUMED;
+    esp_partition_write(partition, sector_address(read_sector) + read_offset + offsetof(record_header_t, state),
+                        &consumed, 1);
+    read_offset += padded(size);
+    flash_count--;
+}
+
+// Rebuild reader/writer positions from the sector sequence numbers
+static void flash_recover() {
+    bool found = false;
+    uint32_t oldest = 0, newest = 0, oldest_seq = 0, newest_seq = 0;
+
+    for (uint32_t s = 0; s < sector_count; s++) {
+        sector_header_t header;
+        if (esp_partition_read(partition, sector_address(s), &header, sizeof(header)) != ESP_OK ||
+            header.magic != SECTOR_MAGIC) {
+            continue;
+        }
+        if (!found || header.sequence < oldest_seq) { oldest = s; oldest_seq = header.sequence; }
+        if (!found || header.sequence > newest_seq) { newest = s; newest_seq = header.sequence; }
+        found = true;
+    }
+
+    if (!found) {
+        open_sector(0);
+        read_sector = 0;
+        read_offset = sizeof(sector_header_t);
+        return;
+    }
+
+    next_sequence = newest_seq + 1;
+    read_sector = oldest;
+    read_offset = sizeof(sector_header_t);
+    write_sector = newest;
+    for (uint32_t s = oldest; ; s = (s + 1) % sector_count) {
+        uint32_t end = scan_sector(s, sizeof(sector_header_t), &flash_count);
+        if (s == newest) {
+            write_offset = end;
+            break;
+        }
+    }
+}
+
+// Runs from esp_restart(): RAM records would be lost, so move them to flash
+static void persist_ram() {
+    size_t size;
+    while ((size = ram_peek(scratch)) > 0 && flash_append(scratch, size)) {
+        ram_pop(size);
+    }
+}
+
+// ==================== Public API ====================
+
+bool offline_queue_init(offline_policy_t policy) {
+    fill_policy = policy;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         OFFLINE_PARTITION_LABEL);
+    if (partition == nullptr || partition->size < 2 * FLASH_SECTOR_SIZE) {
+        partition = nullptr;
+        DebugHelper::warning("Offline queue: no flash partition, RAM only");
+        return false;
+    }
+
+    sector_count = partition->size / FLASH_SECTOR_SIZE;
+    flash_recover();
+    stats.flash = true;
+    esp_register_shutdown_handler(persist_ram);
+    DebugHelper::info("Offline queue: %lu messages recovered from flash", (unsigned long)flash_count);
+    return true;
+}
+
+// Downsampling factor (log2) from the fill level: 1/2 at 3/4 full, then 1/4, 1/8
+static uint32_t downsample_shift() {
+    size_t capacity = OFFLINE_RAM_BYTES;
+    size_t used = ram_head - ram_tail;
+    if (partition != nullptr) {
+        capacity += (size_t)(sector_count - 1) * FLASH_SECTOR_SIZE;
+        if (flash_count > 0) {
+            used += (size_t)((write_sector + sector_count - read_sector) % sector_count + 1) * FLASH_SECTOR_SIZE;
+        }
+    }
+    uint32_t shift = 0;
+    for (size_t free = capacity - (used < capacity ? used : capacity); free * 4 < capacity && shift < 3; free *= 2) {
+        shift++;
+    }
+    return shift;
+}
+
+bool offline_queue_store(const char* topic, const uint8_t* data, size_t length) {
+    size_t topic_len = strlen(topic);
+    if (length > OFFLINE_MAX_RECORD || topic_len > MQTT_HELPER_MAX_TOPIC_LEN) {
+        DebugHelper::warning("Offline queue: %u byte message not queued", (unsigned)length);
+        stats.dropped++;
+        metrics_count(METRIC_OFFLINE_DROPPED, 1);
+        return false;
+    }
+
+    if (fill_policy == OFFLINE_POLICY_DOWNSAMPLE) {
+        uint32_t shift = downsample_shift();
+        if (shift > 0 && (downsample_counter++ & ((1u << shift) - 1)) != 0) {
+            stats.skipped++;
+            return false;
+        }
+    }
+
+    // Make room: the oldest RAM records move to flash, or are lost without it
+    record_header_t header = {(uint16_t)length, (uint8_t)topic_len, RECORD_VALID};
+    size_t size = record_size(&header);
+    while (ram_free() < size) {
+        size_t moved = ram_peek(scratch);
+        if (partition == nullptr || !flash_append(scratch, moved)) {
+            stats.dropped++;
+            metrics_count(METRIC_OFFLINE_DROPPED, 1);
+        }
+        ram_pop(moved);
+    }
+
+    ram_write(ram_head, &header, sizeof(header));
+    ram_write(ram_head + sizeof(header), topic, topic_len);
+    ram_write(ram_head + sizeof(header) + topic_len, data, length);
+    ram_head += size;
+    ram_count++;
+
+    stats.stored++;
+    metrics_count(METRIC_OFFLINE_STORED, 1);
+    return true;
+}
+
+bool offline_queue_publish(const char* topic, const uint8_t* data, size_t length) {
+    if (mqtt_helper_is_connected() && mqtt_helper_outbox_size() < OFFLINE_OUTBOX_LIMIT &&
+        mqtt_helper_publish_binary(topic, data, length)) {
+        return true;
+    }
+    return offline_queue_store(topic, data, length);
+}
+
+size_t offline_queue_poll(uint32_t now_ms) {
+    uint32_t elapsed = now_ms - last_poll_ms;
+    last_poll_ms = now_ms;
+    uint32_t refill = elapsed < OFFLINE_DRAIN_BURST * 1000 ? elapsed * OFFLINE_DRAIN_RATE
+                                                           : OFFLINE_DRAIN_BURST * 1000;
+    drain_tokens = drain_tokens + refill < OFFLINE_DRAIN_BURST * 1000 ? drain_tokens + refill
+                                                                      : OFFLINE_DRAIN_BURST * 1000;
+
+    if (ram_count + flash_count == 0 || !mqtt_helper_is_connected()) {
+        return 0;
+    }
+
+    size_t replayed = 0;
+    while (drain_tokens >= 1000 && mqtt_helper_outbox_size() < OFFLINE_OUTBOX_LIMIT) {
+        bool from_flash = flash_count > 0;
+        size_t size = from_flash ? flash_peek(scratch) : ram_peek(scratch);
+        if (size == 0) {
+            break;
+        }
+
+        record_header_t header;
+        memcpy(&header, scratch, sizeof(header));
+        char topic[MQTT_HELPER_MAX_TOPIC_LEN + 1];
+        memcpy(topic, &scratch[sizeof(header)], header.topic_len);
+        topic[header.topic_len] = '\0';
+
+        if (!mqtt_helper_publish_binary(topic, &scratch[sizeof(header) + header.topic_len], header.length)) {
+            break;
+        }
+        if (from_flash) {
+            flash_pop(size);
+        } else {
+            ram_pop(size);
+        }
+        drain_tokens -= 1000;
+        replayed++;
+    }
+
+    if (replayed > 0) {
+        stats.replayed += replayed;
+        metrics_count(METRIC_OFFLINE_REPLAYED, replayed);
+        if (ram_count + flash_count == 0) {
+            DebugHelper::info("Offline queue drained");
+        }
+    }
+    return replayed;
+}
+
+void offline_queue_persist() {
+    if (partition != nullptr) {
+        persist_ram();
+    }
+}
+
+offline_queue_stats_t offline_queue_stats() {
+    offline_queue_stats_t current = stats;
+    current.pending = ram_count + flash_count;
+    return current;
+}
@@ -0,0 +1,119 @@
+#ifndef OFFLINE_QUEUE_H
+#define OFFLINE_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "telemetry_batch.h"
+
+/**
+ * @file offline_queue.h
+ * @brief Store-and-forward queue for messages that could not be published
+ *
+ * Messages (topic + payload) that cannot be published, because the broker
+ * is unreachable or the MQTT outbox is backed up, are kept in a RAM ring.
+ * When the ring is full, its oldest records move to a circular log in the
+ * "offline" flash partition, which survives a reboot, so the order is always
+ * flash (oldest) then RAM. RAM records are written to flash on esp_restart()
+ * and by offline_queue_persist() (call before deep sleep).
+ * Without the partition the queue is RAM only.
+ *
+ * After reconnecting, offline_queue_poll() replays the oldest records at no
+ * more than OFFLINE_DRAIN_RATE messages per second, and only while the MQTT
+ * outbox is below OFFLINE_OUTBOX_LIMIT bytes. Live messages still go out
+ * first, so replayed data may arrive after newer data, and consumers must
+ * order by the timestamp in the payload.
+ *
+ * When the queue fills up, the oldest data is dropped. Under
+ * OFFLINE_POLICY_DOWNSAMPLE, once the queue is 3/4 full only every 2nd, then
+ * 4th, then 8th new message is kept, which stretches the time span covered
+ * before old data has to go.
+ *
+ * All functions must be called from the network task.
+ */
+
+#define OFFLINE_RAM_BYTES        16384  // RAM ring size
+// Largest payload that is queued: any telemetry batch message. A record
+// (with the longest topic) must fit one flash sector.
+#define OFFLINE_MAX_RECORD       (TELEMETRY_BATCH_JSON_SIZE > TELEMETRY_BATCH_MAX_FRAME_SIZE ? \
+                                  TELEMETRY_BATCH_JSON_SIZE : TELEMETRY_BATCH_MAX_FRAME_SIZE)
+#define OFFLINE_PARTITION_LABEL  "offline"
+
+#ifndef OFFLINE_DRAIN_RATE
+#define OFFLINE_DRAIN_RATE       5      // Replayed messages per second
+#endif
+#define OFFLINE_DRAIN_BURST      5      // Token bucket depth
+#define OFFLINE_OUTBOX_LIMIT     4096   // Outbox bytes above which live traffic is queued,
+                                        // and replay pauses
+
+/**
+ * @brief Behaviour when the queue fills
+ */
+typedef enum {
+    OFFLINE_POLICY_DROP_OLDEST,     // Drop the oldest queued messages
+    OFFLINE_POLICY_DOWNSAMPLE       // Thin new messages near full, then drop oldest
+} offline_policy_t;
+
+#ifndef OFFLINE_DEFAULT_POLICY
+#define OFFLINE_DEFAULT_POLICY OFFLINE_POLICY_DROP_OLDEST
+#endif
+
+/**
+ * @brief Queue statistics
+ */
+typedef struct {
+    uint32_t pending;               // Messages waiting (RAM + flash)
+    uint32_t stored;                // Messages queued since boot
+    uint32_t replayed;              // Messages replayed since boot
+    uint32_t dropped;               // Discarded: oldest when full, or too large to queue
+    uint32_t skipped;               // New messages thinned out by downsampling
+    bool flash;                     // Flash partition in use
+} offline_queue_stats_t;
+
+/**
+ * @brief Set up the queue and recover messages left in flash
+ * @param policy Fill policy
+ * @return true if the flash partition is in use, false for RAM only
+ */
+bool offline_queue_init(offline_policy_t policy);
+
+/**
+ * @brief Publish a message now, or queue it if that is not possible
+ *
+ * Publishes directly when connected and the outbox is below
+ * OFFLINE_OUTBOX_LIMIT; otherwise the message is queued.
+ *
+ * @param topic MQTT topic
+ * @param data Payload bytes
+ * @param length Payload length
+ * @return true if published or queued, false if thinned out or too large
+ */
+bool offline_queue_publish(const char* topic, const uint8_t* data, size_t length);
+
+/**
+ * @brief Queue a message for later publishing
+ * @param topic MQTT topic
+ * @param data Payload bytes
+ * @param length Payload length
+ * @return true if queued, false if thinned out or too large (counted as dropped)
+ */
+bool offline_queue_store(const char* topic, const uint8_t* data, size_t length);
+
+/**
+ * @brief Replay queued messages within the drain rate
+ * @param now_ms Current time in milliseconds
+ * @return Number of messages replayed
+ */
+size_t offline_queue_poll(uint32_t now_ms);
+
+/**
+ * @brief Move RAM records to flash so they survive a power-down
+ */
+void offline_queue_persist();
+
+/**
+ * @brief Current queue statistics
+ */
+offline_queue_stats_t offline_queue_stats();
+
+#endif // OFFLINE_QUEUE_H
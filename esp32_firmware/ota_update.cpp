@@ -0,0 +1,609 @@
+#include "ota_update.h"
+#include "mqtt_helper.h"
+#include "metrics.h"
+#include "debug_helper.h"
+#include "task_config.h"
+#include <esp_app_desc.h>
+#include <esp_crt_bundle.h>
+#include <esp_http_client.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <nvs.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define OTA_NVS_NAMESPACE   "ota"
+#define OTA_NVS_KEY         "pending"
+#define OTA_IMAGE_MAGIC     0xE9        // First byte of an ESP application image
+#define OTA_MAGIC_SIZE      4
+
+typedef enum {
+    OTA_IDLE,
+    OTA_RUNNING,                        // OTA task downloading
+    OTA_DOWNLOADED,                     // Boot partition switched, reboot pending
+    OTA_FAILED,
+    OTA_RESTARTING
+} ota_phase_t;
+
+typedef enum {
+    DELTA_HEADER,
+    DELTA_OP,
+    DELTA_ADJUST,                       // Copy offset adjustment
+    DELTA_INSERT,
+    DELTA_DONE
+} delta_phase_t;
+
+// Written before the reboot, read by whichever image boots next
+typedef struct {
+    char version[32];
+    char label[17];                     // Partition the update was written to
+    uint8_t delta;
+    uint32_t download_ms;
+    uint32_t download_bytes;
+    uint32_t image_bytes;
+} ota_record_t;
+
+typedef struct {
+    uint8_t phase;                      // delta_phase_t
+    uint8_t header[OTA_DELTA_HEADER_SIZE];
+    size_t header_length;
+    uint64_t varint;                    // Varint being read, across HTTP reads
+    uint8_t shift;
+    uint32_t length;                    // Bytes left in the current op
+    int64_t base_position;
+    uint32_t base_size;
+    uint32_t target_size;
+} delta_state_t;
+
+typedef struct {
+    const esp_partition_t* running;
+    const esp_partition_t* partition;   // Being written
+    esp_ota_handle_t handle;
+    bool begun;
+    uint8_t magic[OTA_MAGIC_SIZE];
+    size_t magic_length;
+    bool delta;
+    delta_state_t patch;
+    uint32_t content_length;            // HTTP, 0 if unknown
+    uint32_t downloaded;
+    uint32_t produced;                  // Image bytes accepted (written or buffered)
+    size_t buffered;
+} ota_session_t;
+
+static const ota_update_config_t* ota_config = nullptr;
+
+// Shared; url before the OTA task starts, the rest before its final phase
+static std::atomic<uint8_t> phase{OTA_IDLE};
+static std::atomic<uint8_t> progress_pct{0};
+static char url[OTA_URL_SIZE];
+static char error_message[80];
+static ota_record_t result;
+
+// OTA task only
+static ota_session_t session;
+static uint8_t http_buffer[OTA_BUFFER_SIZE];
+static uint8_t image_buffer[OTA_BUFFER_SIZE];
+
+// Network task only
+static uint8_t reported_pct = 0;
+static uint32_t restart_at_ms = 0;
+static bool verify_pending = false;     // This image boots for the first time
+static bool outcome_pending = false;    // Boot record to report once connected
+static bool rolled_back = false;
+static ota_record_t booted;
+
+static inline uint32_t now_ms() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static bool fail(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error_message, sizeof(error_message), format, args);
+    va_end(args);
+    return false;
+}
+
+// ==================== Boot Record ====================
+
+static bool load_record(ota_record_t* record) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(*record);
+    esp_err_t ret = nvs_get_blob(nvs_handle, OTA_NVS_KEY, record, &size);
+    nvs_close(nvs_handle);
+    return ret == ESP_OK && size == sizeof(*record);
+}
+
+static bool save_record(const ota_record_t* record) {
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret == ESP_OK) {
+        ret = record != nullptr ? nvs_set_blob(nvs_handle, OTA_NVS_KEY, record, sizeof(*record))
+                                : nvs_erase_key(nvs_handle, OTA_NVS_KEY);
+        if (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = nvs_commit(nvs_handle);
+        }
+        nvs_close(nvs_handle);
+    }
+    return ret == ESP_OK;
+}
+
+// ==================== Image Writer ====================
+
+static bool image_begin(uint32_t size) {
+    session.partition = esp_ota_get_next_update_partition(nullptr);
+    if (session.partition == nullptr) {
+        return fail("no OTA partition");
+    }
+    if (size > session.partition->size) {
+        return fail("image of %lu bytes exceeds %s", (unsigned long)size, session.partition->label);
+    }
+    esp_err_t ret = esp_ota_begin(session.partition, size > 0 ? size : OTA_SIZE_UNKNOWN,
+                                  &session.handle);
+    if (ret != ESP_OK) {
+        return fail("esp_ota_begin: %s", esp_err_to_name(ret));
+    }
+    session.begun = true;
+    return true;
+}
+
+static bool image_flush() {
+    if (session.buffered == 0) {
+        return true;
+    }
+    esp_err_t ret = esp_ota_write(session.handle, image_buffer, session.buffered);
+    session.buffered = 0;
+    return ret == ESP_OK || fail("esp_ota_write: %s", esp_err_to_name(ret));
+}
+
+static bool image_put(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t n = OTA_BUFFER_SIZE - session.buffered;
+        n = n < length ? n : length;
+        memcpy(&image_buffer[session.buffered], data, n);
+        session.buffered += n;
+        session.produced += n;
+        data += n;
+        length -= n;
+        if (session.buffered == OTA_BUFFER_SIZE && !image_flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ==================== Delta Images ====================
+
+static inline uint32_t read_u32(const uint8_t* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static bool delta_start() {
+    delta_state_t* patch = &session.patch;
+    if (patch->header[4] != OTA_DELTA_VERSION) {
+        return fail("delta version %u not supported", patch->header[4]);
+    }
+    patch->base_size = read_u32(&patch->header[8]);
+    patch->target_size = read_u32(&patch->header[12]);
+    if (patch->base_size > session.running->size || patch->target_size == 0) {
+        return fail("delta sizes out of range");
+    }
+
+    // The running image's appended hash identifies the base
+    uint8_t sha256[32];
+    esp_err_t ret = esp_partition_get_sha256(session.running, sha256);
+    if (ret != ESP_OK) {
+        return fail("running image hash: %s", esp_err_to_name(ret));
+    }
+    if (memcmp(sha256, &patch->header[16], sizeof(sha256)) != 0) {
+        return fail("delta is for another base image");
+    }
+    patch->phase = DELTA_OP;
+    return image_begin(patch->target_size);
+}
+
+// Base bytes go straight from flash into the write buffer
+static bool delta_copy() {
+    delta_state_t* patch = &session.patch;
+    if (patch->base_position < 0 || patch->base_position + patch->length > patch->base_size) {
+        return fail("delta copy outside the base image");
+    }
+    while (patch->length > 0) {
+        size_t n = OTA_BUFFER_SIZE - session.buffered;
+        n = n < patch->length ? n : patch->length;
+        esp_err_t ret = esp_partition_read(session.running, (size_t)patch->base_position,
+                                           &image_buffer[session.buffered], n);
+        if (ret != ESP_OK) {
+            return fail("base read: %s", esp_err_to_name(ret));
+        }
+        session.buffered += n;
+        session.produced += n;
+        patch->base_position += n;
+        patch->length -= n;
+        if (session.buffered == OTA_BUFFER_SIZE && !image_flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline uint8_t delta_next_op() {
+    return session.produced == session.patch.target_size ? DELTA_DONE : DELTA_OP;
+}
+
+static bool delta_feed(const uint8_t* data, size_t length) {
+    delta_state_t* patch = &session.patch;
+    size_t i = 0;
+    while (i < length) {
+        switch (patch->phase) {
+            case DELTA_HEADER: {
+                size_t n = OTA_DELTA_HEADER_SIZE - patch->header_length;
+                n = n < length - i ? n : length - i;
+                memcpy(&patch->header[patch->header_length], &data[i], n);
+                patch->header_length += n;
+                i += n;
+                if (patch->header_length == OTA_DELTA_HEADER_SIZE && !delta_start()) {
+                    return false;
+                }
+                break;
+            }
+            case DELTA_OP:
+            case DELTA_ADJUST: {
+                uint8_t byte = data[i++];
+                if (patch->shift > 63) {
+                    return fail("delta varint too long");
+                }
+                patch->varint |= (uint64_t)(byte & 0x7F) << patch->shift;
+                patch->shift += 7;
+                if (byte & 0x80) {
+                    break;
+                }
+                uint64_t value = patch->varint;
+                patch->varint = 0;
+                patch->shift = 0;
+
+                if (patch->phase == DELTA_OP) {
+                    uint64_t op_length = value >> 1;
+                    if (op_length == 0 || op_length > patch->target_size - session.produced) {
+                        return fail("delta op beyond the image end");
+                    }
+                    patch->length = (uint32_t)op_length;
+                    patch->phase = (value & 1) ? DELTA_INSERT : DELTA_ADJUST;
+                } else {
+                    patch->base_position += (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+                    if (!delta_copy()) {
+                        return false;
+                    }
+                    patch->phase = delta_next_op();
+                }
+                break;
+            }
+            case DELTA_INSERT: {
+                size_t n = patch->length < length - i ? patch->length : length - i;
+                if (!image_put(&data[i], n)) {
+                    return false;
+                }
+                i += n;
+                patch->length -= n;
+                if (patch->length == 0) {
+                    patch->phase = delta_next_op();
+                }
+                break;
+            }
+            default:
+                return fail("data after the end of the delta");
+        }
+    }
+    return true;
+}
+
+// ==================== Download ====================
+
+// Full images are written as they arrive; the magic bytes pick the format
+static bool session_feed(const uint8_t* data, size_t length) {
+    if (session.magic_length < OTA_MAGIC_SIZE) {
+        size_t n = OTA_MAGIC_SIZE - session.magic_length;
+        n = n < length ? n : length;
+        memcpy(&session.magic[session.magic_length], data, n);
+        session.magic_length += n;
+        data += n;
+        length -= n;
+        if (session.magic_length < OTA_MAGIC_SIZE) {
+            return true;
+        }
+        if (memcmp(session.magic, OTA_DELTA_MAGIC, OTA_MAGIC_SIZE) == 0) {
+            session.delta = true;
+            return delta_feed(session.magic, OTA_MAGIC_SIZE) && delta_feed(data, length);
+        }
+        if (session.magic[0] != OTA_IMAGE_MAGIC) {
+            return fail("not a firmware image or delta");
+        }
+        if (!image_begin(session.content_length) || !image_put(session.magic, OTA_MAGIC_SIZE)) {
+            return false;
+        }
+    }
+    return session.delta ? delta_feed(data, length) : image_put(data, length);
+}
+
+static void update_progress() {
+    uint32_t total = session.delta ? session.patch.target_size : session.content_length;
+    uint32_t pct = total > 0 ? (uint32_t)((uint64_t)session.produced * 100 / total) : 0;
+    progress_pct.store((uint8_t)(pct < 100 ? pct : 100), std::memory_order_relaxed);
+    metrics_set(METRIC_OTA_PROGRESS_PCT, pct);
+    metrics_set(METRIC_OTA_DOWNLOAD_BYTES, session.downloaded);
+}
+
+static bool download(esp_http_client_handle_t client) {
+    esp_err_t ret = esp_http_client_open(client, 0);
+    if (ret != ESP_OK) {
+        return fail("connect: %s", esp_err_to_name(ret));
+    }
+    int64_t content_length = esp_http_client_fetch_headers(client);
+    int status = esp_http_client_get_status_code(client);
+    if (status != 200) {
+        return fail("HTTP status %d", status);
+    }
+    session.content_length = content_length > 0 ? (uint32_t)content_length : 0;
+
+    for (;;) {
+        int n = esp_http_client_read(client, (char*)http_buffer, sizeof(http_buffer));
+        if (n < 0) {
+            return fail("read failed after %lu bytes", (unsigned long)session.downloaded);
+        }
+        if (n == 0) {
+            break;
+        }
+        session.downloaded += n;
+        if (!session_feed(http_buffer, (size_t)n)) {
+            return false;
+        }
+        update_progress();
+    }
+
+    if (!esp_http_client_is_complete_data_received(client)) {
+        return fail("download cut off after %lu bytes", (unsigned long)session.downloaded);
+    }
+    if (!session.begun || (session.delta && session.patch.phase != DELTA_DONE)) {
+        return fail("image incomplete");
+    }
+    if (!image_flush()) {
+        return false;
+    }
+    session.begun = false;
+    ret = esp_ota_end(session.handle);
+    if (ret != ESP_OK) {
+        return fail("image rejected: %s", esp_err_to_name(ret));
+    }
+    return true;
+}
+
+static bool install(uint32_t elapsed_ms) {
+    esp_app_desc_t desc;
+    esp_err_t ret = esp_ota_get_partition_description(session.partition, &desc);
+    if (ret != ESP_OK) {
+        return fail("image description: %s", esp_err_to_name(ret));
+    }
+    result = {};
+    snprintf(result.version, sizeof(result.version), "%s", desc.version);
+    snprintf(result.label, sizeof(result.label), "%s", session.partition->label);
+    result.delta = session.delta;
+    result.download_ms = elapsed_ms;
+    result.download_bytes = session.downloaded;
+    result.image_bytes = session.produced;
+
+    // The record first: a boot into the new image must find it
+    if (!save_record(&result)) {
+        return fail("boot record not saved");
+    }
+    ret = esp_ota_set_boot_partition(session.partition);
+    if (ret != ESP_OK) {
+        save_record(nullptr);
+        return fail("esp_ota_set_boot_partition: %s", esp_err_to_name(ret));
+    }
+    return true;
+}
+
+static void ota_task(void* parameter) {
+    uint32_t start_ms = now_ms();
+    session = {};
+    session.running = esp_ota_get_running_partition();
+
+    // Full radio duty cycle while downloading: fewer seconds of radio on
+    wifi_ps_type_t power_save;
+    bool restore_ps = esp_wifi_get_ps(&power_save) == ESP_OK;
+    esp_wifi_set_ps(WIFI_PS_NONE);
+
+    esp_http_client_config_t http_config = {};
+    http_config.url = url;
+    http_config.timeout_ms = OTA_HTTP_TIMEOUT_MS;
+    http_config.crt_bundle_attach = esp_crt_bundle_attach;
+    esp_http_client_handle_t client = esp_http_client_init(&http_config);
+    bool ok = client != nullptr ? download(client) : fail("HTTP client init failed");
+    if (client != nullptr) {
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+    }
+    if (restore_ps) {
+        esp_wifi_set_ps(power_save);
+    }
+
+    if (session.begun) {
+        esp_ota_abort(session.handle);
+    }
+    uint32_t elapsed_ms = now_ms() - start_ms;
+    metrics_set(METRIC_OTA_DOWNLOAD_MS, elapsed_ms);
+    metrics_set(METRIC_OTA_IMAGE_BYTES, session.produced);
+    ok = ok && install(elapsed_ms);
+    phase.store(ok ? OTA_DOWNLOADED : OTA_FAILED, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+// ==================== Public API ====================
+
+void ota_update_init(const ota_update_config_t* config) {
+    ota_config = config;
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    verify_pending = running != nullptr &&
+                     esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                     state == ESP_OTA_IMG_PENDING_VERIFY;
+    DebugHelper::info("OTA: running %s from %s%s", esp_app_get_description()->version,
+                      running != nullptr ? running->label : "?",
+                      verify_pending ? ", pending verification" : "");
+
+    if (!load_record(&booted)) {
+        return;
+    }
+    outcome_pending = true;
+    rolled_back = running == nullptr || strcmp(booted.label, running->label) != 0;
+    // An unconfirmed new image keeps the record until verify_image(), so a
+    // rollback from here on is still reported by the previous image
+    if (rolled_back || !verify_pending) {
+        save_record(nullptr);
+    }
+    metrics_set(METRIC_OTA_DOWNLOAD_MS, booted.download_ms);
+    metrics_set(METRIC_OTA_DOWNLOAD_BYTES, booted.download_bytes);
+    metrics_set(METRIC_OTA_IMAGE_BYTES, booted.image_bytes);
+    if (rolled_back) {
+        metrics_count(METRIC_OTA_ROLLBACKS, 1);
+        DebugHelper::warning("OTA: firmware %s was rolled back", booted.version);
+    } else {
+        metrics_set(METRIC_OTA_PROGRESS_PCT, 100);
+    }
+}
+
+bool ota_update_handle_command(const cJSON* params) {
+    if (phase.load(std::memory_order_acquire) != OTA_IDLE) {
+        DebugHelper::warning("OTA: update already in progress");
+        return false;
+    }
+    if (verify_pending) {
+        // The other partition holds the image a rollback would return to
+        DebugHelper::warning("OTA: running image not confirmed yet");
+        return false;
+    }
+    const char* target_url = cJSON_GetStringValue(cJSON_GetObjectItem(params, "url"));
+    if (target_url == nullptr || strlen(target_url) >= sizeof(url)) {
+        DebugHelper::warning("OTA: url missing or longer than %u bytes", (unsigned)(sizeof(url) - 1));
+        return false;
+    }
+    const char* version = cJSON_GetStringValue(cJSON_GetObjectItem(params, "version"));
+    if (version != nullptr && strcmp(version, esp_app_get_description()->version) == 0) {
+        DebugHelper::info("OTA: firmware %s already running", version);
+        ota_config->send_status("IDLE", "Firmware already up to date");
+        return false;
+    }
+    if (ota_config->busy()) {
+        DebugHelper::warning("OTA: not started during an actuation");
+        return false;
+    }
+
+    strcpy(url, target_url);
+    progress_pct.store(0, std::memory_order_relaxed);
+    reported_pct = 0;
+    phase.store(OTA_RUNNING, std::memory_order_release);
+    metrics_set(METRIC_OTA_PROGRESS_PCT, 0);
+    if (xTaskCreatePinnedToCore(ota_task, "ota", OTA_TASK_STACK, nullptr, OTA_TASK_PRIORITY,
+                                nullptr, TASK_CORE_NETWORK) != pdPASS) {
+        phase.store(OTA_IDLE, std::memory_order_release);
+        DebugHelper::error("OTA: failed to create task");
+        return false;
+    }
+    DebugHelper::info("OTA: downloading %s", url);
+    ota_config->send_status("UPDATING", "Firmware download started");
+    return true;
+}
+
+static void report_outcome() {
+    char message[96];
+    if (rolled_back) {
+        snprintf(message, sizeof(message), "Firmware %s rolled back, running %s",
+                 booted.version, esp_app_get_description()->version);
+        ota_config->send_status("ERROR", message);
+        return;
+    }
+    metrics_count(METRIC_OTA_UPDATES, 1);
+    snprintf(message, sizeof(message), "Firmware updated to %s (%s, %lu bytes in %lu ms)",
+             booted.version, booted.delta ? "delta" : "full",
+             (unsigned long)booted.download_bytes, (unsigned long)booted.download_ms);
+    ota_config->send_status("COMPLETED", message);
+}
+
+// Confirm the first boot of an update, or give it up
+static void verify_image(uint32_t now, bool connected) {
+    if (connected && now >= OTA_VERIFY_UPTIME_MS) {
+        esp_err_t ret = esp_ota_mark_app_valid_cancel_rollback();
+        if (ret != ESP_OK) {
+            DebugHelper::error("OTA: confirming image failed: %s", esp_err_to_name(ret));
+        } else {
+            save_record(nullptr);       // Past the last rollback point
+            DebugHelper::info("OTA: image confirmed");
+        }
+        verify_pending = false;
+    } else if (!connected && now >= OTA_VERIFY_TIMEOUT_MS) {
+        DebugHelper::error("OTA: no broker after %lu s, rolling back",
+                           (unsigned long)(OTA_VERIFY_TIMEOUT_MS / 1000));
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
+
+bool ota_update_poll(uint32_t now) {
+    bool connected = mqtt_helper_is_connected();
+    if (verify_pending) {
+        verify_image(now, connected);
+    }
+    if (outcome_pending && !verify_pending && connected) {
+        report_outcome();
+        outcome_pending = false;
+    }
+
+    char message[128];
+    switch (phase.load(std::memory_order_acquire)) {
+        case OTA_RUNNING: {
+            uint8_t pct = progress_pct.load(std::memory_order_relaxed);
+            if (pct >= reported_pct + OTA_PROGRESS_STEP_PCT && pct < 100) {
+                reported_pct = pct - pct % OTA_PROGRESS_STEP_PCT;
+                snprintf(message, sizeof(message), "Firmware download %u%%", (unsigned)reported_pct);
+                ota_config->send_status("UPDATING", message);
+            }
+            return true;
+        }
+        case OTA_FAILED:
+            metrics_count(METRIC_OTA_FAILED, 1);
+            DebugHelper::error("OTA: %s", error_message);
+            snprintf(message, sizeof(message), "Firmware update failed: %s", error_message);
+            ota_config->send_status("ERROR", message);
+            phase.store(OTA_IDLE, std::memory_order_release);
+            return false;
+        case OTA_DOWNLOADED:
+            // Never reboot in the middle of an actuation
+            if (ota_config->busy()) {
+                return true;
+            }
+            snprintf(message, sizeof(message), "Firmware %s installed (%s, %lu bytes in %lu ms), rebooting",
+                     result.version, result.delta ? "delta" : "full",
+                     (unsigned long)result.download_bytes, (unsigned long)result.download_ms);
+            ota_config->send_status("UPDATING", message);
+            restart_at_ms = now + OTA_RESTART_DELAY_MS;
+            phase.store(OTA_RESTARTING, std::memory_order_release);
+            return true;
+        case OTA_RESTARTING:
+            if ((int32_t)(now - restart_at_ms) >= 0) {
+                DebugHelper::info("OTA: rebooting into %s", result.label);
+                esp_restart();
+            }
+            return true;
+        default:
+            return verify_pending || outcome_pending;
+    }
+}
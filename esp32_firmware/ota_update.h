@@ -0,0 +1,107 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+
+/**
+ * @file ota_update.h
+ * @brief MQTT-triggered A/B firmware update with delta images and rollback
+ *
+ * The "ota_update" command names an image URL. An OTA task downloads it into
+ * the inactive app partition (ota_0/ota_1 in partitions.csv) while the module
+ * keeps sampling, then the network task reboots into it once no actuation is
+ * running. The image is either a full application image (first byte 0xE9)
+ * or a delta against the running image, told apart by their magic bytes.
+ *
+ * A delta rebuilds the new image from ranges of the running app partition
+ * and literal bytes, so a rebuild that changes little downloads little,
+ * which is what keeps the radio on for a short time. Layout (little-endian):
+ *
+ *   header   "EDLT", uint8 version (1), 3 reserved bytes,
+ *            uint32 base_size, uint32 target_size,
+ *            base SHA-256 (32 bytes, the hash appended to the running image,
+ *            as returned by esp_partition_get_sha256())
+ *   ops      varint (length << 1 | kind) until target_size bytes are out:
+ *            kind 0 copy: zig-zag varint base offset adjustment, then length
+ *                   bytes from the base, starting at the end of the
+ *                   previous copy plus the adjustment
+ *            kind 1 insert: length literal bytes follow
+ *
+ * A delta for any other base is refused before anything is written. The
+ * backend tool (src/eco_exoskeleton/ota_update.py) builds deltas from the
+ * deployed and new .bin of a module and checks them by applying them.
+ *
+ * Rollback (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE): a new image boots once as
+ * pending verification. It is confirmed after it has reached the broker and
+ * run for OTA_VERIFY_UPTIME_MS; if it does not reach the broker within
+ * OTA_VERIFY_TIMEOUT_MS, or resets before being confirmed, the previous
+ * image boots again. An NVS record of the update lets the image that ends
+ * up running report the outcome. The new image erases it only once it is
+ * confirmed, so the previous image still finds it after any rollback and
+ * tells one from a finished update by the record's partition label.
+ *
+ * Metrics: gauges "ota_progress_pct", "ota_download_bytes",
+ * "ota_download_ms" and "ota_image_bytes" (kept across the reboot), and
+ * counters "ota_updates", "ota_failed" and "ota_rollbacks". Progress is also
+ * sent as UPDATING status messages every OTA_PROGRESS_STEP_PCT.
+ */
+
+#ifndef OTA_TASK_STACK
+#define OTA_TASK_STACK          6144
+#endif
+#define OTA_TASK_PRIORITY       4       // Below the network task (task_config.h)
+#define OTA_BUFFER_SIZE         4096    // HTTP read and flash write chunk, each
+#define OTA_HTTP_TIMEOUT_MS     15000
+#define OTA_URL_SIZE            192
+#define OTA_PROGRESS_STEP_PCT   25      // Between UPDATING status messages
+#define OTA_RESTART_DELAY_MS    1000    // Lets the last status go out
+#ifndef OTA_VERIFY_UPTIME_MS
+#define OTA_VERIFY_UPTIME_MS    30000   // Healthy run time before confirming
+#endif
+#ifndef OTA_VERIFY_TIMEOUT_MS
+#define OTA_VERIFY_TIMEOUT_MS   300000  // No broker by then rolls back
+#endif
+
+#define OTA_DELTA_MAGIC         "EDLT"
+#define OTA_DELTA_VERSION       1
+#define OTA_DELTA_HEADER_SIZE   48
+
+/**
+ * @brief Module binding
+ */
+typedef struct {
+    const char* module;                 // Module name, for log lines
+    void (*send_status)(const char* state, const char* message);
+    bool (*busy)();                     // Actuation running: no start, no reboot
+} ota_update_config_t;
+
+/**
+ * @brief Bind OTA to the module and check the running image (at boot)
+ *
+ * Reports a rollback, or the update that booted this image, once connected.
+ * @param config Module binding (must stay valid)
+ */
+void ota_update_init(const ota_update_config_t* config);
+
+/**
+ * @brief Handle the "ota_update" command
+ *
+ * params: {"url": "http(s)://...", "version": "..."}; the optional version
+ * skips an update to the version already running.
+ *
+ * @param params Command parameters
+ * @return true if a download was started
+ */
+bool ota_update_handle_command(const cJSON* params);
+
+/**
+ * @brief Progress reports, reboot and image confirmation (network task)
+ * @param now_ms Monotonic time in milliseconds
+ * @return true while an update or a confirmation is pending (stay awake)
+ */
+bool ota_update_poll(uint32_t now_ms);
+
+#endif // OTA_UPDATE_H
@@ -0,0 +1,159 @@
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+#include <stdbool.h>
+
+/**
+ * @file pid_controller.h
+ * @brief Discrete PID controller and setpoint ramp for fixed-rate loops
+ *
+ * Derivative acts on the measurement (no kick on setpoint steps) and is
+ * low-pass filtered. The integrator stops while the output is saturated and
+ * can be back-calculated with pid_track() when another controller's output
+ * is applied instead (override / min-select control), so it never winds up.
+ */
+
+/**
+ * @brief Controller tuning
+ */
+typedef struct {
+    float kp;                   // Proportional gain (output per unit error)
+    float ki;                   // Integral gain (output per unit error-second)
+    float kd;                   // Derivative gain (output per unit/s)
+    float output_min;
+    float output_max;
+    float derivative_filter;    // Weight of each new derivative sample, 0-1 (1 = unfiltered)
+} pid_config_t;
+
+/**
+ * @brief Controller state
+ */
+typedef struct {
+    pid_config_t config;
+    float dt;                   // Loop period (s)
+    float integral;             // Integral term, in output units
+    float derivative;           // Filtered measurement derivative
+    float previous;             // Last measurement
+    float unintegrated;         // P + D + feedforward of the last update
+    float output;               // Clamped output of the last update
+    bool primed;
+} pid_controller_t;
+
+/**
+ * @brief Setpoint ramp towards a target at a bounded rate
+ */
+typedef struct {
+    float current;
+    float target;
+    float step;                 // Maximum change per loop iteration
+} setpoint_ramp_t;
+
+/**
+ * @brief Initialise a controller
+ * @param pid Pointer to controller state
+ * @param config Tuning
+ * @param dt Loop period in seconds
+ */
+static inline void pid_init(pid_controller_t* pid, const pid_config_t* config, float dt) {
+    pid->config = *config;
+    pid->dt = dt;
+    pid->integral = 0.0f;
+    pid->derivative = 0.0f;
+    pid->previous = 0.0f;
+    pid->unintegrated = 0.0f;
+    pid->output = 0.0f;
+    pid->primed = false;
+}
+
+static inline float pid_clamp(const pid_controller_t* pid, float output) {
+    if (output > pid->config.output_max) return pid->config.output_max;
+    if (output < pid->config.output_min) return pid->config.output_min;
+    return output;
+}
+
+/**
+ * @brief Run one controller iteration
+ * @param pid Pointer to controller state
+ * @param setpoint Desired value
+ * @param measurement Measured value
+ * @param feedforward Output added ahead of the feedback terms
+ * @return Clamped controller output
+ */
+static inline float pid_update(pid_controller_t* pid, float setpoint, float measurement,
+                               float feedforward) {
+    const pid_config_t* c = &pid->config;
+    float error = setpoint - measurement;
+
+    if (pid->primed) {
+        float rate = (measurement - pid->previous) / pid->dt;
+        pid->derivative += c->derivative_filter * (rate - pid->derivative);
+    }
+    pid->previous = measurement;
+    pid->primed = true;
+
+    pid->unintegrated = feedforward + c->kp * error - c->kd * pid->derivative;
+
+    // Conditional integration: only while it moves the output out of saturation
+    float candidate = pid->integral + c->ki * error * pid->dt;
+    float output = pid->unintegrated + candidate;
+    if ((output <= c->output_max || error < 0.0f) && (output >= c->output_min || error > 0.0f)) {
+        pid->integral = candidate;
+    }
+    pid->output = pid_clamp(pid, pid->unintegrated + pid->integral);
+    return pid->output;
+}
+
+/**
+ * @brief Align the integrator with the output actually applied
+ *
+ * Call after pid_update() when the applied output differs from this
+ * controller's (e.g. another loop won a min-select), for bumpless handover.
+ *
+ * @param pid Pointer to controller state
+ * @param applied Output that was applied to the plant
+ */
+static inline void pid_track(pid_controller_t* pid, float applied) {
+    // Only when overridden; our own saturation is handled in pid_update().
+    // Tracking bleeds off accumulated integral but never drives it negative,
+    // so a proportional term that alone exceeds the override cannot leave a
+    // negative bias behind once this loop takes over again.
+    if (applied < pid->output) {
+        float integral = applied - pid->unintegrated;
+        float floor = pid->integral < 0.0f ? pid->integral : 0.0f;
+        pid->integral = integral > floor ? integral : floor;
+        pid->output = applied;
+    }
+}
+
+/**
+ * @brief Start a ramp
+ * @param ramp Pointer to ramp state
+ * @param start Initial setpoint
+ * @param target Final setpoint
+ * @param rate Maximum rate (units/s)
+ * @param dt Loop period in seconds
+ */
+static inline void ramp_init(setpoint_ramp_t* ramp, float start, float target, float rate, float dt) {
+    ramp->current = start;
+    ramp->target = target;
+    ramp->step = rate * dt;
+}
+
+/**
+ * @brief Advance a ramp by one loop iteration
+ * @param ramp Pointer to ramp state
+ * @return Current setpoint
+ */
+static inline float ramp_step(setpoint_ramp_t* ramp) {
+    float remaining = ramp->target - ramp->current;
+    if (remaining > ramp->step) {
+        ramp->current += ramp->step;
+    } else if (remaining < -ramp->step) {
+        ramp->current -= ramp->step;
+    } else {
+        ramp->current = ramp->target;
+    }
+    return ramp->current;
+}
+
+#endif // PID_CONTROLLER_H
@@ -0,0 +1,194 @@
+#include "power_manager.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "actuator_task.h"
+#include "offline_queue.h"
+#include <string.h>
+#include <esp_attr.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define POWER_RTC_MAGIC 0x50575232      // "PWR2"
+
+// Retained across deep sleep; reinitialised after any other reset
+typedef struct {
+    uint32_t magic;
+    int64_t uptime_us;                  // Time base at wake (sum of awake and sleep time)
+    uint32_t next_sample_ms;            // When the next sample is due
+    uint16_t count;                     // Retained samples
+    telemetry_sample_t samples[POWER_RTC_SAMPLES];
+} power_rtc_state_t;
+
+static RTC_DATA_ATTR power_rtc_state_t rtc_state;
+
+static const power_config_t* power_config = nullptr;
+static power_mode_t active_mode = POWER_MODE_ACTIVE;
+static bool resumed = false;
+
+// Microseconds on a time base that keeps counting through deep sleep
+static int64_t now_us() {
+    return rtc_state.uptime_us + esp_timer_get_time();
+}
+
+static uint32_t now_ms() {
+    return (uint32_t)(now_us() / 1000);
+}
+
+// ==================== Scheduling ====================
+
+static power_mode_t resolve_mode(const power_config_t* config) {
+    if (config->mode != POWER_MODE_AUTO) {
+        return config->mode;
+    }
+    return config->sample_period_ms >= POWER_DEEP_SLEEP_MIN_PERIOD_MS
+        ? POWER_MODE_DEEP_SLEEP : POWER_MODE_LIGHT_SLEEP;
+}
+
+// Samples to retain before a wake brings WiFi up
+static uint16_t samples_per_publish(const power_config_t* config) {
+    uint32_t samples = config->publish_interval_ms / config->sample_period_ms;
+    if (samples < 1) return 1;
+    if (samples > POWER_RTC_SAMPLES) return POWER_RTC_SAMPLES;
+    return (uint16_t)samples;
+}
+
+static void deep_sleep() {
+    uint32_t now = now_ms();
+    int32_t sleep_ms = (int32_t)(rtc_state.next_sample_ms - now);
+    if (sleep_ms < POWER_BURST_SPACING_MS) {
+        sleep_ms = POWER_BURST_SPACING_MS;
+    }
+
+    DebugHelper::info("Power: deep sleep for %ld ms (%u samples retained)",
+                      (long)sleep_ms, (unsigned)rtc_state.count);
+    DebugHelper::flush();
+    esp_wifi_stop();
+
+    rtc_state.uptime_us = now_us() + (int64_t)sleep_ms * 1000;
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000);
+    esp_deep_sleep_start();
+}
+
+// ==================== Deep Sleep Sampling ====================
+
+// Run the callback a few times so the module's filters settle; keep the last
+static void take_sample(acquisition_callback_t callback) {
+    telemetry_sample_t sample = {};
+    for (int i = 0; i < POWER_BURST_SAMPLES; i++) {
+        if (i > 0) {
+            vTaskDelay(POWER_BURST_SPACING_MS / portTICK_PERIOD_MS);
+        }
+        callback(&sample);
+    }
+    sample.timestamp_us = now_us();
+
+    // Full (publishing kept failing): drop the oldest
+    if (rtc_state.count == POWER_RTC_SAMPLES) {
+        memmove(&rtc_state.samples[0], &rtc_state.samples[1],
+                (POWER_RTC_SAMPLES - 1) * sizeof(telemetry_sample_t));
+        rtc_state.count--;
+    }
+    rtc_state.samples[rtc_state.count++] = sample;
+    rtc_state.next_sample_ms = (uint32_t)(sample.timestamp_us / 1000) + power_config->sample_period_ms;
+}
+
+static bool begin_deep_sleep(acquisition_callback_t callback) {
+    resumed = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+              rtc_state.magic == POWER_RTC_MAGIC;
+    if (!resumed) {
+        memset(&rtc_state, 0, sizeof(rtc_state));
+        rtc_state.magic = POWER_RTC_MAGIC;
+    }
+
+    take_sample(callback);
+
+    // Nothing to publish yet: back to sleep without touching WiFi. A reset
+    // always connects, to report the module's startup.
+    if (resumed && rtc_state.count < samples_per_publish(power_config)) {
+        deep_sleep();
+    }
+
+    // Publish everything retained as one batch. Retained times move to this
+    // boot's esp_timer base (earlier wakes are negative), which time_sync.h
+    // maps to Unix time with the system time kept through deep sleep.
+    telemetry_batch_t* batch = power_config->batch;
+    telemetry_batch_configure(batch, rtc_state.count, 0);
+    for (uint16_t i = 0; i < rtc_state.count; i++) {
+        const telemetry_sample_t* sample = &rtc_state.samples[i];
+        telemetry_batch_push(batch, sample->timestamp_us - rtc_state.uptime_us, sample->values,
+                             sample->bools);
+    }
+    rtc_state.count = 0;
+    return true;
+}
+
+// ==================== Public API ====================
+
+bool power_manager_begin(const power_config_t* config, acquisition_callback_t callback) {
+    power_config = config;
+    active_mode = resolve_mode(config);
+
+    switch (active_mode) {
+        case POWER_MODE_DEEP_SLEEP:
+            DebugHelper::info("Power: deep sleep, sample every %lu ms, publish every %u samples",
+                              (unsigned long)config->sample_period_ms,
+                              (unsigned)samples_per_publish(config));
+            return begin_deep_sleep(callback);
+
+        case POWER_MODE_LIGHT_SLEEP: {
+            esp_pm_config_t pm_config = {};
+            pm_config.max_freq_mhz = POWER_CPU_MAX_MHZ;
+            pm_config.min_freq_mhz = POWER_CPU_MIN_MHZ;
+            pm_config.light_sleep_enable = true;
+            if (esp_pm_configure(&pm_config) != ESP_OK) {
+                DebugHelper::warning("Power: automatic light sleep unavailable (CONFIG_PM_ENABLE)");
+            }
+            mqtt_helper_set_power_save(true, POWER_LISTEN_INTERVAL);
+            DebugHelper::info("Power: light sleep, WiFi listen interval %d", POWER_LISTEN_INTERVAL);
+            break;
+        }
+
+        default:
+            break;
+    }
+    return sensor_acquisition_start(config->sample_period_ms * 1000, callback);
+}
+
+void power_manager_poll(uint32_t now_ms) {
+    if (active_mode != POWER_MODE_DEEP_SLEEP || actuator_busy()) {
+        return;
+    }
+
+    if (now_ms < POWER_MIN_AWAKE_MS) {
+        return;
+    }
+    bool delivered = power_config->batch->count == 0 &&
+                     mqtt_helper_is_connected() &&
+                     mqtt_helper_outbox_size() == 0 &&
+                     offline_queue_stats().pending == 0;
+    if (!delivered && now_ms < POWER_MAX_AWAKE_MS) {
+        return;
+    }
+
+    // Whatever is left goes to flash and is replayed on a later wake
+    telemetry_batch_flush(power_config->batch, now_ms, true);
+    offline_queue_persist();
+    deep_sleep();
+}
+
+void power_manager_idle() {
+    uint32_t period_ms = active_mode == POWER_MODE_ACTIVE ? 10 : POWER_LOOP_PERIOD_MS;
+    vTaskDelay(period_ms / portTICK_PERIOD_MS);
+}
+
+power_mode_t power_manager_mode() {
+    return active_mode;
+}
+
+bool power_manager_resumed() {
+    return resumed;
+}
@@ -0,0 +1,110 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensor_acquisition.h"
+#include "telemetry_batch.h"
+
+/**
+ * @file power_manager.h
+ * @brief Duty-cycled sampling with light or deep sleep between samples
+ *
+ * Owns the start of a module's sampling and decides how the module sleeps,
+ * based on its sampling period and how soon samples must be published:
+ *  - ACTIVE:      always awake, as before (fixed-rate acquisition task)
+ *  - LIGHT_SLEEP: same acquisition task, but the CPU light-sleeps whenever
+ *                 idle (esp_pm, needs CONFIG_PM_ENABLE and tickless idle) and
+ *                 WiFi uses max modem sleep, waking every POWER_LISTEN_INTERVAL
+ *                 beacons (DTIM)
+ *  - DEEP_SLEEP:  every wake takes one sample (the last of a short burst, so
+ *                 the filters settle) and stores it in RTC memory. WiFi is only
+ *                 started once publish_interval_ms worth of samples is
+ *                 retained; they are then published as one batch and the chip
+ *                 goes back to deep sleep until the next sample is due
+ *  - AUTO:        DEEP_SLEEP for periods of POWER_DEEP_SLEEP_MIN_PERIOD_MS or
+ *                 more (where a boot is cheaper than staying up), else LIGHT_SLEEP
+ *
+ * In deep sleep the module is off: commands are only received while awake
+ * (build with MQTT_HELPER_PERSISTENT_SESSION=1 so the broker keeps them), and
+ * it never sleeps while an actuation is in progress. Samples that cannot be
+ * published before sleeping are kept by the offline queue in flash.
+ */
+
+typedef enum {
+    POWER_MODE_ACTIVE,
+    POWER_MODE_LIGHT_SLEEP,
+    POWER_MODE_DEEP_SLEEP,
+    POWER_MODE_AUTO
+} power_mode_t;
+
+// Default mode, overridable per module target (-DPOWER_MODE=POWER_MODE_AUTO)
+#ifndef POWER_MODE
+#define POWER_MODE POWER_MODE_ACTIVE
+#endif
+
+#ifndef POWER_PUBLISH_INTERVAL_MS
+#define POWER_PUBLISH_INTERVAL_MS 300000    // Deep sleep: samples retained per WiFi wake
+#endif
+
+#define POWER_DEEP_SLEEP_MIN_PERIOD_MS 30000  // AUTO: shortest period worth a deep sleep
+#define POWER_RTC_SAMPLES       32      // Samples retained across deep sleep
+#define POWER_BURST_SAMPLES     8       // Callback runs per deep-sleep wake
+#define POWER_BURST_SPACING_MS  10
+#define POWER_MIN_AWAKE_MS      500     // Stay up for commands the broker held
+#define POWER_MAX_AWAKE_MS      15000   // Give up on delivery and sleep
+#define POWER_LISTEN_INTERVAL   3       // Beacons between WiFi wakes in light sleep
+#define POWER_CPU_MAX_MHZ       160
+#define POWER_CPU_MIN_MHZ       40
+#define POWER_LOOP_PERIOD_MS    100     // Network task period when sleeping
+
+/**
+ * @brief Module sampling requirements
+ */
+typedef struct {
+    power_mode_t mode;
+    uint32_t sample_period_ms;          // Time between samples
+    uint32_t publish_interval_ms;       // Longest a sample may wait to be published
+    telemetry_batch_t* batch;           // Batch the module publishes from
+} power_config_t;
+
+/**
+ * @brief Apply the power mode and start sampling
+ *
+ * Replaces sensor_acquisition_start(). Call after the hardware is set up and
+ * before connecting to WiFi: in deep sleep mode, a wake with no publish due
+ * samples and goes straight back to sleep without returning.
+ *
+ * @param config Sampling requirements (must stay valid)
+ * @param callback Module sampling callback
+ * @return true if sampling was started
+ */
+bool power_manager_begin(const power_config_t* config, acquisition_callback_t callback);
+
+/**
+ * @brief Enter deep sleep once the wake's work is done (network task)
+ *
+ * Sleeps when the retained samples are delivered and the offline queue is
+ * empty, or after POWER_MAX_AWAKE_MS.
+ *
+ * @param now_ms Milliseconds since boot (esp_timer)
+ */
+void power_manager_poll(uint32_t now_ms);
+
+/**
+ * @brief Wait for the next network task iteration
+ */
+void power_manager_idle();
+
+/**
+ * @brief Mode in effect (AUTO resolved)
+ */
+power_mode_t power_manager_mode();
+
+/**
+ * @brief Whether this boot is a wake from deep sleep rather than a reset
+ */
+bool power_manager_resumed();
+
+#endif // POWER_MANAGER_H
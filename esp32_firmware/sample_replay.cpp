@@ -0,0 +1,387 @@
+#include "sample_replay.h"
+#include "sensor_acquisition.h"
+#include "offline_queue.h"
+#include "telemetry_frame.h"
+#include "telemetry_codec.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "json_arena.h"
+#include "time_sync.h"
+#include <atomic>
+#include <new>
+#include <string.h>
+
+#define SWEEP_FRAMES 256                // Built-in recording length
+#define SWEEP_FULL_SCALE 4095           // 12-bit ADC
+
+// Full-scale triangle per channel, channels a quarter period apart; flags
+// count up every 16 frames
+typedef struct {
+    uint16_t raw[SWEEP_FRAMES * SAMPLE_REPLAY_MAX_CHANNELS];
+    uint8_t flags[SWEEP_FRAMES];
+} sweep_table_t;
+
+static constexpr sweep_table_t make_sweep() {
+    sweep_table_t table = {};
+    for (size_t frame = 0; frame < SWEEP_FRAMES; frame++) {
+        for (size_t channel = 0; channel < SAMPLE_REPLAY_MAX_CHANNELS; channel++) {
+            size_t phase = (frame + channel * SWEEP_FRAMES / 4) % SWEEP_FRAMES;
+            size_t level = phase < SWEEP_FRAMES / 2 ? phase : SWEEP_FRAMES - phase;
+            table.raw[frame * SAMPLE_REPLAY_MAX_CHANNELS + channel] =
+                (uint16_t)(level * SWEEP_FULL_SCALE / (SWEEP_FRAMES / 2));
+        }
+        table.flags[frame] = (uint8_t)(frame / 16);
+    }
+    return table;
+}
+
+static constexpr sweep_table_t SWEEP = make_sweep();
+static const sample_replay_recording_t SWEEP_RECORDING = {
+    SAMPLE_REPLAY_MAX_CHANNELS, SWEEP_FRAMES, SWEEP.raw, SWEEP.flags};
+
+static const char* SOURCE_NAMES[] = {"embedded", "mqtt"};
+
+typedef enum {
+    PHASE_IDLE,
+    PHASE_SETTLING,                     // Rate just changed, not counted
+    PHASE_MEASURING
+} replay_phase_t;
+
+// Cumulative counters, differenced over a measurement window
+typedef struct {
+    uint32_t samples;
+    uint32_t messages;
+    uint32_t overruns;
+    uint32_t missed_ticks;
+    uint32_t overwritten;
+    uint32_t offline;
+} replay_counters_t;
+
+static const sample_replay_config_t* replay_config = nullptr;
+
+// Shared with the acquisition task
+static std::atomic<bool> active{false};
+static const sample_replay_recording_t* recording = nullptr;   // Set before active
+static size_t frame_index = 0;                                  // Acquisition task only
+
+// RAM recording (MQTT task, while no run is active)
+static uint16_t* upload_raw = nullptr;
+static uint8_t* upload_flags = nullptr;
+static sample_replay_recording_t upload = {};
+
+// Requests from the command handler, picked up by the network task
+static sample_replay_plan_t pending_plan;
+static std::atomic<bool> start_pending{false};
+static std::atomic<bool> stop_pending{false};
+
+// Run state (network task only)
+static replay_phase_t phase = PHASE_IDLE;
+static sample_replay_plan_t plan;
+static uint32_t rate_hz = 0;
+static uint32_t step = 0;
+static uint32_t phase_end_ms = 0;
+static uint32_t window_start_ms = 0;
+static replay_counters_t window_start;
+static uint32_t samples_published = 0;
+static uint32_t messages_published = 0;
+static uint32_t best_rate_hz = 0;
+static float best_samples_per_sec = 0;
+static float best_messages_per_sec = 0;
+
+// ==================== Measurement ====================
+
+static replay_counters_t read_counters() {
+    offline_queue_stats_t offline = offline_queue_stats();
+    return {samples_published, messages_published,
+            sensor_acquisition_overruns(), sensor_acquisition_missed_ticks(),
+            replay_config->batch->dropped, offline.stored + offline.skipped};
+}
+
+static void publish_report(cJSON* report) {
+    JsonArenaScope arena;
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "module", replay_config->module);
+    cJSON_AddItemToObject(json, "replay", report);
+    cJSON_AddNumberToObject(json, "timestamp", (double)time_sync_now_ms());
+
+    char* json_string = json_print(json, false);
+    if (json_string != nullptr) {
+        mqtt_helper_publish(replay_config->report_topic, json_string);
+        cJSON_free(json_string);
+    }
+    cJSON_Delete(json);
+}
+
+static void set_rate(uint32_t hz, uint32_t now_ms) {
+    rate_hz = hz;
+    sensor_acquisition_set_period(1000000 / hz);
+    phase = PHASE_SETTLING;
+    phase_end_ms = now_ms + SAMPLE_REPLAY_SETTLE_MS;
+}
+
+static void finish(const char* limit, uint32_t now_ms) {
+    active.store(false, std::memory_order_release);
+    phase = PHASE_IDLE;
+    telemetry_batch_set_report_all(replay_config->batch, false);
+    if (replay_config->finished != nullptr) {
+        replay_config->finished();
+    }
+
+    cJSON* report = cJSON_CreateObject();
+    cJSON_AddStringToObject(report, "event", "summary");
+    cJSON_AddStringToObject(report, "source", SOURCE_NAMES[plan.source]);
+    cJSON_AddNumberToObject(report, "steps", step);
+    cJSON_AddNumberToObject(report, "max_rate_hz", best_rate_hz);
+    cJSON_AddNumberToObject(report, "max_samples_per_sec", best_samples_per_sec);
+    cJSON_AddNumberToObject(report, "max_messages_per_sec", best_messages_per_sec);
+    cJSON_AddStringToObject(report, "limit", limit);
+    cJSON_AddStringToObject(report, "format",
+                            telemetry_get_format() == TELEMETRY_FORMAT_BINARY ? "binary" : "json");
+    cJSON_AddStringToObject(report, "codec", telemetry_codec_name(telemetry_get_codec()));
+    cJSON_AddNumberToObject(report, "batch_size", replay_config->batch->batch_size);
+    publish_report(report);
+
+    DebugHelper::info("Replay finished (%s): %.0f samples/s, %.1f messages/s sustained",
+                      limit, best_samples_per_sec, best_messages_per_sec);
+}
+
+// End of a measurement window: report it, then step up or stop at the first loss
+static void end_step(uint32_t now_ms) {
+    replay_counters_t end = read_counters();
+    float seconds = (now_ms - window_start_ms) / 1000.0f;
+    float samples_per_sec = (end.samples - window_start.samples) / seconds;
+    float messages_per_sec = (end.messages - window_start.messages) / seconds;
+    uint32_t overruns = end.overruns - window_start.overruns;
+    uint32_t missed_ticks = end.missed_ticks - window_start.missed_ticks;
+    uint32_t overwritten = end.overwritten - window_start.overwritten;
+    uint32_t offline = end.offline - window_start.offline;
+    step++;
+
+    cJSON* report = cJSON_CreateObject();
+    cJSON_AddStringToObject(report, "event", "step");
+    cJSON_AddNumberToObject(report, "step", step);
+    cJSON_AddNumberToObject(report, "rate_hz", rate_hz);
+    cJSON_AddNumberToObject(report, "samples_per_sec", samples_per_sec);
+    cJSON_AddNumberToObject(report, "messages_per_sec", messages_per_sec);
+    cJSON* lost = cJSON_AddObjectToObject(report, "lost");
+    cJSON_AddNumberToObject(lost, "overruns", overruns);
+    cJSON_AddNumberToObject(lost, "missed_ticks", missed_ticks);
+    cJSON_AddNumberToObject(lost, "batch_overwrites", overwritten);
+    cJSON_AddNumberToObject(lost, "offline", offline);
+    publish_report(report);
+
+    DebugHelper::info("Replay step %lu at %lu Hz: %.0f samples/s, %.1f messages/s",
+                      (unsigned long)step, (unsigned long)rate_hz, samples_per_sec, messages_per_sec);
+
+    const char* limit = overruns > 0      ? "overruns"
+                      : missed_ticks > 0  ? "missed_ticks"
+                      : overwritten > 0   ? "batch_overwrites"
+                      : offline > 0       ? "offline"
+                      : nullptr;
+    if (limit != nullptr) {
+        finish(limit, now_ms);
+        return;
+    }
+
+    best_rate_hz = rate_hz;
+    best_samples_per_sec = samples_per_sec;
+    best_messages_per_sec = messages_per_sec;
+    if (plan.step_hz == 0 || plan.max_hz - rate_hz < plan.step_hz) {    // rate_hz <= max_hz
+        finish(plan.step_hz == 0 ? "none" : "max_rate", now_ms);
+        return;
+    }
+    set_rate(rate_hz + plan.step_hz, now_ms);
+}
+
+static void begin(uint32_t now_ms) {
+    plan = pending_plan;
+    recording = plan.source == SAMPLE_REPLAY_MQTT ? &upload
+              : replay_config->recording != nullptr ? replay_config->recording
+              : &SWEEP_RECORDING;
+    frame_index = 0;
+    step = 0;
+    best_rate_hz = 0;
+    best_samples_per_sec = 0;
+    best_messages_per_sec = 0;
+
+    // Every sample is published, so each one exercises the whole path
+    telemetry_batch_set_report_all(replay_config->batch, true);
+    active.store(true, std::memory_order_release);
+    set_rate(plan.start_hz, now_ms);
+
+    DebugHelper::info("Replay of %u %s frames from %lu Hz", (unsigned)recording->frame_count,
+                      SOURCE_NAMES[plan.source], (unsigned long)plan.start_hz);
+}
+
+// ==================== Public API ====================
+
+bool sample_replay_init(const sample_replay_config_t* config) {
+    if (config->channel_count > SAMPLE_REPLAY_MAX_CHANNELS ||
+        (config->recording != nullptr && config->recording->channel_count < config->channel_count)) {
+        DebugHelper::error("Replay: recording does not cover %u channels",
+                           (unsigned)config->channel_count);
+        return false;
+    }
+    replay_config = config;
+    return true;
+}
+
+bool sample_replay_start(const sample_replay_plan_t* new_plan) {
+    if (replay_config == nullptr || active.load() || start_pending.load()) {
+        DebugHelper::warning("Replay: already running");
+        return false;
+    }
+    if (new_plan->start_hz == 0 || new_plan->max_hz > SAMPLE_REPLAY_MAX_RATE_HZ ||
+        new_plan->start_hz > new_plan->max_hz || new_plan->step_ms == 0) {
+        DebugHelper::warning("Replay: rates must be within 1..%d Hz", SAMPLE_REPLAY_MAX_RATE_HZ);
+        return false;
+    }
+    if (new_plan->source == SAMPLE_REPLAY_MQTT && upload.frame_count == 0) {
+        DebugHelper::warning("Replay: nothing uploaded");
+        return false;
+    }
+    pending_plan = *new_plan;
+    stop_pending.store(false);
+    start_pending.store(true);
+    return true;
+}
+
+bool sample_replay_handle_command(const cJSON* params) {
+    const char* source = cJSON_GetStringValue(cJSON_GetObjectItem(params, "source"));
+    if (source != nullptr && strcmp(source, "stop") == 0) {
+        sample_replay_stop();
+        return true;
+    }
+
+    sample_replay_plan_t new_plan;
+    if (source == nullptr || strcmp(source, "embedded") == 0) {
+        new_plan.source = SAMPLE_REPLAY_EMBEDDED;
+    } else if (strcmp(source, "mqtt") == 0) {
+        new_plan.source = SAMPLE_REPLAY_MQTT;
+    } else {
+        DebugHelper::warning("Replay: unknown source %s", source);
+        return false;
+    }
+
+    cJSON* rate = cJSON_GetObjectItem(params, "rate_hz");
+    cJSON* step_hz = cJSON_GetObjectItem(params, "step_hz");
+    cJSON* max_hz = cJSON_GetObjectItem(params, "max_hz");
+    cJSON* step_ms = cJSON_GetObjectItem(params, "step_ms");
+    // Negative values would wrap as uint32_t; step_hz 0 means a single rate
+    if (!cJSON_IsNumber(rate) || rate->valuedouble < 1 ||
+        (cJSON_IsNumber(step_hz) && step_hz->valuedouble < 0) ||
+        (cJSON_IsNumber(max_hz) && max_hz->valuedouble < 1) ||
+        (cJSON_IsNumber(step_ms) && step_ms->valuedouble < 1)) {
+        DebugHelper::warning("Replay: rate_hz, max_hz and step_ms must be positive, step_hz not negative");
+        return false;
+    }
+    new_plan.start_hz = cJSON_IsNumber(rate) ? (uint32_t)rate->valueint : 0;
+    new_plan.step_hz = cJSON_IsNumber(step_hz) ? (uint32_t)step_hz->valueint : 0;
+    new_plan.max_hz = cJSON_IsNumber(max_hz) ? (uint32_t)max_hz->valueint
+                    : new_plan.step_hz > 0 ? SAMPLE_REPLAY_MAX_RATE_HZ
+                    : new_plan.start_hz;
+    new_plan.step_ms = cJSON_IsNumber(step_ms) ? (uint32_t)step_ms->valueint : SAMPLE_REPLAY_STEP_MS;
+    return sample_replay_start(&new_plan);
+}
+
+void sample_replay_stop() {
+    start_pending.store(false);
+    stop_pending.store(true);
+}
+
+void sample_replay_upload(const uint8_t* data, size_t length) {
+    if (replay_config == nullptr || active.load() || start_pending.load()) {
+        DebugHelper::warning("Replay: upload ignored during a run");
+        return;
+    }
+    if (length == 0) {
+        upload.frame_count = 0;
+        return;
+    }
+
+    uint8_t channel_count = replay_config->channel_count;
+    size_t frame_size = channel_count * 2 + 1;
+    if (length % frame_size != 0) {
+        DebugHelper::warning("Replay: upload of %u bytes is not whole %u-byte frames",
+                             (unsigned)length, (unsigned)frame_size);
+        return;
+    }
+    if (upload_raw == nullptr) {
+        upload_raw = new (std::nothrow) uint16_t[SAMPLE_REPLAY_UPLOAD_FRAMES * channel_count];
+        upload_flags = new (std::nothrow) uint8_t[SAMPLE_REPLAY_UPLOAD_FRAMES];
+        if (upload_raw == nullptr || upload_flags == nullptr) {
+            DebugHelper::error("Replay: no memory for the upload buffer");
+            delete[] upload_raw;
+            delete[] upload_flags;
+            upload_raw = nullptr;
+            upload_flags = nullptr;
+            return;
+        }
+        upload = {channel_count, 0, upload_raw, upload_flags};
+    }
+
+    size_t frames = length / frame_size;
+    if (upload.frame_count + frames > SAMPLE_REPLAY_UPLOAD_FRAMES) {
+        DebugHelper::warning("Replay: upload full at %d frames", SAMPLE_REPLAY_UPLOAD_FRAMES);
+        frames = SAMPLE_REPLAY_UPLOAD_FRAMES - upload.frame_count;
+    }
+    for (size_t i = 0; i < frames; i++, data += frame_size) {
+        uint16_t* raw = &upload_raw[(upload.frame_count + i) * channel_count];
+        for (uint8_t c = 0; c < channel_count; c++) {
+            raw[c] = (uint16_t)(data[c * 2] | (data[c * 2 + 1] << 8));
+        }
+        upload_flags[upload.frame_count + i] = data[channel_count * 2];
+    }
+    upload.frame_count += frames;
+}
+
+bool sample_replay_next(sensor_value_t* raw, uint8_t* flags) {
+    if (!active.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (frame_index >= recording->frame_count) {
+        frame_index = 0;
+    }
+    const uint16_t* frame = &recording->raw[frame_index * recording->channel_count];
+    for (uint8_t c = 0; c < replay_config->channel_count; c++) {
+        raw[c] = (sensor_value_t)frame[c];
+    }
+    *flags = recording->flags != nullptr ? recording->flags[frame_index] : 0;
+    frame_index++;
+    return true;
+}
+
+void sample_replay_count_published(size_t samples) {
+    samples_published += samples;
+    messages_published++;
+}
+
+bool sample_replay_poll(uint32_t now_ms) {
+    if (start_pending.exchange(false)) {
+        begin(now_ms);
+    }
+    if (phase == PHASE_IDLE) {
+        return false;
+    }
+    if (stop_pending.exchange(false)) {
+        finish("stopped", now_ms);
+        return false;
+    }
+    if ((int32_t)(now_ms - phase_end_ms) < 0) {
+        return true;
+    }
+
+    if (phase == PHASE_SETTLING) {
+        window_start = read_counters();
+        window_start_ms = now_ms;
+        phase = PHASE_MEASURING;
+        phase_end_ms = now_ms + plan.step_ms;
+        return true;
+    }
+    end_step(now_ms);
+    return phase != PHASE_IDLE;
+}
+
+bool sample_replay_active() {
+    return active.load();
+}
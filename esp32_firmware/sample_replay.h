@@ -0,0 +1,156 @@
+#ifndef SAMPLE_REPLAY_H
+#define SAMPLE_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+#include "sensor_value.h"
+#include "telemetry_batch.h"
+
+/**
+ * @file sample_replay.h
+ * @brief Recorded sample replay and telemetry load generator
+ *
+ * Replay substitutes recorded raw readings for the ADC/GPIO reads of the
+ * sampling callback, so the recording goes through the module's filters,
+ * calibration, batching and publishing exactly like live data. Control loops
+ * keep reading the real sensors.
+ *
+ * Recordings are frame-major raw values (one uint16_t per channel) plus one
+ * flag byte per frame. Two sources:
+ *  - embedded: a const recording in flash (the module's, or the built-in
+ *    sweep that crosses every deadband)
+ *  - mqtt: frames uploaded on exoskeleton/<module>/replay into RAM; each
+ *    message carries whole frames of channel_count little-endian uint16_t
+ *    values and a flag byte, an empty message clears the upload
+ * Either way the recording is looped, so the only broker traffic during a
+ * run is the telemetry being measured.
+ *
+ * A run ramps the acquisition rate from start_hz by step_hz up to max_hz.
+ * Each step settles, then counts published samples and messages for step_ms
+ * along with every way a sample can be lost: acquisition overruns and missed
+ * ticks, batch ring overwrites, and messages diverted to the offline queue
+ * (broker or link not keeping up). The first lossy step ends the run; the
+ * last clean step is the maximum sustained rate. Step results and the
+ * summary are published as JSON on the report topic.
+ *
+ * While a run is active the deadband is bypassed and the adaptive rate and
+ * deep sleep are held off; the finished callback hands the rate back.
+ */
+
+#define SAMPLE_REPLAY_MAX_CHANNELS   TELEMETRY_BATCH_MAX_FLOATS
+#define SAMPLE_REPLAY_UPLOAD_FRAMES  1024       // RAM recording capacity
+#define SAMPLE_REPLAY_MAX_RATE_HZ    5000       // 200 us acquisition period
+#define SAMPLE_REPLAY_SETTLE_MS      500        // Ignored after each rate change
+#ifndef SAMPLE_REPLAY_STEP_MS
+#define SAMPLE_REPLAY_STEP_MS        5000       // Default measurement window
+#endif
+
+/**
+ * @brief Recorded raw sample stream
+ */
+typedef struct {
+    uint8_t channel_count;              // Values per frame (>= the module's channels)
+    size_t frame_count;
+    const uint16_t* raw;                // frame_count * channel_count raw readings
+    const uint8_t* flags;               // frame_count flag bytes, nullptr for none
+} sample_replay_recording_t;
+
+/**
+ * @brief Where replayed frames come from
+ */
+typedef enum {
+    SAMPLE_REPLAY_EMBEDDED,
+    SAMPLE_REPLAY_MQTT
+} sample_replay_source_t;
+
+/**
+ * @brief Rate ramp of one run
+ */
+typedef struct {
+    sample_replay_source_t source;
+    uint32_t start_hz;
+    uint32_t step_hz;                   // 0 = single step at start_hz
+    uint32_t max_hz;
+    uint32_t step_ms;                   // Measurement window per step
+} sample_replay_plan_t;
+
+/**
+ * @brief Module binding
+ */
+typedef struct {
+    const char* module;                 // "module" field of reports
+    const char* report_topic;           // Step and summary reports (must stay valid)
+    uint8_t channel_count;              // Raw values used per frame
+    const sample_replay_recording_t* recording;  // Embedded recording, nullptr for the sweep
+    telemetry_batch_t* batch;           // Deadband bypassed, overwrites counted
+    void (*finished)();                 // Network task, after the rate is released
+} sample_replay_config_t;
+
+/**
+ * @brief Bind replay to the module (before the first command)
+ * @param config Module binding (must stay valid)
+ * @return true if the channel layout is supported
+ */
+bool sample_replay_init(const sample_replay_config_t* config);
+
+/**
+ * @brief Start a run
+ * @param plan Rate ramp
+ * @return true if the run started
+ */
+bool sample_replay_start(const sample_replay_plan_t* plan);
+
+/**
+ * @brief Handle the "replay" command
+ *
+ * params: {"source": "embedded"|"mqtt"|"stop", "rate_hz", "step_hz",
+ * "max_hz", "step_ms"}; rate_hz alone measures a single rate. A missing or
+ * non-positive rate_hz, a negative step_hz or a non-positive max_hz/step_ms
+ * rejects the command.
+ *
+ * @param params Command parameters
+ * @return true if a run was started or stopped
+ */
+bool sample_replay_handle_command(const cJSON* params);
+
+/**
+ * @brief End the current run early (its summary is still published)
+ */
+void sample_replay_stop();
+
+/**
+ * @brief Append uploaded frames to the RAM recording (replay topic handler)
+ * @param data Whole frames, empty to clear the upload
+ * @param length Payload length
+ */
+void sample_replay_upload(const uint8_t* data, size_t length);
+
+/**
+ * @brief Next recorded frame, in place of the sensor reads (acquisition task)
+ * @param raw channel_count raw values
+ * @param flags Flag bits
+ * @return false when no run is active (read the sensors)
+ */
+bool sample_replay_next(sensor_value_t* raw, uint8_t* flags);
+
+/**
+ * @brief Count a telemetry_batch_flush() result (network task)
+ * @param samples Samples in the published message
+ */
+void sample_replay_count_published(size_t samples);
+
+/**
+ * @brief Advance the ramp and publish reports (network task)
+ * @param now_ms Current time in milliseconds
+ * @return true while a run owns the sampling rate
+ */
+bool sample_replay_poll(uint32_t now_ms);
+
+/**
+ * @brief Whether a run is active
+ */
+bool sample_replay_active();
+
+#endif // SAMPLE_REPLAY_H
@@ -0,0 +1,145 @@
+#include "sensor_acquisition.h"
+#include "spsc_queue.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include <esp_attr.h>
+#include <atomic>
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static SpscQueue<telemetry_sample_t, ACQUISITION_QUEUE_LENGTH> sample_queue;
+static acquisition_callback_t sample_callback = nullptr;
+static TaskHandle_t acquisition_task = nullptr;
+static esp_timer_handle_t acquisition_timer = nullptr;
+static std::atomic<uint32_t> acquisition_period_us{0};     // 0 while stopped; read by the task
+
+// Written by the acquisition task only, read anywhere
+static std::atomic<uint32_t> overruns{0};
+static std::atomic<uint32_t> missed_ticks{0};
+static int64_t last_tick_us = 0;
+static uint32_t last_period_us = 0;
+
+// esp_timer callback: keep it minimal, the task does the work. With ISR
+// dispatch it runs in the timer interrupt on APP_CPU, not on the esp_timer
+// task that shares PRO_CPU with WiFi.
+static void IRAM_ATTR acquisition_timer_cb(void* arg) {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(acquisition_task, &woken);
+    if (woken == pdTRUE) {
+        esp_timer_isr_dispatch_need_yield();
+    }
+#else
+    xTaskNotifyGive(acquisition_task);
+#endif
+}
+
+static void acquisition_task_fn(void* pvParameter) {
+    while (1) {
+        // Each notification is one tick; more than one means we fell behind
+        uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (ticks > 1) {
+            missed_ticks.fetch_add(ticks - 1, std::memory_order_relaxed);
+        }
+
+        // Tick deviation from the period (skipped across a period change)
+        int64_t now_us = esp_timer_get_time();
+        uint32_t period_us = acquisition_period_us.load(std::memory_order_relaxed);
+        if (last_tick_us != 0 && period_us == last_period_us) {
+            int64_t deviation = now_us - last_tick_us - period_us;
+            metrics_record(METRIC_SAMPLE_JITTER, (uint32_t)(deviation < 0 ? -deviation : deviation));
+        }
+        last_tick_us = now_us;
+        last_period_us = period_us;
+
+        telemetry_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.timestamp_us = now_us;
+        sample_callback(&sample);
+
+        if (!sample_queue.push(sample)) {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool sensor_acquisition_start(uint32_t period_us, acquisition_callback_t callback) {
+    sample_callback = callback;
+
+    if (acquisition_task == nullptr) {
+        if (xTaskCreatePinnedToCore(acquisition_task_fn, "acquisition_task", ACQUISITION_TASK_STACK,
+                                    nullptr, ACQUISITION_TASK_PRIORITY, &acquisition_task,
+                                    ACQUISITION_TASK_CORE) != pdPASS) {
+            DebugHelper::error("Failed to create acquisition task");
+            return false;
+        }
+        metrics_watch_task("acquisition", acquisition_task);
+    }
+
+    if (acquisition_timer == nullptr) {
+        esp_timer_create_args_t timer_args = {};
+        timer_args.callback = acquisition_timer_cb;
+        timer_args.name = "acquisition";
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        timer_args.dispatch_method = ESP_TIMER_ISR;
+#endif
+        if (esp_timer_create(&timer_args, &acquisition_timer) != ESP_OK) {
+            DebugHelper::error("Failed to create acquisition timer");
+            return false;
+        }
+    } else {
+        esp_timer_stop(acquisition_timer);
+    }
+
+    if (esp_timer_start_periodic(acquisition_timer, period_us) != ESP_OK) {
+        DebugHelper::error("Failed to start acquisition timer");
+        return false;
+    }
+
+    acquisition_period_us.store(period_us, std::memory_order_relaxed);
+    DebugHelper::info("Sensor acquisition started: period %lu us", (unsigned long)period_us);
+    return true;
+}
+
+void sensor_acquisition_set_period(uint32_t period_us) {
+    uint32_t current_us = acquisition_period_us.load(std::memory_order_relaxed);
+    if (current_us == 0 || period_us == current_us) {
+        return;
+    }
+    esp_timer_stop(acquisition_timer);
+    if (esp_timer_start_periodic(acquisition_timer, period_us) != ESP_OK) {
+        DebugHelper::error("Failed to restart acquisition timer");
+        acquisition_period_us.store(0, std::memory_order_relaxed);
+        return;
+    }
+    acquisition_period_us.store(period_us, std::memory_order_relaxed);
+    DebugHelper::verbose("Sensor acquisition period %lu us", (unsigned long)period_us);
+}
+
+void sensor_acquisition_stop() {
+    if (acquisition_timer != nullptr) {
+        esp_timer_stop(acquisition_timer);
+    }
+    acquisition_period_us.store(0, std::memory_order_relaxed);
+}
+
+size_t sensor_acquisition_drain(telemetry_batch_t* batch) {
+    size_t moved = 0;
+    telemetry_sample_t sample;
+
+    while (sample_queue.pop(sample)) {
+        telemetry_batch_push(batch, sample.timestamp_us, sample.values, sample.bools);
+        moved++;
+    }
+    return moved;
+}
+
+uint32_t sensor_acquisition_overruns() {
+    return overruns.load(std::memory_order_relaxed);
+}
+
+uint32_t sensor_acquisition_missed_ticks() {
+    return missed_ticks.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,73 @@
+#ifndef SENSOR_ACQUISITION_H
+#define SENSOR_ACQUISITION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "telemetry_batch.h"
+#include "task_config.h"
+
+/**
+ * @file sensor_acquisition.h
+ * @brief Fixed-rate sensor acquisition task decoupled from the MQTT loop
+ *
+ * A periodic esp_timer wakes a dedicated acquisition task, which timestamps
+ * the tick and calls the module's sampling callback (read ADC, filter,
+ * calibrate). Finished samples go into a lock-free SPSC queue that the
+ * network task drains into its telemetry batch on its own schedule, so a
+ * blocked reconnect no longer stops or skews sampling. If the network task
+ * falls behind, new samples are dropped and counted as overruns.
+ */
+
+#define ACQUISITION_QUEUE_LENGTH 64     // SPSC queue slots, power of two
+#ifndef ACQUISITION_TASK_STACK
+#define ACQUISITION_TASK_STACK   4096
+#endif
+#define ACQUISITION_TASK_PRIORITY 10    // Above the actuator task (task_config.h)
+#define ACQUISITION_TASK_CORE    TASK_CORE_CONTROL
+
+/**
+ * @brief Module sampling callback, runs on the acquisition task
+ *
+ * Fill sample->values and sample->bools; the timestamp is already set to the
+ * time the acquisition tick fired.
+ */
+typedef void (*acquisition_callback_t)(telemetry_sample_t* sample);
+
+/**
+ * @brief Start periodic acquisition
+ * @param period_us Sampling period in microseconds
+ * @param callback Module sampling callback
+ * @return true if the task and timer were started
+ */
+bool sensor_acquisition_start(uint32_t period_us, acquisition_callback_t callback);
+
+/**
+ * @brief Change the sampling period of a running acquisition
+ * @param period_us New sampling period in microseconds
+ */
+void sensor_acquisition_set_period(uint32_t period_us);
+
+/**
+ * @brief Stop periodic acquisition (the task stays parked)
+ */
+void sensor_acquisition_stop();
+
+/**
+ * @brief Move queued samples into a telemetry batch (network task side)
+ * @param batch Destination batch
+ * @return Number of samples moved
+ */
+size_t sensor_acquisition_drain(telemetry_batch_t* batch);
+
+/**
+ * @brief Samples dropped because the queue was full
+ */
+uint32_t sensor_acquisition_overruns();
+
+/**
+ * @brief Timer ticks missed because the previous sample was still running
+ */
+uint32_t sensor_acquisition_missed_ticks();
+
+#endif // SENSOR_ACQUISITION_H
@@ -1,54 +1,62 @@
 #ifndef SENSOR_CALIBRATION_H
 #define SENSOR_CALIBRATION_H
 
-#include "debug_helper.h"
+#include "calibration_table.h"
 
 /**
- * @brief Calibrate temperature sensor readings
- * @param raw Raw ADC value
- * @return Calibrated temperature in °C
+ * @file sensor_calibration.h
+ * @brief Default calibration curves
+ *
+ * Compiled-in curves used by calibration_init() until a channel is
+ * recalibrated over MQTT (see calibration_table.h). All take the raw 12-bit
+ * ADC value and are in engineering units.
  */
-float calibrate_temperature(float raw) {
-    // Example calibration: linear formula y = mx + b
-    const float m = 0.125;
-    const float b = -12.5;
-    float calibrated = (raw * m) + b;
-    
-    DebugHelper::logCalibration("Temperature", raw, calibrated);
-    return calibrated;
-}
 
 /**
- * @brief Calibrate pressure sensor readings
- * @param raw Raw ADC value
- * @return Calibrated pressure in kPa
+ * @brief Temperature: y = 0.125x - 12.5 °C
  */
-float calibrate_pressure(float raw) {
-    // Example calibration: quadratic formula
-    const float a = 0.0015;
-    const float b = 0.25;
-    float calibrated = (a * raw * raw) + (b * raw);
-    
-    DebugHelper::logCalibration("Pressure", raw, calibrated);
-    return calibrated;
-}
+static const calibration_curve_t CALIBRATION_DEFAULT_TEMPERATURE = {
+    .type = CALIBRATION_CURVE_LINEAR,
+    .count = 2,
+    .coefficients = {-12.5f, 0.125f},
+};
 
 /**
- * @brief Calibrate flow sensor readings
- * @param raw Raw ADC value
- * @return Calibrated flow rate in L/min
+ * @brief Relative humidity: full scale is 100 %
  */
-float calibrate_flow(float raw) {
-    // Example calibration: piecewise linear
-    float calibrated;
-    if (raw < 500) {
-        calibrated = raw * 0.1;
-    } else {
-        calibrated = 50 + (raw - 500) * 0.08;
-    }
-    
-    DebugHelper::logCalibration("Flow", raw, calibrated);
-    return calibrated;
-}
-
-#endif // SENSOR_CALIBRATION_H
\ No newline at end of file
+static const calibration_curve_t CALIBRATION_DEFAULT_HUMIDITY = {
+    .type = CALIBRATION_CURVE_LINEAR,
+    .count = 2,
+    .coefficients = {0.0f, 100.0f / 4095.0f},
+};
+
+/**
+ * @brief Pressure: y = 0.0015x² + 0.25x kPa
+ */
+static const calibration_curve_t CALIBRATION_DEFAULT_PRESSURE = {
+    .type = CALIBRATION_CURVE_POLYNOMIAL,
+    .count = 3,
+    .coefficients = {0.0f, 0.25f, 0.0015f},
+};
+
+/**
+ * @brief Flow: 0.1 L/min per count below 500, 0.08 above
+ */
+static const calibration_curve_t CALIBRATION_DEFAULT_FLOW = {
+    .type = CALIBRATION_CURVE_PIECEWISE,
+    .count = 3,
+    .coefficients = {},
+    .point_x = {0.0f, 500.0f, 4095.0f},
+    .point_y = {0.0f, 50.0f, 337.6f},
+};
+
+/**
+ * @brief Injection depth: linear potentiometer, 0.1 mm per count
+ */
+static const calibration_curve_t CALIBRATION_DEFAULT_DEPTH = {
+    .type = CALIBRATION_CURVE_LINEAR,
+    .count = 2,
+    .coefficients = {0.0f, 0.1f},
+};
+
+#endif // SENSOR_CALIBRATION_H
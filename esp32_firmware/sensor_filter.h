@@ -1,41 +1,306 @@
 #ifndef SENSOR_FILTER_H
 #define SENSOR_FILTER_H
 
-#define FILTER_WINDOW_SIZE 5
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <type_traits>
 
 /**
- * @brief Moving average filter for sensor data
+ * @file sensor_filter.h
+ * @brief Compile-time sized sensor filter templates
+ *
+ * Every filter takes the sample type (and window size where applicable) as
+ * template parameters, so storage is static and all calls inline. All
+ * filters share the same interface: addValue(), getFiltered(), update()
+ * (add then return the filtered value) and reset().
  */
-class SensorFilter {
+
+#ifndef FILTER_WINDOW_SIZE
+#define FILTER_WINDOW_SIZE 5    // Default window for the C API (sensor_filter_c.h)
+#endif
+
+/**
+ * @brief Moving average with an O(1) running sum
+ *
+ * Floating-point sums are recomputed from the window each time the write
+ * index wraps, which bounds rounding drift at amortised O(1) cost. Integer
+ * samples accumulate in 64 bits so they never overflow.
+ *
+ * @tparam T Sample type
+ * @tparam N Window size
+ */
+template <typename T, size_t N>
+class MovingAverageFilter {
+    static_assert(N > 0, "Window size must be positive");
+    using Acc = std::conditional_t<std::is_floating_point_v<T>, T, int64_t>;
+
 private:
-    float values[FILTER_WINDOW_SIZE] = {0};
-    int index = 0;
-    int count = 0;
-    
+    T values[N] = {};
+    Acc sum = 0;
+    size_t index = 0;
+    size_t count = 0;
+
 public:
     /**
      * @brief Add new value to filter
      * @param value New sensor reading
      */
-    void addValue(float value) {
+    void addValue(T value) {
+        if (count < N) {
+            count++;
+        } else {
+            sum -= values[index];
+        }
         values[index] = value;
-        index = (index + 1) % FILTER_WINDOW_SIZE;
-        if (count < FILTER_WINDOW_SIZE) count++;
+        sum += value;
+
+        if (++index == N) {
+            index = 0;
+            if constexpr (std::is_floating_point_v<T>) {
+                Acc exact = 0;
+                for (size_t i = 0; i < N; i++) exact += values[i];
+                sum = exact;
+            }
+        }
     }
-    
+
     /**
      * @brief Get filtered value
-     * @return Filtered sensor value
+     * @return Mean of the samples in the window (0 before the first sample)
      */
-    float getFiltered() {
-        if (count == 0) return 0.0f;
-        
-        float sum = 0;
-        for (int i = 0; i < count; i++) {
-            sum += values[i];
+    T getFiltered() const {
+        return count == 0 ? T(0) : T(sum / (Acc)count);
+    }
+
+    T update(T value) {
+        addValue(value);
+        return getFiltered();
+    }
+
+    void reset() {
+        *this = MovingAverageFilter();
+    }
+};
+
+/**
+ * @brief Exponential moving average
+ *
+ * Smoothing factor alpha = 2 / (N + 1), the usual equivalent of an N-sample
+ * moving average, fixed at compile time. The first sample seeds the output.
+ * Integer samples keep the state in Q16.16 (64-bit) so small steps are not
+ * truncated away; no floating point is used for them.
+ *
+ * @tparam T Sample type
+ * @tparam N Equivalent window size
+ */
+template <typename T, size_t N>
+class EmaFilter {
+    static constexpr bool isFloat = std::is_floating_point_v<T>;
+    using State = std::conditional_t<isFloat, T, int64_t>;
+
+private:
+    State value = 0;
+    bool seeded = false;
+
+public:
+    void addValue(T sample) {
+        if constexpr (isFloat) {
+            constexpr T alpha = T(2) / T(N + 1);
+            value = seeded ? value + alpha * (sample - value) : sample;
+        } else {
+            constexpr int64_t alphaQ16 = (int64_t(2) << 16) / int64_t(N + 1);
+            int64_t sampleQ16 = int64_t(sample) * 65536;
+            value = seeded ? value + ((alphaQ16 * (sampleQ16 - value)) >> 16) : sampleQ16;
+        }
+        seeded = true;
+    }
+
+    T getFiltered() const {
+        if constexpr (isFloat) {
+            return value;
+        } else {
+            return T((value + 32768) >> 16);
         }
-        return sum / count;
+    }
+
+    T update(T sample) {
+        addValue(sample);
+        return getFiltered();
+    }
+
+    void reset() {
+        value = 0;
+        seeded = false;
     }
 };
 
-#endif // SENSOR_FILTER_H
\ No newline at end of file
+/**
+ * @brief Median of the last N samples
+ *
+ * Keeps the window both in arrival order and sorted; each update removes the
+ * oldest sample and inserts the new one with one shift pass, so getFiltered()
+ * is a single read. Rejects isolated spikes without smearing them.
+ *
+ * @tparam T Sample type
+ * @tparam N Window size (odd sizes give a true median)
+ */
+template <typename T, size_t N>
+class MedianFilter {
+    static_assert(N > 0, "Window size must be positive");
+
+private:
+    T ring[N] = {};
+    T sorted[N] = {};
+    size_t index = 0;
+    size_t count = 0;
+
+    void removeSorted(T value) {
+        size_t i = 0;
+        while (i < count && sorted[i] != value) i++;
+        for (; i + 1 < count; i++) sorted[i] = sorted[i + 1];
+        count--;
+    }
+
+    void insertSorted(T value) {
+        size_t i = count;
+        while (i > 0 && sorted[i - 1] > value) {
+            sorted[i] = sorted[i - 1];
+            i--;
+        }
+        sorted[i] = value;
+        count++;
+    }
+
+public:
+    void addValue(T value) {
+        if (count == N) {
+            removeSorted(ring[index]);
+        }
+        insertSorted(value);
+        ring[index] = value;
+        if (++index == N) index = 0;
+    }
+
+    T getFiltered() const {
+        return count == 0 ? T(0) : sorted[count / 2];
+    }
+
+    T update(T value) {
+        addValue(value);
+        return getFiltered();
+    }
+
+    void reset() {
+        index = 0;
+        count = 0;
+    }
+};
+
+/**
+ * @brief Scalar Kalman filter for a constant-level signal
+ *
+ * Same model and defaults as KalmanFilter in data_processing.py: the first
+ * measurement initialises the estimate, then each update predicts
+ * (error += process variance) and corrects with gain
+ * error / (error + measurement variance).
+ *
+ * @tparam T Sample type (floating point)
+ */
+template <typename T>
+class KalmanFilter {
+    static_assert(std::is_floating_point_v<T>, "KalmanFilter requires a floating-point type");
+
+private:
+    T processVariance;
+    T measurementVariance;
+    T estimate = 0;
+    T estimationError = 1;
+    bool initialized = false;
+
+public:
+    explicit KalmanFilter(T process_variance = T(1e-5), T measurement_variance = T(1e-1))
+        : processVariance(process_variance), measurementVariance(measurement_variance) {}
+
+    void addValue(T measurement) {
+        if (!initialized) {
+            estimate = measurement;
+            initialized = true;
+            return;
+        }
+        T predictedError = estimationError + processVariance;
+        T gain = predictedError / (predictedError + measurementVariance);
+        estimate += gain * (measurement - estimate);
+        estimationError = (T(1) - gain) * predictedError;
+    }
+
+    T getFiltered() const {
+        return estimate;
+    }
+
+    T update(T measurement) {
+        addValue(measurement);
+        return estimate;
+    }
+
+    void reset() {
+        estimate = 0;
+        estimationError = 1;
+        initialized = false;
+    }
+};
+
+/**
+ * @brief Kalman filter reduced to its steady-state gain
+ *
+ * For a constant-level model the scalar Kalman gain converges to
+ * K = M / (M + r) with M = (q + sqrt(q^2 + 4qr)) / 2, after which the filter
+ * is an EMA with that gain. The gain is computed once at construction, so
+ * updates are integer-only for integer T (Q16.16 state); this is the
+ * fixed-point stand-in for KalmanFilter.
+ *
+ * @tparam T Sample type
+ */
+template <typename T>
+class SteadyStateKalmanFilter {
+private:
+    int64_t gainQ16;
+    int64_t valueQ16 = 0;
+    bool seeded = false;
+
+public:
+    explicit SteadyStateKalmanFilter(float process_variance = 1e-5f,
+                                     float measurement_variance = 1e-1f) {
+        float q = process_variance;
+        float r = measurement_variance;
+        float m = (q + sqrtf(q * q + 4.0f * q * r)) * 0.5f;
+        gainQ16 = (int64_t)((m / (m + r)) * 65536.0f + 0.5f);
+    }
+
+    void addValue(T sample) {
+        int64_t sampleQ16 = (int64_t)(sample * 65536);
+        valueQ16 = seeded ? valueQ16 + ((gainQ16 * (sampleQ16 - valueQ16)) >> 16) : sampleQ16;
+        seeded = true;
+    }
+
+    T getFiltered() const {
+        return T((valueQ16 + 32768) >> 16);
+    }
+
+    T update(T sample) {
+        addValue(sample);
+        return getFiltered();
+    }
+
+    void reset() {
+        valueQ16 = 0;
+        seeded = false;
+    }
+};
+
+/**
+ * @brief Legacy name for the default moving average filter
+ */
+using SensorFilter = MovingAverageFilter<float, FILTER_WINDOW_SIZE>;
+
+#endif // SENSOR_FILTER_H
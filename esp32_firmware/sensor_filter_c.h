@@ -1,27 +1,40 @@
 #ifndef SENSOR_FILTER_C_H
 #define SENSOR_FILTER_C_H
 
-#include <string.h>
-
-#define FILTER_WINDOW_SIZE 5
+#include "sensor_filter.h"
+#include "sensor_value.h"
 
 /**
- * @brief C-compatible moving average filter for sensor data
+ * @file sensor_filter_c.h
+ * @brief C-style API over the sensor_filter.h templates
+ *
+ * The module sources are built as C++ (they already call DebugHelper), so
+ * these are plain typedefs of fixed template instantiations plus inline
+ * forwarding functions: no runtime dispatch and no overhead over using the
+ * templates directly. Pick the filter per channel by declaring the matching
+ * type; all windows are FILTER_WINDOW_SIZE samples.
+ *
+ * Samples are sensor_value_t, so with SENSOR_FIXED_POINT every filter runs
+ * on int32 and sensor_kalman_t becomes its integer steady-state form.
  */
-typedef struct {
-    float values[FILTER_WINDOW_SIZE];
-    int index;
-    int count;
-} sensor_filter_t;
+
+typedef MovingAverageFilter<sensor_value_t, FILTER_WINDOW_SIZE> sensor_filter_t;  // Moving average
+typedef EmaFilter<sensor_value_t, FILTER_WINDOW_SIZE> sensor_ema_t;               // Exponential average
+typedef MedianFilter<sensor_value_t, FILTER_WINDOW_SIZE> sensor_median_t;         // Spike rejection
+#if SENSOR_FIXED_POINT
+typedef SteadyStateKalmanFilter<sensor_value_t> sensor_kalman_t;                  // Scalar Kalman
+#else
+typedef KalmanFilter<float> sensor_kalman_t;                                      // Scalar Kalman
+#endif
+
+// ==================== Moving Average ====================
 
 /**
  * @brief Initialize sensor filter
  * @param filter Pointer to filter structure
  */
 static inline void sensor_filter_init(sensor_filter_t* filter) {
-    memset(filter->values, 0, sizeof(filter->values));
-    filter->index = 0;
-    filter->count = 0;
+    filter->reset();
 }
 
 /**
@@ -29,12 +42,8 @@ static inline void sensor_filter_init(sensor_filter_t* filter) {
  * @param filter Pointer to filter structure
  * @param value New sensor reading
  */
-static inline void sensor_filter_add_value(sensor_filter_t* filter, float value) {
-    filter->values[filter->index] = value;
-    filter->index = (filter->index + 1) % FILTER_WINDOW_SIZE;
-    if (filter->count < FILTER_WINDOW_SIZE) {
-        filter->count++;
-    }
+static inline void sensor_filter_add_value(sensor_filter_t* filter, sensor_value_t value) {
+    filter->addValue(value);
 }
 
 /**
@@ -42,14 +51,57 @@ static inline void sensor_filter_add_value(sensor_filter_t* filter, float value)
  * @param filter Pointer to filter structure
  * @return Filtered sensor value
  */
-static inline float sensor_filter_get_filtered(sensor_filter_t* filter) {
-    if (filter->count == 0) return 0.0f;
-    
-    float sum = 0;
-    for (int i = 0; i < filter->count; i++) {
-        sum += filter->values[i];
-    }
-    return sum / filter->count;
+static inline sensor_value_t sensor_filter_get_filtered(sensor_filter_t* filter) {
+    return filter->getFiltered();
+}
+
+// ==================== Exponential Moving Average ====================
+
+static inline void sensor_ema_init(sensor_ema_t* filter) {
+    filter->reset();
+}
+
+static inline void sensor_ema_add_value(sensor_ema_t* filter, sensor_value_t value) {
+    filter->addValue(value);
+}
+
+static inline sensor_value_t sensor_ema_get_filtered(sensor_ema_t* filter) {
+    return filter->getFiltered();
+}
+
+// ==================== Median ====================
+
+static inline void sensor_median_init(sensor_median_t* filter) {
+    filter->reset();
+}
+
+static inline void sensor_median_add_value(sensor_median_t* filter, sensor_value_t value) {
+    filter->addValue(value);
+}
+
+static inline sensor_value_t sensor_median_get_filtered(sensor_median_t* filter) {
+    return filter->getFiltered();
+}
+
+// ==================== Kalman ====================
+
+/**
+ * @brief Initialize Kalman filter with its noise model
+ * @param filter Pointer to filter structure
+ * @param process_variance Expected drift of the true value per sample
+ * @param measurement_variance Sensor noise variance
+ */
+static inline void sensor_kalman_init(sensor_kalman_t* filter, float process_variance,
+                                      float measurement_variance) {
+    *filter = sensor_kalman_t(process_variance, measurement_variance);
+}
+
+static inline void sensor_kalman_add_value(sensor_kalman_t* filter, sensor_value_t value) {
+    filter->addValue(value);
+}
+
+static inline sensor_value_t sensor_kalman_get_filtered(sensor_kalman_t* filter) {
+    return filter->getFiltered();
 }
 
-#endif // SENSOR_FILTER_C_H 
\ No newline at end of file
+#endif // SENSOR_FILTER_C_H
@@ -0,0 +1,32 @@
+#ifndef SENSOR_VALUE_H
+#define SENSOR_VALUE_H
+
+#include <stdint.h>
+
+/**
+ * @file sensor_value.h
+ * @brief Numeric type used from ADC sample to published value
+ *
+ * With the SENSOR_FIXED_POINT CMake option (defines SENSOR_FIXED_POINT=1)
+ * the whole sample path - ADC counts, filters, calibration, telemetry
+ * samples - runs on int32 milli-units (m°C, Pa, mL/min, milli-percent) and
+ * the only float conversion happens when a message is encoded on the network
+ * task. Without it the path uses float, as before. Like ADC_STREAM, this is a
+ * whole-build switch because the shared components store samples in it.
+ */
+
+#ifndef SENSOR_FIXED_POINT
+#define SENSOR_FIXED_POINT 0
+#endif
+
+#if SENSOR_FIXED_POINT
+typedef int32_t sensor_value_t;                         // Milli-units
+#define SENSOR_VALUE_TO_FLOAT(v) ((float)(v) * 0.001f)
+#define SENSOR_VALUE_FROM_FLOAT(x) ((sensor_value_t)((x) * 1000.0f))
+#else
+typedef float sensor_value_t;                           // Engineering units
+#define SENSOR_VALUE_TO_FLOAT(v) ((float)(v))
+#define SENSOR_VALUE_FROM_FLOAT(x) ((sensor_value_t)(x))
+#endif
+
+#endif // SENSOR_VALUE_H
@@ -0,0 +1,85 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @brief Lock-free single-writer snapshot of a small struct (latch seqlock)
+ *
+ * One task publishes a value with write(); any number of tasks or ISRs copy
+ * out the latest complete value with read(). Neither side blocks or disables
+ * interrupts.
+ *
+ * Two copies are kept. The writer bumps the sequence before updating each
+ * copy, and readers take the copy the sequence says is not being written,
+ * retrying only if the writer moved on while they copied. A reader that
+ * preempts the writer on the same core therefore always finishes in one
+ * pass, which a single-copy seqlock cannot guarantee when the reader has the
+ * higher priority.
+ *
+ * @tparam T Trivially copyable value type
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock value must be trivially copyable");
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> copies[2][WORDS] = {};
+
+    void store(size_t index, const uint32_t* words) {
+        for (size_t i = 0; i < WORDS; i++) {
+            copies[index][i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+public:
+    /**
+     * @brief Publish a new value (writer side only)
+     * @param value Value to copy in
+     */
+    void write(const T& value) {
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+
+        // Each sequence store is fenced from the copy written after it, so a
+        // reader that sees any of the new words also sees the new sequence
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);       // Readers move to copy 1
+        std::atomic_thread_fence(std::memory_order_release);
+        store(0, words);
+        std::atomic_thread_fence(std::memory_order_release);
+        sequence.store(s + 2, std::memory_order_relaxed);       // Readers back to copy 0
+        std::atomic_thread_fence(std::memory_order_release);
+        store(1, words);
+    }
+
+    /**
+     * @brief Copy out the latest complete value (any task or ISR)
+     * @param value Receives the value
+     * @return Number of writes the value reflects (0: still zero-initialized)
+     */
+    uint32_t read(T& value) const {
+        uint32_t words[WORDS];
+        uint32_t s;
+        do {
+            s = sequence.load(std::memory_order_acquire);
+            const std::atomic<uint32_t>* copy = copies[s & 1];
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = copy[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (sequence.load(std::memory_order_relaxed) != s);
+
+        memcpy(&value, words, sizeof(T));
+        return s / 2;
+    }
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring queue
+ *
+ * One task (or ISR) may call push() while another calls pop(); neither side
+ * ever blocks or disables interrupts. Indices run freely and are masked on
+ * access, so all N slots are usable.
+ *
+ * @tparam T Element type (copied by value)
+ * @tparam N Capacity, must be a power of two
+ */
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+    T slots[N];
+    std::atomic<size_t> head{0};    // Written by producer only
+    std::atomic<size_t> tail{0};    // Written by consumer only
+
+public:
+    /**
+     * @brief Enqueue an element (producer side)
+     * @param value Element to copy into the queue
+     * @return false if the queue is full
+     */
+    bool push(const T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        slots[h & (N - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Dequeue the oldest element (consumer side)
+     * @param value Receives the element
+     * @return false if the queue is empty
+     */
+    bool pop(T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of queued elements (approximate while the other side runs)
+     */
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return N; }
+};
+
+#endif // SPSC_QUEUE_H
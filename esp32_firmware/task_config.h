@@ -0,0 +1,37 @@
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @file task_config.h
+ * @brief Core assignment and priority plan of the firmware tasks
+ *
+ * The radio stack runs on PRO_CPU: sdkconfig.defaults pins the WiFi, lwIP
+ * and ESP-MQTT tasks to core 0, and the network task, which calls into them,
+ * sits next to them. Everything on the sample/actuation path runs on
+ * APP_CPU, where no radio task is scheduled, and its timers interrupt there
+ * (esp_timer ISR dispatch, ISR on CPU 1), so a busy radio cannot delay a
+ * control step or sample tick.
+ *
+ * Priorities only order tasks on the same core:
+ *
+ *   APP_CPU  control 15 > adc_stream / adc_scan 12 > acquisition 10 > actuator 6
+ *   PRO_CPU  wifi 23, esp_timer 22, tcpip 18 (ESP-IDF) > network 5,
+ *            esp-mqtt 5 > log drain 1
+ *
+ * Each task's stack, priority and core are defined next to the component
+ * that creates it. Stack sizes can be overridden at build time; their
+ * headroom is published as the "stack_free" object of every metrics
+ * snapshot (metrics_watch_task()), which is what the sizes are tuned from.
+ * Single-core builds (CONFIG_FREERTOS_UNICORE) put everything on core 0.
+ */
+
+#define TASK_CORE_NETWORK   PRO_CPU_NUM         // WiFi, MQTT, publishing, logging
+#if CONFIG_FREERTOS_UNICORE
+#define TASK_CORE_CONTROL   PRO_CPU_NUM
+#else
+#define TASK_CORE_CONTROL   APP_CPU_NUM         // Sampling, actuation, control loop
+#endif
+
+#endif // TASK_CONFIG_H
@@ -0,0 +1,364 @@
+#include "telemetry_batch.h"
+#include "mqtt_helper.h"
+#include "debug_helper.h"
+#include "metrics.h"
+#include "json_writer.h"
+#include "telemetry_codec.h"
+#include "offline_queue.h"
+#include "time_sync.h"
+#include <math.h>
+#include <string.h>
+
+// Flush scratch space. telemetry_batch_flush() runs on the network task only,
+// so one set of buffers is shared by all batches.
+static telemetry_sample_t flush_samples[TELEMETRY_BATCH_CAPACITY];
+static union {
+    struct {
+        uint8_t frame[TELEMETRY_BATCH_MAX_FRAME_SIZE];
+        uint8_t packed[TELEMETRY_BATCH_MAX_FRAME_SIZE];     // LZ stage output
+    } binary;
+    char json[TELEMETRY_BATCH_JSON_SIZE];
+} flush_buffer;
+static uint8_t* const flush_frame = flush_buffer.binary.frame;
+static uint8_t* const flush_packed = flush_buffer.binary.packed;
+
+void telemetry_batch_init(telemetry_batch_t* batch, const telemetry_schema_t* schema,
+                          const char* topic) {
+    memset(batch, 0, sizeof(*batch));
+    batch->schema = schema;
+    batch->topic = topic;
+    batch->lock = portMUX_INITIALIZER_UNLOCKED;
+    telemetry_batch_configure(batch, TELEMETRY_BATCH_SIZE, TELEMETRY_BATCH_FLUSH_MS);
+}
+
+void telemetry_batch_configure(telemetry_batch_t* batch, size_t batch_size,
+                               uint32_t flush_interval_ms) {
+    if (batch_size < 1) batch_size = 1;
+    if (batch_size > TELEMETRY_BATCH_CAPACITY) batch_size = TELEMETRY_BATCH_CAPACITY;
+
+    portENTER_CRITICAL(&batch->lock);
+    batch->batch_size = batch_size;
+    batch->flush_interval_ms = flush_interval_ms;
+    portEXIT_CRITICAL(&batch->lock);
+
+    DebugHelper::info("Telemetry batch: %u samples / %lu ms",
+                      (unsigned)batch_size, (unsigned long)flush_interval_ms);
+}
+
+void telemetry_batch_set_deadband(telemetry_batch_t* batch, const sensor_value_t* deadband,
+                                  uint32_t heartbeat_ms) {
+    if (!TELEMETRY_REPORT_ON_CHANGE) {
+        return;
+    }
+
+    portENTER_CRITICAL(&batch->lock);
+    batch->deadband = deadband;
+    batch->heartbeat_ms = heartbeat_ms;
+    batch->has_reference = false;
+    batch->history_count = 0;
+    portEXIT_CRITICAL(&batch->lock);
+}
+
+void telemetry_batch_set_report_all(telemetry_batch_t* batch, bool report_all) {
+    portENTER_CRITICAL(&batch->lock);
+    batch->report_all = report_all;
+    portEXIT_CRITICAL(&batch->lock);
+}
+
+// Whether a sample differs enough from the last kept one (lock held)
+static bool sample_changed(const telemetry_batch_t* batch, int64_t timestamp_us,
+                           const sensor_value_t* values, uint8_t bools) {
+    const telemetry_sample_t* reference = &batch->reference;
+    if (batch->deadband == nullptr || batch->report_all || !batch->has_reference ||
+        timestamp_us <= batch->window_end_us || bools != reference->bools ||
+        timestamp_us - reference->timestamp_us >= (int64_t)batch->heartbeat_ms * 1000) {
+        return true;
+    }
+    for (uint8_t i = 0; i < batch->schema->float_count; i++) {
+        sensor_value_t delta = values[i] - reference->values[i];
+        if (delta > batch->deadband[i] || -delta > batch->deadband[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fill a sample from its fields
+static void make_sample(const telemetry_batch_t* batch, telemetry_sample_t* sample,
+                        int64_t timestamp_us, const sensor_value_t* values, uint8_t bools) {
+    sample->timestamp_us = timestamp_us;
+    memcpy(sample->values, values, batch->schema->float_count * sizeof(sensor_value_t));
+    sample->bools = bools;
+}
+
+// Append a kept sample to the ring (lock held); false if the oldest was dropped
+static bool store_sample(telemetry_batch_t* batch, const telemetry_sample_t* sample) {
+    batch->ring[batch->head] = *sample;
+    batch->reference = *sample;
+    batch->has_reference = true;
+    batch->history_count = 0;
+
+    batch->head = (batch->head + 1 == TELEMETRY_BATCH_CAPACITY) ? 0 : batch->head + 1;
+    if (batch->count < TELEMETRY_BATCH_CAPACITY) {
+        batch->count++;
+        return true;
+    }
+    batch->dropped++;   // Oldest sample overwritten
+    return false;
+}
+
+void telemetry_batch_flag(telemetry_batch_t* batch, int64_t timestamp_us, uint32_t window_ms) {
+    portENTER_CRITICAL(&batch->lock);
+    size_t n = batch->history_count;
+    size_t tail = (batch->history_head + TELEMETRY_BATCH_HISTORY - n) % TELEMETRY_BATCH_HISTORY;
+    for (size_t i = 0; i < n; i++) {
+        store_sample(batch, &batch->history[tail]);
+        tail = (tail + 1 == TELEMETRY_BATCH_HISTORY) ? 0 : tail + 1;
+    }
+    int64_t end_us = timestamp_us + (int64_t)window_ms * 1000;
+    if (end_us > batch->window_end_us) {
+        batch->window_end_us = end_us;
+    }
+    portEXIT_CRITICAL(&batch->lock);
+}
+
+bool telemetry_batch_push(telemetry_batch_t* batch, int64_t timestamp_us,
+                          const sensor_value_t* values, uint8_t bools) {
+    portENTER_CRITICAL(&batch->lock);
+    if (!sample_changed(batch, timestamp_us, values, bools)) {
+        // Kept for a flagged window that may still open
+        make_sample(batch, &batch->history[batch->history_head], timestamp_us, values, bools);
+        batch->history_head = (batch->history_head + 1) % TELEMETRY_BATCH_HISTORY;
+        if (batch->history_count < TELEMETRY_BATCH_HISTORY) {
+            batch->history_count++;
+        }
+        batch->suppressed++;
+        portEXIT_CRITICAL(&batch->lock);
+        metrics_count(METRIC_TELEMETRY_SUPPRESSED, 1);
+        return true;
+    }
+    telemetry_sample_t sample;
+    make_sample(batch, &sample, timestamp_us, values, bools);
+    bool stored = store_sample(batch, &sample);
+    portEXIT_CRITICAL(&batch->lock);
+
+    return stored;
+}
+
+// Move up to max pending samples (oldest first) into dst
+static size_t take_samples(telemetry_batch_t* batch, telemetry_sample_t* dst, size_t max) {
+    size_t n = batch->count < max ? batch->count : max;
+    size_t tail = (batch->head + TELEMETRY_BATCH_CAPACITY - batch->count) % TELEMETRY_BATCH_CAPACITY;
+
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = batch->ring[tail];
+        tail = (tail + 1 == TELEMETRY_BATCH_CAPACITY) ? 0 : tail + 1;
+    }
+    batch->count -= n;
+    return n;
+}
+
+static void write_sample_fields(json_writer_t* writer, const telemetry_schema_t* schema,
+                                const telemetry_sample_t* sample) {
+    for (uint8_t i = 0; i < schema->float_count; i++) {
+#if SENSOR_FIXED_POINT
+        json_writer_milli(writer, schema->float_names[i], sample->values[i]);
+#else
+        json_writer_float(writer, schema->float_names[i], sample->values[i]);
+#endif
+    }
+    for (uint8_t i = 0; i < schema->bool_count; i++) {
+        json_writer_bool(writer, schema->bool_names[i], (sample->bools >> i) & 1);
+    }
+}
+
+// Time since the previous sample (0 for the first one of a message)
+static uint64_t sample_delta_us(const telemetry_sample_t* samples, size_t i) {
+    int64_t delta_us = i > 0 ? samples[i].timestamp_us - samples[i - 1].timestamp_us : 0;
+    return delta_us > 0 ? (uint64_t)delta_us : 0;
+}
+
+// One message from n samples, written straight into the flush buffer
+static const char* write_json(const telemetry_schema_t* schema, const telemetry_sample_t* samples,
+                              size_t n, size_t* length) {
+    json_writer_t writer;
+    json_writer_init(&writer, flush_buffer.json, sizeof(flush_buffer.json));
+    json_writer_begin_object(&writer, nullptr);
+
+    // Latest values at top level keep existing consumers working
+    write_sample_fields(&writer, schema, &samples[n - 1]);
+
+    // Milliseconds with microsecond decimals
+    json_writer_milli(&writer, "timestamp", time_sync_timestamp_us(samples[0].timestamp_us, nullptr));
+    if (n > 1) {
+        json_writer_begin_array(&writer, "samples");
+        for (size_t i = 0; i < n; i++) {
+            json_writer_begin_object(&writer, nullptr);
+            json_writer_int(&writer, "dt_us", sample_delta_us(samples, i));
+            write_sample_fields(&writer, schema, &samples[i]);
+            json_writer_end_object(&writer);
+        }
+        json_writer_end_array(&writer);
+    }
+    json_writer_end_object(&writer);
+    return json_writer_finish(&writer, length);
+}
+
+static bool publish_json(telemetry_batch_t* batch, const telemetry_sample_t* samples, size_t n) {
+    bool ok = true;
+    while (n > 0) {
+        // Halve the message until it fits the buffer
+        uint32_t build_start = metrics_now();
+        size_t count = n;
+        size_t length = 0;
+        const char* json = write_json(batch->schema, samples, count, &length);
+        while (json == nullptr && count > 1) {
+            count /= 2;
+            json = write_json(batch->schema, samples, count, &length);
+        }
+        metrics_record_since(METRIC_JSON_BUILD, build_start);
+
+        if (json == nullptr) {
+            DebugHelper::error("Telemetry sample exceeds %u byte JSON buffer",
+                               (unsigned)TELEMETRY_BATCH_JSON_SIZE);
+            return false;
+        }
+        ok = offline_queue_publish(batch->topic, (const uint8_t*)json, length) && ok;
+        samples += count;
+        n -= count;
+    }
+    return ok;
+}
+
+static size_t encode_sample(uint8_t* dst, const telemetry_schema_t* schema,
+                            const telemetry_sample_t* sample) {
+    size_t length = 0;
+    for (uint8_t i = 0; i < schema->float_count; i++) {
+        float value = SENSOR_VALUE_TO_FLOAT(sample->values[i]);
+        memcpy(&dst[length], &value, sizeof(float));    // ESP32 is little-endian
+        length += sizeof(float);
+    }
+    if (schema->bool_count > 0) {
+        dst[length++] = sample->bools;
+    }
+    return length;
+}
+
+// Value in milli-units for the delta codec; false if it has none
+static bool sample_milli(sensor_value_t value, int64_t* milli) {
+#if SENSOR_FIXED_POINT
+    *milli = value;
+    return true;
+#else
+    if (!isfinite(value) || fabsf(value) > 9.0e15f) {
+        return false;
+    }
+    *milli = llround((double)value * 1000.0);
+    return true;
+#endif
+}
+
+// Delta-encoded samples (telemetry_codec.h); 0 if a value has no milli-unit
+// form or the encoding would not fit
+static size_t encode_delta(uint8_t* dst, size_t capacity, const telemetry_schema_t* schema,
+                           const telemetry_sample_t* samples, size_t n) {
+    int64_t previous[TELEMETRY_BATCH_MAX_FLOATS] = {};
+    uint8_t previous_bools = 0;
+    size_t sample_max = TELEMETRY_VARINT_MAX_SIZE * (1 + schema->float_count) + 1;
+    size_t length = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (capacity - length < sample_max) {
+            return 0;
+        }
+        length += telemetry_frame_put_varint(&dst[length], sample_delta_us(samples, i));
+        for (uint8_t f = 0; f < schema->float_count; f++) {
+            int64_t milli;
+            if (!sample_milli(samples[i].values[f], &milli)) {
+                return 0;
+            }
+            length += telemetry_frame_put_varint(&dst[length], telemetry_zigzag(milli - previous[f]));
+            previous[f] = milli;
+        }
+        if (schema->bool_count > 0) {
+            dst[length++] = samples[i].bools ^ previous_bools;
+            previous_bools = samples[i].bools;
+        }
+    }
+    return length;
+}
+
+static bool publish_binary(telemetry_batch_t* batch, const telemetry_sample_t* samples, size_t n) {
+    const telemetry_schema_t* schema = batch->schema;
+    telemetry_codec_t codec = n > 1 ? telemetry_get_codec() : TELEMETRY_CODEC_RAW;
+    uint8_t flags = n > 1 ? TELEMETRY_FRAME_FLAG_BATCH : 0;
+    size_t length = TELEMETRY_FRAME_HEADER_SIZE;
+
+    if (n == 1) {
+        length += encode_sample(&flush_frame[length], schema, &samples[0]);
+    } else {
+        flush_frame[length++] = (uint8_t)n;
+        size_t delta_length = codec != TELEMETRY_CODEC_RAW
+            ? encode_delta(&flush_frame[length], sizeof(flush_buffer.binary.frame) - length,
+                           schema, samples, n)
+            : 0;
+        if (delta_length > 0) {
+            flags |= TELEMETRY_FRAME_FLAG_DELTA;
+            length += delta_length;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                length += telemetry_frame_put_varint(&flush_frame[length], sample_delta_us(samples, i));
+                length += encode_sample(&flush_frame[length], schema, &samples[i]);
+            }
+        }
+    }
+
+    // Keep the LZ block only if it is smaller
+    uint8_t* frame = flush_frame;
+    if (codec == TELEMETRY_CODEC_DELTA_LZ) {
+        size_t body = length - TELEMETRY_FRAME_HEADER_SIZE;
+        size_t packed = telemetry_lz_compress(&flush_frame[TELEMETRY_FRAME_HEADER_SIZE], body,
+                                              &flush_packed[TELEMETRY_FRAME_HEADER_SIZE], body - 1);
+        if (packed > 0) {
+            flags |= TELEMETRY_FRAME_FLAG_LZ;
+            frame = flush_packed;
+            length = TELEMETRY_FRAME_HEADER_SIZE + packed;
+        }
+    }
+
+    telemetry_frame_write_header(frame, schema->module_id, schema->float_count,
+                                 schema->bool_count, flags, batch->sequence++,
+                                 samples[0].timestamp_us);
+    return offline_queue_publish(batch->topic, frame, length);
+}
+
+size_t telemetry_batch_flush(telemetry_batch_t* batch, uint32_t now_ms, bool force) {
+    size_t n;
+
+    portENTER_CRITICAL(&batch->lock);
+    if (batch->count == 0) {
+        portEXIT_CRITICAL(&batch->lock);
+        return 0;
+    }
+    size_t oldest = (batch->head + TELEMETRY_BATCH_CAPACITY - batch->count) % TELEMETRY_BATCH_CAPACITY;
+    bool due = force ||
+               batch->count >= batch->batch_size ||
+               now_ms - (uint32_t)(batch->ring[oldest].timestamp_us / 1000) >= batch->flush_interval_ms;
+    n = due ? take_samples(batch, flush_samples, batch->batch_size) : 0;
+    portEXIT_CRITICAL(&batch->lock);
+
+    if (n == 0) {
+        return 0;
+    }
+
+    bool ok = telemetry_get_format() == TELEMETRY_FORMAT_BINARY
+                  ? publish_binary(batch, flush_samples, n)
+                  : publish_json(batch, flush_samples, n);
+    if (!ok) {
+        DebugHelper::warning("Telemetry batch of %u samples not published", (unsigned)n);
+        return 0;
+    }
+
+    DebugHelper::verbose("Telemetry batch published: %u samples", (unsigned)n);
+    return n;
+}
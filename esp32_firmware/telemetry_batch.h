@@ -0,0 +1,215 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include "telemetry_frame.h"
+#include "sensor_value.h"
+
+/**
+ * @file telemetry_batch.h
+ * @brief Sample ring buffer with batched MQTT publishing
+ *
+ * Sensing code pushes one sample per reading at the sensing rate; the
+ * network side calls telemetry_batch_flush() regularly, which publishes all
+ * pending samples as one message once either the batch size is reached or
+ * the oldest pending sample is older than the flush interval.
+ *
+ * Batches are encoded in the active telemetry format (telemetry_frame.h).
+ * A flush containing a single sample produces the legacy payload plus its
+ * timestamp, so a batch size of 1 is compatible with unbatched publishing.
+ * Larger batches are encoded as:
+ *  - binary: a frame with TELEMETRY_FRAME_FLAG_BATCH set, optionally
+ *            delta-encoded and LZ-compressed (telemetry_codec.h)
+ *  - JSON:   the latest sample's fields at top level (for existing
+ *            consumers) plus a "samples" array of {"dt_us": us, fields...}
+ *            objects, dt_us being the time since the previous sample (0 for
+ *            the first, which is at the top-level "timestamp")
+ *
+ * Samples carry their acquisition time on the monotonic clock in
+ * microseconds; it is mapped to Unix time when the message is encoded
+ * (time_sync.h). The JSON "timestamp" is in milliseconds with microsecond
+ * decimals, Unix time once synchronised and time since boot before.
+ *
+ * With a deadband set (telemetry_batch_set_deadband()), a pushed sample is
+ * only kept if a bool changed, a value moved more than its field's deadband
+ * from the last kept sample, or the heartbeat interval passed since then.
+ * Steady readings therefore cost one message per heartbeat. Report-all mode
+ * (used while an actuator runs, see telemetry_rate.h) keeps every sample.
+ *
+ * A flagged window (telemetry_batch_flag(), see anomaly_detector.h) keeps
+ * every sample for a while too, starting with the last
+ * TELEMETRY_BATCH_HISTORY samples suppressed before it, so the lead-up to
+ * an anomaly is published at full resolution as well.
+ *
+ * Messages that cannot be published right away go to the offline queue
+ * (offline_queue.h) and are replayed after reconnecting.
+ *
+ * telemetry_batch_push() may be called from any task; telemetry_batch_flush()
+ * must only be called from the network task.
+ */
+
+#define TELEMETRY_BATCH_CAPACITY   64   // Ring buffer slots (samples)
+#define TELEMETRY_BATCH_MAX_FLOATS 8    // Float fields per sample
+#define TELEMETRY_BATCH_MAX_BOOLS  8    // Bool fields per sample
+
+// Default batching parameters, overridable per module target
+#ifndef TELEMETRY_BATCH_SIZE
+#define TELEMETRY_BATCH_SIZE 1          // Samples per message
+#endif
+
+#ifndef TELEMETRY_BATCH_FLUSH_MS
+#define TELEMETRY_BATCH_FLUSH_MS 1000   // Max age of oldest pending sample
+#endif
+
+// Report-on-change (-DTELEMETRY_REPORT_ON_CHANGE=0 keeps every sample)
+#ifndef TELEMETRY_REPORT_ON_CHANGE
+#define TELEMETRY_REPORT_ON_CHANGE 1
+#endif
+
+#define TELEMETRY_BATCH_HISTORY 8   // Suppressed samples kept for a flagged window
+
+#ifndef TELEMETRY_HEARTBEAT_MS
+#define TELEMETRY_HEARTBEAT_MS 60000    // Max silence while readings are steady
+#endif
+
+// Largest binary batch: header + count + per sample (time delta, floats, bools)
+#define TELEMETRY_BATCH_MAX_FRAME_SIZE  (TELEMETRY_FRAME_HEADER_SIZE + 1 + \
+    TELEMETRY_BATCH_CAPACITY * (TELEMETRY_VARINT_MAX_SIZE + TELEMETRY_BATCH_MAX_FLOATS * 4 + \
+                                (TELEMETRY_BATCH_MAX_BOOLS + 7) / 8))
+
+// JSON payload buffer; a batch that does not fit is sent as several messages.
+// At most 3840 so a queued message fits one flash sector (offline_queue.h)
+#ifndef TELEMETRY_BATCH_JSON_SIZE
+#define TELEMETRY_BATCH_JSON_SIZE 3840
+#endif
+
+/**
+ * @brief Field layout of a module's sensor samples
+ *
+ * Names are used for JSON output and must match the keys published before
+ * batching; their order defines the binary field order.
+ */
+typedef struct {
+    uint8_t module_id;                  // telemetry_module_id_t
+    const char* const* float_names;     // Float field names, in order
+    uint8_t float_count;                // <= TELEMETRY_BATCH_MAX_FLOATS
+    const char* const* bool_names;      // Bool field names, in order
+    uint8_t bool_count;                 // <= TELEMETRY_BATCH_MAX_BOOLS
+} telemetry_schema_t;
+
+/**
+ * @brief One sensor reading
+ */
+typedef struct {
+    int64_t timestamp_us;                       // Acquisition time (esp_timer_get_time())
+    sensor_value_t values[TELEMETRY_BATCH_MAX_FLOATS];  // Float fields (see sensor_value.h)
+    uint8_t bools;                              // Bool fields, bit i = field i
+} telemetry_sample_t;
+
+/**
+ * @brief Batch ring buffer and flusher state
+ */
+typedef struct {
+    const telemetry_schema_t* schema;
+    const char* topic;                          // Publish topic
+    telemetry_sample_t ring[TELEMETRY_BATCH_CAPACITY];
+    size_t head;                                // Next slot to write
+    size_t count;                               // Pending samples
+    size_t batch_size;                          // Flush threshold (samples)
+    uint32_t flush_interval_ms;                 // Flush threshold (age)
+    uint32_t dropped;                           // Samples overwritten when full
+    const sensor_value_t* deadband;             // Per float field, nullptr = keep all
+    uint32_t heartbeat_ms;                      // Max time between kept samples
+    bool report_all;                            // Bypass the deadband
+    bool has_reference;                         // reference is valid
+    telemetry_sample_t reference;               // Last kept sample
+    uint32_t suppressed;                        // Samples discarded as unchanged
+    telemetry_sample_t history[TELEMETRY_BATCH_HISTORY];   // Suppressed since the last kept one
+    size_t history_head;                        // Next history slot to write
+    size_t history_count;
+    int64_t window_end_us;                      // Flagged window: keep every sample until then
+    uint16_t sequence;                          // Next frame sequence number
+    portMUX_TYPE lock;                          // Guards ring/head/count
+} telemetry_batch_t;
+
+/**
+ * @brief Initialize a batch with the library default batching parameters
+ *
+ * Modules apply their own compile-time TELEMETRY_BATCH_SIZE /
+ * TELEMETRY_BATCH_FLUSH_MS afterwards with telemetry_batch_configure().
+ *
+ * @param batch Pointer to batch state
+ * @param schema Sample field layout (must outlive the batch)
+ * @param topic MQTT topic to publish on (must outlive the batch)
+ */
+void telemetry_batch_init(telemetry_batch_t* batch, const telemetry_schema_t* schema,
+                          const char* topic);
+
+/**
+ * @brief Change batch size and flush interval at runtime
+ * @param batch Pointer to batch state
+ * @param batch_size Samples per message (clamped to 1..TELEMETRY_BATCH_CAPACITY)
+ * @param flush_interval_ms Max age of the oldest pending sample before flushing
+ */
+void telemetry_batch_configure(telemetry_batch_t* batch, size_t batch_size,
+                               uint32_t flush_interval_ms);
+
+/**
+ * @brief Keep only samples that changed (report-on-change)
+ * @param batch Pointer to batch state
+ * @param deadband schema->float_count thresholds in sample units (must
+ *                 outlive the batch), nullptr to keep every sample
+ * @param heartbeat_ms Keep a sample at least this often
+ */
+void telemetry_batch_set_deadband(telemetry_batch_t* batch, const sensor_value_t* deadband,
+                                  uint32_t heartbeat_ms);
+
+/**
+ * @brief Keep every sample regardless of the deadband
+ * @param batch Pointer to batch state
+ * @param report_all true to bypass the deadband
+ */
+void telemetry_batch_set_report_all(telemetry_batch_t* batch, bool report_all);
+
+/**
+ * @brief Keep every sample of a flagged window
+ *
+ * The suppressed samples still in the history are stored first (they are
+ * newer than anything pending), then the deadband is bypassed for samples
+ * up to window_ms after timestamp_us.
+ *
+ * @param batch Pointer to batch state
+ * @param timestamp_us Time of the flagged sample on the monotonic clock, in us
+ * @param window_ms Length of the window after it
+ */
+void telemetry_batch_flag(telemetry_batch_t* batch, int64_t timestamp_us, uint32_t window_ms);
+
+/**
+ * @brief Add a sample to the ring buffer
+ *
+ * Never blocks. When the ring is full the oldest sample is overwritten.
+ * Samples within the deadband are discarded and counted as suppressed.
+ *
+ * @param batch Pointer to batch state
+ * @param timestamp_us Acquisition time on the monotonic clock, in us
+ * @param values schema->float_count values, converted to float only on flush
+ * @param bools Bool fields packed LSB first
+ * @return true if stored without overwriting (or suppressed), false if the
+ *         oldest was dropped
+ */
+bool telemetry_batch_push(telemetry_batch_t* batch, int64_t timestamp_us,
+                          const sensor_value_t* values, uint8_t bools);
+
+/**
+ * @brief Publish pending samples if the batch is due
+ * @param batch Pointer to batch state
+ * @param now_ms Current time in ms since boot
+ * @param force Publish whatever is pending regardless of thresholds
+ * @return Number of samples published (0 if not due or publish failed)
+ */
+size_t telemetry_batch_flush(telemetry_batch_t* batch, uint32_t now_ms, bool force);
+
+#endif // TELEMETRY_BATCH_H
@@ -0,0 +1,197 @@
+#include "telemetry_codec.h"
+#include "debug_helper.h"
+#include <string.h>
+
+#define LZ_MIN_MATCH     4
+#define LZ_LAST_LITERALS 5              // LZ4: the block ends with literals
+#define LZ_MATCH_LIMIT   12             // LZ4: no match starts in the last 12 bytes
+
+static telemetry_codec_t active_codec = TELEMETRY_DEFAULT_CODEC;
+
+static const char* const CODEC_NAMES[] = {"raw", "delta", "delta_lz"};
+
+// Match finder: last position of each 4-byte hash (network task only)
+static uint16_t lz_table[1 << TELEMETRY_LZ_HASH_BITS];
+
+// ==================== LZ4 Block ====================
+
+static inline uint32_t read_u32(const uint8_t* src) {
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+static inline uint32_t lz_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - TELEMETRY_LZ_HASH_BITS);
+}
+
+// Length beyond a token nibble of 15: 255-byte steps, then the remainder
+static bool put_length(uint8_t** out, const uint8_t* end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (*out >= end) {
+            return false;
+        }
+        *(*out)++ = 255;
+    }
+    if (*out >= end) {
+        return false;
+    }
+    *(*out)++ = (uint8_t)length;
+    return true;
+}
+
+// One sequence: literals, then a match unless match_length is 0 (last sequence)
+static bool put_sequence(uint8_t** out, const uint8_t* end, const uint8_t* literals,
+                         size_t literal_length, size_t offset, size_t match_length) {
+    if (*out >= end) {
+        return false;
+    }
+    size_t match_code = match_length > 0 ? match_length - LZ_MIN_MATCH : 0;
+    uint8_t* token = (*out)++;
+    *token = (uint8_t)(((literal_length < 15 ? literal_length : 15) << 4) |
+                       (match_code < 15 ? match_code : 15));
+    if (literal_length >= 15 && !put_length(out, end, literal_length - 15)) {
+        return false;
+    }
+    if ((size_t)(end - *out) < literal_length) {
+        return false;
+    }
+    memcpy(*out, literals, literal_length);
+    *out += literal_length;
+
+    if (match_length == 0) {
+        return true;
+    }
+    if (end - *out < 2) {
+        return false;
+    }
+    *(*out)++ = (uint8_t)(offset & 0xFF);
+    *(*out)++ = (uint8_t)(offset >> 8);
+    return match_code < 15 || put_length(out, end, match_code - 15);
+}
+
+size_t telemetry_lz_compress(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity) {
+    if (length > TELEMETRY_LZ_MAX_INPUT) {
+        return 0;
+    }
+    uint8_t* out = dst;
+    const uint8_t* end = dst + capacity;
+    size_t anchor = 0;
+    size_t position = 0;
+    memset(lz_table, 0, sizeof(lz_table));
+
+    if (length > LZ_MATCH_LIMIT) {
+        size_t last_start = length - LZ_MATCH_LIMIT;
+        size_t last_end = length - LZ_LAST_LITERALS;
+        while (position < last_start) {
+            uint32_t sequence = read_u32(&src[position]);
+            uint32_t hash = lz_hash(sequence);
+            size_t candidate = lz_table[hash];
+            lz_table[hash] = (uint16_t)position;
+            if (candidate >= position || read_u32(&src[candidate]) != sequence) {
+                position++;
+                continue;
+            }
+
+            size_t match_length = LZ_MIN_MATCH;
+            while (position + match_length < last_end &&
+                   src[candidate + match_length] == src[position + match_length]) {
+                match_length++;
+            }
+            if (!put_sequence(&out, end, &src[anchor], position - anchor,
+                              position - candidate, match_length)) {
+                return 0;
+            }
+            position += match_length;
+            anchor = position;
+        }
+    }
+
+    if (!put_sequence(&out, end, &src[anchor], length - anchor, 0, 0)) {
+        return 0;
+    }
+    return (size_t)(out - dst);
+}
+
+// Length continuation bytes after a nibble of 15
+static bool get_length(const uint8_t** in, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*in >= end) {
+            return false;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+size_t telemetry_lz_decompress(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity) {
+    const uint8_t* in = src;
+    const uint8_t* in_end = src + length;
+    size_t written = 0;
+
+    while (in < in_end) {
+        uint8_t token = *in++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !get_length(&in, in_end, &literal_length)) {
+            return 0;
+        }
+        if ((size_t)(in_end - in) < literal_length || capacity - written < literal_length) {
+            return 0;
+        }
+        memcpy(&dst[written], in, literal_length);
+        in += literal_length;
+        written += literal_length;
+        if (in == in_end) {
+            return written;                 // Last sequence has no match
+        }
+
+        if (in_end - in < 2) {
+            return 0;
+        }
+        size_t offset = in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !get_length(&in, in_end, &match_length)) {
+            return 0;
+        }
+        match_length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > written || capacity - written < match_length) {
+            return 0;
+        }
+        // Byte by byte: a match may overlap the bytes it produces
+        for (size_t i = 0; i < match_length; i++, written++) {
+            dst[written] = dst[written - offset];
+        }
+    }
+    return 0;                               // A block ends with literals
+}
+
+// ==================== Selection ====================
+
+telemetry_codec_t telemetry_get_codec() {
+    return active_codec;
+}
+
+void telemetry_set_codec(telemetry_codec_t codec) {
+    active_codec = codec;
+    DebugHelper::info("Telemetry codec set to: %s", telemetry_codec_name(codec));
+}
+
+bool telemetry_parse_codec(const char* name, telemetry_codec_t* codec) {
+    if (name == nullptr) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(CODEC_NAMES) / sizeof(CODEC_NAMES[0]); i++) {
+        if (strcmp(name, CODEC_NAMES[i]) == 0) {
+            *codec = (telemetry_codec_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* telemetry_codec_name(telemetry_codec_t codec) {
+    return (size_t)codec < sizeof(CODEC_NAMES) / sizeof(CODEC_NAMES[0]) ? CODEC_NAMES[codec] : "?";
+}
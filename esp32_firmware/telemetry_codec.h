@@ -0,0 +1,108 @@
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_codec.h
+ * @brief Optional compression of batched binary telemetry frames
+ *
+ * Consecutive samples of a slow channel (temperature, tank level, humidity)
+ * differ by a few milli-units, so a batched frame is mostly redundant. Two
+ * stages can be applied to batched frames (TELEMETRY_FRAME_FLAG_BATCH,
+ * telemetry_frame.h); single-sample frames are always sent raw:
+ *
+ *  - delta (TELEMETRY_FRAME_FLAG_DELTA): each float field is sent as the
+ *    zig-zag varint of its change in milli-units since the previous sample
+ *    (the first sample against 0), and the bool byte as the XOR with the
+ *    previous one. A steady channel costs one byte per sample instead of
+ *    four. Values are rounded to 0.001 like JSON (lossless on the
+ *    fixed-point path, which works in milli-units already); a batch with a
+ *    NaN, an infinity or a value beyond the milli range is sent raw.
+ *
+ *  - LZ (TELEMETRY_FRAME_FLAG_LZ): everything after the frame header is
+ *    compressed as one LZ4 block (greedy, 4-byte hash, no entropy stage),
+ *    which removes repeated runs such as identical time deltas and zero
+ *    bool changes. The frame is sent without it when it does not shrink.
+ *
+ * Delta-encoded sample layout (after the uint8 sample count):
+ *   varint dt_us, then zig-zag varint delta per float, then the XORed bool
+ *   byte (if the module has bools)
+ *
+ * The backend decoder (src/eco_exoskeleton/telemetry_codec.py) undoes both
+ * stages. The "serialize/delta*" and "codec/lz_*" host benchmarks show the
+ * size and time cost.
+ */
+
+/**
+ * @brief Encodings for batched binary frames
+ */
+typedef enum {
+    TELEMETRY_CODEC_RAW      = 0,       // float32 values (default)
+    TELEMETRY_CODEC_DELTA    = 1,       // Zig-zag varint deltas
+    TELEMETRY_CODEC_DELTA_LZ = 2        // Deltas, then an LZ4 block
+} telemetry_codec_t;
+
+// Compile-time default, override per module target with
+// -DTELEMETRY_DEFAULT_CODEC=TELEMETRY_CODEC_DELTA_LZ
+#ifndef TELEMETRY_DEFAULT_CODEC
+#define TELEMETRY_DEFAULT_CODEC TELEMETRY_CODEC_RAW
+#endif
+
+#define TELEMETRY_LZ_HASH_BITS  10      // Match finder table: 2^bits uint16 slots
+#define TELEMETRY_LZ_MAX_INPUT  65535   // LZ4 offsets are 16 bit
+
+/**
+ * @brief Zig-zag map of a signed value, so small magnitudes get short varints
+ */
+static inline uint64_t telemetry_zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**
+ * @brief Compress a buffer as one LZ4 block (network task only)
+ * @param src Input
+ * @param length Input length (at most TELEMETRY_LZ_MAX_INPUT)
+ * @param dst Output
+ * @param capacity Output capacity
+ * @return Compressed length, 0 if it would not fit in capacity
+ */
+size_t telemetry_lz_compress(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity);
+
+/**
+ * @brief Decompress one LZ4 block (host tests and tools)
+ * @param src Compressed block
+ * @param length Block length
+ * @param dst Output
+ * @param capacity Output capacity
+ * @return Decompressed length, 0 if the block is malformed or too large
+ */
+size_t telemetry_lz_decompress(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity);
+
+/**
+ * @brief Get the codec applied to batched binary frames
+ */
+telemetry_codec_t telemetry_get_codec();
+
+/**
+ * @brief Select the codec applied to batched binary frames at runtime
+ * @param codec New codec
+ */
+void telemetry_set_codec(telemetry_codec_t codec);
+
+/**
+ * @brief Parse a codec name received in a command ("raw", "delta", "delta_lz")
+ * @param name Null-terminated codec name
+ * @param codec Output codec, untouched on failure
+ * @return true if the name was recognised
+ */
+bool telemetry_parse_codec(const char* name, telemetry_codec_t* codec);
+
+/**
+ * @brief Name of a codec, as accepted by telemetry_parse_codec()
+ */
+const char* telemetry_codec_name(telemetry_codec_t codec);
+
+#endif // TELEMETRY_CODEC_H
@@ -0,0 +1,78 @@
+#include "telemetry_frame.h"
+#include "debug_helper.h"
+#include "time_sync.h"
+#include <string.h>
+
+static telemetry_format_t active_format = TELEMETRY_DEFAULT_FORMAT;
+
+// Little-endian writers, independent of host byte order
+static inline void put_u16(uint8_t* dst, uint16_t value) {
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static inline void put_u32(uint8_t* dst, uint32_t value) {
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)((value >> 8) & 0xFF);
+    dst[2] = (uint8_t)((value >> 16) & 0xFF);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+static inline void put_u64(uint8_t* dst, uint64_t value) {
+    put_u32(&dst[0], (uint32_t)value);
+    put_u32(&dst[4], (uint32_t)(value >> 32));
+}
+
+size_t telemetry_frame_put_varint(uint8_t* dst, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        dst[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dst[length++] = (uint8_t)value;
+    return length;
+}
+
+void telemetry_frame_write_header(uint8_t* dst, uint8_t module_id,
+                                  uint8_t float_count, uint8_t bool_count,
+                                  uint8_t flags, uint16_t sequence,
+                                  int64_t timestamp_us) {
+    bool epoch = false;
+    int64_t time_us = time_sync_timestamp_us(timestamp_us, &epoch);
+    if (epoch) {
+        flags |= TELEMETRY_FRAME_FLAG_EPOCH;
+    }
+    dst[0] = TELEMETRY_FRAME_MAGIC;
+    dst[1] = TELEMETRY_FRAME_VERSION;
+    dst[2] = module_id;
+    dst[3] = float_count;
+    dst[4] = bool_count;
+    dst[5] = flags;
+    put_u16(&dst[6], sequence);
+    put_u64(&dst[8], (uint64_t)time_us);
+}
+
+telemetry_format_t telemetry_get_format() {
+    return active_format;
+}
+
+void telemetry_set_format(telemetry_format_t format) {
+    active_format = format;
+    DebugHelper::info("Telemetry format set to: %s",
+                      format == TELEMETRY_FORMAT_BINARY ? "binary" : "json");
+}
+
+bool telemetry_parse_format(const char* name, telemetry_format_t* format) {
+    if (name == nullptr) {
+        return false;
+    }
+    if (strcmp(name, "json") == 0) {
+        *format = TELEMETRY_FORMAT_JSON;
+        return true;
+    }
+    if (strcmp(name, "binary") == 0) {
+        *format = TELEMETRY_FORMAT_BINARY;
+        return true;
+    }
+    return false;
+}
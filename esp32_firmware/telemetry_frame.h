@@ -0,0 +1,129 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_frame.h
+ * @brief Binary telemetry frame layout and header helpers for ESP32 modules
+ *
+ * Opt-in alternative to the cJSON sensor payloads. Frames are encoded by the
+ * batch publisher (telemetry_batch.h) into its static flush buffer, so
+ * publishing performs no heap allocation; this file holds the shared header
+ * writer, the varint writer and the format selection.
+ *
+ * Frame layout (multi-byte fields are little-endian):
+ *
+ * | Offset | Size | Field                                   |
+ * |--------|------|-----------------------------------------|
+ * | 0      | 1    | Magic byte (TELEMETRY_FRAME_MAGIC)      |
+ * | 1      | 1    | Format version (TELEMETRY_FRAME_VERSION)|
+ * | 2      | 1    | Module id (telemetry_module_id_t)       |
+ * | 3      | 1    | Number of float fields (N)              |
+ * | 4      | 1    | Number of bool fields (M)               |
+ * | 5      | 1    | Flags (TELEMETRY_FRAME_FLAG_*)          |
+ * | 6      | 2    | Sequence number                         |
+ * | 8      | 8    | Timestamp of the first sample, signed us|
+ * | 16     | 1    | Sample count                            |
+ * | 17     | ...  | Samples                                 |
+ *
+ * Each sample is the time since the previous sample in us as an unsigned
+ * LEB128 varint (0 for the first, which is at the header timestamp), N
+ * IEEE-754 float32 values and M packed bools, LSB first (rounded up to
+ * bytes). At 10 ms to 16 s between samples the varint is two or three bytes.
+ * TELEMETRY_FRAME_FLAG_BATCH marks the count and sample list; a batch of one
+ * sample is sent without it, as just the values and bools after the header.
+ * Batched samples can also be delta-encoded and LZ-compressed, see
+ * telemetry_codec.h and TELEMETRY_FRAME_FLAG_DELTA / TELEMETRY_FRAME_FLAG_LZ.
+ *
+ * The timestamp is Unix time in microseconds when TELEMETRY_FRAME_FLAG_EPOCH
+ * is set, else microseconds since boot (time_sync.h).
+ *
+ * Version 1 frames (still decoded by the backend) had a 12 byte header with
+ * a uint32 ms-since-boot timestamp and a uint16 ms offset per batched sample.
+ *
+ * Field order is fixed per module and mirrored by the backend decoder
+ * (src/eco_exoskeleton/telemetry_codec.py). The first byte can never be '{',
+ * so binary frames and JSON documents can share the same sensor topic.
+ */
+
+#define TELEMETRY_FRAME_MAGIC       0xEC
+#define TELEMETRY_FRAME_VERSION     2
+#define TELEMETRY_FRAME_HEADER_SIZE 16
+#define TELEMETRY_FRAME_FLAG_BATCH  0x01
+#define TELEMETRY_FRAME_FLAG_EPOCH  0x02    // Timestamp is Unix time
+#define TELEMETRY_FRAME_FLAG_DELTA  0x04    // Batched samples delta-encoded (telemetry_codec.h)
+#define TELEMETRY_FRAME_FLAG_LZ     0x08    // Everything after the header is an LZ4 block
+#define TELEMETRY_VARINT_MAX_SIZE   10      // LEB128 bytes of a uint64
+
+/**
+ * @brief Module identifiers carried in the frame header
+ */
+typedef enum {
+    TELEMETRY_MODULE_GREENHOUSE = 1,
+    TELEMETRY_MODULE_INJECTION  = 2,
+    TELEMETRY_MODULE_BUBBLE     = 3
+} telemetry_module_id_t;
+
+/**
+ * @brief Sensor payload encodings selectable per module
+ */
+typedef enum {
+    TELEMETRY_FORMAT_JSON   = 0,    // cJSON document (default, human readable)
+    TELEMETRY_FORMAT_BINARY = 1     // Compact binary frame (see layout above)
+} telemetry_format_t;
+
+// Compile-time default, override per module target with
+// -DTELEMETRY_DEFAULT_FORMAT=TELEMETRY_FORMAT_BINARY
+#ifndef TELEMETRY_DEFAULT_FORMAT
+#define TELEMETRY_DEFAULT_FORMAT TELEMETRY_FORMAT_JSON
+#endif
+
+/**
+ * @brief Write a frame header into a buffer
+ * @param dst Destination, at least TELEMETRY_FRAME_HEADER_SIZE bytes
+ * @param module_id Module identifier
+ * @param float_count Float fields per sample
+ * @param bool_count Bool fields per sample
+ * @param flags TELEMETRY_FRAME_FLAG_* bits
+ * @param sequence Frame sequence number
+ * @param timestamp_us Sample time on the monotonic clock, written as Unix
+ *                     time (with TELEMETRY_FRAME_FLAG_EPOCH added to flags)
+ *                     once time_sync.h has a mapping
+ */
+void telemetry_frame_write_header(uint8_t* dst, uint8_t module_id,
+                                  uint8_t float_count, uint8_t bool_count,
+                                  uint8_t flags, uint16_t sequence,
+                                  int64_t timestamp_us);
+
+/**
+ * @brief Write an unsigned LEB128 varint
+ * @param dst Destination, at least TELEMETRY_VARINT_MAX_SIZE bytes
+ * @param value Value to encode
+ * @return Bytes written
+ */
+size_t telemetry_frame_put_varint(uint8_t* dst, uint64_t value);
+
+/**
+ * @brief Get the currently selected sensor payload format
+ * @return Active format
+ */
+telemetry_format_t telemetry_get_format();
+
+/**
+ * @brief Select the sensor payload format at runtime
+ * @param format New format
+ */
+void telemetry_set_format(telemetry_format_t format);
+
+/**
+ * @brief Parse a format name received in a command ("json" or "binary")
+ * @param name Null-terminated format name
+ * @param format Output format, untouched on failure
+ * @return true if the name was recognised
+ */
+bool telemetry_parse_format(const char* name, telemetry_format_t* format);
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,49 @@
+#include "telemetry_rate.h"
+#include "sensor_acquisition.h"
+#include "actuator_task.h"
+#include "debug_helper.h"
+
+static const telemetry_rate_config_t* rate_config = nullptr;
+static telemetry_batch_t* rate_batch = nullptr;
+static bool active = false;
+static uint32_t last_busy_ms = 0;
+
+void telemetry_rate_init(const telemetry_rate_config_t* config, telemetry_batch_t* batch) {
+    rate_config = config;
+    rate_batch = batch;
+    active = false;
+}
+
+static void set_active(bool enable) {
+    active = enable;
+    uint32_t period_ms = enable ? rate_config->active_period_ms : rate_config->idle_period_ms;
+    sensor_acquisition_set_period(period_ms * 1000);
+    telemetry_batch_set_report_all(rate_batch, enable);
+    DebugHelper::info("Telemetry rate: %s, every %lu ms", enable ? "active" : "idle",
+                      (unsigned long)period_ms);
+}
+
+void telemetry_rate_poll(uint32_t now_ms) {
+    if (rate_config == nullptr) {
+        return;
+    }
+
+    if (actuator_busy()) {
+        last_busy_ms = now_ms;
+        if (!active) {
+            set_active(true);
+        }
+    } else if (active && now_ms - last_busy_ms >= rate_config->linger_ms) {
+        set_active(false);
+    }
+}
+
+bool telemetry_rate_active() {
+    return active;
+}
+
+void telemetry_rate_resume() {
+    if (rate_config != nullptr) {
+        set_active(active);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef TELEMETRY_RATE_H
+#define TELEMETRY_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry_batch.h"
+
+/**
+ * @file telemetry_rate.h
+ * @brief Sampling rate that follows actuator activity
+ *
+ * While an actuation is in progress (actuator_busy()), the acquisition
+ * period drops to the active period and the batch keeps every sample,
+ * bypassing its deadband. When the actuator has been idle for linger_ms,
+ * the idle period and report-on-change come back. Only the network task
+ * calls telemetry_rate_poll().
+ */
+
+#define TELEMETRY_RATE_LINGER_MS 2000   // Fast rate kept after an actuation ends
+
+/**
+ * @brief Rate settings
+ */
+typedef struct {
+    uint32_t idle_period_ms;            // Sampling period at rest
+    uint32_t active_period_ms;          // Sampling period while actuating
+    uint32_t linger_ms;                 // Idle time before slowing down
+} telemetry_rate_config_t;
+
+/**
+ * @brief Set up rate switching
+ * @param config Rate settings (must stay valid)
+ * @param batch Batch whose deadband is bypassed while active
+ */
+void telemetry_rate_init(const telemetry_rate_config_t* config, telemetry_batch_t* batch);
+
+/**
+ * @brief Switch rates on actuator activity (network task)
+ * @param now_ms Current time in milliseconds
+ */
+void telemetry_rate_poll(uint32_t now_ms);
+
+/**
+ * @brief Whether the active rate is in effect
+ */
+bool telemetry_rate_active();
+
+/**
+ * @brief Re-apply the current rate after something else changed the period
+ *        or deadband (sample_replay.h)
+ */
+void telemetry_rate_resume();
+
+#endif // TELEMETRY_RATE_H
@@ -0,0 +1,129 @@
+#include "time_sync.h"
+#include "seqlock.h"
+#include "metrics.h"
+#include "debug_helper.h"
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+typedef struct {
+    int64_t sync_us;                    // Monotonic time of the measurement
+    int64_t offset_us;                  // Unix time minus monotonic time at sync_us
+    int32_t drift_ppb;                  // Unix clock rate relative to esp_timer
+    bool valid;
+    bool from_sntp;                     // Measured by SNTP (not kept through sleep)
+} time_mapping_t;
+
+// Written by time_sync_init() and then the SNTP callback (lwIP task) only
+static Seqlock<time_mapping_t> mapping_lock;
+static time_mapping_t mapping = {};     // Writer's copy
+static bool sntp_started = false;
+
+static int64_t map_time(const time_mapping_t* m, int64_t mono_us) {
+    int64_t elapsed_us = mono_us - m->sync_us;
+    return mono_us + m->offset_us + elapsed_us * m->drift_ppb / 1000000000;
+}
+
+// Offset between the system time and esp_timer, read back to back
+static int64_t measure_offset(int64_t* mono_us) {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    *mono_us = esp_timer_get_time();
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec - *mono_us;
+}
+
+static void on_sntp_sync(struct timeval* tv) {
+    int64_t mono_us;
+    int64_t offset_us = measure_offset(&mono_us);
+    time_mapping_t next = mapping;
+
+    if (mapping.valid) {
+        int64_t error_us = mono_us + offset_us - map_time(&mapping, mono_us);
+        uint64_t magnitude = error_us < 0 ? 0 - (uint64_t)error_us : (uint64_t)error_us;
+        metrics_record(METRIC_TIME_SYNC, magnitude > UINT32_MAX ? UINT32_MAX : (uint32_t)magnitude);
+
+        // The offset of a wake from deep sleep only dates the sleep, not the drift
+        int64_t interval_us = mono_us - mapping.sync_us;
+        if (mapping.from_sntp && interval_us >= (int64_t)TIME_SYNC_MIN_DRIFT_S * 1000000) {
+            int64_t drift_ppb = (offset_us - mapping.offset_us) * 1000 / (interval_us / 1000000);
+            if (drift_ppb >= -TIME_SYNC_MAX_DRIFT_PPB && drift_ppb <= TIME_SYNC_MAX_DRIFT_PPB) {
+                next.drift_ppb = (int32_t)drift_ppb;
+            } else {
+                DebugHelper::warning("Time sync: drift %lld ppb discarded", (long long)drift_ppb);
+            }
+        }
+        DebugHelper::info("Time sync: corrected by %lld us, drift %ld ppb",
+                          (long long)error_us, (long)next.drift_ppb);
+    } else {
+        DebugHelper::info("Time sync: clock set, %lld.%06ld", (long long)tv->tv_sec,
+                          (long)tv->tv_usec);
+    }
+
+    next.sync_us = mono_us;
+    next.offset_us = offset_us;
+    next.valid = true;
+    next.from_sntp = true;
+    mapping = next;
+    mapping_lock.write(mapping);
+    metrics_count(METRIC_TIME_SYNCS, 1);
+}
+
+void time_sync_init() {
+    int64_t mono_us;
+    int64_t offset_us = measure_offset(&mono_us);
+    if ((mono_us + offset_us) / 1000 < TIME_SYNC_MIN_EPOCH_MS) {
+        return;
+    }
+    mapping = {};
+    mapping.sync_us = mono_us;
+    mapping.offset_us = offset_us;
+    mapping.valid = true;
+    mapping_lock.write(mapping);
+    DebugHelper::info("Time sync: system time kept from before reset");
+}
+
+bool time_sync_start(const char* server) {
+    if (sntp_started) {
+        return true;
+    }
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, server);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_sync_interval(TIME_SYNC_INTERVAL_MS);
+    sntp_set_time_sync_notification_cb(on_sntp_sync);
+    esp_sntp_init();
+
+    sntp_started = esp_sntp_enabled();
+    if (!sntp_started) {
+        DebugHelper::error("Time sync: failed to start SNTP");
+        return false;
+    }
+    DebugHelper::info("Time sync: SNTP polling %s every %lu s", server,
+                      (unsigned long)(TIME_SYNC_INTERVAL_MS / 1000));
+    return true;
+}
+
+bool time_sync_valid() {
+    time_mapping_t current;
+    mapping_lock.read(current);
+    return current.valid;
+}
+
+int64_t time_sync_epoch_us(int64_t mono_us) {
+    time_mapping_t current;
+    mapping_lock.read(current);
+    return current.valid ? map_time(&current, mono_us) : 0;
+}
+
+int64_t time_sync_timestamp_us(int64_t mono_us, bool* epoch) {
+    time_mapping_t current;
+    mapping_lock.read(current);
+    if (epoch != nullptr) {
+        *epoch = current.valid;
+    }
+    return current.valid ? map_time(&current, mono_us) : mono_us;
+}
+
+int64_t time_sync_now_ms() {
+    return time_sync_timestamp_us(esp_timer_get_time(), nullptr) / 1000;
+}
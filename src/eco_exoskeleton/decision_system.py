@@ -23,6 +23,10 @@ class CentralDecisionSystem:
             self._generate_repair_plan()
     
     def update_module_status(self, status: ModuleStatus):
+        # 告警是模块端异常检测的事件，不改变模块状态
+        if status.state == ModuleState.ALERT:
+            self._handle_module_alert(status)
+            return
         self.module_states[status.module] = status
         if status.state == ModuleState.COMPLETED:
             self._handle_task_completion(status.module)
@@ -63,6 +67,9 @@ class CentralDecisionSystem:
     def _handle_task_completion(self, module: str):
         logger.info(f"{module} 模块任务完成，继续执行后续计划")
     
+    def _handle_module_alert(self, status: ModuleStatus):
+        logger.warning(f"{status.module} 模块检测到传感器异常: {status.message}")
+    
     def _handle_module_error(self, module: str):
         error_status = self.module_states[module]
         if "超时" in error_status.message:
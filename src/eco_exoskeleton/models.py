@@ -10,6 +10,8 @@ class ModuleState(Enum):
     SPRAYING = "SPRAYING"
     ERROR = "ERROR"
     COMPLETED = "COMPLETED"
+    UPDATING = "UPDATING"
+    ALERT = "ALERT"
 
 @dataclass
 class SensorData:
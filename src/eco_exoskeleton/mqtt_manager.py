@@ -1,8 +1,10 @@
 import json
 import logging
+from typing import List, Optional
 import paho.mqtt.client as mqtt
 from eco_exoskeleton.models import SensorData, ModuleStatus, Command, ModuleState
 from eco_exoskeleton.config import *
+from eco_exoskeleton.telemetry_codec import decode_payload
 
 logger = logging.getLogger(__name__)
 
@@ -43,8 +45,7 @@ class MQTTManager:
     
     def _on_message(self, client, userdata, msg):
         try:
-            payload = msg.payload.decode("utf-8")
-            data = json.loads(payload)
+            data = decode_payload(msg.payload)
             
             if msg.topic == TOPIC_GREENHOUSE_SENSORS:
                 self._process_greenhouse_sensors(data)
@@ -114,18 +115,21 @@ class MQTTManager:
         )
         self.decision_system.update_module_status(status)
     
+    def _command_topic(self, module: str) -> str:
+        if module == "greenhouse":
+            return TOPIC_GREENHOUSE_COMMAND
+        elif module == "injection":
+            return TOPIC_INJECTION_COMMAND
+        elif module == "bubble":
+            return TOPIC_BUBBLE_COMMAND
+        return ""
+    
     def send_command(self, command: Command) -> bool:
         if not self.connected:
             return False
             
-        topic = ""
-        if command.module == "greenhouse":
-            topic = TOPIC_GREENHOUSE_COMMAND
-        elif command.module == "injection":
-            topic = TOPIC_INJECTION_COMMAND
-        elif command.module == "bubble":
-            topic = TOPIC_BUBBLE_COMMAND
-        else:
+        topic = self._command_topic(command.module)
+        if not topic:
             return False
             
         payload = json.dumps({
@@ -135,6 +139,58 @@ class MQTTManager:
         
         self.client.publish(topic, payload)
         return True
+    
+    def send_batch(self, module: str, commands: List[Command], batch_id: str = "",
+                   at_ms: Optional[List[int]] = None) -> bool:
+        """Send several commands for one module as a single batch.
+
+        The module queues them and runs them back-to-back, each no earlier
+        than its at_ms offset from arrival, then reports one consolidated
+        status (see esp32_firmware/command_scheduler.h).
+        """
+        if not self.connected or not commands:
+            return False
+            
+        topic = self._command_topic(module)
+        if not topic:
+            return False
+            
+        steps = []
+        for i, command in enumerate(commands):
+            step = {"action": command.action, "params": command.params}
+            if at_ms is not None and at_ms[i] > 0:
+                step["at_ms"] = at_ms[i]
+            steps.append(step)
+            
+        payload = json.dumps({
+            "action": "batch",
+            "params": {"id": batch_id, "commands": steps}
+        })
+        
+        self.client.publish(topic, payload)
+        return True
+
+    def send_ota_update(self, module: str, url: str, version: str = "") -> bool:
+        """Ask a module to download and boot a new firmware image.
+
+        url serves a full image or a delta against the running image
+        (eco_exoskeleton.ota_update). The module reports progress and the
+        outcome on its status topic (see esp32_firmware/ota_update.h).
+        """
+        if not self.connected:
+            return False
+            
+        topic = self._command_topic(module)
+        if not topic:
+            return False
+            
+        params = {"url": url}
+        if version:
+            params["version"] = version
+        payload = json.dumps({"action": "ota_update", "params": params})
+        
+        self.client.publish(topic, payload, qos=1)
+        return True
 
     def disconnect(self):
         if self.connected:
@@ -0,0 +1,290 @@
+"""
+OTA Update Tool for Eco-Exoskeleton Firmware
+
+Builds delta images between two builds of a module and pushes updates over
+MQTT (see esp32_firmware/ota_update.h). A delta rebuilds the new image from
+ranges of the image the module is running plus literal bytes, so it only has
+to be downloaded where the two builds differ. Every delta is applied here and
+compared with the new image before it is written or sent.
+
+    python -m eco_exoskeleton.ota_update delta deployed.bin new.bin -o new.delta
+    python -m eco_exoskeleton.ota_update push greenhouse new.bin --base deployed.bin
+
+push serves the image (or the delta against --base) over HTTP from this
+machine, sends the ota_update command and follows the module's status
+messages until the new image has confirmed itself or the update failed.
+"""
+
+import argparse
+import http.server
+import json
+import os
+import socket
+import struct
+import threading
+import paho.mqtt.client as mqtt
+from eco_exoskeleton.config import MQTT_BROKER, MQTT_PORT, MQTT_USER, MQTT_PASS
+
+TOPIC_PREFIX = "exoskeleton/"
+DELTA_MAGIC = b"EDLT"               # OTA_DELTA_MAGIC
+DELTA_VERSION = 1
+DELTA_HEADER = struct.Struct("<4sB3xII32s")
+IMAGE_MAGIC = 0xE9
+IMAGE_HEADER_SIZE = 24              # esp_image_header_t, hash_appended is the last byte
+APP_DESC_OFFSET = 32
+APP_DESC_MAGIC = 0xABCD5432
+MATCH_MIN = 12                      # Shortest match worth a copy op
+INDEX_STRIDE = 4                    # Base positions indexed (any match >= 15 bytes is found)
+
+
+def image_hash(image: bytes) -> bytes:
+    """SHA-256 appended to an ESP application image (esp_partition_get_sha256())."""
+    if len(image) < IMAGE_HEADER_SIZE + 32 or image[0] != IMAGE_MAGIC:
+        raise ValueError("not an ESP application image")
+    if image[IMAGE_HEADER_SIZE - 1] != 1:
+        raise ValueError("image has no appended SHA-256")
+    return image[-32:]
+
+
+def image_version(image: bytes) -> str:
+    """Version string of the image's esp_app_desc_t, "" if it has none."""
+    offset = APP_DESC_OFFSET
+    if len(image) < offset + 48:
+        return ""
+    (magic,) = struct.unpack_from("<I", image, offset)
+    if magic != APP_DESC_MAGIC:
+        return ""
+    return image[offset + 16:offset + 48].split(b"\0", 1)[0].decode("utf-8", "replace")
+
+
+def _varint(value: int) -> bytes:
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _zigzag(value: int) -> int:
+    return value * 2 if value >= 0 else -value * 2 - 1
+
+
+def _match_length(base: bytes, base_pos: int, target: bytes, target_pos: int) -> int:
+    """Length of the common run at the two positions, compared in chunks."""
+    length = 0
+    while True:
+        n = min(256, len(target) - target_pos - length, len(base) - base_pos - length)
+        if n <= 0:
+            return length
+        if target[target_pos + length:target_pos + length + n] == \
+                base[base_pos + length:base_pos + length + n]:
+            length += n
+            continue
+        while n > 0 and target[target_pos + length] == base[base_pos + length]:
+            length += 1
+            n -= 1
+        return length
+
+
+def make_delta(base: bytes, target: bytes) -> bytes:
+    """Delta image that rebuilds target from base (greedy copy/insert ops)."""
+    index = {}
+    for pos in range(0, len(base) - MATCH_MIN + 1, INDEX_STRIDE):
+        index.setdefault(base[pos:pos + MATCH_MIN], pos)
+
+    ops = bytearray()
+    literal_start = 0
+    base_next = 0                   # End of the previous copy
+    shift = 0                       # Base minus target position of the previous copy
+    t = 0
+    while t + MATCH_MIN <= len(target):
+        key = target[t:t + MATCH_MIN]
+        # Code after an edit usually continues at the same shift
+        candidate = t + shift
+        if not (0 <= candidate <= len(base) - MATCH_MIN and base[candidate:candidate + MATCH_MIN] == key):
+            candidate = index.get(key, -1)
+        if candidate < 0:
+            t += 1
+            continue
+
+        start = t
+        length = _match_length(base, candidate, target, t)
+        while start > literal_start and candidate > 0 and target[start - 1] == base[candidate - 1]:
+            start -= 1
+            candidate -= 1
+            length += 1
+        if start > literal_start:
+            ops += _varint((start - literal_start) << 1 | 1) + target[literal_start:start]
+        ops += _varint(length << 1) + _varint(_zigzag(candidate - base_next))
+        base_next = candidate + length
+        shift = candidate - start
+        t = literal_start = start + length
+
+    if literal_start < len(target):
+        ops += _varint((len(target) - literal_start) << 1 | 1) + target[literal_start:]
+    header = DELTA_HEADER.pack(DELTA_MAGIC, DELTA_VERSION, len(base), len(target), image_hash(base))
+    return header + bytes(ops)
+
+
+def apply_delta(base: bytes, delta: bytes) -> bytes:
+    """Rebuild the target image the way the firmware does."""
+    magic, version, base_size, target_size, base_sha = DELTA_HEADER.unpack_from(delta, 0)
+    if magic != DELTA_MAGIC or version != DELTA_VERSION:
+        raise ValueError("not a delta image")
+    if base_size != len(base) or base_sha != image_hash(base):
+        raise ValueError("delta is for another base image")
+
+    def read_varint(offset: int):
+        value = shift = 0
+        while True:
+            byte = delta[offset]
+            offset += 1
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value, offset
+            shift += 7
+
+    out = bytearray()
+    offset = DELTA_HEADER.size
+    base_pos = 0
+    while len(out) < target_size:
+        op, offset = read_varint(offset)
+        length = op >> 1
+        if op & 1:
+            out += delta[offset:offset + length]
+            offset += length
+        else:
+            adjust, offset = read_varint(offset)
+            base_pos += (adjust >> 1) ^ -(adjust & 1)
+            if base_pos < 0 or base_pos + length > len(base):
+                raise ValueError("copy outside the base image")
+            out += base[base_pos:base_pos + length]
+            base_pos += length
+    if len(out) != target_size or offset != len(delta):
+        raise ValueError("delta does not end with the image")
+    return bytes(out)
+
+
+def build_delta(base: bytes, target: bytes) -> bytes:
+    """make_delta() checked by applying it."""
+    delta = make_delta(base, target)
+    if apply_delta(base, delta) != target:
+        raise RuntimeError("delta does not rebuild the image")
+    return delta
+
+
+def read_file(path: str) -> bytes:
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def serve(payload: bytes, name: str, host: str, port: int) -> http.server.HTTPServer:
+    """Serve payload at /name from a background thread."""
+    class Handler(http.server.BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path != "/" + name:
+                self.send_error(404)
+                return
+            self.send_response(200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def log_message(self, format, *args):
+            print(f"http: {self.address_string()} {format % args}")
+
+    server = http.server.ThreadingHTTPServer((host, port), Handler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def local_address(broker: str) -> str:
+    """Address of the interface that reaches the broker (and the modules)."""
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.connect((broker, MQTT_PORT))
+        return s.getsockname()[0]
+
+
+def push(module: str, payload: bytes, name: str, version: str, host: str, port: int,
+         timeout: float) -> bool:
+    """Send the update and wait for the module's final status."""
+    server = serve(payload, name, "", port)
+    url = f"http://{host}:{port}/{name}"
+    done = threading.Event()
+    outcome = {"ok": False}
+
+    def on_message(client, userdata, msg):
+        status = json.loads(msg.payload)
+        state, message = status.get("state"), status.get("message", "")
+        print(f"{module}: {state} - {message}")
+        if state == "COMPLETED" and message.startswith("Firmware updated"):
+            outcome["ok"] = True
+            done.set()
+        elif state == "ERROR" or (state == "IDLE" and "up to date" in message):
+            outcome["ok"] = state == "IDLE"
+            done.set()
+
+    client = mqtt.Client()
+    client.username_pw_set(MQTT_USER, MQTT_PASS)
+    client.on_message = on_message
+    client.connect(MQTT_BROKER, MQTT_PORT)
+    client.subscribe(TOPIC_PREFIX + module + "/status")
+    client.loop_start()
+    params = {"url": url}
+    if version:
+        params["version"] = version
+    client.publish(TOPIC_PREFIX + module + "/command",
+                   json.dumps({"action": "ota_update", "params": params}), qos=1)
+    print(f"Sent ota_update: {url} ({len(payload)} bytes)")
+
+    if not done.wait(timeout):
+        print(f"No result within {timeout:.0f} s")
+    client.loop_stop()
+    client.disconnect()
+    server.shutdown()
+    return outcome["ok"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build and push module firmware updates")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    delta_parser = commands.add_parser("delta", help="build a delta image")
+    delta_parser.add_argument("base", help="image the module runs (.bin)")
+    delta_parser.add_argument("target", help="new image (.bin)")
+    delta_parser.add_argument("-o", "--output", required=True)
+
+    push_parser = commands.add_parser("push", help="update a module over MQTT")
+    push_parser.add_argument("module", choices=["greenhouse", "injection", "bubble"])
+    push_parser.add_argument("image", help="new image (.bin) or a prepared delta")
+    push_parser.add_argument("--base", help="image the module runs: send a delta against it")
+    push_parser.add_argument("--host", help="address the module downloads from (default: auto)")
+    push_parser.add_argument("--port", type=int, default=8070)
+    push_parser.add_argument("--timeout", type=float, default=600)
+    args = parser.parse_args()
+
+    if args.command == "delta":
+        base, target = read_file(args.base), read_file(args.target)
+        delta = build_delta(base, target)
+        with open(args.output, "wb") as f:
+            f.write(delta)
+        print(f"{args.output}: {len(delta)} bytes for a {len(target)} byte image "
+              f"({100 * len(delta) / len(target):.1f}%)")
+        return
+
+    image = read_file(args.image)
+    version = image_version(image) if image[:1] == bytes([IMAGE_MAGIC]) else ""
+    payload, name = image, os.path.basename(args.image)
+    if args.base:
+        payload = build_delta(read_file(args.base), image)
+        name += ".delta"
+        print(f"Delta: {len(payload)} of {len(image)} bytes")
+    ok = push(args.module, payload, name, version, args.host or local_address(MQTT_BROKER),
+              args.port, args.timeout)
+    raise SystemExit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,127 @@
+"""
+Replay Load Test for Eco-Exoskeleton Firmware
+
+Uploads a recorded raw sample stream to a module over MQTT, starts a replay
+run that ramps the sampling rate, and prints the step reports and the maximum
+sustained samples/sec and messages/sec the module published before losing
+data (see esp32_firmware/sample_replay.h).
+
+The recording is a CSV with one row per frame: the raw ADC reading of every
+module channel in order, optionally followed by the flag byte. Without
+--csv the built-in flash recording is replayed instead.
+
+    python -m eco_exoskeleton.replay_load_test greenhouse --csv capture.csv \
+        --start 100 --step 200 --max 3000
+"""
+
+import argparse
+import csv
+import json
+import struct
+import threading
+import paho.mqtt.client as mqtt
+from eco_exoskeleton.config import MQTT_BROKER, MQTT_PORT, MQTT_USER, MQTT_PASS
+
+TOPIC_PREFIX = "exoskeleton/"
+UPLOAD_FRAMES = 1024            # SAMPLE_REPLAY_UPLOAD_FRAMES
+RX_BUFFER_SIZE = 2048           # MQTT_HELPER_RX_BUFFER_SIZE, largest message
+
+
+def load_frames(path: str) -> list:
+    """Read CSV rows as lists of integers, one per frame."""
+    frames = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or not row[0].strip().lstrip("-").isdigit():
+                continue    # Header or blank line
+            frames.append([int(v) for v in row])
+    return frames
+
+
+def encode_frames(frames: list, channels: int, with_flags: bool) -> bytes:
+    """Pack frames as channels little-endian uint16 values and a flag byte."""
+    data = bytearray()
+    for values in frames:
+        raw = values[:channels]
+        flags = values[channels] if with_flags and len(values) > channels else 0
+        data += struct.pack(f"<{channels}H", *[max(0, min(v, 0xFFFF)) for v in raw])
+        data.append(flags & 0xFF)
+    return bytes(data)
+
+
+def upload(client: mqtt.Client, topic: str, frames: list, channels: int, with_flags: bool):
+    """Clear the module's RAM recording and send the frames in whole-frame chunks."""
+    frame_size = channels * 2 + 1
+    per_message = RX_BUFFER_SIZE // frame_size
+    client.publish(topic, b"", qos=1).wait_for_publish()
+    for i in range(0, min(len(frames), UPLOAD_FRAMES), per_message):
+        chunk = encode_frames(frames[i:i + per_message], channels, with_flags)
+        client.publish(topic, chunk, qos=1).wait_for_publish()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Firmware replay throughput test")
+    parser.add_argument("module", help="Module topic name (greenhouse, injection, bubble)")
+    parser.add_argument("--csv", help="Recorded raw frames; default is the flash recording")
+    parser.add_argument("--channels", type=int, help="Channels per frame (default: CSV width)")
+    parser.add_argument("--flags", action="store_true", help="Last CSV column is the flag byte")
+    parser.add_argument("--start", type=int, default=100, help="First rate (Hz)")
+    parser.add_argument("--step", type=int, default=100, help="Rate increment (Hz), 0 for one step")
+    parser.add_argument("--max", type=int, default=5000, help="Highest rate (Hz)")
+    parser.add_argument("--step-ms", type=int, default=5000, help="Measurement window per step")
+    parser.add_argument("--batch", type=int, help="Samples per message during the run")
+    args = parser.parse_args()
+
+    base = TOPIC_PREFIX + args.module
+    done = threading.Event()
+
+    def on_message(client, userdata, msg):
+        try:
+            report = json.loads(msg.payload).get("replay")
+        except ValueError:
+            return
+        if report is None:
+            return
+        if report["event"] == "step":
+            print(f"{report['rate_hz']:>6} Hz  {report['samples_per_sec']:>9.1f} samples/s  "
+                  f"{report['messages_per_sec']:>8.1f} msg/s  lost {report['lost']}")
+        else:
+            print(f"max sustained: {report['max_samples_per_sec']:.1f} samples/s, "
+                  f"{report['max_messages_per_sec']:.1f} msg/s at {report['max_rate_hz']} Hz "
+                  f"(limit: {report['limit']}, {report['format']}, batch {report['batch_size']})")
+            done.set()
+
+    client = mqtt.Client()
+    client.username_pw_set(MQTT_USER, MQTT_PASS)
+    client.on_message = on_message
+    client.connect(MQTT_BROKER, MQTT_PORT, 60)
+    client.subscribe(base + "/metrics")
+    client.loop_start()
+
+    source = "embedded"
+    if args.csv:
+        frames = load_frames(args.csv)
+        channels = args.channels or (len(frames[0]) - (1 if args.flags else 0))
+        upload(client, base + "/replay", frames, channels, args.flags)
+        source = "mqtt"
+
+    if args.batch:
+        command = {"action": "set_batch", "params": {"size": args.batch, "interval_ms": 1000}}
+        client.publish(base + "/command", json.dumps(command), qos=1)
+    command = {"action": "replay", "params": {"source": source, "rate_hz": args.start,
+                                              "step_hz": args.step, "max_hz": args.max,
+                                              "step_ms": args.step_ms}}
+    client.publish(base + "/command", json.dumps(command), qos=1)
+    print(f"Replay started on {args.module} ({source}). Press Ctrl+C to stop.")
+
+    try:
+        done.wait()
+    except KeyboardInterrupt:
+        stop = {"action": "replay", "params": {"source": "stop"}}
+        client.publish(base + "/command", json.dumps(stop), qos=1).wait_for_publish()
+        done.wait(5)
+    client.loop_stop()
+
+
+if __name__ == "__main__":
+    main()
@@ -18,6 +18,7 @@ from eco_exoskeleton.config import (
     TOPIC_GREENHOUSE_SENSORS, TOPIC_INJECTION_SENSORS, TOPIC_BUBBLE_SENSORS
 )
 from eco_exoskeleton.database_manager import get_database_manager
+from eco_exoskeleton.telemetry_codec import decode_payload, device_time
 
 logger = logging.getLogger(__name__)
 
@@ -165,8 +166,9 @@ class SensorCollector:
         """MQTT消息回调"""
         try:
             topic = msg.topic
-            payload = json.loads(msg.payload.decode('utf-8'))
-            timestamp = time.time()
+            payload = decode_payload(msg.payload)
+            # 采集时间由模块给出（SNTP同步后）；未同步时按接收时间
+            timestamp = device_time(payload) or time.time()
             
             # 确定模块名称
             module = self._extract_module_name(topic)
@@ -0,0 +1,239 @@
+"""
+遥测数据编解码模块
+
+解析ESP32模块在传感器主题上发布的负载。负载可以是JSON文档，
+也可以是固件 telemetry_frame.h 定义的紧凑二进制帧。两者共用同一主题，
+二进制帧以魔数字节 0xEC 开头，因此不会与以 '{' 开头的JSON混淆。
+批量发布（telemetry_batch.h）的负载在两种格式下都保持相同的字典结构。
+
+时间戳（time_sync.h）：顶层 "timestamp" 为毫秒（可带微秒小数）。模块完成SNTP同步后
+为Unix时间，之前为开机以来的时间，两者按数值大小区分（见 device_time()）。
+批量样本的 "dt_us" 为距前一个样本的微秒数，第一个样本为0。
+
+压缩（telemetry_codec.h）：批量帧可带 FLAG_DELTA（浮点字段为相对前一样本的
+千分位zig-zag变长整数差值，布尔字节与前一样本异或）和 FLAG_LZ（帧头之后整体为
+一个LZ4块）。decode_frame() 依次还原，结果与未压缩帧结构相同；差值编码的浮点值
+精确到0.001，与JSON负载一致。
+"""
+
+import json
+import struct
+from typing import Dict, List, Optional, Tuple, Any
+
+FRAME_MAGIC = 0xEC
+FRAME_VERSION = 2
+FRAME_HEADER = struct.Struct("<BBBBBBHq")      # v2: 有符号微秒时间戳
+FRAME_HEADER_V1 = struct.Struct("<BBBBBBHI")   # v1: 开机以来毫秒
+FLAG_BATCH = 0x01
+FLAG_EPOCH = 0x02
+FLAG_DELTA = 0x04
+FLAG_LZ = 0x08
+LZ_MIN_MATCH = 4
+
+# 早于此值（2020-01-01）的时间戳是开机以来的时间，而非Unix时间
+MIN_EPOCH_MS = 1577836800000
+
+# 模块ID -> (模块名, 浮点字段顺序, 布尔字段顺序)
+# 字段顺序必须与各模块 publishSensorData() 中的写入顺序一致
+MODULE_SCHEMAS: Dict[int, Tuple[str, List[str], List[str]]] = {
+    1: ("greenhouse", ["temperature", "humidity"], ["deployed", "retracted"]),
+    2: ("injection", ["depth", "pressure"], ["needle_position"]),
+    3: ("bubble", ["flow_rate", "tank_level", "system_pressure"], []),
+}
+
+
+class FrameDecodeError(ValueError):
+    """二进制帧格式错误"""
+
+
+def is_binary_frame(payload: bytes) -> bool:
+    """判断负载是否为二进制遥测帧"""
+    return len(payload) > 0 and payload[0] == FRAME_MAGIC
+
+
+def _decode_values(payload: bytes, offset: int, n_floats: int, n_bools: int,
+                   float_names: List[str], bool_names: List[str]) -> Tuple[Dict[str, Any], int]:
+    """解码一个样本的浮点与布尔字段，返回(字段字典, 下一个偏移)"""
+    end = offset + 4 * n_floats + (n_bools + 7) // 8
+    if len(payload) < end:
+        raise FrameDecodeError("帧数据被截断")
+
+    floats = struct.unpack_from(f"<{n_floats}f", payload, offset)
+    bool_bytes = payload[offset + 4 * n_floats:end]
+    values: Dict[str, Any] = {}
+    for i, value in enumerate(floats):
+        values[float_names[i] if i < len(float_names) else f"float_{i}"] = value
+    for i in range(n_bools):
+        name = bool_names[i] if i < len(bool_names) else f"bool_{i}"
+        values[name] = bool(bool_bytes[i >> 3] & (1 << (i & 7)))
+    return values, end
+
+
+def _decode_varint(payload: bytes, offset: int) -> Tuple[int, int]:
+    """解码无符号LEB128变长整数，返回(值, 下一个偏移)"""
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(payload) or shift > 63:
+            raise FrameDecodeError("变长整数被截断")
+        byte = payload[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+
+
+def _decode_zigzag(payload: bytes, offset: int) -> Tuple[int, int]:
+    """解码zig-zag编码的有符号变长整数，返回(值, 下一个偏移)"""
+    value, offset = _decode_varint(payload, offset)
+    return (value >> 1) ^ -(value & 1), offset
+
+
+def _decode_delta_values(payload: bytes, offset: int, n_floats: int, n_bools: int,
+                         previous: List[int], previous_bools: int,
+                         float_names: List[str], bool_names: List[str]) -> Tuple[Dict[str, Any], int, int]:
+    """解码一个差值编码样本，原地更新previous，返回(字段字典, 布尔字节, 下一个偏移)"""
+    values: Dict[str, Any] = {}
+    for i in range(n_floats):
+        delta, offset = _decode_zigzag(payload, offset)
+        previous[i] += delta
+        values[float_names[i] if i < len(float_names) else f"float_{i}"] = previous[i] / 1000
+    bools = previous_bools
+    if n_bools > 0:
+        if offset >= len(payload):
+            raise FrameDecodeError("帧数据被截断")
+        bools ^= payload[offset]
+        offset += 1
+    for i in range(n_bools):
+        name = bool_names[i] if i < len(bool_names) else f"bool_{i}"
+        values[name] = bool(bools & (1 << i))
+    return values, bools, offset
+
+
+def lz_decompress(block: bytes) -> bytes:
+    """解压一个LZ4块（固件 telemetry_lz_compress() 的输出）"""
+    out = bytearray()
+    offset = 0
+
+    def read_length(length: int) -> int:
+        nonlocal offset
+        if length != 15:
+            return length
+        while True:
+            if offset >= len(block):
+                raise FrameDecodeError("LZ块长度被截断")
+            byte = block[offset]
+            offset += 1
+            length += byte
+            if byte != 255:
+                return length
+
+    while offset < len(block):
+        token = block[offset]
+        offset += 1
+        literal_length = read_length(token >> 4)
+        if offset + literal_length > len(block):
+            raise FrameDecodeError("LZ块字面量被截断")
+        out += block[offset:offset + literal_length]
+        offset += literal_length
+        if offset == len(block):
+            return bytes(out)           # 最后一个序列没有匹配
+
+        if offset + 2 > len(block):
+            raise FrameDecodeError("LZ块偏移被截断")
+        distance = block[offset] | (block[offset + 1] << 8)
+        offset += 2
+        match_length = read_length(token & 0x0F) + LZ_MIN_MATCH
+        if distance == 0 or distance > len(out):
+            raise FrameDecodeError("LZ块偏移无效")
+        # 逐字节复制：匹配可能与自身输出重叠
+        start = len(out) - distance
+        for i in range(match_length):
+            out.append(out[start + i])
+    raise FrameDecodeError("LZ块未以字面量结束")
+
+
+def decode_frame(payload: bytes) -> Dict[str, Any]:
+    """将二进制遥测帧解码为与JSON负载键名一致的字典
+
+    批量帧的最新样本字段放在顶层，全部样本放在 "samples" 列表中，
+    每个样本的 "dt_us" 为距前一个样本的微秒数，与固件JSON批量格式一致。
+    v1帧（旧固件）的 "timestamp" 为开机以来毫秒，样本为相对顶层的毫秒偏移 "dt"。
+    LZ与差值编码的批量帧先还原，再按相同结构返回。
+    """
+    if len(payload) < 2:
+        raise FrameDecodeError("帧长度不足")
+    if payload[0] != FRAME_MAGIC:
+        raise FrameDecodeError("魔数不匹配")
+    version = payload[1]
+    if version not in (1, FRAME_VERSION):
+        raise FrameDecodeError(f"不支持的帧版本: {version}")
+
+    header = FRAME_HEADER if version == FRAME_VERSION else FRAME_HEADER_V1
+    if len(payload) < header.size:
+        raise FrameDecodeError("帧长度不足")
+    _, _, module_id, n_floats, n_bools, flags, sequence, timestamp = \
+        header.unpack_from(payload, 0)
+
+    module, float_names, bool_names = MODULE_SCHEMAS.get(module_id, (f"module_{module_id}", [], []))
+    data: Dict[str, Any] = {
+        "module": module,
+        "sequence": sequence,
+        "timestamp": timestamp / 1000 if version == FRAME_VERSION else timestamp,
+    }
+
+    if not flags & FLAG_BATCH:
+        values, _ = _decode_values(payload, header.size, n_floats, n_bools,
+                                   float_names, bool_names)
+        data.update(values)
+        return data
+
+    if flags & FLAG_LZ:
+        payload = payload[:header.size] + lz_decompress(payload[header.size:])
+    if len(payload) < header.size + 1:
+        raise FrameDecodeError("批量帧缺少样本数")
+    count = payload[header.size]
+    offset = header.size + 1
+    delta_key = "dt_us" if version == FRAME_VERSION else "dt"
+    previous = [0] * n_floats          # 差值编码：前一样本的千分位值
+    previous_bools = 0
+    samples = []
+    for _ in range(count):
+        if version == FRAME_VERSION:
+            dt, offset = _decode_varint(payload, offset)
+        else:
+            if len(payload) < offset + 2:
+                raise FrameDecodeError("帧数据被截断")
+            (dt,) = struct.unpack_from("<H", payload, offset)
+            offset += 2
+        if flags & FLAG_DELTA:
+            values, previous_bools, offset = _decode_delta_values(
+                payload, offset, n_floats, n_bools, previous, previous_bools,
+                float_names, bool_names)
+        else:
+            values, offset = _decode_values(payload, offset, n_floats, n_bools,
+                                            float_names, bool_names)
+        samples.append({delta_key: dt, **values})
+
+    if samples:
+        latest = dict(samples[-1])
+        latest.pop(delta_key)
+        data.update(latest)
+    data["samples"] = samples
+    return data
+
+
+def device_time(data: Dict[str, Any]) -> Optional[float]:
+    """负载的设备时间（Unix秒）；模块尚未同步时钟时返回None"""
+    timestamp = data.get("timestamp")
+    if not isinstance(timestamp, (int, float)) or timestamp < MIN_EPOCH_MS:
+        return None
+    return timestamp / 1000
+
+
+def decode_payload(payload: bytes) -> Dict[str, Any]:
+    """解码传感器/状态主题负载，自动识别JSON与二进制帧"""
+    if is_binary_frame(payload):
+        return decode_frame(payload)
+    return json.loads(payload.decode("utf-8"))